@@ -49,3 +49,8 @@ error_t arch_cpu_get_irq_entry(struct cpu_s *cpu, int irq_nr, struct irq_action_
 	*action = cpu->arch.action;
 	return 0;
 }
+
+error_t arch_cpu_set_timer(struct cpu_s *cpu, uint_t cycles)
+{
+	return ENOSYS;
+}
@@ -52,6 +52,7 @@
 #undef PMM_SWAP
 #undef PMM_LOCKED
 #undef PMM_CLEAR
+#undef PMM_HINT
 
 /** Page flags */
 #undef PMM_TEXT
@@ -66,6 +67,8 @@
 #undef pmm_except_isPresent
 #undef pmm_except_isRights
 #undef pmm_except_isInKernelMode
+#undef PMM_EXCEPT_KREAD
+#undef PMM_EXCEPT_KWRITE
 
 #define _PMM_BIT_ORDER(x)     (1 << (x))
 
@@ -97,6 +100,7 @@
 #define PMM_SWAP                0x04
 #define PMM_LOCKED              0x08
 #define PMM_CLEAR               0x10
+#define PMM_HINT                0x20
 
 /** Page flags */
 #define PMM_TEXT                0x001
@@ -117,6 +121,9 @@
 #define pmm_except_isRights(_flags)       ((_flags)  & 0x0004)
 #define pmm_except_isInKernelMode(_flags) ((_flags)  & 0x0100)
 
+#define PMM_EXCEPT_KREAD        (MMU_EKMODE | 0x1000)
+#define PMM_EXCEPT_KWRITE       (MMU_EKMODE)
+
 #define MMU_EFATAL              0x01E0
 #define MMU_EWMASK              0x0FFF
 
@@ -118,6 +118,11 @@ error_t arch_barrier_destroy(struct cluster_s *cluster, uint_t barrier_id)
 }
 
 
+error_t arch_cpu_set_timer(struct cpu_s *cpu, uint_t cycles)
+{
+	return soclib_xicu_timer_set(cpu->cluster->arch.xicu, cpu->lid, cycles);
+}
+
 error_t arch_cpu_send_ipi(struct cpu_s *target)
 {
 	struct cluster_s *cluster;
@@ -464,7 +464,7 @@ error_t pmm_region_attr_set(struct pmm_s *pmm, vma_t vaddr, uint_t pages_nr, uin
 		if((err = pmm_get_page(pmm, vaddr, &info)))
 			return err;
 
-		if((info.ppn != 0) && (info.attr & PMM_PRESENT))
+		if((info.ppn != 0) && (info.attr & (PMM_PRESENT | PMM_HINT)))
 		{
 			info.attr = attr;
 			pmm_set_page(pmm, vaddr, &info);
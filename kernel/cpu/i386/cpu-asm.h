@@ -136,6 +136,11 @@ static inline void cpu_fpu_disable(void)
 {
 }
 
+static inline bool_t cpu_usr_counters_enable(void)
+{
+	return false;
+}
+
 static inline uint_t cpu_get_stack(void)
 {
 	return 0;
@@ -194,6 +194,21 @@ static inline void cpu_fpu_disable(void)
 			".set at                           \n");
 }
 
+/* Allow user-mode rdhwr of CPUNum, CC & CCRes (HWREna) */
+static inline bool_t cpu_usr_counters_enable(void)
+{
+	__asm__ volatile 
+		(
+			".set push                         \n"
+			".set mips32r2                     \n"
+			"li     $8,     0xD                \n"
+			"mtc0   $8,     $7                 \n"
+			".set pop                          \n"
+			::: "$8");
+
+	return true;
+}
+
 /* Disable a specific IRQ number and save old SR state */
 static inline void cpu_disable_single_irq (uint_t irq_num, uint_t *old)
 {
@@ -222,6 +222,7 @@ static sint_t block_open(struct device_s *blk_dev, dev_request_t *rq)
 
 
 struct device_s * __sys_blk;
+struct device_s * __swap_blk;
 static uint_t sda_count = 0;
 
 error_t soclib_block_init(struct device_s *block, void *base, uint_t size, uint_t irq)
@@ -241,6 +242,10 @@ error_t soclib_block_init(struct device_s *block, void *base, uint_t size, uint_
 	if(sda_count == 0)
 		__sys_blk = block;
 
+	/* The second block device holds the swap area, if any */
+	if(sda_count == 1)
+		__swap_blk = block;
+
 	sprintk(block->name, 
 #if CONFIG_ROOTFS_IS_VFAT
 		"SDA%d"
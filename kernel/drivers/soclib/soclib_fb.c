@@ -49,10 +49,10 @@ static sint_t fb_read(struct device_s *fb, dev_request_t *rq)
 	src   = ((uint8_t *) fb->base + rq->file->f_offset);
 	limit = (uint8_t*)fb->base + (uint_t)fb->data;
 
-	if(src == limit)
+	if(src >= limit)
 		return 0;
 
-	size = ((src + rq->count) > limit) ? limit - (src + rq->count) : rq->count;
+	size = ((src + rq->count) > limit) ? limit - src : rq->count;
 
 #if CONFIG_FB_USE_DMA
 	error_t err;
@@ -78,10 +78,10 @@ static sint_t fb_write(struct device_s *fb, dev_request_t *rq)
 	dst = ((uint8_t *) fb->base + rq->file->f_offset);
 	limit = (uint8_t*)fb->base + (uint_t)fb->data;
 
-	if(dst == limit)
+	if(dst >= limit)
 		return -ERANGE;
 
-	size = ((dst + rq->count) > limit) ? limit - (dst + rq->count) : rq->count;
+	size = ((dst + rq->count) > limit) ? limit - dst : rq->count;
 
 #if CONFIG_FB_USE_DMA
 	error_t err;
@@ -104,7 +104,7 @@ static sint_t fb_write(struct device_s *fb, dev_request_t *rq)
 	printk(INFO,"%s: dst 0x%x, src 0x%x, size %d\n", __FUNCTION__, dst, rq->src, size);
 	memcpy(dst, rq->src, size);
 #endif
-	return rq->count;
+	return size;
 }
 
 static error_t fb_lseek(struct device_s *fb, dev_request_t *rq)
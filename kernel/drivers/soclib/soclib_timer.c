@@ -92,7 +92,7 @@ void timer_irq_handler (struct irq_action_s *action)
    
 	timer = action->dev;
 	timer_reset_irq(timer);
-	timer_set_period(timer, CPU_CLOCK_TICK);
+	timer_set_period(timer, cpu_get_next_shot(cpu));
 	timer_run(timer, 1);
 }
 
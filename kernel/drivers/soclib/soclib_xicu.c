@@ -125,7 +125,7 @@ void xicu_timer_irq_handler (struct device_s *xicu, uint_t output_irq)
 	cpu = current_cpu;
 	cpu_clock(cpu);
 	xicu_reg_read(xicu->base, XICU_PTI_ACK, output_irq);
-	xicu_reg_write(xicu->base, XICU_PTI_VAL, output_irq, cpu_get_ticks_period(cpu));
+	xicu_reg_write(xicu->base, XICU_PTI_VAL, output_irq, cpu_get_next_shot(cpu));
 }
 
 static void xicu_default_irq_handler(struct device_s *icu, uint_t irq_num, uint_t output_irq)
@@ -231,6 +231,12 @@ error_t soclib_xicu_ipi_send(struct device_s *xicu, uint_t port)
 	xicu_reg_write(xicu->base, XICU_WTI_REG, port, 0);
 	return 0;
 }
+error_t soclib_xicu_timer_set(struct device_s *xicu, uint_t port, uint_t cycles)
+{
+	xicu_reg_write(xicu->base, XICU_PTI_VAL, port, cycles);
+	return 0;
+}
+
 sint_t soclib_xicu_barrier_init(struct device_s *xicu, struct event_s *event, uint_t count)
 {
 	sint_t hwid;
@@ -62,6 +62,7 @@ error_t ext2_blk_get(struct ext2_blk_req_s *rq)
 			break;
 
 		page_unlock(page);
+		mapper_put_page(page);
 	}
 
 	if(try == EXT2_MAX_TRY_NR)
@@ -83,6 +84,7 @@ error_t ext2_blk_put(struct ext2_blk_req_s *rq)
 
 		mapper_remove_page(rq->page);
 		page_unlock(rq->page);
+		mapper_put_page(rq->page);
 		return 0;
 	}
     
@@ -90,6 +92,7 @@ error_t ext2_blk_put(struct ext2_blk_req_s *rq)
 		page_set_dirty(rq->page);
   
 	page_unlock(rq->page);
+	mapper_put_page(rq->page);
 	return 0;
 }
 
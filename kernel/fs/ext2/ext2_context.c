@@ -75,6 +75,7 @@ error_t ext2_context_init(struct ext2_context_s *ctx, struct device_s *dev, stru
 	if(sb->s_magic != 0xEF53)
 	{
 		printk(ERROR, "ERROR: %s: unexpected file system format\n", __FUNCTION__);
+		mapper_put_page(page);
 		return -1;
 	}
 
@@ -88,6 +89,7 @@ error_t ext2_context_init(struct ext2_context_s *ctx, struct device_s *dev, stru
 			printk(ERROR, "ERROR: %s: invalid state of file system, s_errors [%d]\n", 
 			       __FUNCTION__, sb->s_errors);
 
+			mapper_put_page(page);
 			return -1;
 		}
 	}
@@ -102,11 +104,12 @@ error_t ext2_context_init(struct ext2_context_s *ctx, struct device_s *dev, stru
 		       ctx->bytes_per_sector,
 		       PMM_PAGE_SIZE);
 
+		mapper_put_page(page);
 		return -1;
 	}
 
+	/* The reference taken by mapper_get_page keeps ctx->sb */
 	PAGE_SET(page,PG_PINNED);
-	page_refcount_up(page);
 
 	spinlock_init(&ctx->lock, "Ext2fs ctx");
 
@@ -93,6 +93,7 @@ VFS_READ_DIR(ext2_readdir)
 		err = VFS_EODIR;
 
 	page_unlock(page);
+	mapper_put_page(page);
 
 	ext2_dmsg(1, "%s: +++ ended , err %d\n", __FUNCTION__, err);
 	return err;
@@ -108,7 +109,9 @@ const struct vfs_file_op_s ext2_f_op =
 	.close   = ext2_close,
 	.release = ext2_release,
 	.mmap    = vfs_default_mmap_file,
-	.munmap  = vfs_default_munmap_file
+	.munmap  = vfs_default_munmap_file,
+	.readv   = vfs_default_readv,
+	.writev  = vfs_default_writev
 };
 
 KMEM_OBJATTR_INIT(ext2_kmem_file_init)
@@ -57,6 +57,9 @@ static inline error_t ext2_pgio_meta(struct ext2_context_s* ctx,
 	blkio->b_dev_rq.dst   = (void*)vaddr;
 	blkio->b_dev_rq.count = sectors_per_page;
 
+	if(flags & BLKIO_ASYNC)
+		return blkio_sync(page, flags | BLKIO_RELEASE);
+
 	err = blkio_sync(page,flags);
 	blkio_destroy(page);
 	return err;
@@ -350,7 +353,10 @@ MAPPER_READ_PAGE(ext2_node_read_page)
 	uint_t op_flags;
 	error_t err;
 
-	op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_RD | BLKIO_SYNC : BLKIO_RD;
+	if(flags & MAPPER_ASYNC_OP)
+		op_flags = BLKIO_RD | BLKIO_ASYNC;
+	else
+		op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_RD | BLKIO_SYNC : BLKIO_RD;
 
 	mapper = page->mapper;
 
@@ -251,6 +251,7 @@ error_t ext2_dir_init(struct vfs_node_s *parent, struct vfs_node_s *node)
 	entry->d_name[0]   = '.';
 	entry->d_name[1]   = '.';
 	entry->d_name[2]   = '\0';
+	mapper_put_page(page);
   
 	node->n_size = n_info->ctx->blk_size;
 	node->n_links ++;
@@ -312,6 +313,7 @@ error_t ext2_node_link(struct vfs_node_s *parent, struct vfs_node_s *node)
 		}
 
 		page_unlock(page);
+		mapper_put_page(page);
 	}
 
 	return ENOSPC;
@@ -337,6 +339,7 @@ found:
 		if((n_info->ctx->blk_size - (offset % n_info->ctx->blk_size)) < size)
 		{
 			page_unlock(page);
+			mapper_put_page(page);
 
 			printk(WARNING, "%s: unexpected directory format, dir %s, offset %d, size %d, pg %d\n",
 			       __FUNCTION__,
@@ -359,6 +362,7 @@ found:
   
 	p_info->flags |= EXT2_GF_DIRTY;
 	page_unlock(page);
+	mapper_put_page(page);
   
 	size = offset + (i * PMM_PAGE_SIZE);
 
@@ -697,6 +701,7 @@ VFS_LOOKUP_NODE(ext2_lookup_node)
 		}
 
 		page_unlock(page);
+		mapper_put_page(page);
 	}
 
 	return VFS_NOT_FOUND;
@@ -704,11 +709,16 @@ VFS_LOOKUP_NODE(ext2_lookup_node)
 found:
   
 	if((node->n_attr & VFS_DIR) && (entry->d_file_type != EXT2_FT_DIR))
+	{
+		page_unlock(page);
+		mapper_put_page(page);
 		return ENOTDIR;
+	}
 
 	n_info->ino = entry->d_inode;
 
 	page_unlock(page);
+	mapper_put_page(page);
 
 	err = ext2_node_read(parent,node);
   
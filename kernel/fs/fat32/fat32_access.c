@@ -80,6 +80,7 @@ error_t vfat_query_fat(struct vfat_context_s* ctx,
   data = (vfat_sector_t*) ppm_page2addr(page);
   data = (vfat_sector_t*)((uint8_t*) data + (cluster_offset % PMM_PAGE_SIZE));
   *next_cluster_index = *data & 0x0FFFFFFF;
+  mapper_put_page(page);
   
   vfat_dmsg(1, "%s: next cluster for %u is %u\n", __FUNCTION__, cluster_index, *next_cluster_index);
   return 0;
@@ -127,6 +128,9 @@ error_t vfat_alloc_fat_entry(struct vfat_context_s* ctx, vfat_cluster_t *new_clu
     {  
       vfat_dmsg(2, "%s: current page #%d, next page #%d\n", __FUNCTION__, old_page_id, page_id);
 
+      if(page != NULL)
+	mapper_put_page(page);
+
       page = mapper_get_page(mapper, page_id, MAPPER_SYNC_OP, NULL);
 
       if(page == NULL)
@@ -190,8 +194,8 @@ error_t vfat_alloc_fat_entry(struct vfat_context_s* ctx, vfat_cluster_t *new_clu
     old_page_id = page_id;
   }
 
-  //if(page)
-  // page_refcount_down(page);
+  if(page != NULL)
+    mapper_put_page(page);
 
  VFAT_ALLOC_CLUSTER_ERROR:
   rwlock_unlock(&ctx->lock);
@@ -246,7 +250,7 @@ error_t vfat_extend_cluster(struct vfat_context_s* ctx,
     vfat_dmsg(1,"%s: freeing %u\n", __FUNCTION__, *next_cluster);
 
     page_unlock(page);
-    //page_refcount_down(page);
+    mapper_put_page(page);
 
     lba = ctx->fat_begin_lba + ((*next_cluster *4) / sector_size);
 
@@ -267,6 +271,7 @@ error_t vfat_extend_cluster(struct vfat_context_s* ctx,
 
   page_unlock(page);
   vfat_dmsg(1,"%s: page #%d (@%x) is set to delayed write\n", __FUNCTION__, page->index, page);
+  mapper_put_page(page);
 
 
   vfat_dmsg(1,"%s: cluster %u's FAT entry is set to %u, FAT's sector %u is set as delayed write\n",
@@ -326,7 +331,7 @@ error_t vfat_free_fat_entry(struct vfat_context_s* ctx, vfat_cluster_t start_clu
     mapper->m_ops->set_page_dirty(page);
     page_unlock(page);
     vfat_dmsg(1,"%s: page #%d (@%x) is set to delayed write\n", __FUNCTION__, page->index, page);
-    //page_refcount_down(page);
+    mapper_put_page(page);
 
 #if VFAT_INSTRUMENT
     wr_count ++;
@@ -381,7 +386,7 @@ error_t vfat_locate_entry(struct vfat_entry_request_s *rq)
     {
       if(dir[entry].DIR_Name[0] == 0x00)
       {
-	//page_refcount_down(page);
+	mapper_put_page(page);
 	return VFS_NOT_FOUND;
       }
 
@@ -392,7 +397,10 @@ error_t vfat_locate_entry(struct vfat_entry_request_s *rq)
 	continue;
 
       if(rq->entry_name == NULL)
+      {
+	mapper_put_page(page);
 	return VFS_ENOTEMPTY;
+      }
 
       if(dir[entry].DIR_Attr == 0x0F)
 	continue;
@@ -419,12 +427,15 @@ error_t vfat_locate_entry(struct vfat_entry_request_s *rq)
       current_offset += sizeof (struct vfat_DirEntry_s);
     }
    
+    if(found)
+      break;
+
     entry_id++;
     current_page++;
-    //page_refcount_down(page);
+    mapper_put_page(page);
   }
   
-  //page_refcount_down(page);
+  mapper_put_page(page);
   vfat_dmsg(1,"%s: found %d, entry_index %d\n", __FUNCTION__, found, *rq->entry_index);
 
   return (found) ? VFS_FOUND : VFS_NOT_FOUND;
@@ -470,17 +481,26 @@ error_t vfat_cluster_lookup(struct vfat_context_s* ctx,
     vfat_dmsg(5,"%s: next cluster found %u\n",__FUNCTION__, next_cluster);
 
     if(next_cluster == 0x0FFFFFF7)  // bad block
+    {
+      mapper_put_page(page);
       return VFS_EBADBLK;
+    }
 
     if(next_cluster >= 0x0FFFFFF8)
     { 
       if(vfat_extend_cluster(ctx, current_vfat_cluster, &next_cluster))
+      {
 	// error while trying to extend
+	mapper_put_page(page);
 	return VFS_IO_ERR;
+      }
       
       if(next_cluster == 0)
+      {
 	// no more space for another cluster
+	mapper_put_page(page);
 	return VFS_ENOSPC;
+      }
       
       *extended = 1;
     }
@@ -491,7 +511,7 @@ error_t vfat_cluster_lookup(struct vfat_context_s* ctx,
 
     if(page_id != old_page_id)
     {
-      //page_refcount_down(page);
+      mapper_put_page(page);
       
       page = mapper_get_page(mapper, page_id, MAPPER_SYNC_OP, NULL);
       
@@ -507,7 +527,7 @@ error_t vfat_cluster_lookup(struct vfat_context_s* ctx,
   }
 
   vfat_dmsg(1, "%s: cluster found: %u\n", __FUNCTION__, current_vfat_cluster);
-  //page_refcount_down(page);
+  mapper_put_page(page);
   *cluster_index = current_vfat_cluster;
   return 0;
 }
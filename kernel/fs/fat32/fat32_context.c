@@ -89,6 +89,8 @@ static error_t vfat_context_init(struct vfat_context_s *ctx)
 		  bpb->BPB_Media,
 		  &bpb->BPB_Media);
 
+	mapper_put_page(page);
+
 	vfat_dmsg(1, "DEBUG: context_init: last allocated sector %d, last allocated index %d\n",
 		  ctx->last_allocated_sector, ctx->last_allocated_index);
 
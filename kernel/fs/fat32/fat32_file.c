@@ -171,6 +171,7 @@ VFS_READ_DIR(vfat_readdir)
 		buff += file->f_offset % PMM_PAGE_SIZE;
 
 		memcpy(&dir, buff, sizeof(dir));
+		mapper_put_page(page);
 
 		if(dir.DIR_Name[0] == 0x00) {
 			vfat_dmsg(3,"vfat_readdir: entries termination found (0x00)\n");
@@ -244,5 +245,7 @@ const struct vfs_file_op_s vfat_f_op =
 	.close   = vfat_close,
 	.release = vfat_release,
 	.mmap    = vfs_default_mmap_file,
-	.munmap  = vfs_default_munmap_file
+	.munmap  = vfs_default_munmap_file,
+	.readv   = vfs_default_readv,
+	.writev  = vfs_default_writev
 };
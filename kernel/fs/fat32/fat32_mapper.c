@@ -57,6 +57,9 @@ static inline error_t vfat_pgio_fat(struct vfat_context_s* ctx, struct page_s *p
 	blkio->b_dev_rq.dst   = (void*)vaddr;
 	blkio->b_dev_rq.count = sectors_per_page;
 
+	if(flags & BLKIO_ASYNC)
+		return blkio_sync(page, flags | BLKIO_RELEASE);
+
 	err = blkio_sync(page,flags);
 	blkio_destroy(page);
 	return err;
@@ -201,8 +204,14 @@ static inline error_t vfat_pgio_reg(struct vfat_file_s *file_info, struct page_s
 		}
 	}
 
+	if(flags & BLKIO_ASYNC)
+		flags |= BLKIO_RELEASE;
+
 	err = blkio_sync(page,flags);
-	blkio_destroy(page);
+
+	if(!(flags & BLKIO_ASYNC))
+		blkio_destroy(page);
+
 	file_info->pg_current_cluster = current_vfat_cluster;
 	file_info->pg_current_rank    = cluster_rank;
 
@@ -217,7 +226,10 @@ MAPPER_READ_PAGE(vfat_node_read_page)
 	struct vfat_file_s file_info;
 	uint_t op_flags;
 
-	op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_SYNC | BLKIO_RD : BLKIO_RD;
+	if(flags & MAPPER_ASYNC_OP)
+		op_flags = BLKIO_RD | BLKIO_ASYNC;
+	else
+		op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_SYNC | BLKIO_RD : BLKIO_RD;
 
 	mapper = page->mapper;
 
@@ -263,7 +275,10 @@ MAPPER_READ_PAGE(vfat_file_read_page)
 {
 	uint_t op_flags;
 
-	op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_SYNC | BLKIO_RD : BLKIO_RD;
+	if(flags & MAPPER_ASYNC_OP)
+		op_flags = BLKIO_RD | BLKIO_ASYNC;
+	else
+		op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_SYNC | BLKIO_RD : BLKIO_RD;
 	return vfat_pgio_reg(((struct vfs_file_s*)data)->f_pv, page, op_flags);
 }
 
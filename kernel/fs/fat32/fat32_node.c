@@ -227,6 +227,7 @@ VFS_CREATE_NODE(vfat_create_node)
 		}
     
 		page_unlock(page);
+		mapper_put_page(page);
 		current_page ++;
 	}
 
@@ -250,6 +251,7 @@ FREE_ENTRY_FOUND:
 			if(err)
 			{
 				page_unlock(page);
+				mapper_put_page(page);
 
 				if(tmp_page != NULL)
 				{
@@ -323,6 +325,7 @@ FREE_ENTRY_FOUND:
 
 			mapper->m_ops->set_page_dirty(page);
 			page_unlock(page);
+			mapper_put_page(page);
 			return 0;
 		}
  
@@ -331,6 +334,7 @@ FREE_ENTRY_FOUND:
 
 	mapper->m_ops->set_page_dirty(page);
 	page_unlock(page);
+	mapper_put_page(page);
 	return 0;
 
 VFAT_CREATE_NODE_ERR:
@@ -506,6 +510,7 @@ VFS_WRITE_NODE(vfat_write_node)
 
 	mapper->m_ops->set_page_dirty(page);
 	page_unlock(page);
+	mapper_put_page(page);
 
 #if VFAT_INSTRUMENT
 	wr_count ++;
@@ -586,6 +591,7 @@ VFS_UNLINK_NODE(vfat_unlink_node)
 
 		if(temp_page == NULL)
 		{
+			mapper_put_page(page);
 			val = entry_index_page + 1;
 			err = VFS_IO_ERR;
 			goto UNLINK_IOERR;
@@ -604,6 +610,7 @@ VFS_UNLINK_NODE(vfat_unlink_node)
 		mapper->m_ops->set_page_dirty(page);
 		page_unlock(page);
 		page_unlock(temp_page);
+		mapper_put_page(temp_page);
 	} 
 	else 
 	{
@@ -614,6 +621,8 @@ VFS_UNLINK_NODE(vfat_unlink_node)
 		page_unlock(page);
 	}
 
+	mapper_put_page(page);
+
 #if VFAT_INSTRUMENT
 	wr_count ++;
 #endif
@@ -31,14 +31,28 @@
 #include <atomic.h>
 #include <cluster.h>
 #include <page.h>
+#include <mapper.h>
 #include <blkio.h>
 
+static void blkio_async_end(struct page_s *page, struct blkio_s *info)
+{
+	error_t err;
+
+	err = (info->b_ctrl.error) ? EIO : 0;
+
+	if(info->b_ctrl.flags & BLKIO_RELEASE)
+		blkio_destroy(page);
+
+	mapper_io_end(page, err);
+}
+
 static EVENT_HANDLER(blkio_async)
 {
 	struct blkio_s *blkio;
 	struct blkio_s *info;
 	struct page_s *page;
 	struct thread_s *thread;
+	bool_t isEnded;
 	error_t err;
 	uint_t irq_state;
 
@@ -54,14 +68,17 @@ static EVENT_HANDLER(blkio_async)
 		       blkio->b_dev_rq.src);
 	}
 
-	err = (err) ? 1 : 0;
+	err     = (err) ? 1 : 0;
+	isEnded = false;
 
 	spinlock_lock_noirq(&info->b_ctrl.lock, &irq_state);
 
 	info->b_ctrl.cntr ++;
 	info->b_ctrl.error = (info->b_ctrl.error) ? 1 : err;
 
-	if(info->b_ctrl.cntr == info->b_ctrl.count) 
+	if((info->b_ctrl.cntr == info->b_ctrl.count) && (info->b_ctrl.flags & BLKIO_ASYNC))
+		isEnded = true;
+	else if(info->b_ctrl.cntr == info->b_ctrl.count) 
 	{
 		thread = wakeup_one(&info->b_ctrl.wait, WAIT_ANY);
 
@@ -79,6 +96,10 @@ static EVENT_HANDLER(blkio_async)
 	}
 
 	spinlock_unlock_noirq(&info->b_ctrl.lock, irq_state);
+
+	if(isEnded)
+		blkio_async_end(page, info);
+
 	return 0;
 }
 
@@ -150,6 +171,7 @@ error_t blkio_init(struct device_s *dev, struct page_s *page, uint_t count)
 	blkio->b_ctrl.count = blkio_nr;
 	blkio->b_ctrl.cntr  = 0;
 	blkio->b_ctrl.error = 0;
+	blkio->b_ctrl.flags = 0;
 
 	PAGE_SET(page, PG_BUFFER);
 	return 0;
@@ -164,12 +186,20 @@ error_t blkio_sync(struct page_s *page, uint_t flags)
 	error_t err;
 	uint_t irq_state;
 	uint_t cntr;
+	bool_t isEnded;
 
 	info = list_head(&page->root, struct blkio_s, b_list);
 	handler = (flags & BLKIO_RD) ? info->b_dev->op.dev.read : info->b_dev->op.dev.write;
 	cntr =  0;
 	err =  0;
 
+	/* Blkios may be kept attached to the page across several syncs */
+	spinlock_lock_noirq(&info->b_ctrl.lock, &irq_state);
+	info->b_ctrl.cntr  = 0;
+	info->b_ctrl.error = 0;
+	info->b_ctrl.flags = flags & (BLKIO_ASYNC | BLKIO_RELEASE);
+	spinlock_unlock_noirq(&info->b_ctrl.lock, irq_state);
+
 	list_foreach(&page->root, iter) 
 	{
 		blkio = list_element(iter, struct blkio_s, b_list);
@@ -203,6 +233,25 @@ error_t blkio_sync(struct page_s *page, uint_t flags)
 		cntr ++;
 	}
 
+	if(flags & BLKIO_ASYNC)
+	{
+		spinlock_lock_noirq(&info->b_ctrl.lock, &irq_state);
+
+		/* Only the one making cntr reach count ends the I/O */
+		isEnded = ((cntr != info->b_ctrl.count) && 
+			   ((info->b_ctrl.cntr + info->b_ctrl.count - cntr) == info->b_ctrl.count));
+
+		info->b_ctrl.cntr += (info->b_ctrl.count - cntr);
+		info->b_ctrl.error = (err) ? 1 : info->b_ctrl.error;
+
+		spinlock_unlock_noirq(&info->b_ctrl.lock, irq_state);
+
+		if(isEnded)
+			blkio_async_end(page, info);
+
+		return EINPROGRESS;
+	}
+
 	if(flags & BLKIO_SYNC) 
 	{
 		spinlock_lock_noirq(&info->b_ctrl.lock, &irq_state);
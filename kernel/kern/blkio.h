@@ -27,6 +27,8 @@
 
 #define BLKIO_RD        0x01
 #define BLKIO_SYNC      0x02
+#define BLKIO_ASYNC     0x04   /* completion is reported by mapper_io_end */
+#define BLKIO_RELEASE   0x08   /* destroy blkios once an async I/O is ended */
 
 #define BLKIO_INIT      0x01
 
@@ -43,6 +45,7 @@ struct blkio_s
 		uint16_t            count;	
 		uint16_t            cntr;	        
 		error_t             error;	
+		uint_t              flags;          // BLKIO_ASYNC, BLKIO_RELEASE
 		struct wait_queue_s wait;
 
 	}                     b_ctrl;         // Only used in head-blkio
@@ -79,6 +82,9 @@ error_t blkio_init(struct device_s *dev, struct page_s *page, uint_t count);
 
 /**
  * Synchronizes all the buffers in a buffer page.
+ * With BLKIO_ASYNC, requests are only submitted and EINPROGRESS
+ * is returned: the last completion calls mapper_io_end, and destroys
+ * the page's blkios first if BLKIO_RELEASE is set.
  *
  * @page	buffer page to be synced with the disk
  * @flags	blkio flags
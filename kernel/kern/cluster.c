@@ -37,6 +37,7 @@
 #include <kmem.h>
 #include <task.h>
 #include <dqdt.h>
+#include <utime.h>
 
 struct cluster_entry_s clusters_tbl[CLUSTER_NR];
 
@@ -140,6 +141,12 @@ error_t cluster_init(struct boot_info_s *info,
 		 0, 1, 1, NULL, NULL, 
 		 &kcm_page_alloc, &kcm_page_free);
 
+	if(utime_cluster_init(cluster))
+	{
+		boot_dmsg("%s: cid %d, failed to allocate time page\n", __FUNCTION__, cid);
+		return ENOMEM;
+	}
+
 	sprintk(cluster->name,
 #if CONFIG_ROOTFS_IS_VFAT
 		"CID%d"
@@ -50,6 +50,7 @@ struct task_s;
 struct thread_s;
 struct heap_manager_s;
 struct dqdt_cluster_s;
+struct utime_page_s;
 
 struct cluster_s
 {
@@ -106,6 +107,10 @@ struct cluster_s
 	/* Kernel Task */
 	struct task_s *task;
 
+	/* User readable time page */
+	struct page_s *utime_pg;
+	struct utime_page_s *utime;
+
 	/* Manger Thread */
 	struct thread_s *manager;
   
@@ -32,8 +32,10 @@
 #include <cpu-trace.h>
 #include <sysfs.h>
 #include <dqdt.h>
+#include <utime.h>
 
 static void cpu_sysfs_op_init(sysfs_op_t *op);
+static void cpu_timer_sysfs_op_init(sysfs_op_t *op);
 
 error_t cpu_init(struct cpu_s *cpu, struct cluster_s *cluster, uint_t lid, uint_t gid)
 {
@@ -55,6 +57,9 @@ error_t cpu_init(struct cpu_s *cpu, struct cluster_s *cluster, uint_t lid, uint_
 	cpu->time.cycles       = 0;
 	cpu->time.ticks_nr     = 0;
 	cpu->time.ticks_period = CPU_CLOCK_TICK;
+	cpu->time.next_shot    = CPU_CLOCK_TICK;
+	cpu->time.tickless     = false;
+	cpu->time.idle_stamp   = 0;
 	cpu->ticks_count       = 0;
 	cpu->usage             = 0;
 	cpu->busy_percent      = 0;
@@ -79,6 +84,18 @@ error_t cpu_init(struct cpu_s *cpu, struct cluster_s *cluster, uint_t lid, uint_
 	sysfs_entry_init(&cpu->node, &op, cpu->name);
 	sysfs_entry_register(&cluster->node, &cpu->node);
 
+	sprintk(cpu->tm_name,
+#if CONFIG_ROOTFS_IS_VFAT
+		"TMR%d"
+#else
+		"tmr%d"
+#endif
+		,lid);
+
+	cpu_timer_sysfs_op_init(&op);
+	sysfs_entry_init(&cpu->tm_node, &op, cpu->tm_name);
+	sysfs_entry_register(&cluster->node, &cpu->tm_node);
+
 	cpu->prng_A = 65519;
 	cpu->prng_C = 64037 & 0xFFFFFFFB;
 	srand(cpu_time_stamp() & 0xFFF);
@@ -128,7 +145,7 @@ void cpu_compute_stats(struct cpu_s *cpu, sint_t threshold)
 	idle->ticks_nr   = 0;
 }
 
-static void cpu_time_update(struct cpu_s *cpu)
+static uint_t cpu_time_update(struct cpu_s *cpu)
 {
 	uint64_t cycles;
 	uint_t ticks_nr;
@@ -161,6 +178,9 @@ static void cpu_time_update(struct cpu_s *cpu)
 	cpu->time.cycles    = cycles;
 	cpu->time.ticks_nr += ticks_nr;
 	cpu->ticks_count   += ticks_nr;
+
+	utime_cpu_update(cpu);
+	return ticks_nr;
 }
 
 void cpu_time_reset(struct cpu_s *cpu)
@@ -173,12 +193,73 @@ void cpu_time_reset(struct cpu_s *cpu)
 	cpu_wbflush();
 }
 
+/* Account suppressed ticks to idle thread and go back to periodic mode */
+static void cpu_tickless_stop(struct cpu_s *cpu, bool_t isClock)
+{
+	register uint_t skipped;
+
+	skipped = (cpu_get_cycles(cpu) - cpu->time.idle_stamp) / cpu_get_ticks_period(cpu);
+
+	/* The clock itself is accounted by sched_clock */
+	if(isClock && (skipped != 0))
+		skipped --;
+
+	cpu_get_thread_idle(cpu)->ticks_nr += skipped;
+	cpu->alarm_mgr.stats.skipped_nr    += skipped;
+	cpu->time.next_shot                 = cpu_get_ticks_period(cpu);
+	cpu->time.tickless                  = false;
+}
+
+void cpu_idle_enter(struct cpu_s *cpu)
+{
+#if CONFIG_CPU_TICKLESS_IDLE
+	register uint_t ticks;
+
+	/* BSCPU keeps ticking as it drives cluster's DQDT updates */
+	if((cpu->time.tickless) || (cpu == cpu->cluster->bscpu))
+		return;
+
+	ticks = alarm_next_expiry(&cpu->alarm_mgr, 
+				  cpu_get_ticks(cpu), 
+				  CONFIG_CPU_TICKLESS_MAX_TICKS);
+
+	if(ticks <= 1)
+		return;
+
+	cpu->time.idle_stamp = cpu_get_cycles(cpu);
+	cpu->time.next_shot  = ticks * cpu_get_ticks_period(cpu);
+	cpu->time.tickless   = true;
+
+	if(arch_cpu_set_timer(cpu, cpu->time.next_shot))
+	{
+		cpu->time.next_shot = cpu_get_ticks_period(cpu);
+		cpu->time.tickless  = false;
+		return;
+	}
+
+	cpu->alarm_mgr.stats.oneshot_nr ++;
+#endif	/* CONFIG_CPU_TICKLESS_IDLE */
+}
+
+void cpu_idle_leave(struct cpu_s *cpu)
+{
+	if(!(cpu->time.tickless))
+		return;
+
+	cpu_tickless_stop(cpu, false);
+	(void)arch_cpu_set_timer(cpu, cpu->time.next_shot);
+}
+
 void cpu_clock(struct cpu_s *cpu)
 {
 	register uint_t ticks;
 
 	cpu_time_update(cpu);
 
+	/* Timer will be rearmed by caller with the restored period */
+	if(cpu->time.tickless)
+		cpu_tickless_stop(cpu, true);
+
 	ticks = cpu_get_ticks(cpu);
 	alarm_clock(&cpu->alarm_mgr, ticks);
 	sched_clock(current_thread, ticks);
@@ -255,3 +336,46 @@ static void cpu_sysfs_op_init(sysfs_op_t *op)
 	op->write = NULL;
 	op->close = NULL;
 }
+
+static error_t cpu_timer_sysfs_read_op(sysfs_entry_t *entry, sysfs_request_t *rq, uint_t *offset)
+{
+	register struct cpu_s *cpu;
+	register struct alarm_stats_s *stats;
+
+	if(*offset != 0)
+	{
+		*offset = 0;
+		rq->count = 0;
+		return 0;
+	}
+
+	cpu   = sysfs_container(entry, struct cpu_s, tm_node);
+	stats = &cpu->alarm_mgr.stats;
+
+	sprintk((char*)rq->buffer, 
+		"%s\n\tAlarms\n\t\tPending %d\n\t\tInserted %u\n\t\tCanceled %u\n"
+		"\t\tExpired %u\n\t\tCascaded %u\n\tTickless %s\n\t\tOne-Shots %u\n"
+		"\t\tSuppressed-Ticks %u\n",
+		cpu->tm_name,
+		cpu->alarm_mgr.pending_nr,
+		stats->insert_nr,
+		stats->cancel_nr,
+		stats->expire_nr,
+		stats->cascade_nr,
+		(CONFIG_CPU_TICKLESS_IDLE) ? "on" : "off",
+		stats->oneshot_nr,
+		stats->skipped_nr);
+
+	rq->count = strlen((const char*)rq->buffer);
+	*offset   = 0;
+
+	return 0;
+}
+
+static void cpu_timer_sysfs_op_init(sysfs_op_t *op)
+{
+	op->open  = NULL;
+	op->read  = cpu_timer_sysfs_read_op;
+	op->write = NULL;
+	op->close = NULL;
+}
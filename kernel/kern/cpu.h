@@ -52,6 +52,9 @@ struct cpu_time_s
 	uint_t tmstmp;
 	uint_t ticks_nr;
 	uint_t ticks_period;  
+	uint_t next_shot;
+	bool_t tickless;
+	uint64_t idle_stamp;
 };
 
 struct cpu_s
@@ -108,6 +111,8 @@ struct cpu_s
 	/* Sysfs informations */
 	char name[SYSFS_NAME_LEN];
 	sysfs_entry_t node;
+	char tm_name[SYSFS_NAME_LEN];
+	sysfs_entry_t tm_node;
 };
 
 /** Initialize CPU object */
@@ -123,6 +128,12 @@ void cpu_time_reset(struct cpu_s *cpu);
 void cpu_clock(struct cpu_s *cpu);
 void cpu_ipi_notify(struct cpu_s *cpu);
 
+/** Suppress periodic ticks until next alarm, called by idle thread with IRQs disabled */
+void cpu_idle_enter(struct cpu_s *cpu);
+
+/** Restore periodic ticks, called by idle thread with IRQs disabled */
+void cpu_idle_leave(struct cpu_s *cpu);
+
 /** Set CPU idle thread */
 #define cpu_set_thread_idle(cpu,idle)
 
@@ -141,6 +152,9 @@ void cpu_ipi_notify(struct cpu_s *cpu);
 /** Get CPU ticks period */
 #define cpu_get_ticks_period(cpu)
 
+/** Get CPU next timer shot in cycles */
+#define cpu_get_next_shot(cpu)
+
 /** Get CPU current cycles number */
 static inline uint64_t cpu_get_cycles(struct cpu_s *cpu);
 
@@ -175,6 +189,9 @@ struct cpu_s* cpu_gid2ptr(uint_t gid);
 #undef cpu_get_ticks_period
 #define cpu_get_ticks_period(_cpu)    ((_cpu)->time.ticks_period)
 
+#undef cpu_get_next_shot
+#define cpu_get_next_shot(_cpu)       ((_cpu)->time.next_shot)
+
 static inline uint64_t cpu_get_cycles(struct cpu_s *cpu)
 {
 	uint64_t cycles;
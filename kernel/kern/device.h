@@ -67,6 +67,7 @@ struct device_s
 
 /* TODO: put this devices into a dedicated device tables */
 extern struct device_s *__sys_blk;
+extern struct device_s *__swap_blk;
 extern struct device_s *__sys_dma;
 extern struct device_s *ttys_tbl[];
 /* ----------------------------------------------------- */
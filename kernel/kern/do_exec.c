@@ -39,6 +39,7 @@
 #include <spinlock.h>
 #include <cluster.h>
 #include <dqdt.h>
+#include <utime.h>
 
 #define USR_LIMIT  (CONFIG_USR_LIMIT)
 
@@ -348,6 +349,13 @@ error_t do_exec(struct task_s *task,
 
 	task->vmm.heap_current += TASK_DEFAULT_HEAP_SIZE;
 
+	if((err = utime_task_map(task)))
+	{
+		printk(INFO, "INFO: %s: failed to map time pages, [pid %d, err %d]\n", 
+		       __FUNCTION__, task->pid, err);
+		goto DO_EXEC_ERR;
+	}
+
 	attr.flags = (current_thread->info.attr.flags | PT_ATTR_DETACH);
 	attr.sched_policy = SCHED_RR;
 	attr.cid = task->cluster->id;
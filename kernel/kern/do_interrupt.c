@@ -27,6 +27,8 @@
 #include <device.h>
 #include <system.h>
 #include <signal.h>
+#include <cluster.h>
+#include <vmm.h>
 
 #define irq_cpu_dmsg(c,...)				\
 	do{						\
@@ -97,6 +99,15 @@ void do_interrupt(struct thread_s *this, uint_t irq_num)
 
 		thread_set_cap_migrate(this);
 	}
+
+#if CONFIG_NUMA_BALANCING
+	if(vmm_numa_scan_isPending(&this->task->vmm))
+	{
+		cpu_enable_all_irq(&irq_state);
+		vmm_numa_scan(&this->task->vmm);
+		cpu_restore_irq(irq_state);
+	}
+#endif
 	
 	if(isYield || (thread_sched_isActivated(this)))
 	{
@@ -39,6 +39,7 @@
 #include <vmm.h>
 #include <signal.h>
 #include <page.h>
+#include <sysring.h>
 
 static int sys_notAvailable()
 {
@@ -93,9 +94,20 @@ static const sys_func_t sys_call_tbl[__SYS_CALL_SERVICES_NUM] = {
 	sys_mcntl,
 	sys_stat,
 	sys_thread_migrate,
-	sys_sbrk
+	sys_sbrk,
+	sys_readv,
+	sys_writev,
+	sys_pread,
+	sys_pwrite,
+	sys_sysring,
+	sys_aio
 };
 
+int do_syscall_service(uint_t service_num, reg_t arg0, reg_t arg1, reg_t arg2, reg_t arg3)
+{
+	return sys_call_tbl[service_num] (arg0,arg1,arg2,arg3);
+}
+
 reg_t do_syscall (reg_t arg0,
 		  reg_t arg1,
 		  reg_t arg2,
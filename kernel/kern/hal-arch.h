@@ -71,6 +71,9 @@ error_t arch_cpu_set_irq_entry(struct cpu_s *cpu, int irq_nr, struct irq_action_
 error_t arch_cpu_get_irq_entry(struct cpu_s *cpu, int irq_nr, struct irq_action_s **action);
 error_t arch_cpu_send_ipi(struct cpu_s *target);
 
+/* Program current CPU timer to fire once after given cycles number */
+error_t arch_cpu_set_timer(struct cpu_s *cpu, uint_t cycles);
+
 /* Specific architecture-dependent DQDT macros & functions */
 #define DQDT_DIST_NOTSET     0	/* must be zero (c.f: see dqdt_attr_init in kern/dqdt.h) */
 #define DQDT_DIST_DEFAULT    1
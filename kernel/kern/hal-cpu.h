@@ -100,6 +100,8 @@ static inline void cpu_fpu_enable(void);
 
 static inline void cpu_fpu_disable(void);
 
+static inline bool_t cpu_usr_counters_enable(void);
+
 static inline uint_t cpu_get_stack(void);
 
 static inline uint_t cpu_set_stack(void* new_val);
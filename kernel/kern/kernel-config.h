@@ -62,6 +62,13 @@
 #define CONFIG_KERNEL_REPLICATE          yes
 #define CONFIG_USE_COA                   yes
 #define CONFIG_MAPPER_AUTO_MGRT          yes
+#define CONFIG_NUMA_BALANCING            yes
+#define CONFIG_NUMA_SCAN_PERIOD          16
+#define CONFIG_NUMA_SCAN_PAGES           64
+#define CONFIG_NUMA_MGRT_THRESHOLD       2
+#define CONFIG_NUMA_HOME_THRESHOLD       8
+#define CONFIG_PPM_RECLAIM               yes
+#define CONFIG_SWAP                      yes
 #define CONFIG_FORK_LOCAL_ALLOC          no
 #define CONFIG_USE_SCHED_LOCKS           no
 #define CONFIG_REMOTE_FORK               yes
@@ -81,6 +88,10 @@
 #define CONFIG_DQDT_WAIT_FOR_UPDATE      no
 #define CONFIG_CPU_BALANCING_PERIOD      4
 #define CONFIG_CPU_LOAD_PERIOD           4
+#define CONFIG_CPU_TICKLESS_IDLE         yes
+#define CONFIG_CPU_TICKLESS_MAX_TICKS    64
+#define CONFIG_UTIME_PAGE                yes
+#define CONFIG_UTIME_USR_CYCLES          yes
 #define CONFIG_CLUSTER_KEYS_NR           8
 #define CONFIG_REL_KFIFO_SIZE            32
 #define CONFIG_VFS_NODES_PER_CLUSTER     128
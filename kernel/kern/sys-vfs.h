@@ -37,6 +37,11 @@ int sys_write (uint_t fd, void *buf, size_t count);
 int sys_lseek (uint_t fd, off_t offset, int whence);
 int sys_unlink (char *pathname);
 int sys_close (uint_t fd);
+int sys_readv (uint_t fd, struct vfs_iovec_s *iov, uint_t iovcnt);
+int sys_writev (uint_t fd, struct vfs_iovec_s *iov, uint_t iovcnt);
+int sys_pread (uint_t fd, void *buf, size_t count, uint_t offset);
+int sys_pwrite (uint_t fd, void *buf, size_t count, uint_t offset);
+int sys_aio (uint_t operation, void *arg0, uint_t arg1, uint_t arg2);
 
 /* Directories related system call */
 int sys_opendir (char *pathname);
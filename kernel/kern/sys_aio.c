@@ -0,0 +1,76 @@
+/*
+ * kern/sys_aio.c - asynchronous file I/O
+ * 
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+#include <errno.h>
+#include <thread.h>
+#include <vfs.h>
+#include <sys-vfs.h>
+
+/*
+ * VFS_AIO_SUBMIT (aiocb)           : queue the request, returns 0
+ * VFS_AIO_POLL   (aiocb)           : returns 0 if completed, EINPROGRESS otherwise
+ * VFS_AIO_WAIT   (list, nr, min)   : returns the number of completed requests
+ * VFS_AIO_CANCEL (aiocb)           : returns 0, or -1 with ENOENT if not pending
+ */
+int sys_aio (uint_t operation, void *arg0, uint_t arg1, uint_t arg2)
+{
+	struct thread_s *this;
+	uint_t done;
+	error_t err;
+
+	this = current_thread;
+
+	switch(operation)
+	{
+	case VFS_AIO_SUBMIT:
+		err = vfs_aio_submit(arg0);
+		break;
+
+	case VFS_AIO_POLL:
+		err = vfs_aio_poll(arg0);
+
+		if((err == 0) || (err == EINPROGRESS))
+			return err;
+		break;
+
+	case VFS_AIO_WAIT:
+		if((err = vfs_aio_wait(arg0, arg1, arg2, &done)) == 0)
+			return done;
+		break;
+
+	case VFS_AIO_CANCEL:
+		err = vfs_aio_cancel(arg0);
+		break;
+
+	default:
+		err = EINVAL;
+	}
+
+	if(err)
+	{
+		this->info.errno = err;
+		return -1;
+	}
+
+	return 0;
+}
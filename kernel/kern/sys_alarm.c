@@ -55,6 +55,9 @@ int sys_alarm (unsigned nb_sec)
 
 	alarm_wait(&info, nb_sec * 4);
 	sched_sleep(this);
+
+	/* Woken up before expiry, alarm must not outlive this frame */
+	(void)alarm_cancel(&info);
 	return 0;
 }
 
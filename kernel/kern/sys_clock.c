@@ -23,8 +23,11 @@
 #include <errno.h>
 #include <cpu.h>
 #include <thread.h>
+#include <cluster.h>
+#include <time.h>
+#include <utime.h>
 
-int sys_clock(uint64_t *val)
+int sys_clock(uint64_t *val, uint_t clock_id)
 {
 	error_t err;
 	uint64_t cycles;
@@ -35,8 +38,29 @@ int sys_clock(uint64_t *val)
 		goto fail_inval;
 	}
 
-	cycles = cpu_get_cycles(current_cpu);
-	err    = cpu_uspace_copy(val, &cycles, sizeof(cycles));
+	switch(clock_id)
+	{
+	case UTIME_CLOCK_CYCLES:
+		cycles = cpu_get_cycles(current_cpu);
+		break;
+
+#if CONFIG_THREAD_TIME_STAT
+	case UTIME_CLOCK_THREAD:
+		tm_sys_compute(current_thread);
+		cycles = current_thread->info.tm_usr + current_thread->info.tm_sys;
+		break;
+#endif
+
+	case UTIME_CLOCK_PAGE:
+		cycles = (current_cluster->utime != NULL) ? UTIME_USR_BASE : 0;
+		break;
+
+	default:
+		err = EINVAL;
+		goto fail_inval;
+	}
+
+	err = cpu_uspace_copy(val, &cycles, sizeof(cycles));
 
 fail_inval:
 	current_thread->info.errno = err;
@@ -31,7 +31,9 @@
 #include <kcm.h>
 #include <thread.h>
 #include <cluster.h>
-#include <kcm.h>
+#include <task.h>
+#include <vmm.h>
+#include <page.h>
 
 
 KMEM_OBJATTR_INIT(dma_kmem_request_init)
@@ -113,7 +115,71 @@ error_t dma_memcpy(void *dst, void *src, size_t size, uint_t isAsync)
 }
 
 
+/* 
+ * User buffers are copied page by page: both pages are faulted in
+ * and referenced first, the destination one being checked for write
+ * (COW is broken), so the engine only writes where the task may.
+ */
 int sys_dma_memcpy(void *src, void *dst, size_t size)
 {
-	return dma_do_sync_request(dst, src, size);
+	struct thread_s *this;
+	struct vmm_s *vmm;
+	struct page_s *src_pg;
+	struct page_s *dst_pg;
+	kmem_req_t req;
+	uint_t src_addr;
+	uint_t dst_addr;
+	uint_t count;
+	error_t err;
+
+	this     = current_thread;
+	vmm      = &this->task->vmm;
+	src_addr = (uint_t)src;
+	dst_addr = (uint_t)dst;
+	req.type = KMEM_PAGE;
+	err      = 0;
+
+	if((size == 0)                                         ||
+	   (size > (CONFIG_KERNEL_OFFSET - src_addr))          ||
+	   (size > (CONFIG_KERNEL_OFFSET - dst_addr)))
+	{
+		err = EINVAL;
+		goto fail_args;
+	}
+
+	while(size)
+	{
+		count = PMM_PAGE_SIZE - (src_addr & PMM_PAGE_MASK);
+		count = MIN(count, PMM_PAGE_SIZE - (dst_addr & PMM_PAGE_MASK));
+		count = MIN(count, size);
+
+		if((err = vmm_get_user_page(vmm, src_addr, false, &src_pg)))
+			break;
+
+		if((err = vmm_get_user_page(vmm, dst_addr, true, &dst_pg)) == 0)
+		{
+			err = dma_do_sync_request((void*)dst_addr, (void*)src_addr, count);
+
+			req.ptr = dst_pg;
+			kmem_free(&req);
+		}
+
+		req.ptr = src_pg;
+		kmem_free(&req);
+
+		if(err) break;
+
+		src_addr += count;
+		dst_addr += count;
+		size     -= count;
+	}
+
+fail_args:
+	if(err)
+	{
+		this->info.errno = err;
+		return -1;
+	}
+
+	return 0;
 }
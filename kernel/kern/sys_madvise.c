@@ -61,12 +61,13 @@ static error_t check_args(struct vmm_s *vmm, uint_t start, uint_t len, struct vm
 
 
 /* TODO: compute other advices */
-int sys_madvise(void *start, size_t length, uint_t advice)
+int sys_madvise(void *start, size_t length, uint_t advice, mpol_attr_t *mpol)
 {
 	error_t err;
 	struct vmm_s *vmm;
 	struct vm_region_s *region;
 	struct thread_s *this;
+	mpol_attr_t attr;
 
 	err = 0;
 	this = current_thread;
@@ -87,6 +88,32 @@ int sys_madvise(void *start, size_t length, uint_t advice)
 	err = check_args(vmm, (uint_t)start, length, &region);
   
 	if(err) goto SYS_MADVISE_ERR;
+
+	/* The policy applies to the whole region as regions cannot be split */
+	if(advice == MADV_MPOL)
+	{
+		if((region == NULL)                         || 
+		   ((uint_t)start < region->vm_start)       || 
+		   ((uint_t)start >= region->vm_limit)      || 
+		   (region->vm_flags & VM_REG_DEV)          ||
+		   (mpol == NULL))
+		{
+			err = EINVAL;
+			goto SYS_MADVISE_ERR;
+		}
+
+		if(((uint_t)mpol + sizeof(*mpol)) >= CONFIG_KERNEL_OFFSET)
+		{
+			err = EPERM;
+			goto SYS_MADVISE_ERR;
+		}
+
+		if((err = cpu_uspace_copy(&attr, mpol, sizeof(attr))))
+			goto SYS_MADVISE_ERR;
+
+		err = vm_region_set_mpol(region, attr.mode, &attr.mask[0]);
+		goto SYS_MADVISE_ERR;
+	}
   
 	if((region->vm_flags & VM_REG_DEV) || (region->vm_flags & VM_REG_SHARED))
 		return 0;
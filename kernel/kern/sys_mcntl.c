@@ -31,20 +31,54 @@
 #include <thread.h>
 #include <page.h>
 
-/* TODO: implement the MCNTL_MOVE operation */
-int sys_mcntl(int op, uint_t vaddr, size_t len, minfo_t *pinfo)
+#define MCNTL_CHUNK  16
+
+static void mcntl_page_info(uint_t vaddr, minfo_t *info)
 {
-	minfo_t uinfo;
-	pmm_page_info_t info;
+	pmm_page_info_t pinfo;
 	struct ppm_s *ppm;
 	struct cluster_s *cluster;
 	error_t err;
 
-#if 0
-	err = cpu_uspace_copy(&uinfo, pinfo, sizeof(*pinfo));
+	info->mi_cid = MCNTL_CID_NONE;
+	info->mi_cx  = 0;
+	info->mi_cy  = 0;
+	info->mi_cz  = 0;
+
+	err = pmm_get_page(&current_task->vmm.pmm, vaddr, &pinfo);
+
+	/* The ppn of a swap entry is a swap slot */
+	if(err || (pinfo.ppn == 0) || (pinfo.attr & PMM_SWAP)) 
+		return;
+
+	ppm = pmm_ppn2ppm(pinfo.ppn);
+
+	if(ppm->signature != PPM_ID)
+		return;
 
-	if(err) goto SYS_MCNTL_ERR;
-#endif
+	cluster = ppm_get_cluster(ppm);
+
+	info->mi_cid = cluster->id;
+	info->mi_cx  = cluster->x_coord;
+	info->mi_cy  = cluster->y_coord;
+	info->mi_cz  = cluster->z_coord;
+}
+
+/* 
+ * MCNTL_READ fills pinfo[i] with the cluster holding the page vaddr + i * PMM_PAGE_SIZE,
+ * MCNTL_MOVE moves each page to cluster pinfo[i].mi_cid and fills pinfo[i] with the
+ * cluster holding it afterwards, so the caller sees which pages could not be moved.
+ * Pages without physical memory are reported with mi_cid set to MCNTL_CID_NONE.
+ */
+int sys_mcntl(int op, uint_t vaddr, size_t len, minfo_t *pinfo)
+{
+	minfo_t uinfo[MCNTL_CHUNK];
+	struct cluster_s *cluster;
+	struct vmm_s *vmm;
+	uint_t count;
+	uint_t i;
+	bool_t isSingle;
+	error_t err;
 
 	if(op == MCNTL_L1_iFLUSH)
 	{
@@ -59,50 +93,64 @@ int sys_mcntl(int op, uint_t vaddr, size_t len, minfo_t *pinfo)
 	}
 
 	vaddr = ARROUND_DOWN(vaddr, PMM_PAGE_SIZE);
+	len   = (len == 0) ? 1 : len;
 
-	if((((uint_t)vaddr + (len * PMM_PAGE_SIZE)) >= CONFIG_KERNEL_OFFSET) || 
-	   (((uint_t)pinfo + sizeof(*pinfo)) >= CONFIG_KERNEL_OFFSET))
+	if((vaddr >= CONFIG_KERNEL_OFFSET)                                    ||
+	   (len > ((CONFIG_KERNEL_OFFSET - vaddr) >> PMM_PAGE_SHIFT))         ||
+	   ((uint_t)pinfo >= CONFIG_KERNEL_OFFSET)                            ||
+	   (len > ((CONFIG_KERNEL_OFFSET - (uint_t)pinfo) / sizeof(*pinfo))))
 	{
 		err = EACCES;
 		goto SYS_MCNTL_ERR;
 	}
 
-	err = pmm_get_page(&current_task->vmm.pmm, vaddr, &info);
+	vmm      = &current_task->vmm;
+	isSingle = (len == 1);
 
-	if(err) goto SYS_MCNTL_ERR;
+	while(len != 0)
+	{
+		count = (len > MCNTL_CHUNK) ? MCNTL_CHUNK : len;
 
-	ppm = pmm_ppn2ppm(info.ppn);
+		if(op == MCNTL_MOVE)
+		{
+			err = cpu_uspace_copy(&uinfo[0], pinfo, count * sizeof(*pinfo));
 
-	if(ppm->signature != PPM_ID)
-	{
-		err = EIO;
-		goto SYS_MCNTL_ERR;
-	}
+			if(err) goto SYS_MCNTL_ERR;
+		}
 
-	cluster = ppm_get_cluster(ppm);
+		for(i = 0; i < count; i++, vaddr += PMM_PAGE_SIZE)
+		{
+			if(op == MCNTL_MOVE)
+			{
+				if(uinfo[i].mi_cid >= CLUSTER_NR)
+				{
+					err = EINVAL;
+					goto SYS_MCNTL_ERR;
+				}
 
-	uinfo.mi_cid = cluster->id;
-	uinfo.mi_cx  = cluster->x_coord;
-	uinfo.mi_cy  = cluster->y_coord;
-	uinfo.mi_cz  = cluster->z_coord;
+				cluster = cluster_cid2ptr(uinfo[i].mi_cid);
 
-	printk(INFO, "%s: cid %d, cx %d, cy %d, cz %d\n", 
-	       __FUNCTION__,
-	       uinfo.mi_cid,
-	       uinfo.mi_cx,
-	       uinfo.mi_cy,
-	       uinfo.mi_cz);
+				/* failures are reported by the page's actual cluster */
+				if(cluster != NULL)
+					(void)vmm_move_page(vmm, vaddr, cluster);
+			}
 
-	err = cpu_uspace_copy(pinfo, &uinfo, sizeof(*pinfo));
+			mcntl_page_info(vaddr, &uinfo[i]);
+		}
 
-	if(err) 
-	{ 
-		printk(INFO, "%s: error copying result to userland, err %d\n", 
-		       __FUNCTION__,
-		       err);
+		/* a single page query keeps failing on unbacked pages */
+		if(isSingle && (op == MCNTL_READ) && (uinfo[0].mi_cid == MCNTL_CID_NONE))
+		{
+			err = EFAULT;
+			goto SYS_MCNTL_ERR;
+		}
 
-		err = EBADE; 
-		goto SYS_MCNTL_ERR;
+		err = cpu_uspace_copy(pinfo, &uinfo[0], count * sizeof(*pinfo));
+
+		if(err) goto SYS_MCNTL_ERR;
+
+		pinfo += count;
+		len   -= count;
 	}
 
 	return 0;
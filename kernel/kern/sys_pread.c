@@ -0,0 +1,67 @@
+/*
+ * kern/sys_pread.c - read from a file descriptor at a given offset
+ * 
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <thread.h>
+#include <vfs.h>
+#include <sys-vfs.h>
+#include <task.h>
+
+int sys_pread (uint_t fd, void *buf, size_t count, uint_t offset)
+{
+	struct vfs_iovec_s iov;
+	struct thread_s *this;
+	struct task_s *task;
+	struct vfs_file_s *file;
+	ssize_t err;
+
+	this = current_thread;
+	task = current_task;
+
+	if((fd >= CONFIG_TASK_FILE_MAX_NR) || (task_fd_lookup(task,fd) == NULL))
+	{
+		this->info.errno = EBADFD;
+		return -1;
+	}
+
+	file = task_fd_lookup(task,fd);
+
+	if(((uint_t)buf >= CONFIG_KERNEL_OFFSET) || (count > (CONFIG_KERNEL_OFFSET - (uint_t)buf)))
+	{
+		this->info.errno = EINVAL;
+		return -1;
+	}
+
+	if(count == 0)
+		return 0;
+
+	iov.iov_base = buf;
+	iov.iov_len  = count;
+
+	if((err = vfs_readv(file, &iov, 1, &offset)) < 0)
+	{
+		this->info.errno = -err;
+		return -1;
+	}
+
+	return err;
+}
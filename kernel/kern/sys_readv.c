@@ -0,0 +1,62 @@
+/*
+ * kern/sys_readv.c - read data into multiple buffers
+ * 
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <thread.h>
+#include <vfs.h>
+#include <sys-vfs.h>
+#include <task.h>
+
+int sys_readv (uint_t fd, struct vfs_iovec_s *iov, uint_t iovcnt)
+{
+	struct vfs_iovec_s kiov[VFS_IOV_MAX];
+	struct thread_s *this;
+	struct task_s *task;
+	struct vfs_file_s *file;
+	size_t count;
+	ssize_t err;
+
+	this = current_thread;
+	task = current_task;
+
+	if((fd >= CONFIG_TASK_FILE_MAX_NR) || (task_fd_lookup(task,fd) == NULL))
+	{
+		this->info.errno = EBADFD;
+		return -1;
+	}
+
+	file = task_fd_lookup(task,fd);
+
+	if((err = vfs_iovec_copyin(&kiov[0], iov, iovcnt, &count)))
+	{
+		this->info.errno = err;
+		return -1;
+	}
+
+	if((err = vfs_readv(file, &kiov[0], iovcnt, NULL)) < 0)
+	{
+		this->info.errno = -err;
+		return -1;
+	}
+
+	return err;
+}
@@ -0,0 +1,200 @@
+/*
+ * kern/sys_sysring.c - batched system calls submission/completion ring
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <types.h>
+#include <errno.h>
+#include <cpu.h>
+#include <thread.h>
+#include <syscall.h>
+#include <sysring.h>
+
+/* Services that never return to their caller or rely on its saved context */
+static bool_t sysring_service_isAllowed(uint_t service)
+{
+	if(service >= __SYS_CALL_SERVICES_NUM)
+		return false;
+
+	switch(service)
+	{
+	case SYS_EXIT:
+	case SYS_FORK:
+	case SYS_EXEC:
+	case SYS_SIGRETURN:
+	case SYS_SET_SIGRETURN:
+	case SYS_MIGRATE:
+	case SYS_SYSRING:
+		return false;
+
+	default:
+		return true;
+	}
+}
+
+static error_t sysring_setup(struct thread_s *this, struct sysring_s *ring, uint_t entries_nr)
+{
+	struct sysring_s hdr;
+	error_t err;
+
+	if((ring == NULL) || ((uint_t)ring & (sizeof(uint_t) - 1)) ||
+	   (entries_nr == 0) || (entries_nr > SYSRING_MAX_ENTRIES) ||
+	   (entries_nr & (entries_nr - 1)))
+		return EINVAL;
+
+	if(((uint_t)ring >= CONFIG_KERNEL_OFFSET) ||
+	   (sysring_size(entries_nr) > (CONFIG_KERNEL_OFFSET - (uint_t)ring)))
+		return EINVAL;
+
+	hdr.signature  = SYSRING_SIGNATURE;
+	hdr.entries_nr = entries_nr;
+	hdr.sq_head    = 0;
+	hdr.sq_tail    = 0;
+	hdr.cq_head    = 0;
+	hdr.cq_tail    = 0;
+
+	if((err = cpu_uspace_copy(ring, &hdr, sizeof(hdr))))
+		return err;
+
+	this->info.sysring    = ring;
+	this->info.sysring_nr = entries_nr;
+	return 0;
+}
+
+static int sysring_enter(struct sysring_s *ring, uint_t entries_nr, uint_t to_submit)
+{
+	struct thread_s *this;
+	struct sysring_s hdr;
+	struct sysring_sqe_s sqe;
+	struct sysring_cqe_s cqe;
+	uint_t pending;
+	uint_t mask;
+	uint_t done;
+	error_t err;
+
+	if((err = cpu_uspace_copy(&hdr, ring, sizeof(hdr))))
+		return -err;
+
+	pending = hdr.sq_tail - hdr.sq_head;
+	mask    = entries_nr - 1;
+
+	if((hdr.signature != SYSRING_SIGNATURE) ||
+	   (hdr.entries_nr != entries_nr)       ||
+	   (pending > entries_nr))
+		return -EINVAL;
+
+	if((to_submit == 0) || (to_submit > pending))
+		to_submit = pending;
+
+	for(done = 0; done < to_submit; done++)
+	{
+		/* Completion queue is full, let the user reap it */
+		if((hdr.cq_tail - hdr.cq_head) >= entries_nr)
+			break;
+
+		err = cpu_uspace_copy(&sqe, &sysring_sq(ring)[hdr.sq_head & mask], sizeof(sqe));
+
+		if(err) break;
+
+		cqe.user_data = sqe.user_data;
+		cqe.reserved  = 0;
+
+		if(sysring_service_isAllowed(sqe.service))
+		{
+			current_thread->info.errno = 0;
+
+			cqe.retval = do_syscall_service(sqe.service,
+							sqe.args[0],
+							sqe.args[1],
+							sqe.args[2],
+							sqe.args[3]);
+
+			/* Thread may have been migrated by the service */
+			cqe.errno = current_thread->info.errno;
+		}
+		else
+		{
+			cqe.retval = -1;
+			cqe.errno  = ENOSYS;
+		}
+
+		err = cpu_uspace_copy(&sysring_cq(ring, entries_nr)[hdr.cq_tail & mask], &cqe, sizeof(cqe));
+
+		if(err) break;
+
+		hdr.sq_head ++;
+		hdr.cq_tail ++;
+	}
+
+	this = current_thread;
+
+	if((cpu_uspace_copy((void*)&ring->sq_head, (void*)&hdr.sq_head, sizeof(hdr.sq_head))) ||
+	   (cpu_uspace_copy((void*)&ring->cq_tail, (void*)&hdr.cq_tail, sizeof(hdr.cq_tail))))
+		err = EFAULT;
+
+	if((done == 0) && err)
+		return -err;
+
+	this->info.errno = 0;
+	return done;
+}
+
+int sys_sysring(uint_t operation, struct sysring_s *ring, uint_t arg)
+{
+	struct thread_s *this;
+	error_t err;
+	int ret;
+
+	this = current_thread;
+
+	switch(operation)
+	{
+	case SYSRING_SETUP:
+		err = sysring_setup(this, ring, arg);
+		break;
+
+	case SYSRING_ENTER:
+		if((this->info.sysring == NULL) || (this->info.sysring != ring))
+		{
+			err = EINVAL;
+			break;
+		}
+
+		if((ret = sysring_enter(ring, this->info.sysring_nr, arg)) < 0)
+		{
+			err = -ret;
+			break;
+		}
+
+		return ret;
+
+	case SYSRING_DESTROY:
+		this->info.sysring    = NULL;
+		this->info.sysring_nr = 0;
+		err = 0;
+		break;
+
+	default:
+		err = EINVAL;
+	}
+
+	this->info.errno = err;
+	return (err) ? -1 : 0;
+}
@@ -28,11 +28,30 @@
 #include <arch.h>
 #include <pmm.h>
 #include <thread.h>
+#include <cluster.h>
 #include <sysconf.h>
 
 static sysfs_entry_t sysconf;
 static void sysconf_sysfs_op_init(sysfs_op_t *op);
 
+/* Clusters per mesh column, cid being x * ymax + y */
+static uint_t sysconf_cluster_ymax(void)
+{
+	struct cluster_s *cluster;
+	uint_t ymax;
+	uint_t cid;
+
+	for(ymax = 1, cid = 0; cid < CLUSTER_NR; cid++)
+	{
+		cluster = clusters_tbl[cid].cluster;
+
+		if((cluster != NULL) && (cluster->y_coord >= ymax))
+			ymax = cluster->y_coord + 1;
+	}
+
+	return ymax;
+}
+
 error_t sysconf_init(void)
 {
 	sysfs_op_t op;
@@ -64,8 +83,9 @@ static error_t sysconf_sysfs_read_op(sysfs_entry_t *entry, sysfs_request_t *rq,
 	this = current_thread;
 
 	sprintk((char*)rq->buffer, 
-		"CLUSTER_ONLN_NR %d\nCPU_ONLN_NR %d\nCPU_CACHE_LINE_SIZE %d\nPAGE_SIZE %d\nHEAP_MAX_SIZE %d\n",
+		"CLUSTER_ONLN_NR %d\nCLUSTER_YMAX %d\nCPU_ONLN_NR %d\nCPU_CACHE_LINE_SIZE %d\nPAGE_SIZE %d\nHEAP_MAX_SIZE %d\n",
 		arch_onln_cluster_nr(),
+		sysconf_cluster_ymax(),
 		arch_onln_cpu_nr(), 
 		CACHE_LINE_SIZE, 
 		PMM_PAGE_SIZE,
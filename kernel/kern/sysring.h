@@ -0,0 +1,86 @@
+/*
+ * kern/sysring.h - batched system calls submission/completion ring
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _SYSRING_H_
+#define _SYSRING_H_
+
+#include <types.h>
+#include <hal-cpu.h>
+
+/*
+ * A ring lives in the user-space of its thread and is registered once
+ * by SYSRING_SETUP. User code fills submission entries and advances
+ * sq_tail, then calls SYSRING_ENTER: the kernel runs the queued services
+ * in a single kernel entry, advancing sq_head and pushing completion
+ * records at cq_tail. The user consumes completions by advancing cq_head.
+ * Heads and tails are free running counters, entries_nr is a power of 2.
+ *
+ * This layout is shared with user-space (dietlibc sys/sysring.h),
+ * any change must be reported there.
+ */
+
+#define SYSRING_SIGNATURE    0x474E5253 /* SRNG */
+#define SYSRING_MAX_ENTRIES  256
+
+/* sys_sysring operations */
+#define SYSRING_SETUP        1
+#define SYSRING_ENTER        2
+#define SYSRING_DESTROY      3
+
+struct sysring_sqe_s
+{
+	uint_t service;
+	uint_t args[4];
+	uint_t user_data;
+};
+
+struct sysring_cqe_s
+{
+	sint_t retval;
+	uint_t errno;
+	uint_t user_data;
+	uint_t reserved;
+};
+
+struct sysring_s
+{
+	uint_t signature;
+	uint_t entries_nr;
+	volatile uint_t sq_head;
+	volatile uint_t sq_tail;
+	volatile uint_t cq_head;
+	volatile uint_t cq_tail;
+	uint_t reserved[2];
+	/* followed by sq[entries_nr] then cq[entries_nr] */
+};
+
+#define sysring_sq(_ring)      ((struct sysring_sqe_s*)((struct sysring_s*)(_ring) + 1))
+#define sysring_cq(_ring,_nr)  ((struct sysring_cqe_s*)(sysring_sq(_ring) + (_nr)))
+#define sysring_size(_nr)  (sizeof(struct sysring_s) +				\
+			    ((_nr) * (sizeof(struct sysring_sqe_s) + sizeof(struct sysring_cqe_s))))
+
+int sys_sysring(uint_t operation, struct sysring_s *ring, uint_t arg);
+
+/** Run a service of the system call table on behalf of current thread */
+int do_syscall_service(uint_t service_num, reg_t arg0, reg_t arg1, reg_t arg2, reg_t arg3);
+
+#endif	/* _SYSRING_H_ */
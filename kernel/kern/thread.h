@@ -28,6 +28,7 @@
 #include <spinlock.h>
 #include <wait_queue.h>
 #include <cpu.h>
+#include <numa_balance.h>
 
 typedef enum
 {   
@@ -57,6 +58,8 @@ struct sched_s;
 struct list_entry;
 struct task_s;
 struct event_s;
+struct sysring_s;
+struct vfs_aio_s;
 
 #define PT_ATTR_DEFAULT             0x000
 #define PT_ATTR_DETACH              0x001 /* for compatiblity */
@@ -139,6 +142,12 @@ struct thread_info
 	uint_t tm_dead;                     /*! date of the death */
 	uint_t order;
 	uint_t usr_tls;
+	struct sysring_s *sysring;          /*! registered batched syscalls ring */
+	uint_t sysring_nr;                  /*! its number of entries */
+	struct vfs_aio_s *aio;              /*! pending asynchronous I/O, allocated on demand */
+#if CONFIG_NUMA_BALANCING
+	struct numa_vote_s numa_vote;       /*! memory home, from its hinting faults */
+#endif
 	pthread_attr_t attr;
 	void  *kstack_addr;
 	uint_t kstack_size;
@@ -102,6 +102,9 @@ error_t thread_create(struct task_s *task, pthread_attr_t *attr, struct thread_s
 	thread->info.kstack_size = PMM_PAGE_SIZE << ARCH_THREAD_PAGE_ORDER;
 	thread->info.page = page;
 	thread->info.ppm_last_cid = attr->cid;
+#if CONFIG_NUMA_BALANCING
+	numa_vote_init(&thread->info.numa_vote);
+#endif
 	thread->signature = THREAD_ID;
 
 	wait_queue_init(&thread->info.wait_queue, "Join/Exit Sync");
@@ -28,6 +28,7 @@
 #include <event.h>
 #include <cluster.h>
 #include <ppm.h>
+#include <vfs.h>
 
 #include <page.h>
 
@@ -177,7 +178,7 @@ void pthread_destroy(struct thread_s *thread)
 	
 	spinlock_destroy(&thread->lock);
 	cpu_context_destroy(&thread->pws);
-
+	vfs_aio_destroy(thread);
 
 	thread->task = NULL;
 	req.type     = KMEM_PAGE; 
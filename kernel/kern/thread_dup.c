@@ -77,6 +77,10 @@ error_t thread_dup(struct task_s *task,
 	dst->info.tm_wait                    = 0;
 	signal_init(dst);
 	dst->info.join                       = NULL;
+	dst->info.aio                        = NULL;
+#if CONFIG_NUMA_BALANCING
+	numa_vote_init(&dst->info.numa_vote);
+#endif
 	wait_queue_init(&dst->info.wait_queue, "Join/Exit Sync");
 	dst->info.attr.sched_policy          = sched_policy;
 	dst->info.attr.cid                   = cid;
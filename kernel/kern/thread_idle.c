@@ -36,6 +36,7 @@
 #include <kcm.h>
 #include <page.h>
 #include <dqdt.h>
+#include <utime.h>
 
 extern mcs_barrier_t boot_sync;
 
@@ -75,6 +76,8 @@ void* thread_idle(void *arg)
 	cpu_time_reset(cpu);
 	////////////////////
 
+	utime_cpu_init(cpu);
+
 	mcs_barrier_wait(&boot_sync);
 
 	printk(INFO, "INFO: Starting Thread Idle On Core %d\tOK\n", cpu->gid);
@@ -135,6 +138,29 @@ void* thread_idle(void *arg)
 
 #endif
 
+#if CONFIG_PPM_RECLAIM
+		thread = kthread_create(this->task, 
+					&ppm_reclaimd, 
+					&cpu->cluster->ppm, 
+					cpu->cluster->id, 
+					cpu->lid);
+
+		if(thread == NULL)
+		{
+			PANIC("Failed to create pages reclaim thread, cid %d, cpu %d\n", 
+			      cpu->cluster->id, 
+			      cpu->gid);
+		}
+
+		thread->task = this->task;
+		wait_queue_init(&thread->info.wait_queue, "PPM-Reclaim");
+
+		err = sched_register(thread);
+		assert(err == 0);
+
+		sched_add_created(thread);
+#endif
+
 		if(clusters_tbl[cpu->cluster->id].flags & CLUSTER_IO)
 		{
 			thread = kthread_create(this->task, 
@@ -156,6 +182,25 @@ void* thread_idle(void *arg)
 			assert(err == 0);
 			sched_add_created(thread);
 			printk(INFO,"INFO: kvfsd has been created\n");
+
+			thread = kthread_create(this->task, 
+						&vfs_aiod, 
+						NULL, 
+						cpu->cluster->id, 
+						cpu->lid);
+       
+			if(thread == NULL)
+			{
+				PANIC("Failed to create VFS AIO worker on cluster %d, cpu %d\n", 
+				      cpu->cluster->id, 
+				      cpu->gid);
+			}
+
+			thread->task  = this->task;
+			wait_queue_init(&thread->info.wait_queue, "VFS-AIO");
+			err           = sched_register(thread);
+			assert(err == 0);
+			sched_add_created(thread);
 		}
 	}
 
@@ -174,6 +219,11 @@ void* thread_idle(void *arg)
 
 		count = sched_runnable_count(&cpu->scheduler);
 
+		if(count == 0)
+			cpu_idle_enter(cpu);
+		else
+			cpu_idle_leave(cpu);
+
 		cpu_enable_all_irq(NULL);
 
 		if(count != 0)
@@ -124,6 +124,14 @@ error_t thread_migrate(struct thread_s *this, sint_t target_gid)
 
 		logical = cpu->cluster->levels_tbl[0];
 
+#if CONFIG_NUMA_BALANCING
+		/* Search from the cluster holding most of the thread's pages */
+		cid = numa_vote_home(&this->info.numa_vote, CONFIG_NUMA_HOME_THRESHOLD);
+
+		if((cid != NUMA_CID_NONE) && (cid != cpu->cluster->id) && (clusters_tbl[cid].cluster != NULL))
+			logical = clusters_tbl[cid].cluster->levels_tbl[0];
+#endif
+
 		err = dqdt_thread_migrate(logical, &attr);
 
 		if((err) || (attr.cpu == cpu))
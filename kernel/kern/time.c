@@ -28,72 +28,298 @@
 #include <list.h>
 #include <rt_timer.h>
 #include <kmagics.h>
+#include <errno.h>
+#include <string.h>
+#include <bits.h>
+#include <utime.h>
+
+#define alarm_wheel_index(_tm,_level)				\
+	(((_tm) >> ((_level) * ALARM_WHEEL_SHIFT)) & ALARM_WHEEL_MASK)
+
+#define alarm_wheel_root(_alarm,_slot)					\
+	(&(_alarm)->wheel[(_slot) >> ALARM_WHEEL_SHIFT][(_slot) & ALARM_WHEEL_MASK])
+
+/* to be called with alarm manager lock taken */
+static void alarm_enqueue(struct alarm_s *alarm, struct alarm_info_s *info)
+{
+	register sint_t delta;
+	register uint_t expire;
+	register uint_t level;
+	register uint_t index;
+
+	delta  = (sint_t)(info->tm_wakeup - alarm->tm_clock);
+	expire = info->tm_wakeup;
+
+	if(delta < 0)
+	{
+		/* Already expired, to be fired on next clock */
+		delta  = 0;
+		expire = alarm->tm_clock;
+	}
+
+	if(delta >= ALARM_WHEEL_RANGE)
+	{
+		/* Out of range, will be requeued while cascading */
+		delta  = ALARM_WHEEL_RANGE - 1;
+		expire = alarm->tm_clock + delta;
+	}
+
+	for(level = 0; level < (ALARM_WHEEL_LEVELS - 1); level++)
+	{
+		if(delta < (1 << ((level + 1) * ALARM_WHEEL_SHIFT)))
+			break;
+	}
+
+	index      = alarm_wheel_index(expire, level);
+	info->slot = (level << ALARM_WHEEL_SHIFT) | index;
+	info->mgr  = alarm;
+
+	list_add_last(&alarm->wheel[level][index], &info->list);
+	bitmap_set(alarm->bitmap[level], index);
+}
+
+/* to be called with alarm manager lock taken */
+static void alarm_dequeue(struct alarm_s *alarm, struct alarm_info_s *info)
+{
+	register struct list_entry *root;
+	register uint_t slot;
+
+	slot = info->slot;
+	root = alarm_wheel_root(alarm, slot);
+
+	list_unlink(&info->list);
+
+	if(list_empty(root))
+		bitmap_clear(alarm->bitmap[slot >> ALARM_WHEEL_SHIFT], slot & ALARM_WHEEL_MASK);
+
+	info->slot = ALARM_SLOT_NONE;
+	info->mgr  = NULL;
+}
+
+/* Requeue alarms of given slot into lower levels, returns slot index */
+static uint_t alarm_cascade(struct alarm_s *alarm, uint_t level)
+{
+	struct list_entry root;
+	register struct list_entry *iter;
+	register struct alarm_info_s *info;
+	register uint_t index;
+
+	index = alarm_wheel_index(alarm->tm_clock, level);
+
+	if(!(bitmap_state(alarm->bitmap[level], index)))
+		return index;
+
+	/* Steal the whole slot list before requeuing its members */
+	list_replace(&alarm->wheel[level][index], &root);
+	list_root_init(&alarm->wheel[level][index]);
+	bitmap_clear(alarm->bitmap[level], index);
+
+	list_foreach_forward(&root, iter)
+	{
+		info = list_element(iter, struct alarm_info_s, list);
+		alarm_enqueue(alarm, info);
+		alarm->stats.cascade_nr ++;
+	}
+
+	return index;
+}
+
+/* Cascade higher levels when wheel's clock reaches a level-0 round */
+static void alarm_wheel_round(struct alarm_s *alarm)
+{
+	register uint_t level;
+
+	if(alarm_wheel_index(alarm->tm_clock, 0) != 0)
+		return;
+
+	for(level = 1; level < ALARM_WHEEL_LEVELS; level++)
+	{
+		if(alarm_cascade(alarm, level) != 0)
+			break;
+	}
+}
 
 error_t alarm_wait(struct alarm_info_s *info, uint_t msec)
 {
 	register uint_t tm_now;
 	struct cpu_s *cpu;
 	struct alarm_s *alarm_mgr;
-	struct list_entry *iter;
-	struct alarm_info_s *current;
 	uint_t irq_state;
 
 	cpu       = current_cpu;
 	alarm_mgr = &cpu->alarm_mgr;
 
-	cpu_disable_all_irq(&irq_state);
+	spinlock_lock_noirq(&alarm_mgr->lock, &irq_state);
 
 	tm_now          = cpu_get_ticks(cpu) * MSEC_PER_TICK;
 	info->signature = ALRM_INFO_ID;
 	info->tm_wakeup = tm_now + msec;
 
-	if(list_empty(&alarm_mgr->wait_queue))
-		list_add_first(&alarm_mgr->wait_queue, &info->list);
+	/* Wheel may lag behind after a tickless period, resync it */
+	if(alarm_mgr->pending_nr == 0)
+		alarm_mgr->tm_clock = tm_now;
+
+	alarm_enqueue(alarm_mgr, info);
+	alarm_mgr->pending_nr ++;
+	alarm_mgr->stats.insert_nr ++;
+
+	spinlock_unlock_noirq(&alarm_mgr->lock, irq_state);
+	return 0;
+}
+
+error_t alarm_cancel(struct alarm_info_s *info)
+{
+	struct alarm_s *alarm_mgr;
+	uint_t irq_state;
+	error_t err;
+
+	assert((info->signature == ALRM_INFO_ID) && "Not an ALRM info object");
+
+	alarm_mgr = info->mgr;
+
+	if(alarm_mgr == NULL)
+		return ENOENT;
+
+	spinlock_lock_noirq(&alarm_mgr->lock, &irq_state);
+
+	/* Fired while we were waiting for the lock */
+	if(info->mgr != alarm_mgr)
+		err = ENOENT;
 	else
 	{
-		list_foreach_forward(&alarm_mgr->wait_queue, iter)
-		{
-			current = list_element(iter, struct alarm_info_s, list);
-      
-			if(info->tm_wakeup <= current->tm_wakeup) 
-			{
-				list_add_pred(iter, &info->list);
-				goto NEXT_TRAITMENT;
-			}
-		}
-		list_add_last(&alarm_mgr->wait_queue, &info->list);
+		alarm_dequeue(alarm_mgr, info);
+		alarm_mgr->pending_nr --;
+		alarm_mgr->stats.cancel_nr ++;
+		err = 0;
 	}
 
-NEXT_TRAITMENT:
-	cpu_restore_irq(irq_state);
-	return 0;
+	spinlock_unlock_noirq(&alarm_mgr->lock, irq_state);
+	return err;
 }
 
 void alarm_clock(struct alarm_s *alarm, uint_t ticks_nr)
 {
 	register uint_t tm_msec;
+	register uint_t index;
+	register sint_t next;
 	register struct list_entry *iter;
 	register struct alarm_info_s *info;
-  
+	uint_t irq_state;
+
 	tm_msec = ticks_nr * MSEC_PER_TICK;
 
-	list_foreach_forward(&alarm->wait_queue, iter)
+	spinlock_lock_noirq(&alarm->lock, &irq_state);
+
+	while((sint_t)(tm_msec - alarm->tm_clock) >= 0)
 	{
-		info = list_element(iter, struct alarm_info_s, list);
+		if(alarm->pending_nr == 0)
+		{
+			alarm->tm_clock = tm_msec + 1;
+			break;
+		}
 
-		assert((info->signature == ALRM_INFO_ID) && "Not an ALRM info object");
+		index = alarm_wheel_index(alarm->tm_clock, 0);
+		alarm_wheel_round(alarm);
 
-		if(tm_msec < info->tm_wakeup)
-			break;
-    
-		list_unlink(iter);
-		event_send(info->event, &current_cpu->le_listner);
+		if(bitmap_state(alarm->bitmap[0], index))
+		{
+			list_foreach_forward(&alarm->wheel[0][index], iter)
+			{
+				info = list_element(iter, struct alarm_info_s, list);
+
+				assert((info->signature == ALRM_INFO_ID) && "Not an ALRM info object");
+
+				alarm_dequeue(alarm, info);
+				alarm->pending_nr --;
+
+				/* Cascaded out-of-range alarm, not yet expired */
+				if((sint_t)(info->tm_wakeup - alarm->tm_clock) > 0)
+				{
+					alarm->pending_nr ++;
+					alarm_enqueue(alarm, info);
+					continue;
+				}
+
+				alarm->stats.expire_nr ++;
+				event_send(info->event, &current_cpu->le_listner);
+			}
+		}
+
+		/* Skip empty slots up to the next non-empty one or the next cascade */
+		next = ((index + 1) < ALARM_WHEEL_SLOTS) ? 
+			bitmap_ffs2(alarm->bitmap[0], index + 1, ALARM_WHEEL_SLOTS/8) : -1;
+
+		next = (next == -1) ? ALARM_WHEEL_SLOTS : next;
+
+		if((sint_t)(tm_msec - alarm->tm_clock) < (next - index))
+			alarm->tm_clock = tm_msec + 1;
+		else
+			alarm->tm_clock += next - index;
+	}
+
+	/* 
+	 * Cascade as soon as a new round is reached so that 
+	 * alarm_next_expiry sees its alarms in level 0
+	 */
+	if(alarm->pending_nr != 0)
+		alarm_wheel_round(alarm);
+
+	spinlock_unlock_noirq(&alarm->lock, irq_state);
+}
+
+uint_t alarm_next_expiry(struct alarm_s *alarm, uint_t ticks_nr, uint_t max)
+{
+	register uint_t index;
+	register sint_t next;
+	register uint_t tm_next;
+	register sint_t delta;
+	uint_t irq_state;
+
+	spinlock_lock_noirq(&alarm->lock, &irq_state);
+
+	if(alarm->pending_nr == 0)
+	{
+		spinlock_unlock_noirq(&alarm->lock, irq_state);
+		return max;
 	}
+
+	/* 
+	 * Alarms queued on higher levels cannot expire before 
+	 * the next cascade, which is then a safe wakeup point.
+	 */
+	index   = alarm_wheel_index(alarm->tm_clock, 0);
+	next    = bitmap_ffs2(alarm->bitmap[0], index, ALARM_WHEEL_SLOTS/8);
+	next    = (next == -1) ? ALARM_WHEEL_SLOTS : next;
+	tm_next = alarm->tm_clock + (next - index);
+
+	spinlock_unlock_noirq(&alarm->lock, irq_state);
+
+	delta = (sint_t)(tm_next - (ticks_nr * MSEC_PER_TICK)) / MSEC_PER_TICK;
+
+	if(delta <= 0)
+		return 1;
+
+	return MIN((uint_t)delta, max);
 }
 
 error_t alarm_manager_init(struct alarm_s *alarm)
 {
-	list_root_init(&alarm->wait_queue);
+	register uint_t level;
+	register uint_t index;
+
+	spinlock_init(&alarm->lock, "Alarms");
+
+	alarm->tm_clock   = 0;
+	alarm->pending_nr = 0;
+	memset(&alarm->stats, 0, sizeof(alarm->stats));
+	memset(&alarm->bitmap[0][0], 0, sizeof(alarm->bitmap));
+
+	for(level = 0; level < ALARM_WHEEL_LEVELS; level++)
+	{
+		for(index = 0; index < ALARM_WHEEL_SLOTS; index++)
+			list_root_init(&alarm->wheel[level][index]);
+	}
+
 	return 0;
 }
 
@@ -128,6 +354,7 @@ inline void tm_sys_compute(struct thread_s *thread)
 	rt_timer_read(&tm_now);
 	thread->info.tm_sys += (tm_now - thread->info.tm_tmp);
 	thread->info.tm_tmp  = tm_now;
+	utime_thread_update(thread);
 }
 
 inline void tm_wait_compute(struct thread_s *thread)
@@ -26,9 +26,18 @@
 #include <types.h>
 #include <list.h>
 #include <device.h>
+#include <bits.h>
 
 struct event_s;
 
+/* Per-CPU hierarchical timer wheel geometry */
+#define ALARM_WHEEL_LEVELS   4
+#define ALARM_WHEEL_SHIFT    6
+#define ALARM_WHEEL_SLOTS    (1 << ALARM_WHEEL_SHIFT)
+#define ALARM_WHEEL_MASK     (ALARM_WHEEL_SLOTS - 1)
+#define ALARM_WHEEL_RANGE    (1 << (ALARM_WHEEL_LEVELS * ALARM_WHEEL_SHIFT))
+#define ALARM_SLOT_NONE      ((uint_t)-1)
+
 struct alarm_info_s 
 {
 	uint_t signature;
@@ -38,20 +47,51 @@ struct alarm_info_s
 
 	/* Private members */
 	uint_t tm_wakeup;
+	uint_t slot;
+	struct alarm_s *mgr;
 	struct list_entry list;
 };
 
+struct alarm_stats_s
+{
+	uint_t insert_nr;
+	uint_t cancel_nr;
+	uint_t expire_nr;
+	uint_t cascade_nr;
+	uint_t oneshot_nr;
+	uint_t skipped_nr;
+};
+
 struct alarm_s
 { 
-	struct list_entry wait_queue;
+	spinlock_t lock;
+	uint_t tm_clock;
+	uint_t pending_nr;
+	struct alarm_stats_s stats;
+	BITMAP_DECLARE(bitmap[ALARM_WHEEL_LEVELS], ALARM_WHEEL_SLOTS/8);
+	struct list_entry wheel[ALARM_WHEEL_LEVELS][ALARM_WHEEL_SLOTS];
 };
 
+/** Initialize a per-CPU alarms manager */
 error_t alarm_manager_init(struct alarm_s *alarm);
+
+/** Arm an alarm to be fired on current CPU in msec milliseconds, O(1) */
 error_t alarm_wait(struct alarm_info_s *info, uint_t msec);
 
+/** Disarm a pending alarm, O(1), no effect if it has been already fired */
+error_t alarm_cancel(struct alarm_info_s *info);
+
+/** Fire all alarms expired at the given ticks number */
 void alarm_clock(struct alarm_s *alarm, uint_t ticks_nr);
 
-int sys_clock (uint64_t *val);
+/** 
+ * Get the number of ticks, starting from ticks_nr, 
+ * before the next alarm expiry or the next wheel cascade.
+ * The returned value is clamped to max.
+ */
+uint_t alarm_next_expiry(struct alarm_s *alarm, uint_t ticks_nr, uint_t max);
+
+int sys_clock (uint64_t *val, uint_t clock_id);
 int sys_alarm (unsigned nb_sec);
 
 #if CONFIG_THREAD_TIME_STAT
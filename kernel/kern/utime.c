@@ -0,0 +1,232 @@
+/*
+ * kern/utime.c - user-space readable time page
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <types.h>
+#include <errno.h>
+#include <kmem.h>
+#include <page.h>
+#include <ppm.h>
+#include <pmm.h>
+#include <vmm.h>
+#include <vm_region.h>
+#include <cluster.h>
+#include <cpu.h>
+#include <thread.h>
+#include <task.h>
+#include <rwlock.h>
+#include <kdmsg.h>
+#include <utime.h>
+
+error_t utime_cluster_init(struct cluster_s *cluster)
+{
+	struct utime_page_s *utime;
+	struct page_s *page;
+	kmem_req_t req;
+
+	cluster->utime_pg = NULL;
+	cluster->utime    = NULL;
+
+#if CONFIG_UTIME_PAGE
+	req.type  = KMEM_PAGE;
+	req.size  = 0;
+	req.flags = AF_BOOT | AF_ZERO;
+
+	if((page = kmem_alloc(&req)) == NULL)
+		return ENOMEM;
+
+	/* Mappings take their own references, the initial one is never dropped */
+	page->mapper = NULL;
+
+	utime                 = ppm_page2addr(page);
+	utime->signature      = UTIME_SIGNATURE;
+	utime->flags          = 0;
+	utime->cid            = cluster->id;
+	utime->cpu_nr         = cluster->cpu_nr;
+	utime->cycles_per_sec = CYCLES_PER_SECOND;
+	utime->usec_per_tick  = MSEC_PER_TICK * 1000;
+	utime->epoch_sec      = 0;
+
+#if CONFIG_THREAD_TIME_STAT
+	utime->flags |= UTIME_THREAD_TIME;
+#endif
+
+	cluster->utime_pg = page;
+	cluster->utime    = utime;
+	cpu_wbflush();
+#endif	/* CONFIG_UTIME_PAGE */
+
+	return 0;
+}
+
+void utime_cpu_init(struct cpu_s *cpu)
+{
+	struct utime_page_s *utime;
+
+	utime = cpu->cluster->utime;
+
+	if(utime == NULL)
+		return;
+
+#if CONFIG_UTIME_USR_CYCLES
+	/* All CPUs of the cluster set the same flag */
+	if(cpu_usr_counters_enable())
+		utime->flags |= UTIME_USR_CYCLES;
+#endif
+
+	utime_cpu_update(cpu);
+}
+
+void utime_cpu_update(struct cpu_s *cpu)
+{
+	register struct utime_cpu_s *entry;
+	uint_t irq_state;
+
+	if(cpu->cluster->utime == NULL)
+		return;
+
+	entry = &cpu->cluster->utime->cpu_tbl[cpu->lid];
+
+	cpu_disable_all_irq(&irq_state);
+	entry->seq ++;
+	cpu_wbflush();
+
+	entry->tmstmp    = cpu->time.tmstmp;
+	entry->cycles_lo = (uint_t)cpu->time.cycles;
+	entry->cycles_hi = (uint_t)(cpu->time.cycles >> 32);
+	entry->ticks_nr  = cpu->time.ticks_nr;
+
+	cpu_wbflush();
+	entry->seq ++;
+	cpu_restore_irq(irq_state);
+}
+
+void utime_thread_update(struct thread_s *thread)
+{
+#if CONFIG_THREAD_TIME_STAT
+	register struct utime_cpu_s *entry;
+	register struct cpu_s *cpu;
+	struct cpu_uzone_attr_s attr;
+	uint_t irq_state;
+
+	/* The entry belongs to the thread running on the CPU */
+	if((thread != current_thread) || (thread->type != PTHREAD))
+		return;
+
+	cpu = thread_current_cpu(thread);
+
+	if(cpu->cluster->utime == NULL)
+		return;
+
+	entry = &cpu->cluster->utime->cpu_tbl[cpu->lid];
+	(void)cpu_uzone_getattr(&thread->uzone, &attr);
+
+	cpu_disable_all_irq(&irq_state);
+	entry->seq ++;
+	cpu_wbflush();
+
+	entry->th_tls     = attr.tls;
+	entry->th_cputime = thread->info.tm_usr + thread->info.tm_sys;
+	entry->th_stamp   = thread->info.tm_tmp;
+
+	cpu_wbflush();
+	entry->seq ++;
+	cpu_restore_irq(irq_state);
+#endif
+}
+
+static VM_REGION_PAGE_FAULT(utime_pagefault)
+{
+	struct cluster_s *cluster;
+	struct page_s *page;
+	pmm_page_info_t old;
+	pmm_page_info_t new;
+	uint_t index;
+	error_t err;
+
+	index = (vaddr - region->vm_start) >> PMM_PAGE_SHIFT;
+
+	if(index == 0)
+		cluster = current_cluster;
+	else
+		cluster = (index <= CLUSTER_NR) ? clusters_tbl[index - 1].cluster : NULL;
+
+	if((cluster == NULL) || (cluster->utime_pg == NULL))
+		return EFAULT;
+
+	if((err = pmm_lock_page(&region->vmm->pmm, vaddr, &old)))
+		return err;
+
+	if(old.isAtomic == false)
+	{
+		current_thread->info.spurious_pgfault_cntr ++;
+		pmm_tlb_flush_vaddr(vaddr, PMM_DATA);
+		return 0;
+	}
+
+	page = cluster->utime_pg;
+	page_refcount_up(page);
+
+	new.attr    = region->vm_pgprot;
+	new.ppn     = ppm_page2ppn(page);
+	new.cluster = NULL;
+
+	if((err = pmm_set_page(&region->vmm->pmm, vaddr, &new)))
+	{
+		(void)page_refcount_down(page);
+		(void)pmm_unlock_page(&region->vmm->pmm, vaddr, &old);
+	}
+
+	return err;
+}
+
+static const struct vm_region_op_s utime_vm_region_op =
+{
+	.page_in     = NULL,
+	.page_out    = NULL,
+	.page_lookup = NULL,
+	.page_fault  = utime_pagefault
+};
+
+error_t utime_task_map(struct task_s *task)
+{
+#if CONFIG_UTIME_PAGE
+	struct vm_region_s *region;
+	void *addr;
+
+	addr = vmm_mmap(task, NULL,
+			(void*)UTIME_USR_BASE,
+			(CLUSTER_NR + 1) * PMM_PAGE_SIZE,
+			VM_REG_RD,
+			VM_REG_PRIVATE | VM_REG_DEV | VM_REG_FIXED, 0);
+
+	if(addr == VM_FAILED)
+		return current_thread->info.errno;
+
+	rwlock_rdlock(&task->vmm.rwlock);
+	region = vm_region_find(&task->vmm, (uint_t)addr);
+	rwlock_unlock(&task->vmm.rwlock);
+
+	assert(region != NULL);
+	region->vm_op = (struct vm_region_op_s*)&utime_vm_region_op;
+#endif
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * kern/utime.h - user-space readable time page
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _UTIME_H_
+#define _UTIME_H_
+
+#include <types.h>
+
+/*
+ * Each cluster owns one page holding the time base of its CPUs.
+ * Pages are mapped read-only into every task starting at UTIME_USR_BASE:
+ * cluster cid's page is at UTIME_USR_BASE + ((cid + 1) * PMM_PAGE_SIZE),
+ * the first page is an alias of the page of the cluster that touched it
+ * first and must only be used to read the header.
+ *
+ * A CPU entry is protected by a sequence counter: it is odd while
+ * the owner CPU updates the entry, readers must retry if it was odd
+ * or has changed during the read.
+ *
+ * This layout is shared with user-space (dietlibc sys/utime.h),
+ * any change must be reported there.
+ */
+
+#define UTIME_SIGNATURE      0x454D4954 /* TIME */
+#define UTIME_USR_BASE       (CONFIG_USR_LIMIT)
+
+/* Header flags */
+#define UTIME_USR_CYCLES     0x1 /* rdhwr of CPUNum & CC is allowed in user mode */
+#define UTIME_THREAD_TIME    0x2 /* th_* fields are published */
+
+/* Clocks ids accepted by sys_clock */
+#define UTIME_CLOCK_CYCLES   0
+#define UTIME_CLOCK_THREAD   1
+#define UTIME_CLOCK_PAGE     2 /* user address of the time pages, 0 if none */
+
+struct utime_cpu_s
+{
+	volatile uint_t seq;
+	uint_t tmstmp;		/* CPU counter value at last update */
+	uint_t cycles_lo;	/* 64 bits cycles count at tmstmp */
+	uint_t cycles_hi;
+	uint_t ticks_nr;
+	uint_t th_tls;		/* user TLS of the running thread */
+	uint_t th_cputime;	/* its user + system cycles at th_stamp */
+	uint_t th_stamp;
+}__attribute__ ((aligned (CONFIG_CACHE_LINE_SIZE)));
+
+struct utime_page_s
+{
+	uint_t signature;
+	uint_t flags;
+	uint_t cid;
+	uint_t cpu_nr;
+	uint_t cycles_per_sec;
+	uint_t usec_per_tick;
+	uint_t epoch_sec;
+	struct utime_cpu_s cpu_tbl[CPU_PER_CLUSTER] __attribute__ ((aligned (CONFIG_CACHE_LINE_SIZE)));
+};
+
+struct cluster_s;
+struct cpu_s;
+struct thread_s;
+struct task_s;
+
+/** Allocate and initialize the time page of given cluster */
+error_t utime_cluster_init(struct cluster_s *cluster);
+
+/** Enable user access to time counters on current CPU */
+void utime_cpu_init(struct cpu_s *cpu);
+
+/** Publish CPU's time base, called by owner CPU on time update */
+void utime_cpu_update(struct cpu_s *cpu);
+
+/** Publish running thread's CPU time, called on return to user-mode */
+void utime_thread_update(struct thread_s *thread);
+
+/** Map time pages into given task */
+error_t utime_task_map(struct task_s *task);
+
+#endif	/* _UTIME_H_ */
@@ -49,7 +49,7 @@ error_t eomtkp_func(void *param)
   ms_args_t *args;
   struct sgi_info_s *sgi_info;
 
-  sys_clock(&tm_start);
+  sys_clock(&tm_start, 0);
 
   args  = (ms_args_t *) param;
   src_name = args->argv[1];
@@ -85,7 +85,7 @@ error_t eomtkp_func(void *param)
   if((size = sys_lseek(src_fd, sizeof(struct sgi_info_s), VFS_SEEK_SET)) == -1)
     return -4;
 
-  sys_clock(&tm_tmp);
+  sys_clock(&tm_tmp, 0);
   tm_header = tm_tmp - tm_start;
 
   size = 0;
@@ -98,7 +98,7 @@ error_t eomtkp_func(void *param)
   sys_close(src_fd);
   sys_close(dst_fd);
   
-  sys_clock(&tm_end);
+  sys_clock(&tm_end, 0);
 
   ksh_print("  Command statistics:\n\tStart time: %u\n\tEnd time: %u\n\tElapsed time: %u\n\tHeader time: %u\n",
 	 tm_start,
@@ -118,6 +118,17 @@ void* kmem_alloc(struct kmem_req_s *req)
 	{
 	case KMEM_PAGE:
 		ptr = (void*) ppm_alloc_pages(&cluster->ppm, size, flags);
+
+#if CONFIG_PPM_RECLAIM
+		/* Last chance for user pages, evicts some clean pagecache pages */
+		if((ptr == NULL) && (flags & AF_USR) && 
+		   (ppm_reclaim(&cluster->ppm, CONFIG_PPM_LRU_BATCH, false) != 0))
+			ptr = (void*) ppm_alloc_pages(&cluster->ppm, size, flags);
+
+		if(cluster->ppm.free_pages_nr < cluster->ppm.pages_low)
+			ppm_reclaim_wakeup(&cluster->ppm);
+#endif
+
 		if((flags & AF_ZERO) && (ptr != NULL)) page_zero(ptr);
     
 		if(cluster->ppm.free_pages_nr < cluster->ppm.kprio_pages_min)
@@ -0,0 +1,139 @@
+/*
+ * mm/lru.c - active/inactive pages replacement lists
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <types.h>
+#include <list.h>
+#include <page.h>
+#include <lru.h>
+
+void lru_init(struct lru_s *lru)
+{
+	list_root_init(&lru->active);
+	list_root_init(&lru->inactive);
+	lru->active_nr   = 0;
+	lru->inactive_nr = 0;
+}
+
+void lru_add(struct lru_s *lru, struct page_s *page, bool_t isActive)
+{
+	PAGE_LRU_CLEAR(page, PG_REFERENCED);
+	PAGE_LRU_SET(page, PG_LRU);
+
+	if(isActive)
+	{
+		PAGE_LRU_SET(page, PG_ACTIVE);
+		list_add_first(&lru->active, &page->list);
+		lru->active_nr ++;
+	}
+	else
+	{
+		PAGE_LRU_CLEAR(page, PG_ACTIVE);
+		list_add_first(&lru->inactive, &page->list);
+		lru->inactive_nr ++;
+	}
+}
+
+void lru_del(struct lru_s *lru, struct page_s *page)
+{
+	list_unlink(&page->list);
+
+	if(PAGE_LRU_IS(page, PG_ACTIVE))
+		lru->active_nr --;
+	else
+		lru->inactive_nr --;
+
+	PAGE_LRU_CLEAR(page, PG_LRU | PG_ACTIVE | PG_REFERENCED);
+}
+
+static void lru_activate(struct lru_s *lru, struct page_s *page)
+{
+	list_unlink(&page->list);
+	lru->inactive_nr --;
+
+	PAGE_LRU_CLEAR(page, PG_REFERENCED);
+	PAGE_LRU_SET(page, PG_ACTIVE);
+	list_add_first(&lru->active, &page->list);
+	lru->active_nr ++;
+}
+
+void lru_touch(struct lru_s *lru, struct page_s *page)
+{
+	if(!(PAGE_LRU_IS(page, PG_ACTIVE)) && (PAGE_LRU_IS(page, PG_REFERENCED)))
+	{
+		lru_activate(lru, page);
+		return;
+	}
+
+	PAGE_LRU_SET(page, PG_REFERENCED);
+}
+
+uint_t lru_age(struct lru_s *lru, uint_t count)
+{
+	struct page_s *page;
+	uint_t deactivated;
+
+	deactivated = 0;
+
+	while((count != 0) && !(list_empty(&lru->active)))
+	{
+		count --;
+		page = list_last(&lru->active, struct page_s, list);
+		list_unlink(&page->list);
+
+		if(PAGE_LRU_IS(page, PG_REFERENCED))
+		{
+			PAGE_LRU_CLEAR(page, PG_REFERENCED);
+			list_add_first(&lru->active, &page->list);
+			continue;
+		}
+
+		PAGE_LRU_CLEAR(page, PG_ACTIVE);
+		list_add_first(&lru->inactive, &page->list);
+		lru->active_nr --;
+		lru->inactive_nr ++;
+		deactivated ++;
+	}
+
+	return deactivated;
+}
+
+struct page_s* lru_isolate(struct lru_s *lru, uint_t count)
+{
+	struct page_s *page;
+
+	while((count != 0) && !(list_empty(&lru->inactive)))
+	{
+		count --;
+		page = list_last(&lru->inactive, struct page_s, list);
+
+		if(PAGE_LRU_IS(page, PG_REFERENCED))
+		{
+			lru_activate(lru, page);
+			continue;
+		}
+
+		lru_del(lru, page);
+		return page;
+	}
+
+	return NULL;
+}
@@ -0,0 +1,102 @@
+/*
+ * mm/lru.h - active/inactive pages replacement lists
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _LRU_H_
+#define _LRU_H_
+
+#include <types.h>
+#include <list.h>
+
+struct page_s;
+
+/**
+ * Second chance replacement over two lists, the newest pages are at
+ * the head of each one. A page enters the inactive list (or the active
+ * one if it is already known to be in use), an access sets its
+ * PG_REFERENCED flag and a second access promotes it. Aging moves the
+ * unreferenced tail of the active list back to the inactive one, whose
+ * unreferenced tail gives the victims.
+ *
+ * Only the lists are handled here, the caller provides the locking
+ * (ppm->lru_lock) and decides what to do with the victims.
+ */
+struct lru_s
+{
+	struct list_entry active;
+	struct list_entry inactive;
+	uint_t active_nr;
+	uint_t inactive_nr;
+};
+
+/**
+ * Initializes an empty LRU
+ *
+ * @lru         LRU to initialize
+ **/
+void lru_init(struct lru_s *lru);
+
+/**
+ * Inserts a page which is not yet on the LRU
+ *
+ * @lru         LRU of the page's cluster
+ * @page        Page to insert
+ * @isActive    Insert it on the active list
+ **/
+void lru_add(struct lru_s *lru, struct page_s *page, bool_t isActive);
+
+/**
+ * Removes a page from the LRU and clears its replacement flags
+ *
+ * @lru         LRU of the page's cluster
+ * @page        Page to remove, PG_LRU is set
+ **/
+void lru_del(struct lru_s *lru, struct page_s *page);
+
+/**
+ * Records an access to a page, promoting it if it was already referenced
+ *
+ * @lru         LRU of the page's cluster
+ * @page        Accessed page, PG_LRU is set
+ **/
+void lru_touch(struct lru_s *lru, struct page_s *page);
+
+/**
+ * Scans up to count pages at the tail of the active list, referenced
+ * ones get a second chance, others are moved to the inactive list
+ *
+ * @lru         LRU to age
+ * @count       Maximum number of pages to scan
+ * @return      Number of deactivated pages
+ **/
+uint_t lru_age(struct lru_s *lru, uint_t count);
+
+/**
+ * Scans up to count pages at the tail of the inactive list, referenced
+ * ones are promoted, the first unreferenced one is removed from the LRU
+ *
+ * @lru         LRU to scan
+ * @count       Maximum number of pages to scan
+ * @return      The victim, NULL if none has been found
+ **/
+struct page_s* lru_isolate(struct lru_s *lru, uint_t count);
+
+#endif	/* _LRU_H_ */
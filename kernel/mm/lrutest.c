@@ -0,0 +1,401 @@
+/*
+ * mm/lrutest.c - host test of the active/inactive pages replacement lists
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * lru.c only reaches page->list and the PG_LRU, PG_ACTIVE and
+ * PG_REFERENCED bits of page->lru_flags, so it is included here on top
+ * of a two-field page_s. Random add, del, touch, age and isolate calls are mirrored on
+ * arrays; both must agree on the order of each list and on every flag.
+ * A second run reclaims in CONFIG_PPM_LRU_BATCH steps, as ppm_reclaim()
+ * does, while a stream of once-read pages flows through, and counts the
+ * hot pages it loses. Host build (*test.c is not in the kernel image):
+ *
+ *   cc -idirafter . -idirafter ../kern -idirafter ../libk -o lrutest lrutest.c && ./lrutest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+/* stand for libk/types.h, libk/config.h and mm/page.h */
+#define _TYPES_H_
+#define _CONFIG_H_
+#define _PAGE_H_
+#define false  0
+#define true   1
+typedef unsigned long uint_t;
+typedef unsigned long bool_t;
+
+#include <list.h>
+#include <mm-config.h>
+
+#define PG_LRU          0x001
+#define PG_ACTIVE       0x002
+#define PG_REFERENCED   0x004
+
+#define PAGE_LRU_SET(page,flag)    ((page)->lru_flags) |= (flag)
+#define PAGE_LRU_CLEAR(page,flag)  ((page)->lru_flags) &= ~(flag)
+#define PAGE_LRU_IS(page,flag)     ((page)->lru_flags) & (flag)
+
+struct page_s
+{
+	uint_t lru_flags;
+	struct list_entry list;
+};
+
+#include "lru.c"
+
+#define PAGES_NR  64
+
+static int errors;
+
+#define CHECK(cond)							\
+	do {								\
+		if(!(cond))						\
+		{							\
+			printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			errors ++;					\
+		}							\
+	} while(0)
+
+static struct page_s pages[PAGES_NR];
+
+/* Model of the LRU: pages indexes, newest first, and their flags */
+struct model_s
+{
+	int active[PAGES_NR];
+	int inactive[PAGES_NR];
+	uint_t active_nr;
+	uint_t inactive_nr;
+	bool_t isLru[PAGES_NR];
+	bool_t isReferenced[PAGES_NR];
+};
+
+static void model_remove(int *tbl, uint_t *nr, int idx)
+{
+	uint_t i;
+
+	for(i = 0; tbl[i] != idx; i++)
+		;
+
+	for(; i + 1 < *nr; i++)
+		tbl[i] = tbl[i + 1];
+
+	(*nr) --;
+}
+
+static void model_push(int *tbl, uint_t *nr, int idx)
+{
+	uint_t i;
+
+	for(i = *nr; i > 0; i--)
+		tbl[i] = tbl[i - 1];
+
+	tbl[0] = idx;
+	(*nr) ++;
+}
+
+static bool_t model_is_active(struct model_s *m, int idx)
+{
+	uint_t i;
+
+	for(i = 0; i < m->active_nr; i++)
+		if(m->active[i] == idx)
+			return true;
+
+	return false;
+}
+
+static void model_add(struct model_s *m, int idx, bool_t isActive)
+{
+	m->isLru[idx] = true;
+	m->isReferenced[idx] = false;
+
+	if(isActive)
+		model_push(m->active, &m->active_nr, idx);
+	else
+		model_push(m->inactive, &m->inactive_nr, idx);
+}
+
+static void model_del(struct model_s *m, int idx)
+{
+	if(model_is_active(m, idx))
+		model_remove(m->active, &m->active_nr, idx);
+	else
+		model_remove(m->inactive, &m->inactive_nr, idx);
+
+	m->isLru[idx] = false;
+	m->isReferenced[idx] = false;
+}
+
+static void model_activate(struct model_s *m, int idx)
+{
+	model_remove(m->inactive, &m->inactive_nr, idx);
+	model_push(m->active, &m->active_nr, idx);
+	m->isReferenced[idx] = false;
+}
+
+static void model_touch(struct model_s *m, int idx)
+{
+	if(!model_is_active(m, idx) && m->isReferenced[idx])
+		model_activate(m, idx);
+	else
+		m->isReferenced[idx] = true;
+}
+
+static uint_t model_age(struct model_s *m, uint_t count)
+{
+	uint_t deactivated;
+	int idx;
+
+	for(deactivated = 0; (count != 0) && (m->active_nr != 0); count--)
+	{
+		idx = m->active[m->active_nr - 1];
+		model_remove(m->active, &m->active_nr, idx);
+
+		if(m->isReferenced[idx])
+		{
+			m->isReferenced[idx] = false;
+			model_push(m->active, &m->active_nr, idx);
+			continue;
+		}
+
+		model_push(m->inactive, &m->inactive_nr, idx);
+		deactivated ++;
+	}
+
+	return deactivated;
+}
+
+static int model_isolate(struct model_s *m, uint_t count)
+{
+	int idx;
+
+	for(; (count != 0) && (m->inactive_nr != 0); count--)
+	{
+		idx = m->inactive[m->inactive_nr - 1];
+
+		if(m->isReferenced[idx])
+		{
+			model_activate(m, idx);
+			continue;
+		}
+
+		model_del(m, idx);
+		return idx;
+	}
+
+	return -1;
+}
+
+/* Walks a list of the LRU from its head, comparing it with the model */
+static void check_list(struct list_entry *root, int *tbl, uint_t nr, bool_t isActive)
+{
+	struct list_entry *iter;
+	struct page_s *page;
+	uint_t i;
+
+	for(i = 0, iter = root->next; iter != root; iter = iter->next, i++)
+	{
+		CHECK(iter->next->pred == iter);
+
+		if(i >= nr)
+			break;
+
+		page = list_element(iter, struct page_s, list);
+		CHECK(page == &pages[tbl[i]]);
+		CHECK(PAGE_LRU_IS(page, PG_LRU));
+		CHECK(!(PAGE_LRU_IS(page, PG_ACTIVE)) == !isActive);
+	}
+
+	CHECK(i == nr);
+}
+
+static void check_model(struct lru_s *lru, struct model_s *m)
+{
+	int idx;
+
+	CHECK(lru->active_nr == m->active_nr);
+	CHECK(lru->inactive_nr == m->inactive_nr);
+	check_list(&lru->active, m->active, m->active_nr, true);
+	check_list(&lru->inactive, m->inactive, m->inactive_nr, false);
+
+	for(idx = 0; idx < PAGES_NR; idx++)
+	{
+		CHECK(!(PAGE_LRU_IS(&pages[idx], PG_LRU)) == !m->isLru[idx]);
+		CHECK(!(PAGE_LRU_IS(&pages[idx], PG_REFERENCED)) == !m->isReferenced[idx]);
+	}
+}
+
+/* Random operations, the lists are compared with the model after each one */
+static void test_model(unsigned long rounds)
+{
+	static struct model_s m;
+	struct lru_s lru;
+	struct page_s *page;
+	unsigned long r;
+	uint_t count;
+	int idx;
+
+	lru_init(&lru);
+
+	for(r = 0; (r < rounds) && !errors; r++)
+	{
+		idx = rand() % PAGES_NR;
+		count = rand() % 8;
+
+		switch(rand() % 6)
+		{
+		case 0:
+			if(m.isLru[idx])
+			{
+				lru_del(&lru, &pages[idx]);
+				model_del(&m, idx);
+				CHECK(!(PAGE_LRU_IS(&pages[idx], PG_ACTIVE)));
+			}
+			else
+			{
+				bool_t isActive = rand() & 1;
+
+				pages[idx].lru_flags |= (rand() & 1) ? PG_REFERENCED : 0;
+				lru_add(&lru, &pages[idx], isActive);
+				model_add(&m, idx, isActive);
+			}
+			break;
+
+		case 1:
+		case 2:
+			if(m.isLru[idx])
+			{
+				lru_touch(&lru, &pages[idx]);
+				model_touch(&m, idx);
+			}
+			break;
+
+		case 3:
+			CHECK(lru_age(&lru, count) == model_age(&m, count));
+			break;
+
+		default:
+			page = lru_isolate(&lru, count);
+			idx  = model_isolate(&m, count);
+			CHECK(page == ((idx < 0) ? NULL : &pages[idx]));
+
+			if(page != NULL)
+				CHECK(!(PAGE_LRU_IS(page, PG_LRU | PG_ACTIVE | PG_REFERENCED)));
+			break;
+		}
+
+		check_model(&lru, &m);
+	}
+}
+
+/*
+ * A working set touched on every round keeps its pages while a stream
+ * of pages loaded once goes through the inactive list. The LRU holds at
+ * most PAGES_NR pages, the reclaim scans it by batches the way
+ * ppm_reclaim() does.
+ */
+static void test_scan(void)
+{
+	static struct page_s stream[4096];
+	struct page_s *hot[PAGES_NR / 4];
+	struct page_s *victim;
+	struct lru_s lru;
+	uint_t i, j, scan, lost;
+
+	lru_init(&lru);
+
+	for(i = 0; i < PAGES_NR; i++)
+		pages[i].lru_flags = 0;
+
+	for(i = 0; i < PAGES_NR / 4; i++)
+	{
+		hot[i] = &pages[i];
+		lru_add(&lru, hot[i], false);
+		lru_touch(&lru, hot[i]);
+		lru_touch(&lru, hot[i]);
+		CHECK(PAGE_LRU_IS(hot[i], PG_ACTIVE));
+	}
+
+	for(i = 0, lost = 0; i < sizeof(stream) / sizeof(stream[0]); i++)
+	{
+		for(j = 0; j < PAGES_NR / 4; j++)
+		{
+			if(!(PAGE_LRU_IS(hot[j], PG_LRU)))
+			{
+				lost ++;
+				lru_add(&lru, hot[j], false);
+			}
+
+			lru_touch(&lru, hot[j]);
+		}
+
+		/* as a page filled by mapper_get_page() */
+		stream[i].lru_flags = 0;
+		lru_add(&lru, &stream[i], false);
+
+		scan = lru.active_nr + lru.inactive_nr;
+
+		while((lru.active_nr + lru.inactive_nr > PAGES_NR) && (scan != 0))
+		{
+			scan --;
+
+			if(lru.inactive_nr < lru.active_nr)
+				(void)lru_age(&lru, CONFIG_PPM_LRU_BATCH);
+
+			victim = lru_isolate(&lru, CONFIG_PPM_LRU_BATCH);
+
+			if(victim != NULL)
+				CHECK(!(PAGE_LRU_IS(victim, PG_LRU)));
+		}
+
+		CHECK(lru.active_nr + lru.inactive_nr <= PAGES_NR);
+	}
+
+	printf("scan: %u hot pages lost over %u pages streamed\n",
+	       (unsigned)lost, (unsigned)(sizeof(stream) / sizeof(stream[0])));
+	CHECK(lost == 0);
+
+	for(j = 0; j < PAGES_NR / 4; j++)
+		CHECK(PAGE_LRU_IS(hot[j], PG_ACTIVE));
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long rounds;
+
+	rounds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+	srand(1);
+
+	test_model(rounds);
+	test_scan();
+
+	if(errors)
+	{
+		printf("%d checks failed\n", errors);
+		return 1;
+	}
+
+	printf("lru tests passed, %lu rounds\n", rounds);
+	return 0;
+}
@@ -33,6 +33,7 @@
 #include <cluster.h>
 #include <vfs.h>
 #include <vm_region.h>
+#include <swap.h>
 
 static void mapper_ctor(struct kcm_s *kcm, void *ptr) 
 {
@@ -232,6 +233,56 @@ void mapper_remove_page(struct page_s *page)
 	kmem_free(&req);
 }
 
+static error_t __mapper_evict_page(struct mapper_s *mapper, struct page_s *page, bool_t isUnused)
+{
+	kmem_req_t req;
+	uint_t irq_state;
+	error_t err;
+
+	mcs_lock(&mapper->m_lock, &irq_state);
+
+	/* Lookups take their reference under the mapper lock */
+	if((page->mapper != mapper) || (radix_tree_lookup(&mapper->m_radix, page->index) != page))
+		err = ENOENT;
+	else if(PAGE_IS(page, PG_DIRTY | PG_MAPPED | PG_INLOAD))
+		err = EBUSY;
+	else if(isUnused && (page_refcount_get(page) > 2))
+		err = EBUSY;
+	else
+	{
+		__mapper_remove_page(mapper, page);
+		err = 0;
+	}
+
+	mcs_unlock(&mapper->m_lock, irq_state);
+
+	if(err) return err;
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+	return 0;
+}
+
+error_t mapper_evict_page(struct mapper_s *mapper, struct page_s *page)
+{
+	return __mapper_evict_page(mapper, page, false);
+}
+
+error_t mapper_evict_unused_page(struct mapper_s *mapper, struct page_s *page)
+{
+	return __mapper_evict_page(mapper, page, true);
+}
+
+void mapper_put_page(struct page_s *page)
+{
+	kmem_req_t req;
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+}
+
 MAPPER_RELEASE_PAGE(mapper_default_release_page)
 {
 #if 0
@@ -248,6 +299,15 @@ MAPPER_RELEASE_PAGE(mapper_default_release_page)
 }
 
 struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t flags, void* data)
+{
+	return mapper_get_page_on(mapper, index, flags, data, NULL);
+}
+
+struct page_s* mapper_get_page_on(struct mapper_s* mapper, 
+				  uint_t index, 
+				  uint_t flags, 
+				  void* data, 
+				  struct cluster_s *cluster)
 {
 	kmem_req_t req;
 	struct page_s dummy;
@@ -264,6 +324,12 @@ struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t fla
 	req.size  = 0;
 	req.flags = AF_USER;
 
+	if(cluster != NULL)
+	{
+		req.flags |= AF_REMOTE;
+		req.ptr    = cluster;
+	}
+
 	while (1) 
 	{
 		mcs_lock(&mapper->m_lock, &irq_state);
@@ -336,8 +402,13 @@ struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t fla
 			err = radix_item_info_apply(&mapper->m_radix, &info, RADIX_INFO_SET, page);
 			assert(err == 0);
 			PAGE_CLEAR(page, PG_INLOAD);
+			page_refcount_up(page);
 			wakeup_all(&dummy.wait_queue);
 			mcs_unlock(&mapper->m_lock,irq_state);
+#if CONFIG_PPM_RECLAIM
+			if((mapper->m_node != NULL) || (swap_cache_isMapper(mapper)))
+				ppm_lru_add(page, false);
+#endif
 			return page;
 		}
 
@@ -371,7 +442,11 @@ struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t fla
 			}
 			else
 			{
+				page_refcount_up(page);
 				mcs_unlock(&mapper->m_lock, irq_state);
+#if CONFIG_PPM_RECLAIM
+				ppm_lru_touch(page);
+#endif
 				return page;
 			}
 
@@ -407,6 +482,11 @@ struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t fla
 			if((err == 0) && (new != NULL))
 				err2 = radix_item_info_apply(&mapper->m_radix, &info, RADIX_INFO_SET, new);
 
+			if((new == NULL) || (err != 0) || (err2 != 0))
+				page_refcount_up(page);
+			else
+				page_refcount_up(new);
+
 			wakeup_all(&dummy.wait_queue);
 
 			mcs_unlock(&mapper->m_lock, irq_state);
@@ -427,7 +507,11 @@ struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t fla
 			return new;
 		}
 
+		page_refcount_up(page);
 		mcs_unlock(&mapper->m_lock, irq_state);
+#if CONFIG_PPM_RECLAIM
+		ppm_lru_touch(page);
+#endif
 		return page;
 	}
 
@@ -456,6 +540,165 @@ fail_alloc_load:
 	return NULL;
 }
 
+error_t mapper_prefetch_page(struct mapper_s *mapper, 
+			     uint_t index, 
+			     uint_t flags, 
+			     void *data, 
+			     struct page_s **held)
+{
+	kmem_req_t req;
+	struct page_s *page;
+	radix_item_info_t info;
+	uint_t irq_state;
+	bool_t found;
+	error_t err;
+
+again:
+	mcs_lock(&mapper->m_lock, &irq_state);
+	page = radix_tree_lookup(&mapper->m_radix, index);
+
+	/* Synchronous loaders insert a dummy page, wait for the real one */
+	while((held != NULL) && (page != NULL) && (PAGE_IS(page, PG_INLOAD)))
+	{
+		if(flags & MAPPER_NOWAIT_OP)
+		{
+			mcs_unlock(&mapper->m_lock, irq_state);
+			return EAGAIN;
+		}
+
+		wait_on(&page->wait_queue, WAIT_LAST);
+		mcs_unlock(&mapper->m_lock, irq_state);
+		sched_sleep(current_thread);
+		mcs_lock(&mapper->m_lock, &irq_state);
+		page = radix_tree_lookup(&mapper->m_radix, index);
+	}
+
+	err = ((page != NULL) && (PAGE_IS(page, PG_INLOAD))) ? EINPROGRESS : 0;
+
+	if((page != NULL) && (held != NULL))
+	{
+		page_refcount_up(page);
+		*held = page;
+	}
+
+	mcs_unlock(&mapper->m_lock, irq_state);
+
+	if(page != NULL)
+		return err;
+
+	req.type  = KMEM_PAGE;
+	req.size  = 0;
+	req.flags = AF_USER;
+
+	if((page = kmem_alloc(&req)) == NULL)
+		return ENOMEM;
+
+	PAGE_SET(page, PG_INLOAD);
+	page->mapper = mapper;
+	page->index  = index;
+
+	mcs_lock(&mapper->m_lock, &irq_state);
+	found = radix_item_info_lookup(&mapper->m_radix, index, &info);
+
+	if((found == true) && (info.item != NULL))
+	{
+		/* Lost the race against another loader */
+		err = (PAGE_IS((struct page_s*)info.item, PG_INLOAD)) ? EINPROGRESS : 0;
+		mcs_unlock(&mapper->m_lock, irq_state);
+
+		if(held == NULL)
+			goto fail_insert;
+
+		page->mapper = NULL;
+		req.ptr      = page;
+		kmem_free(&req);
+		goto again;
+	}
+
+	if(found == true)
+		err = radix_item_info_apply(&mapper->m_radix, &info, RADIX_INFO_INSERT, page);
+	else
+		err = radix_tree_insert(&mapper->m_radix, index, page);
+
+	if(err) __mapper_remove_page(mapper, page);
+
+	/* Taken before the fill, whose failure drops the mapper's one */
+	if((err == 0) && (held != NULL))
+		page_refcount_up(page);
+
+	mcs_unlock(&mapper->m_lock, irq_state);
+
+	if(err) goto fail_insert;
+
+	/* Page is visible, other loaders wait on its queue */
+	err = mapper->m_ops->readpage(page, MAPPER_SYNC_OP | MAPPER_ASYNC_OP, data);
+
+	if(err != EINPROGRESS)
+		mapper_io_end(page, err);
+
+	if((err == 0) || (err == EINPROGRESS))
+	{
+		if(held != NULL)
+			*held = page;
+
+		return err;
+	}
+
+	if(held != NULL)
+	{
+		req.ptr = page;
+		kmem_free(&req);
+	}
+
+	return err;
+
+fail_insert:
+	page->mapper = NULL;
+	req.ptr      = page;
+	kmem_free(&req);
+	return err;
+}
+
+void mapper_io_end(struct page_s *page, error_t err)
+{
+	struct mapper_s *mapper;
+	kmem_req_t req;
+	uint_t irq_state;
+	uint_t index;
+
+	mapper = page->mapper;
+	index  = page->index;
+
+	mcs_lock(&mapper->m_lock, &irq_state);
+
+	if(err) __mapper_remove_page(mapper, page);
+
+	PAGE_CLEAR(page, PG_INLOAD);
+	wakeup_all(&page->wait_queue);
+	mcs_unlock(&mapper->m_lock, irq_state);
+
+	/* Asynchronous I/O requests waiting for this page */
+	vfs_aio_page_end(mapper, index);
+
+#if CONFIG_PPM_RECLAIM
+	if((err == 0) && ((mapper->m_node != NULL) || (swap_cache_isMapper(mapper))))
+		ppm_lru_add(page, false);
+#endif
+
+	if(err == 0) return;
+
+	printk(WARNING, "WARNING: %s: cpu %d, failed to load page, index %d, err %d [%u]\n",
+	       __FUNCTION__,
+	       cpu_get_id(),
+	       page->index,
+	       err,
+	       cpu_time_stamp());
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+}
+
 void mapper_destroy(struct mapper_s *mapper, bool_t doSync)
 {
 	kmem_req_t req;
@@ -479,9 +722,9 @@ void mapper_destroy(struct mapper_s *mapper, bool_t doSync)
 			{
 				page_lock(pages[j]);
 				mapper->m_ops->sync_page(pages[j]);
+				__mapper_remove_page(mapper,pages[j]);
 				page_unlock(pages[j]);
 
-				__mapper_remove_page(mapper,pages[j]);
 				req.ptr = pages[j];
 				kmem_free(&req);
 			}
@@ -505,7 +748,11 @@ void mapper_destroy(struct mapper_s *mapper, bool_t doSync)
 				page_unlock(pages[j]);
 			}
 
+			/* Waits for the page reclaim, which may be using this mapper */
+			page_lock(pages[j]);
 			__mapper_remove_page(mapper,pages[j]);
+			page_unlock(pages[j]);
+
 			req.ptr = pages[j];
 			kmem_free(&req);
 		}
@@ -32,8 +32,11 @@
 
 struct vfs_file_s;
 struct page_s;
+struct cluster_s;
 
 #define MAPPER_SYNC_OP              0x01
+#define MAPPER_ASYNC_OP             0x02  /* readpage may return EINPROGRESS */
+#define MAPPER_NOWAIT_OP            0x04  /* mapper_prefetch_page does not sleep */
 
 #define MAPPER_READ_PAGE(n)         error_t (n) (struct page_s *page, uint_t flags, void *data)
 #define MAPPER_WRITE_PAGE(n)        error_t (n) (struct page_s *page, uint_t flags, void *data)
@@ -188,10 +191,43 @@ error_t mapper_add_page(struct mapper_s *mapper, struct page_s* page, uint_t ind
  */
 void mapper_remove_page(struct page_s* page);
 
+/**
+ * Evicts a clean page from the pagecache on behalf of the
+ * page reclaim or the swap, the page is kept if it has been
+ * dirtied, mapped or removed meanwhile. The caller holds its
+ * own reference on the page, and locks it unless its content
+ * is no more needed.
+ *
+ * @mapper	mapper the page was found in
+ * @page	page to evict
+ * @return	0 if the page is no more in the pagecache
+ */
+error_t mapper_evict_page(struct mapper_s *mapper, struct page_s *page);
+
+/**
+ * Same as mapper_evict_page, the page being also kept while
+ * anyone else than the pagecache and the caller holds it.
+ *
+ * @mapper	mapper the page was found in
+ * @page	page to evict
+ * @return	0 if the page is no more in the pagecache
+ */
+error_t mapper_evict_unused_page(struct mapper_s *mapper, struct page_s *page);
+
+/**
+ * Releases the reference taken on a page by mapper_get_page,
+ * mapper_get_page_on or mapper_prefetch_page.
+ *
+ * @page	page to release
+ */
+void mapper_put_page(struct page_s *page);
+
 /**
  * Reads into the pagecache, fills it if needed.
  * If the page already exists, ensures that it is
- * up to date.
+ * up to date. The page is returned with a reference
+ * that keeps the page reclaim from freeing it, the
+ * caller releases it by mapper_put_page.
  *
  * @mapper	mapper for the page
  * @index	page index
@@ -201,6 +237,50 @@ void mapper_remove_page(struct page_s* page);
  */
 struct page_s* mapper_get_page(struct mapper_s*	mapper, uint_t index, uint_t flags, void *data);
 
+/**
+ * Same as mapper_get_page, a page missing from the 
+ * pagecache being allocated on the given cluster.
+ *
+ * @cluster     cluster to allocate from, NULL for the default placement
+ */
+struct page_s* mapper_get_page_on(struct mapper_s* mapper, 
+				  uint_t index, 
+				  uint_t flags, 
+				  void *data, 
+				  struct cluster_s *cluster);
+
+/**
+ * Starts filling a pagecache page without waiting for it.
+ * The page is inserted with PG_INLOAD set and readpage is
+ * called with MAPPER_SYNC_OP | MAPPER_ASYNC_OP, backends
+ * ignoring the latter load it synchronously.
+ * @mapper	mapper for the page
+ * @index	page index
+ * @flags       MAPPER_NOWAIT_OP to fail with EAGAIN instead
+ *              of waiting for a page loaded by another thread
+ * @data        opaque parameter
+ * @held        if not NULL, set to a new reference on the page
+ *              unless the fill failed, a page being loaded by
+ *              another thread is then waited for
+ * @return	0 if the page is up to date, EINPROGRESS
+ *              if it is being loaded, error code otherwise
+ */
+error_t mapper_prefetch_page(struct mapper_s *mapper, 
+			     uint_t index, 
+			     uint_t flags, 
+			     void *data, 
+			     struct page_s **held);
+
+/**
+ * Ends an asynchronous page fill, called by the backend
+ * I/O completion (blkio events), then ends the asynchronous
+ * I/O requests waiting for it. On error, the page is
+ * removed from the mapper and freed.
+ * @page	page being loaded
+ * @err         I/O error code, 0 if OK
+ */
+void mapper_io_end(struct page_s *page, error_t err);
+
 
 /**
  * Writes and frees all the dirty pages from a mapper.
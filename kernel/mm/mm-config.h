@@ -35,6 +35,12 @@
 #define CONFIG_PPM_URGENT_PGMIN       5
 #define CONFIG_PPM_KPRIO_PGMIN        15
 #define CONFIG_PPM_UPRIO_PGMIN        80
+#define CONFIG_PPM_PAGES_LOW          20
+#define CONFIG_PPM_PAGES_HIGH         30
+#define CONFIG_PPM_LRU_BATCH          32
+#define CONFIG_PPM_RECLAIM_BACKOFF    10
+#define CONFIG_SWAP_PAGES_MAX         16384
+#define CONFIG_SWAP_CLUSTER           8
 #define CONFIG_KHEAP_ORDER            7
 #define CONFIG_VM_REGION_KEYWIDTH     16
 #define CONFIG_DMA_RQ_KCM_MIN         2
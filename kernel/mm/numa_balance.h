@@ -0,0 +1,123 @@
+/*
+ * mm/numa_balance.h - automatic NUMA balancing policy
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _NUMA_BALANCE_H_
+#define _NUMA_BALANCE_H_
+
+#include <types.h>
+
+/**
+ * The access sampling itself lives in vmm.c: vmm_numa_scan() revokes the
+ * access to some private pages of a task (PMM_HINT), and the resulting
+ * hinting faults are fed to the decisions below. They only deal with
+ * clusters identifiers, so they can be exercised outside of the kernel.
+ */
+
+#define NUMA_CID_NONE      0xFFFF
+#define NUMA_VOTES_MAX     64
+
+/* Hinting faults history of a page */
+struct numa_stat_s
+{
+	uint16_t cid;		/* cluster of the last hinting fault */
+	uint16_t hits;		/* consecutive hinting faults from cid */
+};
+
+/* Memory home of a thread, majority of the clusters its pages live on */
+struct numa_vote_s
+{
+	uint16_t cid;
+	uint16_t votes;
+};
+
+static inline void numa_stat_init(struct numa_stat_s *stat)
+{
+	stat->cid  = NUMA_CID_NONE;
+	stat->hits = 0;
+}
+
+/**
+ * Records a hinting fault taken from cluster cid on a page living on
+ * cluster page_cid. Only an uninterrupted series of threshold remote
+ * faults from the same cluster asks for a migration, so pages shared
+ * by several clusters do not bounce between them.
+ *
+ * @stat        : page history
+ * @cid         : faulting cluster
+ * @page_cid    : cluster of the page
+ * @threshold   : remote faults needed to migrate
+ * @return      : true if the page has to move to cid
+ */
+static inline bool_t numa_stat_fault(struct numa_stat_s *stat,
+				     uint_t cid,
+				     uint_t page_cid,
+				     uint_t threshold)
+{
+	if((cid == page_cid) || (stat->cid != cid))
+	{
+		stat->cid  = cid;
+		stat->hits = 0;
+	}
+
+	if(cid == page_cid)
+		return false;
+
+	if(++ stat->hits < threshold)
+		return false;
+
+	stat->hits = 0;
+	return true;
+}
+
+static inline void numa_vote_init(struct numa_vote_s *vote)
+{
+	vote->cid   = NUMA_CID_NONE;
+	vote->votes = 0;
+}
+
+/* Counts a hinting fault of a thread on a page living on cluster cid */
+static inline void numa_vote(struct numa_vote_s *vote, uint_t cid)
+{
+	if(vote->cid == cid)
+	{
+		if(vote->votes < NUMA_VOTES_MAX)
+			vote->votes ++;
+		return;
+	}
+
+	if(vote->votes == 0)
+	{
+		vote->cid   = cid;
+		vote->votes = 1;
+		return;
+	}
+
+	vote->votes --;
+}
+
+/* Gives the memory home of a thread, or NUMA_CID_NONE if not yet known */
+static inline uint_t numa_vote_home(struct numa_vote_s *vote, uint_t threshold)
+{
+	return (vote->votes >= threshold) ? vote->cid : NUMA_CID_NONE;
+}
+
+#endif	/* _NUMA_BALANCE_H_ */
@@ -0,0 +1,268 @@
+/*
+ * mm/numatest.c - host simulation of the NUMA balancing policy
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Pages are plain (cid, numa_stat_s) pairs here: each synthetic hinting
+ * fault goes through numa_stat_fault() and numa_vote() exactly as in
+ * vmm_hint_fault(), with the CONFIG_NUMA_* thresholds of kernel-config.h.
+ * The traces cover a private page, a page shared by several clusters,
+ * a moving majority and a whole task with one thread per cluster.
+ * numa_balance.h needs no other kernel header, so the host compiler
+ * builds it directly (the Makefile leaves *test.c out):
+ *
+ *   cc -idirafter ../kern -idirafter ../libk -o numatest numatest.c && ./numatest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* stand for libk/types.h and libk/config.h */
+#define _TYPES_H_
+#define _CONFIG_H_
+#define false  0
+#define true   1
+typedef unsigned long uint_t;
+typedef unsigned long bool_t;
+
+#include <kernel-config.h>
+#include "numa_balance.h"
+
+#define CLUSTERS_NR   4
+#define PAGES_NR      256
+#define THREADS_NR    CLUSTERS_NR
+
+static int errors;
+
+#define CHECK(cond)							\
+	do {								\
+		if(!(cond))						\
+		{							\
+			printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			errors ++;					\
+		}							\
+	} while(0)
+
+struct sim_page_s
+{
+	uint_t cid;
+	struct numa_stat_s numa;
+};
+
+/* One hinting fault of a thread running on cid, as in vmm_hint_fault() */
+static bool_t sim_fault(struct sim_page_s *page, struct numa_vote_s *vote, uint_t cid)
+{
+	bool_t isMove;
+
+	isMove = numa_stat_fault(&page->numa, cid, page->cid, CONFIG_NUMA_MGRT_THRESHOLD);
+	numa_vote(vote, (isMove) ? cid : page->cid);
+
+	if(isMove)
+		page->cid = cid;
+
+	return isMove;
+}
+
+static void sim_page_init(struct sim_page_s *page, uint_t cid)
+{
+	page->cid = cid;
+	numa_stat_init(&page->numa);
+}
+
+/* A private page touched from a remote cluster follows it, then stays */
+static void test_private(void)
+{
+	struct sim_page_s page;
+	struct numa_vote_s vote;
+	uint_t i, moves;
+
+	sim_page_init(&page, 0);
+	numa_vote_init(&vote);
+
+	for(i = 0, moves = 0; i < 100; i++)
+	{
+		if(sim_fault(&page, &vote, 3))
+		{
+			CHECK(i == CONFIG_NUMA_MGRT_THRESHOLD - 1);
+			moves ++;
+		}
+	}
+
+	CHECK(moves == 1);
+	CHECK(page.cid == 3);
+	CHECK(numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) == 3);
+
+	/* the thread moves away: the page follows it once more */
+	for(i = 0, moves = 0; i < 100; i++)
+		moves += sim_fault(&page, &vote, 1);
+
+	CHECK(moves == 1);
+	CHECK(page.cid == 1);
+}
+
+/* A page shared by interleaved clusters does not bounce */
+static void test_shared(void)
+{
+	struct sim_page_s page;
+	struct numa_vote_s vote;
+	uint_t i, moves;
+
+	sim_page_init(&page, 0);
+	numa_vote_init(&vote);
+
+	for(i = 0, moves = 0; i < 1000; i++)
+		moves += sim_fault(&page, &vote, 1 + (i % 3));
+
+	CHECK(moves == 0);
+	CHECK(page.cid == 0);
+
+	/* random interleaving of two remote clusters: a migration needs a
+	 * run of threshold faults from the same one */
+	srand(1);
+	for(i = 0, moves = 0; i < 10000; i++)
+		moves += sim_fault(&page, &vote, 1 + (rand() & 1));
+
+	printf("shared page: %u migrations for 10000 faults from 2 clusters\n", (unsigned)moves);
+	CHECK(moves < 10000 / (1U << CONFIG_NUMA_MGRT_THRESHOLD) + 100);
+
+	/* local faults reset the remote series */
+	sim_page_init(&page, 0);
+	for(i = 0, moves = 0; i < 1000; i++)
+		moves += sim_fault(&page, &vote, (i & 1) ? 0 : 2);
+
+	CHECK(moves == 0);
+}
+
+/* The memory home of a thread is the majority cluster of its faults */
+static void test_vote(void)
+{
+	struct numa_vote_s vote;
+	uint_t i, cid, first;
+
+	srand(2);
+	numa_vote_init(&vote);
+	CHECK(numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) == NUMA_CID_NONE);
+
+	/* 70% of the faults on cluster 2 */
+	for(i = 0; i < 1000; i++)
+	{
+		cid = (rand() % 10 < 7) ? 2 : rand() % CLUSTERS_NR;
+		numa_vote(&vote, cid);
+	}
+
+	CHECK(numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) == 2);
+	CHECK(vote.votes <= NUMA_VOTES_MAX);
+
+	/* the majority moves to cluster 1, the home follows in bounded time */
+	for(i = 0, first = 0; i < 1000; i++)
+	{
+		numa_vote(&vote, (rand() % 10 < 9) ? 1 : 2);
+
+		if(!first && (numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) == 1))
+			first = i + 1;
+	}
+
+	printf("home vote: followed the new majority after %u faults\n", (unsigned)first);
+	CHECK(first != 0);
+	CHECK(first < 2 * (NUMA_VOTES_MAX + CONFIG_NUMA_HOME_THRESHOLD));
+	CHECK(numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) == 1);
+
+	/* no majority, no home most of the time */
+	numa_vote_init(&vote);
+	for(i = 0, first = 0; i < 1000; i++)
+	{
+		numa_vote(&vote, i % CLUSTERS_NR);
+		first += (numa_vote_home(&vote, CONFIG_NUMA_HOME_THRESHOLD) != NUMA_CID_NONE);
+	}
+
+	CHECK(first == 0);
+}
+
+/*
+ * Whole task: every page first touched by the main thread on cluster 0,
+ * then each thread works on its own slice and once in a while on a slice
+ * of another one. Scans sample a random subset of the pages.
+ */
+static void test_task(void)
+{
+	static struct sim_page_s pages[PAGES_NR];
+	struct numa_vote_s votes[THREADS_NR];
+	uint_t scan, i, tid, idx, cid, local, total, moves;
+	uint_t slice = PAGES_NR / THREADS_NR;
+
+	srand(3);
+
+	for(i = 0; i < PAGES_NR; i++)
+		sim_page_init(&pages[i], 0);
+
+	for(tid = 0; tid < THREADS_NR; tid++)
+		numa_vote_init(&votes[tid]);
+
+	for(scan = 0, moves = 0; scan < 64; scan++)
+	{
+		for(i = 0; i < CONFIG_NUMA_SCAN_PAGES; i++)
+		{
+			tid = rand() % THREADS_NR;
+			idx = tid * slice + rand() % slice;
+
+			if(rand() % 8 == 0)
+				idx = rand() % PAGES_NR;
+
+			moves += sim_fault(&pages[idx], &votes[tid], tid);
+		}
+	}
+
+	for(i = 0, local = 0, total = 0; i < PAGES_NR; i++)
+	{
+		local += (pages[i].cid == i / slice);
+		total ++;
+	}
+
+	printf("task: %u/%u pages on their thread cluster, %u migrations\n",
+	       (unsigned)local, (unsigned)total, (unsigned)moves);
+
+	CHECK(local * 10 >= total * 9);
+	CHECK(moves < 2 * PAGES_NR);
+
+	for(tid = 0; tid < THREADS_NR; tid++)
+	{
+		cid = numa_vote_home(&votes[tid], CONFIG_NUMA_HOME_THRESHOLD);
+		CHECK(cid == tid);
+	}
+}
+
+int main(void)
+{
+	test_private();
+	test_shared();
+	test_vote();
+	test_task();
+
+	if(errors)
+	{
+		printf("%d checks failed\n", errors);
+		return 1;
+	}
+
+	printf("numa balancing tests passed\n");
+	return 0;
+}
@@ -146,6 +146,21 @@ void page_lock(struct page_s *page)
 	}
 }
 
+bool_t page_trylock(struct page_s *page)
+{
+	bool_t isLocked;
+
+	spin_lock(&page->lock);
+
+	isLocked = (PAGE_IS(page, PG_LOCKED)) ? true : false;
+
+	if(isLocked == false)
+		PAGE_SET(page, PG_LOCKED);
+
+	spin_unlock(&page->lock);
+	return (isLocked == false);
+}
+
 void page_unlock(struct page_s *page)
 {
 	register bool_t isEmpty;
@@ -28,6 +28,7 @@
 #include <types.h>
 #include <list.h>
 #include <wait_queue.h>
+#include <numa_balance.h>
 
 #define PG_INIT		0x001
 #define PG_RESERVED	0x002
@@ -40,6 +41,8 @@
 #define PG_LOCKED       0x100
 #define PG_PINNED       0x200
 #define PG_MIGRATE      0x400
+#define PG_MAPPED       0x4000
+#define PG_ANON         0x8000
 
 typedef enum
 {
@@ -56,14 +59,23 @@ typedef enum
 #define PAGE_CLEAR(page,flag)  ((page)->flags) &= ~(flag)
 #define PAGE_IS(page,flag)     ((page)->flags) & (flag)
 
+/* Replacement state, in lru_flags and only changed under the ppm lru_lock */
+#define PG_LRU          0x001
+#define PG_ACTIVE       0x002
+#define PG_REFERENCED   0x004
+
+#define PAGE_LRU_SET(page,flag)    ((page)->lru_flags) |= (flag)
+#define PAGE_LRU_CLEAR(page,flag)  ((page)->lru_flags) &= ~(flag)
+#define PAGE_LRU_IS(page,flag)     ((page)->lru_flags) & (flag)
+
 struct ppm_s;
 
 struct page_s
 {
 	/* flags */
-	uint32_t state : 4;
-	uint32_t flags : 12;
-	uint32_t cid   : 12;
+	uint32_t state : 3;
+	uint32_t flags : 16;
+	uint32_t cid   : 9;
 	uint32_t order : 4;
 
 	/* waiting threads */
@@ -92,6 +104,14 @@ struct page_s
 	/* Allocation/Replacement policies list */
 	struct list_entry list;
 
+	/* Replacement flags, apart from the flags set under other locks */
+	uint_t lru_flags;
+
+#if CONFIG_NUMA_BALANCING
+	/* Hinting faults history */
+	struct numa_stat_s numa;
+#endif
+
 	/* Reference Count & lock */
 	refcount_t count;
 	slock_t    lock;
@@ -117,6 +137,7 @@ bool_t page_clear_dirty(struct page_s *page);
 void page_copy(struct page_s *dst, struct page_s *src);
 void page_zero(struct page_s *page);
 void page_lock(struct page_s *page);
+bool_t page_trylock(struct page_s *page);
 void page_unlock(struct page_s *page);
 
 void page_state_set(struct page_s *page, page_state_t new_state);
@@ -137,8 +158,11 @@ void page_print(struct page_s *page);
 
 #define MCNTL_READ           0x0
 #define MCNTL_L1_iFLUSH      0x1
-#define MCNTL_MOVE           0x2 /* this operation is not implemented in this version */
-#define MCNTL_OPS_NR         MCNTL_MOVE //(MCNTL_MOVE + 1)
+#define MCNTL_MOVE           0x2
+#define MCNTL_OPS_NR         (MCNTL_MOVE + 1)
+
+/* mi_cid of a page which is not (or no more) backed by physical memory */
+#define MCNTL_CID_NONE       ((uint_t)-1)
 
 struct minfo_s
 {
@@ -161,6 +185,7 @@ static inline void page_init(struct page_s *page, uint_t cid)
 	wait_queue_init(&page->wait_queue, "Page");
 	page->state = PGINIT;
 	page->flags = 0;
+	page->lru_flags = 0;
 	page->order = 0;
 	page->cid = cid;
 	refcount_init(&page->count);
@@ -169,6 +194,9 @@ static inline void page_init(struct page_s *page, uint_t cid)
 	page->index = 0;
 	page->mapper = NULL;
 	page->private = 0;
+#if CONFIG_NUMA_BALANCING
+	numa_stat_init(&page->numa);
+#endif
 }
 
 static inline page_state_t page_state_get(struct page_s *page)
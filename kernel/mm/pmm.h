@@ -49,6 +49,7 @@
 #define PMM_SWAP
 #define PMM_LOCKED
 #define PMM_CLEAR
+#define PMM_HINT
 
 /** Page flags */
 #define PMM_TEXT
@@ -64,6 +65,10 @@
 #define pmm_except_isRights(flags) 
 #define pmm_except_isInKernelMode(flags)
 
+/** Reports of a kernel access to a user page, given to the fault path */
+#define PMM_EXCEPT_KREAD
+#define PMM_EXCEPT_KWRITE
+
 /** 
  * Structure provided 
  * by this interface 
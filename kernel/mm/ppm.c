@@ -109,6 +109,12 @@ error_t ppm_init(struct ppm_s *ppm,
 	for(i=0; i < PPM_MAX_WAIT; i++)
 		wait_queue_init(&ppm->wait_tbl[i], "PPM WAIT TBL");
 
+#if CONFIG_PPM_RECLAIM
+	spinlock_init(&ppm->lru_lock, "PPM LRU");
+	lru_init(&ppm->lru);
+	wait_queue_init(&ppm->reclaim_wq, "PPM Reclaim");
+#endif
+
 	err = ppm_init_finalize(ppm, info);
 
 	if(err != 0) return err;
@@ -117,6 +123,11 @@ error_t ppm_init(struct ppm_s *ppm,
 	ppm->kprio_pages_min  = (ppm->free_pages_nr * (CONFIG_PPM_KPRIO_PGMIN)) / 100;
 	ppm->urgent_pages_min = (ppm->free_pages_nr * (CONFIG_PPM_URGENT_PGMIN)) / 100;
 
+#if CONFIG_PPM_RECLAIM
+	ppm->pages_low  = (ppm->free_pages_nr * (CONFIG_PPM_PAGES_LOW)) / 100;
+	ppm->pages_high = (ppm->free_pages_nr * (CONFIG_PPM_PAGES_HIGH)) / 100;
+#endif
+
 
 	if(info->local_cluster_id == info->boot_cluster_id)
 	{
@@ -279,9 +290,20 @@ void ppm_free_pages(struct page_s *page)
 	register uint_t index;
 	uint_t irq_state;
 
-	if((order = page_refcount_down(page)) > 1)
+#if CONFIG_PPM_RECLAIM
+	if(PAGE_LRU_IS(page, PG_LRU))
+		order = ppm_lru_put(page);
+	else
+#endif
+		order = page_refcount_down(page);
+
+	if(order > 1)
 		return;
 
+#if CONFIG_PPM_RECLAIM
+	PAGE_CLEAR(page, PG_MAPPED | PG_ANON);
+#endif
+
 	ppm   = page_get_ppm(page);
 	order = page->order;
 	index = page - ppm->pages_tbl;
@@ -27,6 +27,7 @@
 #include <list.h>
 #include <spinlock.h>
 #include <wait_queue.h>
+#include <lru.h>
 
 #define PPM_MAX_ORDER     CONFIG_PPM_MAX_ORDER
 #define PPM_MAX_WAIT      PPM_MAX_ORDER 
@@ -147,6 +148,51 @@ struct page_s* ppm_alloc_pages(struct ppm_s *ppm, uint_t order, uint_t flags);
  **/
 void ppm_free_pages(struct page_s *page);
 
+#if CONFIG_PPM_RECLAIM
+/**
+ * Puts a page on the LRU of its cluster so it may be reclaimed
+ * once it gets cold, only file pages are evicted for now
+ *
+ * @page         Page which is not yet on the LRU
+ * @isActive     The page is known to be in use
+ **/
+void ppm_lru_add(struct page_s *page, bool_t isActive);
+
+/**
+ * Records an access to a page which may be on the LRU
+ *
+ * @page         Accessed page
+ **/
+void ppm_lru_touch(struct page_s *page);
+
+/**
+ * Tries to free count pages of the given PPM by evicting its
+ * coldest clean page-cache pages, dirty ones are first written
+ * back if doWriteback is set (the caller may then sleep on I/O)
+ *
+ * @ppm          PPM to reclaim pages from
+ * @count        Number of pages to free
+ * @doWriteback  Write back the dirty victims
+ * @return       Number of freed pages
+ **/
+uint_t ppm_reclaim(struct ppm_s *ppm, uint_t count, bool_t doWriteback);
+
+/**
+ * Wakes up the reclaim thread of the given PPM if it is sleeping
+ *
+ * @ppm          PPM which is under its low watermark
+ **/
+void ppm_reclaim_wakeup(struct ppm_s *ppm);
+
+/**
+ * Per-cluster reclaim thread, keeps the free pages of its PPM
+ * between the low and the high watermarks
+ *
+ * @arg          The PPM to take care of
+ **/
+void* ppm_reclaimd(void *arg);
+#endif
+
 /////////////////////////////////////////////
 ///             Private Section           ///
 /////////////////////////////////////////////
@@ -179,6 +225,13 @@ struct ppm_s
 	uint_t begin;
 	spinlock_t wait_lock;
 	struct wait_queue_s wait_tbl[PPM_MAX_WAIT];
+#if CONFIG_PPM_RECLAIM
+	spinlock_t lru_lock;
+	struct lru_s lru;
+	uint_t pages_low;
+	uint_t pages_high;
+	struct wait_queue_s reclaim_wq;
+#endif
 };
 
 struct ppm_dqdt_req_s
@@ -214,6 +267,11 @@ static inline uint_t ppm_wakeup_all(struct ppm_s *ppm, struct page_s *page)
 	return count;
 }
 
+#if CONFIG_PPM_RECLAIM
+/* Drops a reference on a page which is on the LRU, returns the old count */
+uint_t ppm_lru_put(struct page_s *page);
+#endif
+
 void ppm_print(struct ppm_s *ppm);
 void ppm_assert_order(struct ppm_s *ppm);
 /////////////////////////////////////////////
@@ -0,0 +1,359 @@
+/*
+ * mm/ppm_reclaim.c - Per-cluster pages reclaim
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <types.h>
+#include <errno.h>
+#include <list.h>
+#include <spinlock.h>
+#include <wait_queue.h>
+#include <thread.h>
+#include <scheduler.h>
+#include <cluster.h>
+#include <cpu.h>
+#include <kmem.h>
+#include <page.h>
+#include <ppm.h>
+#include <lru.h>
+#include <mapper.h>
+#include <vmm.h>
+#include <rwlock.h>
+#include <swap.h>
+#include <event.h>
+#include <time.h>
+#include <kdmsg.h>
+
+#if CONFIG_PPM_RECLAIM
+
+/* What to do with a victim that could not be evicted */
+#define PPM_LRU_DROP       0	/* not reclaimable, leaves the LRU */
+#define PPM_LRU_ACTIVE     1	/* in use or failed, back to the active list */
+#define PPM_LRU_INACTIVE   2	/* transiently busy, will be retried */
+
+void ppm_lru_add(struct page_s *page, bool_t isActive)
+{
+	struct ppm_s *ppm;
+	uint_t irq_state;
+
+	ppm = page_get_ppm(page);
+
+	spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+
+	if(!(PAGE_LRU_IS(page, PG_LRU)))
+		lru_add(&ppm->lru, page, isActive);
+
+	spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+}
+
+void ppm_lru_touch(struct page_s *page)
+{
+	struct ppm_s *ppm;
+	uint_t irq_state;
+
+	if(!(PAGE_LRU_IS(page, PG_LRU)))
+		return;
+
+	/* Already as hot as it can be */
+	if((PAGE_LRU_IS(page, PG_ACTIVE)) && (PAGE_LRU_IS(page, PG_REFERENCED)))
+		return;
+
+	ppm = page_get_ppm(page);
+
+	spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+
+	if(PAGE_LRU_IS(page, PG_LRU))
+		lru_touch(&ppm->lru, page);
+
+	spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+}
+
+/*
+ * The reference count of a page on the LRU only drops under the LRU
+ * lock, so ppm_reclaim can safely take its own reference on a victim
+ */
+uint_t ppm_lru_put(struct page_s *page)
+{
+	struct ppm_s *ppm;
+	uint_t irq_state;
+	uint_t count;
+
+	ppm = page_get_ppm(page);
+
+	spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+
+	count = page_refcount_down(page);
+
+	if((count == 1) && (PAGE_LRU_IS(page, PG_LRU)))
+		lru_del(&ppm->lru, page);
+
+	spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+	return count;
+}
+
+static void ppm_lru_putback(struct ppm_s *ppm, struct page_s *page, uint_t where)
+{
+	uint_t irq_state;
+
+	if(where == PPM_LRU_DROP)
+		return;
+
+	spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+
+	if(!(PAGE_LRU_IS(page, PG_LRU)))
+		lru_add(&ppm->lru, page, (where == PPM_LRU_ACTIVE));
+
+	spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+}
+
+#if CONFIG_SWAP
+/* Hypothesis: the caller holds a reference on the page */
+static uint_t ppm_swap_page(struct page_s *page, bool_t doWriteback)
+{
+	struct vmm_s *vmm;
+	uint_t where;
+	error_t err;
+
+	if(!(swap_isEnabled()))
+		return PPM_LRU_ACTIVE;
+
+	/* Writing to the swap area is left to the reclaim thread */
+	if(doWriteback == false)
+		return PPM_LRU_INACTIVE;
+
+	if(page_trylock(page) == false)
+		return PPM_LRU_INACTIVE;
+
+	/* Holding the page lock keeps vm_region_unmap from releasing the vmm */
+	if((page->mapper != NULL) || !(PAGE_IS(page, PG_ANON)))
+	{
+		where = (page->mapper != NULL) ? PPM_LRU_INACTIVE : PPM_LRU_ACTIVE;
+		goto SWAP_END;
+	}
+
+	vmm   = page->data;
+	where = PPM_LRU_INACTIVE;
+
+	/* Keeps fork from sharing the page meanwhile */
+	if(rwlock_tryrdlock(&vmm->rwlock))
+		goto SWAP_END;
+
+	err = swap_out(vmm, page->index, page);
+	rwlock_unlock(&vmm->rwlock);
+
+	if(err == 0)
+		where = PPM_LRU_DROP;
+	else if(err != EAGAIN)
+		where = PPM_LRU_ACTIVE;
+
+SWAP_END:
+	page_unlock(page);
+	return where;
+}
+#endif	/* CONFIG_SWAP */
+
+/* Hypothesis: the caller holds a reference on the page */
+static uint_t ppm_evict_page(struct page_s *page, bool_t doWriteback)
+{
+	struct mapper_s *mapper;
+	uint_t where;
+	error_t err;
+
+	/* Anonymous memory has no backing store to go to but the swap area */
+	if(page->mapper == NULL)
+#if CONFIG_SWAP
+		return ppm_swap_page(page, doWriteback);
+#else
+		return PPM_LRU_ACTIVE;
+#endif
+
+	if(page_trylock(page) == false)
+		return PPM_LRU_INACTIVE;
+
+	/* Holding the page lock keeps mapper_destroy away */
+	mapper = page->mapper;
+	where  = PPM_LRU_DROP;
+
+	if((mapper == NULL) || (PAGE_IS(page, PG_MAPPED)))
+		goto EVICT_END;
+
+	/* Swap cache pages are clean copies of their slot */
+	if((mapper->m_node == NULL) && !(swap_cache_isMapper(mapper)))
+		goto EVICT_END;
+
+	where = PPM_LRU_INACTIVE;
+
+	if(PAGE_IS(page, PG_INLOAD))
+		goto EVICT_END;
+
+	/* Held beyond the mapper and us, e.g. by a pending asynchronous I/O */
+	if(page_refcount_get(page) > 2)
+		goto EVICT_END;
+
+	if(PAGE_IS(page, PG_DIRTY))
+	{
+		if(doWriteback == false)
+			goto EVICT_END;
+
+		err = mapper->m_ops->sync_page(page);
+
+		if(err)
+		{
+			where = PPM_LRU_ACTIVE;
+			goto EVICT_END;
+		}
+	}
+
+	/* Kept on the inactive list if it has been dirtied or looked up meanwhile */
+	if(mapper_evict_unused_page(mapper, page) != EBUSY)
+		where = PPM_LRU_DROP;
+
+EVICT_END:
+	page_unlock(page);
+	return where;
+}
+
+uint_t ppm_reclaim(struct ppm_s *ppm, uint_t count, bool_t doWriteback)
+{
+	struct page_s *page;
+	kmem_req_t req;
+	uint_t irq_state;
+	uint_t scan;
+	uint_t freed;
+	uint_t where;
+
+	req.type = KMEM_PAGE;
+	freed    = 0;
+
+	spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+	scan = ppm->lru.active_nr + ppm->lru.inactive_nr;
+	spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+
+	while((freed < count) && (scan != 0))
+	{
+		scan --;
+
+		spinlock_lock_noirq(&ppm->lru_lock, &irq_state);
+
+		/* Keeps the inactive list at least as long as the active one */
+		if(ppm->lru.inactive_nr < ppm->lru.active_nr)
+			(void)lru_age(&ppm->lru, CONFIG_PPM_LRU_BATCH);
+
+		page = lru_isolate(&ppm->lru, CONFIG_PPM_LRU_BATCH);
+
+		if(page != NULL)
+			page_refcount_up(page);
+
+		spinlock_unlock_noirq(&ppm->lru_lock, irq_state);
+
+		if(page == NULL)
+			continue;
+
+		where = ppm_evict_page(page, doWriteback);
+		ppm_lru_putback(ppm, page, where);
+
+		/* Dropping our own reference frees an evicted page */
+		if(page_refcount_get(page) == 1)
+			freed ++;
+
+		req.ptr = page;
+		kmem_free(&req);
+	}
+
+	return freed;
+}
+
+void ppm_reclaim_wakeup(struct ppm_s *ppm)
+{
+	uint_t irq_state;
+
+	if(wait_queue_isEmpty(&ppm->reclaim_wq))
+		return;
+
+	spinlock_lock_noirq(&ppm->wait_lock, &irq_state);
+	(void)wakeup_one(&ppm->reclaim_wq, WAIT_ANY);
+	spinlock_unlock_noirq(&ppm->wait_lock, irq_state);
+}
+
+static EVENT_HANDLER(ppm_reclaimd_alarm_event_handler)
+{
+	struct thread_s *reclaimd;
+
+	reclaimd = event_get_senderId(event);
+	sched_wakeup(reclaimd);
+	return 0;
+}
+
+void* ppm_reclaimd(void *arg)
+{
+	struct ppm_s *ppm;
+	struct thread_s *this;
+	struct alarm_info_s info;
+	struct event_s event;
+	uint_t irq_state;
+	uint_t count;
+	uint_t freed;
+
+	cpu_enable_all_irq(NULL);
+
+	ppm  = arg;
+	this = current_thread;
+
+	event_set_senderId(&event, this);
+	event_set_priority(&event, E_FUNC);
+	event_set_handler(&event, &ppm_reclaimd_alarm_event_handler);
+	info.event = &event;
+
+	printk(INFO, "INFO: Starting Pages Reclaim On Cluster %d, watermarks [%d, %d]\n",
+	       ppm_get_cluster(ppm)->id,
+	       ppm->pages_low,
+	       ppm->pages_high);
+
+	while(1)
+	{
+		spinlock_lock_noirq(&ppm->wait_lock, &irq_state);
+
+		if(ppm->free_pages_nr >= ppm->pages_low)
+		{
+			wait_on(&ppm->reclaim_wq, WAIT_LAST);
+			spinlock_unlock_nosched(&ppm->wait_lock);
+			sched_sleep(this);
+			cpu_restore_irq(irq_state);
+			continue;
+		}
+
+		spinlock_unlock_noirq(&ppm->wait_lock, irq_state);
+
+		count = ppm->free_pages_nr;
+		count = (count < ppm->pages_high) ? ppm->pages_high - count : 0;
+		freed = ppm_reclaim(ppm, count, true);
+
+		/* Only cold anonymous or mapped pages are left, let them warm up */
+		if(freed == 0)
+		{
+			alarm_wait(&info, CONFIG_PPM_RECLAIM_BACKOFF);
+			sched_sleep(this);
+		}
+	}
+
+	return NULL;
+}
+
+#endif	/* CONFIG_PPM_RECLAIM */
@@ -0,0 +1,413 @@
+/*
+ * mm/swap.c - swap area of anonymous memory
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <types.h>
+#include <errno.h>
+#include <libk.h>
+#include <bits.h>
+#include <spinlock.h>
+#include <mcs_sync.h>
+#include <thread.h>
+#include <scheduler.h>
+#include <device.h>
+#include <driver.h>
+#include <blkio.h>
+#include <kmem.h>
+#include <page.h>
+#include <ppm.h>
+#include <pmm.h>
+#include <radix.h>
+#include <mapper.h>
+#include <vmm.h>
+#include <kdmsg.h>
+#include <swap.h>
+
+#if CONFIG_SWAP
+
+struct swap_s swap_area;
+
+#define swap_slot2lba(_slot) (swap_area.start + ((_slot) * swap_area.sectors))
+
+static error_t swap_pgio(struct device_s *dev, struct page_s *page, uint_t lba, uint_t flags)
+{
+	struct blkio_s *blkio;
+	error_t err;
+
+	if((err = blkio_init(dev, page, 1)) != 0)
+		return err;
+
+	blkio                 = list_first(&page->root, struct blkio_s, b_list);
+	blkio->b_dev_rq.src   = (void*)lba;
+	blkio->b_dev_rq.dst   = (void*)ppm_page2addr(page);
+	blkio->b_dev_rq.count = swap_area.sectors;
+
+	if(flags & BLKIO_ASYNC)
+		return blkio_sync(page, flags | BLKIO_RELEASE);
+
+	err = blkio_sync(page, flags);
+	blkio_destroy(page);
+	return err;
+}
+
+static MAPPER_READ_PAGE(swap_cache_read_page)
+{
+	uint_t op_flags;
+
+	if(flags & MAPPER_ASYNC_OP)
+		op_flags = BLKIO_RD | BLKIO_ASYNC;
+	else
+		op_flags = (flags & MAPPER_SYNC_OP) ? BLKIO_RD | BLKIO_SYNC : BLKIO_RD;
+
+	return swap_pgio(swap_area.dev, page, swap_slot2lba(page->index), op_flags);
+}
+
+/* Swap cache pages are never dirty, swap_out writes them itself */
+static const struct mapper_op_s swap_cache_op =
+{
+	.writepage      = mapper_default_write_page,
+	.readpage       = swap_cache_read_page,
+	.sync_page      = mapper_default_sync_page,
+	.set_page_dirty = mapper_default_set_page_dirty,
+	.releasepage    = mapper_default_release_page,
+};
+
+error_t swap_init(void)
+{
+	struct device_s *dev;
+	struct mapper_s *cache;
+	struct page_s *page;
+	dev_params_t params;
+	kmem_req_t req;
+	uint_t slots_nr;
+	error_t err;
+
+	dev = __swap_blk;
+
+	spinlock_init(&swap_area.lock, "Swap Area");
+	swap_area.dev = NULL;
+
+	if(dev == NULL)
+	{
+		printk(INFO, "INFO: No Swap Device, Swapping Is Disabled\n");
+		return ENODEV;
+	}
+
+	if((err = dev->op.dev.get_params(dev, &params)) != 0)
+		return err;
+
+	if((params.sector_size == 0) || (PMM_PAGE_SIZE % params.sector_size))
+	{
+		printk(ERROR, "ERROR: %s: not supported sector size %d\n",
+		       __FUNCTION__, params.sector_size);
+		return EINVAL;
+	}
+
+	swap_area.sectors = PMM_PAGE_SIZE / params.sector_size;
+	swap_area.start   = swap_area.sectors;
+	slots_nr          = params.count / swap_area.sectors;
+
+	if(slots_nr < 2)
+		return EINVAL;
+
+	/* The first page is the header */
+	slots_nr = MIN(slots_nr - 1, CONFIG_SWAP_PAGES_MAX);
+
+	req.type  = KMEM_PAGE;
+	req.size  = 0;
+	req.flags = AF_KERNEL;
+
+	if((page = kmem_alloc(&req)) == NULL)
+		return ENOMEM;
+
+	err = swap_pgio(dev, page, 0, BLKIO_RD | BLKIO_SYNC);
+
+	if((err == 0) && strncmp(ppm_page2addr(page), SWAP_MAGIC, sizeof(SWAP_MAGIC) - 1))
+		err = EINVAL;
+
+	req.ptr = page;
+	kmem_free(&req);
+
+	if(err)
+	{
+		printk(WARNING, "WARNING: %s: no swap area found on %s, err %d\n",
+		       __FUNCTION__, dev->name, err);
+		return err;
+	}
+
+	req.type  = KMEM_GENERIC;
+	req.size  = slots_nr * sizeof(*swap_area.map);
+	req.flags = AF_KERNEL | AF_ZERO;
+
+	if((swap_area.map = kmem_alloc(&req)) == NULL)
+		return ENOMEM;
+
+	req.type  = KMEM_MAPPER;
+	req.size  = sizeof(*cache);
+	req.flags = AF_KERNEL;
+
+	if((cache = kmem_alloc(&req)) == NULL)
+		goto fail_cache;
+
+	if((err = mapper_init(cache, &swap_cache_op, NULL, NULL)))
+		goto fail_cache_init;
+
+	swap_area.cache    = cache;
+	swap_area.slots_nr = slots_nr;
+	swap_area.free_nr  = slots_nr;
+	swap_area.next     = 0;
+	swap_area.dev      = dev;
+
+	printk(INFO, "INFO: Swap Area On %s, %d Slots\n", dev->name, slots_nr);
+	return 0;
+
+fail_cache_init:
+	req.ptr = cache;
+	kmem_free(&req);
+
+fail_cache:
+	req.type = KMEM_GENERIC;
+	req.ptr  = swap_area.map;
+	kmem_free(&req);
+	return ENOMEM;
+}
+
+/* Next-fit, pages swapped out together get neighbouring slots */
+static uint_t swap_alloc(void)
+{
+	uint_t irq_state;
+	uint_t count;
+	uint_t slot;
+
+	slot = SWAP_SLOT_NONE;
+
+	spinlock_lock_noirq(&swap_area.lock, &irq_state);
+
+	for(count = (swap_area.free_nr) ? swap_area.slots_nr : 0; count != 0; count--)
+	{
+		slot           = swap_area.next;
+		swap_area.next = (slot + 1 == swap_area.slots_nr) ? 0 : slot + 1;
+
+		if(swap_area.map[slot] == 0)
+		{
+			swap_area.map[slot] = 1;
+			swap_area.free_nr --;
+			break;
+		}
+
+		slot = SWAP_SLOT_NONE;
+	}
+
+	spinlock_unlock_noirq(&swap_area.lock, irq_state);
+	return slot;
+}
+
+uint_t swap_count(uint_t slot)
+{
+	return swap_area.map[slot];
+}
+
+error_t swap_dup(uint_t slot)
+{
+	uint_t irq_state;
+	error_t err;
+
+	spinlock_lock_noirq(&swap_area.lock, &irq_state);
+
+	err = (swap_area.map[slot] == SWAP_COUNT_MAX) ? EAGAIN : 0;
+
+	if(err == 0)
+		swap_area.map[slot] ++;
+
+	spinlock_unlock_noirq(&swap_area.lock, irq_state);
+	return err;
+}
+
+/* Takes a reference on the up to date page of a slot if it is cached */
+static struct page_s* swap_cache_find(uint_t slot)
+{
+	struct mapper_s *cache;
+	struct page_s *page;
+	uint_t irq_state;
+
+	cache = swap_area.cache;
+
+	mcs_lock(&cache->m_lock, &irq_state);
+
+	page = radix_tree_lookup(&cache->m_radix, slot);
+
+	if((page != NULL) && (PAGE_IS(page, PG_INLOAD)))
+		page = NULL;
+
+	if(page != NULL)
+		page_refcount_up(page);
+
+	mcs_unlock(&cache->m_lock, irq_state);
+	return page;
+}
+
+void swap_free(uint_t slot)
+{
+	struct page_s *page;
+	kmem_req_t req;
+	uint_t irq_state;
+	uint_t count;
+
+	spinlock_lock_noirq(&swap_area.lock, &irq_state);
+
+	if((count = -- swap_area.map[slot]) == 0)
+		swap_area.free_nr ++;
+
+	spinlock_unlock_noirq(&swap_area.lock, irq_state);
+
+	if(count != 0)
+		return;
+
+	/* The cached copy of a released slot is out of date */
+	page = swap_cache_find(slot);
+
+	if(page == NULL)
+		return;
+
+	spinlock_lock_noirq(&swap_area.lock, &irq_state);
+
+	/* Checked under the lock, a reallocated slot keeps its new page */
+	if(swap_area.map[slot] == 0)
+		(void)mapper_evict_page(swap_area.cache, page);
+
+	spinlock_unlock_noirq(&swap_area.lock, irq_state);
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+}
+
+struct page_s* swap_cache_get(uint_t slot)
+{
+	return mapper_get_page(swap_area.cache, slot, MAPPER_SYNC_OP, NULL);
+}
+
+bool_t swap_cache_take(uint_t slot, struct page_s *page)
+{
+	if(swap_count(slot) != 1)
+		return false;
+
+	/* Last user of the slot, the swap cache's reference goes to the caller */
+	page_refcount_up(page);
+	(void)mapper_evict_page(swap_area.cache, page);
+	return true;
+}
+
+void swap_readahead(uint_t slot)
+{
+	uint_t start;
+	uint_t end;
+	uint_t i;
+
+	start = ARROUND_DOWN(slot, CONFIG_SWAP_CLUSTER);
+	end   = MIN(start + CONFIG_SWAP_CLUSTER, swap_area.slots_nr);
+
+	/* The faulting slot is submitted first */
+	if(mapper_prefetch_page(swap_area.cache, slot, 0, NULL, NULL) == ENOMEM)
+		return;
+
+	for(i = start; i < end; i++)
+	{
+		if((i == slot) || (swap_area.map[i] == 0))
+			continue;
+
+		if(mapper_prefetch_page(swap_area.cache, i, 0, NULL, NULL) == ENOMEM)
+			return;
+	}
+}
+
+error_t swap_out(struct vmm_s *vmm, uint_t vaddr, struct page_s *page)
+{
+	pmm_page_info_t info;
+	pmm_page_info_t old;
+	uint_t slot;
+	error_t err;
+
+	if((err = pmm_get_page(&vmm->pmm, vaddr, &info)))
+		return err;
+
+	/* Only a page mapped by vaddr alone, the other reference being ours */
+	if(!(info.attr & PMM_PRESENT)                                   ||
+	   (info.attr & (PMM_COW | PMM_MIGRATE | PMM_HINT | PMM_LOCKED)) ||
+	   (info.ppn != ppm_page2ppn(page))                              ||
+	   (page_refcount_get(page) != 2))
+		return EBUSY;
+
+	/* Second chance, the MMU sets the bits again on the next access */
+	if(info.attr & PMM_ACCESSED)
+	{
+		info.attr   &= ~(PMM_ACCESSED);
+		info.cluster = NULL;
+		(void)pmm_set_page(&vmm->pmm, vaddr, &info);
+		return EBUSY;
+	}
+
+	if((slot = swap_alloc()) == SWAP_SLOT_NONE)
+		return ENOSPC;
+
+	/* Fails without memory or on a stale page left by a readahead, released by swap_free */
+	if((err = mapper_add_page(swap_area.cache, page, slot)))
+	{
+		swap_free(slot);
+		return EAGAIN;
+	}
+
+	/* Its index is now the slot, a failure sets the reverse map again */
+	PAGE_CLEAR(page, PG_ANON);
+
+	old          = info;
+	old.cluster  = NULL;
+	info.attr    = PMM_SWAP;
+	info.ppn     = slot;
+	info.cluster = NULL;
+
+	/* From now on, the swap cache holds the reference of the mapping */
+	if((err = pmm_set_page(&vmm->pmm, vaddr, &info)))
+		goto fail_set;
+
+	err = swap_pgio(swap_area.dev, page, swap_slot2lba(slot), BLKIO_SYNC);
+
+	if(err == 0)
+	{
+		(void)mapper_evict_page(swap_area.cache, page);
+		return 0;
+	}
+
+	printk(WARNING, "WARNING: %s: failed to write slot %d, err %d\n",
+	       __FUNCTION__, slot, err);
+
+	(void)pmm_set_page(&vmm->pmm, vaddr, &old);
+
+fail_set:
+	/* Leaves the swap cache, keeping the reference of the mapping */
+	page_refcount_up(page);
+	(void)mapper_evict_page(swap_area.cache, page);
+	swap_rmap_set(page, vmm, vaddr);
+	swap_free(slot);
+	return err;
+}
+
+#endif	/* CONFIG_SWAP */
@@ -0,0 +1,177 @@
+/*
+ * mm/swap.h - swap area of anonymous memory
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _SWAP_H_
+#define _SWAP_H_
+
+#include <config.h>
+#include <types.h>
+#include <spinlock.h>
+#include <page.h>
+#include <pmm.h>
+
+struct device_s;
+struct mapper_s;
+struct page_s;
+struct vmm_s;
+struct vm_region_s;
+
+/**
+ * The swap area is a raw block device (the second one, __swap_blk)
+ * whose first page holds SWAP_MAGIC, the following pages are the
+ * slots. A private anonymous page which is swapped out leaves a swap
+ * entry in its PTE: PMM_SWAP without PMM_PRESENT, the slot number in
+ * place of the ppn. Each slot counts the PTEs referring to it, so a
+ * fork shares the slot as it shares a present page.
+ *
+ * Slots being read or written are cached by the swap cache, a mapper
+ * indexed by slot number: a swapped in slot which is still shared,
+ * or prefetched by the readahead, is found there by the next fault.
+ */
+#define SWAP_MAGIC         "ALMOS-SWAP"
+#define SWAP_SLOT_NONE     ((uint_t) -1)
+#define SWAP_COUNT_MAX     0xFFFF
+
+struct swap_s
+{
+	spinlock_t lock;
+	struct device_s *dev;
+	uint_t start;			/* first sector of slot 0 */
+	uint_t sectors;			/* sectors per slot */
+	uint_t slots_nr;
+	uint_t free_nr;
+	uint_t next;			/* next-fit cursor */
+	uint16_t *map;			/* PTEs per slot, 0 if free */
+	struct mapper_s *cache;
+};
+
+extern struct swap_s swap_area;
+
+#if CONFIG_SWAP
+
+#define swap_isEnabled()             (swap_area.dev != NULL)
+#define swap_cache_isMapper(_mapper) ((_mapper) == swap_area.cache)
+
+/**
+ * Looks for the swap area on __swap_blk,
+ * swapping stays disabled if it is not found
+ *
+ * @return      error code
+ **/
+error_t swap_init(void);
+
+/**
+ * Adds a PTE to a swap slot, the caller holds one
+ *
+ * @slot        swap slot
+ * @return      EAGAIN if the slot has too many users
+ **/
+error_t swap_dup(uint_t slot);
+
+/**
+ * Removes a PTE from a swap slot, the slot
+ * and its swap cache page are released with
+ * the last one
+ *
+ * @slot        swap slot
+ **/
+void swap_free(uint_t slot);
+
+/**
+ * Gives the number of PTEs referring to a slot
+ *
+ * @slot        swap slot
+ **/
+uint_t swap_count(uint_t slot);
+
+/**
+ * Gives the page of a slot from the swap cache,
+ * reading it if it is not there
+ *
+ * @slot        swap slot in use
+ * @return      page holding a new reference, NULL on error
+ **/
+struct page_s* swap_cache_get(uint_t slot);
+
+/**
+ * Takes a page out of the swap cache when the caller
+ * is the last user of its slot, so it can be mapped
+ * without a copy. Hypothesis: the page is locked.
+ *
+ * @slot        swap slot of the page
+ * @page        page given by swap_cache_get
+ * @return      true if the page left the swap cache,
+ *              the caller then holds one more reference
+ **/
+bool_t swap_cache_take(uint_t slot, struct page_s *page);
+
+/**
+ * Starts reading a slot and its neighbours in use
+ * (CONFIG_SWAP_CLUSTER aligned) into the swap cache
+ *
+ * @slot        faulting slot
+ **/
+void swap_readahead(uint_t slot);
+
+/**
+ * Writes a private anonymous page to a new slot
+ * and replaces its mapping by the swap entry.
+ * Hypothesis: the page is locked, the caller holds
+ * its own reference on it and has rdlocked the vmm.
+ *
+ * @vmm         the only address space mapping the page
+ * @vaddr       where it is mapped
+ * @page        page to swap out
+ * @return      0 if swapped out, EBUSY if the page is in use,
+ *              ENOSPC if the swap area is full, error code otherwise
+ **/
+error_t swap_out(struct vmm_s *vmm, uint_t vaddr, struct page_s *page);
+
+/**
+ * Reverse map of a private anonymous page: PG_ANON says
+ * that page->data and page->index give the address space
+ * and the address it is mapped at, which is only true for
+ * a page mapped once. Both are called with the page locked.
+ */
+static inline void swap_rmap_set(struct page_s *page, struct vmm_s *vmm, uint_t vaddr)
+{
+	page->data  = vmm;
+	page->index = vaddr & ~(PMM_PAGE_MASK);
+	PAGE_SET(page, PG_ANON);
+}
+
+static inline void swap_rmap_clear(struct page_s *page, struct vmm_s *vmm)
+{
+	if((PAGE_IS(page, PG_ANON)) && (page->data == vmm))
+		PAGE_CLEAR(page, PG_ANON);
+}
+
+#else
+
+#define swap_isEnabled()             (false)
+#define swap_cache_isMapper(_mapper) (false)
+#define swap_rmap_set(_page,_vmm,_vaddr)
+#define swap_rmap_clear(_page,_vmm)
+
+#endif	/* CONFIG_SWAP */
+
+#endif	/* _SWAP_H_ */
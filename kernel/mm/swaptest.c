@@ -0,0 +1,807 @@
+/*
+ * mm/swaptest.c - host test of the swap slots and of the swap cache
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * swap.c is included here on top of a RAM disk, a pool of pages with
+ * their reference counts, one PTE table per address space and a mapper
+ * reduced to an array indexed by slot. The tests walk the slot map
+ * (next-fit allocation, swap_dup up to SWAP_COUNT_MAX, release by the
+ * last swap_free), then swap pages out and back in the way
+ * vmm_do_swapin() does: after a fork shares a slot, the first fault
+ * copies the swap cache page and the last one takes it with no copy
+ * and no read. Every test ends with no page left but the ones it
+ * still maps. Host build (*test.c is not in the kernel image):
+ *
+ *   cc -idirafter . -idirafter ../kern -idirafter ../libk -idirafter ../vfs -o swaptest swaptest.c && ./swaptest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* stand for the kernel headers included by swap.c */
+#define _CONFIG_H_
+#define _TYPES_H_
+#define _LIBK_H_
+#define _BITS_H_
+#define _SPINLOCK_H_
+#define _MCS_SYNC_H_
+#define _THREAD_H_
+#define _SCHEDULER_H_
+#define _DEVICE_H_
+#define _DRIVER_H_
+#define BLKIO_H_
+#define _KMEM_H_
+#define _PAGE_H_
+#define _PPM_H_
+#define _PMM_H_
+#define RADIX_H_
+#define _MAPPER_H_
+#define _VMM_H_
+#define _KDMSG_H_
+
+#define no     0
+#define yes    1
+#define false  0
+#define true   1
+typedef unsigned long uint_t;
+typedef long sint_t;
+typedef unsigned long bool_t;
+typedef long error_t;
+
+#include <kernel-config.h>
+#include <mm-config.h>
+#include <errno.h>
+
+#define ARROUND_DOWN(val, size)  ((val) & ~((size) - 1))
+#define MIN(x,y) (((x) < (y)) ? (x) : (y))
+
+#define printk(level, ...)  do { } while(0)
+
+static int errors;
+
+#define CHECK(cond)							\
+	do {								\
+		if(!(cond))						\
+		{							\
+			printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			errors ++;					\
+		}							\
+	} while(0)
+
+/* Locks only check that they are not taken twice */
+typedef struct { uint_t held; } spinlock_t;
+
+#define spinlock_init(_lock, _name)  ((_lock)->held = 0)
+
+static void spinlock_lock_noirq(spinlock_t *lock, uint_t *irq_state)
+{
+	CHECK(lock->held == 0);
+	lock->held = 1;
+}
+
+static void spinlock_unlock_noirq(spinlock_t *lock, uint_t irq_state)
+{
+	CHECK(lock->held == 1);
+	lock->held = 0;
+}
+
+#define mcs_lock(_lock, _irq)    spinlock_lock_noirq((_lock), (_irq))
+#define mcs_unlock(_lock, _irq)  spinlock_unlock_noirq((_lock), (_irq))
+
+/* Pages */
+#define PMM_PAGE_SHIFT  12
+#define PMM_PAGE_SIZE   (1 << PMM_PAGE_SHIFT)
+#define PMM_PAGE_MASK   (PMM_PAGE_SIZE - 1)
+
+#define PG_INLOAD  0x008
+#define PG_DIRTY   0x080
+#define PG_MAPPED  0x4000
+#define PG_ANON    0x8000
+
+#define PAGE_SET(page,flag)    ((page)->flags) |= (flag)
+#define PAGE_CLEAR(page,flag)  ((page)->flags) &= ~(flag)
+#define PAGE_IS(page,flag)     ((page)->flags) & (flag)
+
+struct mapper_s;
+
+struct page_s
+{
+	uint_t flags;
+	uint_t index;
+	uint_t count;
+	struct mapper_s *mapper;
+	void *data;
+	char buffer[PMM_PAGE_SIZE];
+};
+
+#define PAGES_NR  64
+
+static struct page_s pages[PAGES_NR];
+static uint_t pages_used;
+
+#define page_refcount_get(_page)  ((_page)->count)
+#define page_refcount_up(_page)   ((_page)->count ++)
+#define ppm_page2addr(_page)      ((void*)(_page)->buffer)
+#define ppm_page2ppn(_page)       ((uint_t)((_page) - pages))
+
+#define KMEM_GENERIC  0
+#define KMEM_PAGE     1
+#define KMEM_MAPPER   2
+#define AF_KERNEL     0x1
+#define AF_ZERO       0x2
+
+typedef struct
+{
+	uint_t type;
+	uint_t size;
+	uint_t flags;
+	void *ptr;
+} kmem_req_t;
+
+static void* kmem_alloc(kmem_req_t *req)
+{
+	uint_t i;
+
+	if(req->type != KMEM_PAGE)
+		return calloc(1, req->size);
+
+	for(i = 0; i < PAGES_NR; i++)
+	{
+		if(pages[i].count == 0)
+		{
+			memset(&pages[i], 0, sizeof(pages[i]));
+			pages[i].count = 1;
+			pages_used ++;
+			return &pages[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void kmem_free(kmem_req_t *req)
+{
+	struct page_s *page;
+
+	if(req->type != KMEM_PAGE)
+	{
+		free(req->ptr);
+		return;
+	}
+
+	page = req->ptr;
+	CHECK(page->count != 0);
+
+	if(-- page->count == 0)
+		pages_used --;
+}
+
+/* RAM disk of 512 bytes sectors */
+#define SECTOR_SIZE  512
+#define DISK_SLOTS   48
+#define DISK_SIZE    ((DISK_SLOTS + 1) * PMM_PAGE_SIZE)
+
+#define BLKIO_RD        0x01
+#define BLKIO_SYNC      0x02
+#define BLKIO_ASYNC     0x04
+#define BLKIO_RELEASE   0x08
+
+typedef struct
+{
+	uint_t count;
+	uint_t sector_size;
+} dev_params_t;
+
+struct device_s
+{
+	struct
+	{
+		struct
+		{
+			sint_t (*get_params)(struct device_s *dev, dev_params_t *params);
+		} dev;
+	} op;
+
+	char name[16];
+};
+
+struct blkio_s
+{
+	struct
+	{
+		void *src;
+		void *dst;
+		uint_t count;
+	} b_dev_rq;
+};
+
+static unsigned char disk[DISK_SIZE];
+static uint_t disk_reads;
+static error_t disk_error;
+static struct blkio_s disk_blkio;
+
+struct device_s *__swap_blk;
+
+static sint_t disk_get_params(struct device_s *dev, dev_params_t *params)
+{
+	params->count       = DISK_SIZE / SECTOR_SIZE;
+	params->sector_size = SECTOR_SIZE;
+	return 0;
+}
+
+static struct device_s disk_dev = { .op.dev.get_params = disk_get_params, .name = "sda1" };
+
+#define blkio_init(_dev, _page, _count)               0
+#define blkio_destroy(_page)
+#define list_first(_root, _type, _member)             (&disk_blkio)
+
+static error_t blkio_sync(struct page_s *page, uint_t flags)
+{
+	unsigned char *sector;
+
+	if(disk_error)
+		return disk_error;
+
+	sector = disk + (uint_t)disk_blkio.b_dev_rq.src * SECTOR_SIZE;
+	CHECK(sector + disk_blkio.b_dev_rq.count * SECTOR_SIZE <= disk + DISK_SIZE);
+
+	if(flags & BLKIO_RD)
+	{
+		memcpy(disk_blkio.b_dev_rq.dst, sector, disk_blkio.b_dev_rq.count * SECTOR_SIZE);
+		disk_reads ++;
+	}
+	else
+		memcpy(sector, disk_blkio.b_dev_rq.dst, disk_blkio.b_dev_rq.count * SECTOR_SIZE);
+
+	return 0;
+}
+
+/* A mapper reduced to its pages array, enough for the swap cache */
+#define MAPPER_SYNC_OP   0x01
+#define MAPPER_ASYNC_OP  0x02
+
+#define MAPPER_READ_PAGE(n)         error_t (n) (struct page_s *page, uint_t flags, void *data)
+#define MAPPER_WRITE_PAGE(n)        error_t (n) (struct page_s *page, uint_t flags, void *data)
+#define MAPPER_SYNC_PAGE(n)         error_t (n) (struct page_s *page)
+#define MAPPER_RELEASE_PAGE(n)      error_t (n) (struct page_s *page)
+#define MAPPER_SET_PAGE_DIRTY(n)    error_t (n) (struct page_s *page)
+
+struct mapper_op_s
+{
+	MAPPER_READ_PAGE(*readpage);
+	MAPPER_WRITE_PAGE(*writepage);
+	MAPPER_SYNC_PAGE(*sync_page);
+	MAPPER_SET_PAGE_DIRTY(*set_page_dirty);
+	MAPPER_RELEASE_PAGE(*releasepage);
+};
+
+#define mapper_default_write_page      NULL
+#define mapper_default_sync_page       NULL
+#define mapper_default_set_page_dirty  NULL
+#define mapper_default_release_page    NULL
+
+struct mapper_s
+{
+	spinlock_t m_lock;
+	const struct mapper_op_s *m_ops;
+	struct page_s *m_radix[DISK_SLOTS];
+};
+
+#define radix_tree_lookup(_radix, _index)  ((*(_radix))[(_index)])
+
+static error_t mapper_init(struct mapper_s *mapper, const struct mapper_op_s *ops, void *node, void *data)
+{
+	memset(mapper, 0, sizeof(*mapper));
+	mapper->m_ops = ops;
+	return 0;
+}
+
+static error_t mapper_add_page(struct mapper_s *mapper, struct page_s *page, uint_t index)
+{
+	if(mapper->m_radix[index] != NULL)
+		return EEXIST;
+
+	mapper->m_radix[index] = page;
+	page->mapper = mapper;
+	page->index  = index;
+	return 0;
+}
+
+static error_t mapper_evict_page(struct mapper_s *mapper, struct page_s *page)
+{
+	kmem_req_t req;
+
+	if((page->mapper != mapper) || (mapper->m_radix[page->index] != page))
+		return ENOENT;
+
+	mapper->m_radix[page->index] = NULL;
+	page->mapper = NULL;
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+	return 0;
+}
+
+/* Loads a missing page, the mapper holding its first reference */
+static struct page_s* mapper_load_page(struct mapper_s *mapper, uint_t index, uint_t flags)
+{
+	struct page_s *page;
+	kmem_req_t req;
+
+	req.type = KMEM_PAGE;
+
+	if((page = kmem_alloc(&req)) == NULL)
+		return NULL;
+
+	page->index = index;
+
+	if(mapper->m_ops->readpage(page, flags, NULL))
+	{
+		req.ptr = page;
+		kmem_free(&req);
+		return NULL;
+	}
+
+	(void)mapper_add_page(mapper, page, index);
+	return page;
+}
+
+static struct page_s* mapper_get_page(struct mapper_s *mapper, uint_t index, uint_t flags, void *data)
+{
+	struct page_s *page;
+
+	page = mapper->m_radix[index];
+
+	if((page == NULL) && ((page = mapper_load_page(mapper, index, flags)) == NULL))
+		return NULL;
+
+	page_refcount_up(page);
+	return page;
+}
+
+static error_t mapper_prefetch_page(struct mapper_s *mapper, uint_t index, uint_t flags, void *data, struct page_s **held)
+{
+	if(mapper->m_radix[index] != NULL)
+		return 0;
+
+	return (mapper_load_page(mapper, index, MAPPER_ASYNC_OP) == NULL) ? ENOMEM : 0;
+}
+
+/* One PTE per virtual page */
+#define PMM_PRESENT   0x001
+#define PMM_ACCESSED  0x002
+#define PMM_COW       0x004
+#define PMM_MIGRATE   0x008
+#define PMM_SWAP      0x010
+#define PMM_LOCKED    0x020
+#define PMM_HINT      0x040
+
+#define VPAGES_NR  16
+
+typedef struct
+{
+	uint_t attr;
+	uint_t ppn;
+	void *cluster;
+} pmm_page_info_t;
+
+struct pmm_s
+{
+	pmm_page_info_t pte[VPAGES_NR];
+};
+
+struct vmm_s
+{
+	struct pmm_s pmm;
+};
+
+static error_t pmm_get_page(struct pmm_s *pmm, uint_t vaddr, pmm_page_info_t *info)
+{
+	*info = pmm->pte[vaddr >> PMM_PAGE_SHIFT];
+	return 0;
+}
+
+static error_t pmm_set_page(struct pmm_s *pmm, uint_t vaddr, pmm_page_info_t *info)
+{
+	pmm->pte[vaddr >> PMM_PAGE_SHIFT] = *info;
+	return 0;
+}
+
+#include "swap.h"
+#include "swap.c"
+
+static void swap_reset(bool_t hasMagic)
+{
+	kmem_req_t req;
+
+	if(swap_area.dev != NULL)
+	{
+		req.type = KMEM_GENERIC;
+		req.ptr  = swap_area.map;
+		kmem_free(&req);
+		req.ptr  = swap_area.cache;
+		kmem_free(&req);
+	}
+
+	memset(disk, 0, sizeof(disk));
+
+	if(hasMagic)
+		memcpy(disk, SWAP_MAGIC, sizeof(SWAP_MAGIC) - 1);
+
+	__swap_blk = &disk_dev;
+	disk_error = 0;
+	swap_init();
+}
+
+/* Maps a new page of its own at vaddr, filled with seed */
+static struct page_s* map_page(struct vmm_s *vmm, uint_t vaddr, int seed)
+{
+	pmm_page_info_t info;
+	struct page_s *page;
+	kmem_req_t req;
+
+	req.type = KMEM_PAGE;
+	page     = kmem_alloc(&req);
+	memset(page->buffer, seed, PMM_PAGE_SIZE);
+
+	info.attr    = PMM_PRESENT;
+	info.ppn     = ppm_page2ppn(page);
+	info.cluster = NULL;
+	pmm_set_page(&vmm->pmm, vaddr, &info);
+	swap_rmap_set(page, vmm, vaddr);
+	return page;
+}
+
+static void unmap_page(struct vmm_s *vmm, uint_t vaddr)
+{
+	pmm_page_info_t *pte;
+	kmem_req_t req;
+
+	pte = &vmm->pmm.pte[vaddr >> PMM_PAGE_SHIFT];
+
+	if(pte->attr & PMM_SWAP)
+		swap_free(pte->ppn);
+	else if(pte->attr & PMM_PRESENT)
+	{
+		req.type = KMEM_PAGE;
+		req.ptr  = &pages[pte->ppn];
+		kmem_free(&req);
+	}
+
+	pte->attr = 0;
+}
+
+/* As the reclaim: its own reference on the page while swapping it out */
+static error_t page_out(struct vmm_s *vmm, uint_t vaddr)
+{
+	struct page_s *page;
+	kmem_req_t req;
+	error_t err;
+
+	page = &pages[vmm->pmm.pte[vaddr >> PMM_PAGE_SHIFT].ppn];
+	page_refcount_up(page);
+
+	err = swap_out(vmm, vaddr, page);
+
+	req.type = KMEM_PAGE;
+	req.ptr  = page;
+	kmem_free(&req);
+	return err;
+}
+
+/* The swap part of vmm_do_swapin(), the page lock left out */
+static error_t page_in(struct vmm_s *vmm, uint_t vaddr)
+{
+	pmm_page_info_t info;
+	struct page_s *page;
+	struct page_s *newpage;
+	kmem_req_t req;
+	uint_t slot;
+
+	pmm_get_page(&vmm->pmm, vaddr, &info);
+	CHECK(info.attr == PMM_SWAP);
+	slot = info.ppn;
+
+	swap_readahead(slot);
+
+	if((page = swap_cache_get(slot)) == NULL)
+		return EIO;
+
+	req.type = KMEM_PAGE;
+
+	if(swap_cache_take(slot, page))
+		newpage = page;
+	else
+	{
+		newpage = kmem_alloc(&req);
+		memcpy(newpage->buffer, page->buffer, PMM_PAGE_SIZE);
+	}
+
+	info.attr    = PMM_PRESENT;
+	info.ppn     = ppm_page2ppn(newpage);
+	info.cluster = NULL;
+
+	swap_rmap_set(newpage, vmm, vaddr);
+	pmm_set_page(&vmm->pmm, vaddr, &info);
+	swap_free(slot);
+
+	req.ptr = page;
+	kmem_free(&req);
+	return 0;
+}
+
+static bool_t page_is(struct vmm_s *vmm, uint_t vaddr, int seed)
+{
+	pmm_page_info_t *pte;
+	uint_t i;
+
+	pte = &vmm->pmm.pte[vaddr >> PMM_PAGE_SHIFT];
+
+	if(!(pte->attr & PMM_PRESENT))
+		return false;
+
+	for(i = 0; i < PMM_PAGE_SIZE; i++)
+		if(pages[pte->ppn].buffer[i] != (char)seed)
+			return false;
+
+	return true;
+}
+
+static uint_t cached_pages(void)
+{
+	uint_t slot, count;
+
+	for(slot = 0, count = 0; slot < swap_area.slots_nr; slot++)
+		count += (swap_area.cache->m_radix[slot] != NULL);
+
+	return count;
+}
+
+/* The area is only enabled by a signed disk, the header page is skipped */
+static void test_init(void)
+{
+	swap_reset(false);
+	CHECK(!swap_isEnabled());
+
+	swap_reset(true);
+	CHECK(swap_isEnabled());
+	CHECK(swap_area.slots_nr == DISK_SLOTS);
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+	CHECK(swap_area.start == PMM_PAGE_SIZE / SECTOR_SIZE);
+	CHECK(pages_used == 0);
+}
+
+static void test_slots(void)
+{
+	uint_t slot, i;
+
+	swap_reset(true);
+
+	/* next-fit: consecutive slots, then none */
+	for(i = 0; i < DISK_SLOTS; i++)
+	{
+		slot = swap_alloc();
+		CHECK(slot == i);
+		CHECK(swap_count(slot) == 1);
+	}
+
+	CHECK(swap_area.free_nr == 0);
+	CHECK(swap_alloc() == SWAP_SLOT_NONE);
+
+	/* a released slot is found again from the cursor */
+	swap_free(5);
+	swap_free(30);
+	CHECK(swap_area.free_nr == 2);
+	CHECK(swap_alloc() == 5);
+	CHECK(swap_alloc() == 30);
+	CHECK(swap_alloc() == SWAP_SLOT_NONE);
+
+	/* the slot stays in use until its last user releases it */
+	for(i = 1; i < SWAP_COUNT_MAX; i++)
+		CHECK(swap_dup(7) == 0);
+
+	CHECK(swap_count(7) == SWAP_COUNT_MAX);
+	CHECK(swap_dup(7) == EAGAIN);
+
+	for(i = SWAP_COUNT_MAX; i > 1; i--)
+		swap_free(7);
+
+	CHECK(swap_count(7) == 1);
+	CHECK(swap_area.free_nr == 0);
+	swap_free(7);
+	CHECK(swap_count(7) == 0);
+	CHECK(swap_area.free_nr == 1);
+
+	for(slot = 0; slot < DISK_SLOTS; slot++)
+		if(swap_count(slot))
+			swap_free(slot);
+
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+	CHECK(pages_used == 0);
+}
+
+/* Out and back in, with a slot shared by a fork */
+static void test_cache(void)
+{
+	static struct vmm_s parent, child;
+	pmm_page_info_t info;
+	struct page_s *page;
+	uint_t vaddr, slot, reads;
+
+	swap_reset(true);
+	memset(&parent, 0, sizeof(parent));
+	memset(&child, 0, sizeof(child));
+
+	for(vaddr = 0; vaddr < 4 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+	{
+		map_page(&parent, vaddr, 'a' + (vaddr >> PMM_PAGE_SHIFT));
+
+		/* an accessed page gets a second chance */
+		parent.pmm.pte[vaddr >> PMM_PAGE_SHIFT].attr |= PMM_ACCESSED;
+		CHECK(page_out(&parent, vaddr) == EBUSY);
+		CHECK(page_out(&parent, vaddr) == 0);
+		CHECK(parent.pmm.pte[vaddr >> PMM_PAGE_SHIFT].attr == PMM_SWAP);
+	}
+
+	/* written, then out of the cache and out of memory */
+	CHECK(cached_pages() == 0);
+	CHECK(pages_used == 0);
+	CHECK(swap_area.free_nr == DISK_SLOTS - 4);
+
+	/* a page mapped elsewhere too is not swapped out */
+	page = map_page(&parent, 4 * PMM_PAGE_SIZE, 'e');
+	page_refcount_up(page);
+	CHECK(page_out(&parent, 4 * PMM_PAGE_SIZE) == EBUSY);
+	CHECK(parent.pmm.pte[4].attr == PMM_PRESENT);
+	unmap_page(&parent, 4 * PMM_PAGE_SIZE);
+	page->count --;
+	pages_used --;
+	CHECK(pages_used == 0);
+
+	/* fork: the child shares the slots */
+	for(vaddr = 0; vaddr < 4 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+	{
+		info = parent.pmm.pte[vaddr >> PMM_PAGE_SHIFT];
+		CHECK(swap_dup(info.ppn) == 0);
+		child.pmm.pte[vaddr >> PMM_PAGE_SHIFT] = info;
+	}
+
+	/* first user: a copy, the read and its readahead stay cached */
+	slot  = parent.pmm.pte[1].ppn;
+	reads = disk_reads;
+	CHECK(page_in(&parent, PMM_PAGE_SIZE) == 0);
+	CHECK(page_is(&parent, PMM_PAGE_SIZE, 'b'));
+	CHECK(disk_reads - reads == 4);
+	CHECK(swap_count(slot) == 1);
+	page = swap_area.cache->m_radix[slot];
+	CHECK((page != NULL) && (page_refcount_get(page) == 1));
+	CHECK(pages[parent.pmm.pte[1].ppn].count == 1);
+
+	/* last user: takes the cached page itself, with no read */
+	reads = disk_reads;
+	CHECK(page_in(&child, PMM_PAGE_SIZE) == 0);
+	CHECK(disk_reads == reads);
+	CHECK(child.pmm.pte[1].ppn == ppm_page2ppn(page));
+	CHECK(page_refcount_get(page) == 1);
+	CHECK(page->mapper == NULL);
+	CHECK((PAGE_IS(page, PG_ANON)) && (page->data == &child));
+	CHECK(page_is(&child, PMM_PAGE_SIZE, 'b'));
+	CHECK(swap_count(slot) == 0);
+	CHECK(cached_pages() == 3);
+
+	/* the other slots: the parent releases them, the child takes the pages */
+	for(vaddr = 0; vaddr < 4 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+	{
+		if(vaddr == PMM_PAGE_SIZE)
+			continue;
+
+		unmap_page(&parent, vaddr);
+		reads = disk_reads;
+		CHECK(page_in(&child, vaddr) == 0);
+		CHECK(disk_reads == reads);
+		CHECK(page_is(&child, vaddr, 'a' + (vaddr >> PMM_PAGE_SHIFT)));
+	}
+
+	CHECK(cached_pages() == 0);
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+
+	for(vaddr = 0; vaddr < 4 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+	{
+		unmap_page(&parent, vaddr);
+		unmap_page(&child, vaddr);
+	}
+
+	CHECK(pages_used == 0);
+}
+
+/* A released slot drops its cached copy, failed I/O keep the page */
+static void test_release(void)
+{
+	static struct vmm_s vmm;
+	uint_t vaddr, slot;
+
+	swap_reset(true);
+	memset(&vmm, 0, sizeof(vmm));
+
+	for(vaddr = 0; vaddr < 3 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+	{
+		map_page(&vmm, vaddr, 'x');
+		CHECK(page_out(&vmm, vaddr) == 0);
+	}
+
+	/* readahead of the neighbours, then the task exits */
+	swap_readahead(vmm.pmm.pte[0].ppn);
+	CHECK(cached_pages() == 3);
+
+	for(vaddr = 0; vaddr < 3 * PMM_PAGE_SIZE; vaddr += PMM_PAGE_SIZE)
+		unmap_page(&vmm, vaddr);
+
+	CHECK(cached_pages() == 0);
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+	CHECK(pages_used == 0);
+
+	/* the write fails: the page is mapped again, the slot released */
+	map_page(&vmm, 0, 'y');
+	disk_error = EIO;
+	CHECK(page_out(&vmm, 0) == EIO);
+	CHECK(page_is(&vmm, 0, 'y'));
+	CHECK(pages[vmm.pmm.pte[0].ppn].count == 1);
+	CHECK(PAGE_IS(&pages[vmm.pmm.pte[0].ppn], PG_ANON));
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+	CHECK(cached_pages() == 0);
+
+	/* the read fails: the swap entry and its slot are kept */
+	disk_error = 0;
+	CHECK(page_out(&vmm, 0) == 0);
+	slot = vmm.pmm.pte[0].ppn;
+	disk_error = EIO;
+	CHECK(page_in(&vmm, 0) == EIO);
+	CHECK(vmm.pmm.pte[0].attr == PMM_SWAP);
+	CHECK(swap_count(slot) == 1);
+	disk_error = 0;
+	CHECK(page_in(&vmm, 0) == 0);
+	CHECK(page_is(&vmm, 0, 'y'));
+
+	unmap_page(&vmm, 0);
+	CHECK(swap_area.free_nr == DISK_SLOTS);
+	CHECK(pages_used == 0);
+}
+
+int main(void)
+{
+	test_init();
+	test_slots();
+	test_cache();
+	test_release();
+
+	if(errors)
+	{
+		printf("%d checks failed\n", errors);
+		return 1;
+	}
+
+	printf("swap tests passed\n");
+	return 0;
+}
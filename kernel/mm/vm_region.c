@@ -35,7 +35,9 @@
 #include <page.h>
 #include <vmm.h>
 #include <kmem.h>
+#include <cluster.h>
 #include <vm_region.h>
+#include <swap.h>
 
 static void vm_region_ctor(struct kcm_s *kcm, void *ptr)
 {
@@ -112,9 +114,91 @@ error_t vm_region_init(struct vm_region_s *region,
 	region->vm_prot   = prot;
 	region->vm_pgprot = pgprot;
 
+	if(flags & VM_REG_INTERLEAVE)
+		(void)vm_region_set_mpol(region, VM_MPOL_INTERLEAVE, NULL);
+	else if(flags & VM_REG_LOCAL)
+		(void)vm_region_set_mpol(region, VM_MPOL_LOCAL, NULL);
+	else
+		(void)vm_region_set_mpol(region, VM_MPOL_DEFAULT, NULL);
+
 	return 0;
 }
 
+error_t vm_region_set_mpol(struct vm_region_s *region, uint_t mode, bitmap_t *mask)
+{
+	struct vm_mpol_s mpol;
+	uint_t onln_clusters;
+	uint_t irq_state;
+	uint_t cid;
+
+	if(mode >= VM_MPOL_NR)
+		return EINVAL;
+
+	onln_clusters = arch_onln_cluster_nr();
+	mpol.mode     = mode;
+	mpol.count    = 0;
+	memset(&mpol.mask[0], 0, sizeof(mpol.mask));
+
+	for(cid = 0; cid < onln_clusters; cid++)
+	{
+		if((mask == NULL) || bitmap_state(mask, cid))
+		{
+			bitmap_set(&mpol.mask[0], cid);
+			mpol.count ++;
+		}
+	}
+
+	if(mpol.count == 0)
+		return EINVAL;
+
+	mcs_lock(&region->vm_lock, &irq_state);
+	region->vm_mpol = mpol;
+	mcs_unlock(&region->vm_lock, irq_state);
+
+	return 0;
+}
+
+struct cluster_s* vm_region_mpol_cluster(struct vm_region_s *region, uint_t vaddr)
+{
+	struct vm_mpol_s *mpol;
+	struct cluster_s *cluster;
+	uint_t index;
+	uint_t cid;
+
+	mpol    = &region->vm_mpol;
+	cluster = current_cluster;
+
+	switch(mpol->mode)
+	{
+	case VM_MPOL_LOCAL:
+		return cluster;
+
+	case VM_MPOL_PREFERRED:
+		index = 0;
+		break;
+
+	case VM_MPOL_BIND:
+		if(bitmap_state(&mpol->mask[0], cluster->id))
+			return cluster;
+		/* Spread the pages over the mask as interleave does */
+
+	case VM_MPOL_INTERLEAVE:
+		index = (vaddr >> PMM_PAGE_SHIFT) % mpol->count;
+		break;
+
+	default:
+		return NULL;
+	}
+
+	for(cid = 0; cid < CLUSTER_NR; cid++)
+	{
+		if(bitmap_state(&mpol->mask[0], cid) && (index-- == 0))
+			return cluster_cid2ptr(cid);
+	}
+
+	return NULL;
+}
+
 error_t vm_region_destroy(struct vm_region_s *region)
 {  
 	return 0;
@@ -314,6 +398,9 @@ error_t vm_region_unmap(struct vm_region_s *region)
 	pmm_page_info_t info;
 	uint_t refcount;
 	uint_t attr;
+#if CONFIG_SWAP
+	ppn_t ppn;
+#endif
 	error_t err;
   
 	count  = (region->vm_limit - region->vm_start) >> PMM_PAGE_SHIFT;
@@ -326,6 +413,26 @@ error_t vm_region_unmap(struct vm_region_s *region)
 		if((err = pmm_get_page(pmm, vaddr, &info)))
 			goto NEXT;
 
+#if CONFIG_SWAP
+		if((info.attr & PMM_SWAP) && !(info.attr & PMM_PRESENT))
+		{
+			ppn          = info.ppn;
+			info.attr    = 0;
+			info.ppn     = 0;
+			info.cluster = NULL;
+
+			if(isLazy == false)
+				pmm_set_page(pmm, vaddr, &info);
+
+			swap_free(ppn);
+			goto NEXT;
+		}
+#endif
+
+		/* The page is still referenced by a revoked mapping */
+		if((info.attr & (PMM_HINT | PMM_MIGRATE)) && (info.ppn != 0))
+			info.attr |= PMM_PRESENT;
+
 		if(info.attr & PMM_PRESENT)
 		{
 			ppm          = pmm_ppn2ppm(info.ppn);
@@ -337,12 +444,28 @@ error_t vm_region_unmap(struct vm_region_s *region)
 			refcount     = 0;
 
 			page_lock(page);
+
+#if CONFIG_SWAP
+			/* Swapped out before we got the page, seen again as a swap entry */
+			if((pmm_get_page(pmm, vaddr, &info) == 0) && (info.attr & PMM_SWAP))
+			{
+				page_unlock(page);
+				continue;
+			}
+
+			info.attr    = 0;
+			info.ppn     = 0;
+			info.cluster = NULL;
+#endif
       
 			if(isLazy == false)
 				pmm_set_page(pmm, vaddr, &info);
 
-			if(page->mapper == NULL) 
+			if(page->mapper == NULL)
+			{
+				swap_rmap_clear(page, region->vmm);
 				refcount = page_refcount_down(page);
+			}
 
 			page_unlock(page);
       
@@ -460,6 +583,7 @@ error_t vm_region_dup(struct vm_region_s *dst, struct vm_region_s *src)
 	dst->vm_op      = src->vm_op;
 	dst->vm_mapper  = src->vm_mapper;
 	dst->vm_file    = src->vm_file;
+	dst->vm_mpol    = src->vm_mpol;
 	dst->vm_data    = src->vm_data;
 	task            = vmm_get_task(dst->vmm);
 
@@ -509,7 +633,35 @@ error_t vm_region_dup(struct vm_region_s *dst, struct vm_region_s *src)
 		if((err = pmm_get_page(src_pmm, vaddr, &info)))
 			goto REG_DUP_ERR;
 
-		if(info.attr & PMM_PRESENT)	/* TODO: review this condition on swap */
+		/* The child gets the page back, not the sampling of its parent */
+		if((info.attr & PMM_HINT) && (info.ppn != 0))
+		{
+			info.attr |= PMM_PRESENT;
+			info.attr &= ~(PMM_HINT);
+		}
+
+#if CONFIG_SWAP
+		/* The child shares the slot as it shares a present page */
+		if((info.attr & PMM_SWAP) && !(info.attr & PMM_PRESENT))
+		{
+			if((err = swap_dup(info.ppn)))
+				goto REG_DUP_ERR;
+
+			info.cluster = task->cluster;
+
+#if CONFIG_FORK_LOCAL_ALLOC
+			info.cluster = NULL;
+#endif
+
+			if((err = pmm_set_page(dst_pmm, vaddr, &info)))
+			{
+				swap_free(info.ppn);
+				goto REG_DUP_ERR;
+			}
+		}
+#endif
+
+		if(info.attr & PMM_PRESENT)
 		{
 			ppm  = pmm_ppn2ppm(info.ppn);
 			page = ppm_ppn2page(ppm, info.ppn);
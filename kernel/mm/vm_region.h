@@ -24,6 +24,7 @@
 #define _VM_REGION_H_
 
 #include <types.h>
+#include <bits.h>
 #include <rbtree.h>
 //#include <spinlock.h>
 #include <mcs_sync.h>
@@ -31,6 +32,7 @@
 
 struct vmm_s;
 struct vm_region_s;
+struct cluster_s;
 
 #define VM_REG_SHARED   0x0001
 #define VM_REG_PRIVATE  0x0002
@@ -46,6 +48,8 @@ struct vm_region_s;
 #define VM_REG_INIT     0x0400
 #define VM_REG_HEAP     0x0800
 #define VM_REG_INST     0x1000
+#define VM_REG_INTERLEAVE 0x2000
+#define VM_REG_LOCAL    0x4000
 
 #define VM_REG_NON      0x00
 #define VM_REG_RD       0x01
@@ -58,6 +62,23 @@ struct vm_region_s;
 
 #define VM_FAILED      ((void *) -1)
 
+/* Memory placement policies */
+#define VM_MPOL_DEFAULT     0	/* thread attributes, then DQDT fallback */
+#define VM_MPOL_LOCAL       1	/* the faulting thread's cluster, then DQDT fallback */
+#define VM_MPOL_PREFERRED   2	/* the first cluster of the mask, then DQDT fallback */
+#define VM_MPOL_BIND        3	/* only the clusters of the mask */
+#define VM_MPOL_INTERLEAVE  4	/* the clusters of the mask, round-robin on page number */
+#define VM_MPOL_NR          5
+
+#define VM_MPOL_MASK_SIZE   (CONFIG_MAX_CLUSTER_NR >> 3)
+
+struct vm_mpol_s
+{
+	uint_t mode;
+	uint_t count;		/* number of clusters in mask */
+	BITMAP_DECLARE(mask, VM_MPOL_MASK_SIZE);
+};
+
 /* Virtual Memory Region */
 struct vm_region_s
 {
@@ -79,6 +100,7 @@ struct vm_region_s
 	struct mapper_s *vm_mapper;
 	struct vfs_file_s *vm_file;
 	struct list_entry vm_shared_list;
+	struct vm_mpol_s vm_mpol;
 	void *vm_data;
 };
 
@@ -142,4 +164,10 @@ error_t vm_region_dup(struct vm_region_s *dst, struct vm_region_s *src);
 
 error_t vm_region_update(struct vm_region_s *region, uint_t vaddr, uint_t flags);
 
+/* A NULL mask stands for all online clusters */
+error_t vm_region_set_mpol(struct vm_region_s *region, uint_t mode, bitmap_t *mask);
+
+/* Returns the cluster the policy places the page of vaddr on, NULL for the default placement */
+struct cluster_s* vm_region_mpol_cluster(struct vm_region_s *region, uint_t vaddr);
+
 #endif /* _VM_REGION_H_ */
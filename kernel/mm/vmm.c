@@ -33,6 +33,7 @@
 #include <page.h>
 #include <kmem.h>
 #include <vmm.h>
+#include <swap.h>
 
 error_t vmm_init(struct vmm_s *vmm)
 {  
@@ -50,6 +51,11 @@ error_t vmm_init(struct vmm_s *vmm)
 	vmm->u_err_nr            = 0;
 	vmm->m_err_nr            = 0;
 
+#if CONFIG_NUMA_BALANCING
+	vmm->numa_scan_stamp     = cpu_time_stamp();
+	vmm->numa_scan_addr      = 0;
+#endif
+
 	return keysdb_init(&vmm->regions_db, CONFIG_VM_REGION_KEYWIDTH);
 }
 
@@ -214,6 +220,64 @@ error_t vmm_munmap(struct vmm_s *vmm, uint_t vaddr, uint_t length)
 	return err;
 }
 
+/* Number of faults tried before giving up on a page which stays unusable */
+#define VMM_USER_PAGE_RETRY    3
+
+error_t vmm_get_user_page(struct vmm_s *vmm, uint_t vaddr, bool_t isWrite, struct page_s **page)
+{
+	struct vm_region_s *region;
+	struct page_s *ptr;
+	pmm_page_info_t info;
+	uint_t retry;
+	error_t err;
+
+	if(vaddr >= CONFIG_KERNEL_OFFSET)
+		return EFAULT;
+
+	rwlock_rdlock(&vmm->rwlock);
+	region = vm_region_find(vmm, vaddr);
+	rwlock_unlock(&vmm->rwlock);
+
+	if((region == NULL) || (vaddr >= region->vm_limit) || (vaddr < region->vm_start))
+		return EFAULT;
+
+	for(retry = 0; retry < VMM_USER_PAGE_RETRY; retry++)
+	{
+		/* Excludes munmap while the reference is taken */
+		rwlock_rdlock(&vmm->rwlock);
+
+		err = pmm_get_page(&vmm->pmm, vaddr, &info);
+		ptr = NULL;
+
+		if((err == 0)                  && 
+		   (info.attr & PMM_PRESENT)   && 
+		   (info.ppn != 0)             &&
+		   ((isWrite == false) || ((info.attr & PMM_WRITE) && !(info.attr & PMM_COW))))
+		{
+			ptr = ppm_ppn2page(pmm_ppn2ppm(info.ppn), info.ppn);
+			page_refcount_up(ptr);
+		}
+
+		rwlock_unlock(&vmm->rwlock);
+
+		if(ptr != NULL)
+		{
+			*page = ptr;
+			return 0;
+		}
+
+		if(err) return EFAULT;
+
+		err = vm_region_update(region, 
+				       vaddr, 
+				       (isWrite) ? PMM_EXCEPT_KWRITE : PMM_EXCEPT_KREAD);
+
+		if(err) return EFAULT;
+	}
+
+	return EFAULT;
+}
+
 static const struct mapper_op_s vmm_anon_mapper_op = 
 {
 	.writepage      = mapper_default_write_page,
@@ -825,19 +889,67 @@ fail_inval:
 	return err;
 }
 
-static inline error_t vmm_do_migrate(struct vm_region_s *region, pmm_page_info_t *pinfo, uint_t vaddr)
+/* Allocates the page of vaddr as the region's memory policy says */
+static struct page_s* vmm_mpol_alloc(struct vm_region_s *region, uint_t vaddr, kmem_req_t *req)
+{
+	struct vm_mpol_s *mpol;
+	struct cluster_s *cluster;
+	struct page_s *page;
+	uint_t cid;
+
+	mpol    = &region->vm_mpol;
+	cluster = vm_region_mpol_cluster(region, vaddr);
+
+	if(cluster == NULL)
+		return kmem_alloc(req);
+
+	/* The region's policy overrides the thread's placement attributes */
+	req->flags &= ~(AF_AFFINITY);
+
+	if(mpol->mode != VM_MPOL_BIND)
+	{
+		req->flags |= AF_REMOTE;
+		req->ptr    = cluster;
+		return kmem_alloc(req);
+	}
+
+	/* One attempt per cluster of the mask, without any DQDT fallback */
+	req->flags = (req->flags & ~(AF_TTL_MASK)) | AF_REMOTE | 1;
+	req->ptr   = cluster;
+
+	if((page = kmem_alloc(req)) != NULL)
+		return page;
+
+	for(cid = 0; cid < CLUSTER_NR; cid++)
+	{
+		if(!(bitmap_state(&mpol->mask[0], cid)) || (cid == cluster->id))
+			continue;
+
+		req->flags |= AF_REMOTE;
+		req->ptr    = cluster_cid2ptr(cid);
+
+		if((page = kmem_alloc(req)) != NULL)
+			return page;
+	}
+
+	return NULL;
+}
+
+/* Moves the page marked PMM_MIGRATE at vaddr to the given cluster */
+static error_t vmm_migrate_page(struct vm_region_s *region, 
+				pmm_page_info_t *pinfo, 
+				uint_t vaddr, 
+				struct cluster_s *cluster)
 {
 	kmem_req_t req;
 	pmm_page_info_t current;
 	struct page_s *page;
 	struct page_s *newpage;
-	struct cluster_s *cluster;
 	register uint_t count;
 	error_t err;
  
 	assert(pinfo->ppn != 0);
 
-	cluster = current_cluster;
 	page    = ppm_ppn2page(pmm_ppn2ppm(pinfo->ppn), pinfo->ppn);
 	newpage = NULL;
   
@@ -858,12 +970,22 @@ static inline error_t vmm_do_migrate(struct vm_region_s *region, pmm_page_info_t
 			req.size  = 0;
 			req.flags = AF_PGFAULT;
 
+			if(cluster != current_cluster)
+			{
+				req.flags |= AF_REMOTE;
+				req.ptr    = cluster;
+			}
+
 			newpage = kmem_alloc(&req);
       
 			if(newpage != NULL)
 			{
 				newpage->mapper = NULL;
 				page_copy(newpage, page);
+				swap_rmap_set(newpage, region->vmm, vaddr);
+#if CONFIG_NUMA_BALANCING
+				numa_stat_init(&newpage->numa);
+#endif
      
 				if(current.attr & PMM_COW)
 				{
@@ -886,6 +1008,9 @@ static inline error_t vmm_do_migrate(struct vm_region_s *region, pmm_page_info_t
 
 		err = pmm_set_page(&region->vmm->pmm, vaddr, &current);
 
+		if((err == 0) && (newpage != NULL))
+			swap_rmap_clear(page, region->vmm);
+
 		if((newpage != NULL) && (newpage->cid != cluster->id))
 		{
 			current_thread->info.remote_pages_cntr ++;
@@ -932,6 +1057,11 @@ VMM_MIGRATE_ERR:
 	else
 	{
 
+#if CONFIG_PPM_RECLAIM
+		if(newpage != NULL)
+			ppm_lru_add(newpage, true);
+#endif
+
 #if CONFIG_USE_COA
 		if((newpage != NULL) && !(region->vm_flags & VM_REG_INST))
 #else
@@ -946,6 +1076,192 @@ VMM_MIGRATE_ERR:
 	return err;
 }
 
+static inline error_t vmm_do_migrate(struct vm_region_s *region, pmm_page_info_t *pinfo, uint_t vaddr)
+{
+	return vmm_migrate_page(region, pinfo, vaddr, current_cluster);
+}
+
+error_t vmm_move_page(struct vmm_s *vmm, uint_t vaddr, struct cluster_s *cluster)
+{
+	struct vm_region_s *region;
+	struct page_s *page;
+	pmm_page_info_t info;
+	error_t err;
+
+	rwlock_rdlock(&vmm->rwlock);
+	region = vm_region_find(vmm, vaddr);
+	rwlock_unlock(&vmm->rwlock);
+
+	if((region == NULL) || (vaddr < region->vm_start) || (vaddr >= region->vm_limit))
+		return EFAULT;
+
+	if(region->vm_flags & (VM_REG_SHARED | VM_REG_DEV))
+		return EACCES;
+
+	if((err = pmm_get_page(&vmm->pmm, vaddr, &info)))
+		return err;
+
+	if(!(info.attr & (PMM_PRESENT | PMM_HINT)) || (info.ppn == 0))
+		return ENOENT;
+
+	page = ppm_ppn2page(pmm_ppn2ppm(info.ppn), info.ppn);
+
+	if(page->cid == cluster->id)
+		return 0;
+
+	/* Page-cache pages belong to their mapper and are not moved */
+	if(page->mapper != NULL)
+		return EACCES;
+
+	info.attr   &= ~(PMM_PRESENT | PMM_HINT);
+	info.attr   |= PMM_MIGRATE;
+	info.cluster = NULL;
+
+	if((err = pmm_set_page(&vmm->pmm, vaddr, &info)))
+		return err;
+
+	return vmm_migrate_page(region, &info, vaddr, cluster);
+}
+
+#if CONFIG_NUMA_BALANCING
+/* Hinting fault on a page revoked by vmm_numa_scan */
+static error_t vmm_do_hint(struct vm_region_s *region, pmm_page_info_t *pinfo, uint_t vaddr)
+{
+	struct cluster_s *cluster;
+	struct page_s *page;
+	pmm_page_info_t current;
+	bool_t isMove;
+	error_t err;
+
+	cluster = current_cluster;
+	page    = ppm_ppn2page(pmm_ppn2ppm(pinfo->ppn), pinfo->ppn);
+	isMove  = false;
+
+	page_lock(page);
+
+	if((err = pmm_get_page(&region->vmm->pmm, vaddr, &current)))
+		goto VMM_HINT_END;
+
+	if((current.ppn != pinfo->ppn) || !(current.attr & PMM_HINT))
+	{
+		current_thread->info.spurious_pgfault_cntr ++;
+		goto VMM_HINT_END;
+	}
+
+	isMove = numa_stat_fault(&page->numa,
+				 cluster->id,
+				 page->cid,
+				 CONFIG_NUMA_MGRT_THRESHOLD);
+
+	numa_vote(&current_thread->info.numa_vote, (isMove) ? cluster->id : page->cid);
+
+	current.attr   &= ~(PMM_HINT);
+	current.attr   |= (isMove) ? PMM_MIGRATE : PMM_PRESENT;
+	current.cluster = NULL;
+
+	err = pmm_set_page(&region->vmm->pmm, vaddr, &current);
+
+VMM_HINT_END:
+	page_unlock(page);
+
+	if(err || !isMove)
+		return err;
+
+	return vmm_migrate_page(region, &current, vaddr, cluster);
+}
+
+void vmm_numa_scan(struct vmm_s *vmm)
+{
+	struct vm_region_s *region;
+	struct list_entry *iter;
+	struct page_s *page;
+	pmm_page_info_t info;
+	uint_t deadline;
+	uint_t start;
+	uint_t vaddr;
+	uint_t count;
+	uint_t budget;
+
+	deadline = vmm->numa_scan_stamp;
+
+	if((sint_t)(cpu_time_stamp() - deadline) < 0)
+		return;
+
+	/* Only one thread of the task scans per period, wherever they run */
+	if(!(cpu_atomic_cas((void*)&vmm->numa_scan_stamp, 
+			    deadline, 
+			    cpu_time_stamp() + (CONFIG_NUMA_SCAN_PERIOD * cpu_get_ticks_period(current_cpu)))))
+		return;
+
+	start  = vmm->numa_scan_addr;
+	vaddr  = start;
+	count  = CONFIG_NUMA_SCAN_PAGES;
+	budget = CONFIG_NUMA_SCAN_PAGES << 3;
+
+	rwlock_rdlock(&vmm->rwlock);
+
+	list_foreach_forward(&vmm->regions_root, iter)
+	{
+		region = list_element(iter, struct vm_region_s, vm_list);
+
+		if(vaddr >= region->vm_limit)
+			continue;
+
+		/* Only private anonymous pages without an explicit policy */
+		if((region->vm_flags & (VM_REG_SHARED | VM_REG_DEV)) ||
+		   (region->vm_mapper != NULL)                       ||
+		   (region->vm_mpol.mode != VM_MPOL_DEFAULT))
+			continue;
+
+		if(vaddr < region->vm_start)
+			vaddr = region->vm_start;
+
+		for(; (vaddr < region->vm_limit) && count && budget; vaddr += PMM_PAGE_SIZE)
+		{
+			budget --;
+
+			if(pmm_get_page(&vmm->pmm, vaddr, &info))
+				continue;
+
+			if(!(info.attr & PMM_PRESENT) || (info.attr & PMM_COW) || (info.ppn == 0))
+				continue;
+
+			page = ppm_ppn2page(pmm_ppn2ppm(info.ppn), info.ppn);
+
+			if((page->mapper != NULL) || (page_refcount_get(page) != 1))
+				continue;
+
+			count --;
+			page_lock(page);
+
+			if((pmm_get_page(&vmm->pmm, vaddr, &info) == 0) &&
+			   (info.attr & PMM_PRESENT) &&
+			   !(info.attr & PMM_COW)    &&
+			   (info.ppn == ppm_page2ppn(page)))
+			{
+				info.attr   &= ~(PMM_PRESENT);
+				info.attr   |= PMM_HINT;
+				info.cluster = NULL;
+				(void)pmm_set_page(&vmm->pmm, vaddr, &info);
+			}
+
+			page_unlock(page);
+		}
+
+		if((count == 0) || (budget == 0))
+			break;
+	}
+
+	/* Starts again from the first region once the last one is done,
+	 * unless a later scan has already moved on */
+	(void)cpu_atomic_cas((void*)&vmm->numa_scan_addr, 
+			     start, 
+			     (iter == &vmm->regions_root) ? 0 : vaddr);
+
+	rwlock_unlock(&vmm->rwlock);
+}
+#endif	/* CONFIG_NUMA_BALANCING */
+
 error_t vmm_do_cow(struct vm_region_s *region, struct page_s *page, pmm_page_info_t *pinfo, uint_t vaddr)
 {
 	register struct page_s *newpage;
@@ -1019,7 +1335,7 @@ error_t vmm_do_cow(struct vm_region_s *region, struct page_s *page, pmm_page_inf
 		req.size  = 0;
 		req.flags = AF_PGFAULT;
   
-		if((newpage = kmem_alloc(&req)) == NULL)
+		if((newpage = vmm_mpol_alloc(region, vaddr, &req)) == NULL)
 		{
 			err = ENOMEM;
 			goto VMM_COW_END;
@@ -1046,7 +1362,17 @@ error_t vmm_do_cow(struct vm_region_s *region, struct page_s *page, pmm_page_inf
 	info.ppn     = ppm_page2ppn(newpage);
 	info.cluster = NULL;
 
+	swap_rmap_set(newpage, region->vmm, vaddr);
+
 	err = pmm_set_page(&region->vmm->pmm, vaddr, &info);
+
+	if((err == 0) && (newpage != page))
+		swap_rmap_clear(page, region->vmm);
+
+#if CONFIG_PPM_RECLAIM
+	if((err == 0) && (newpage != page))
+		ppm_lru_add(newpage, true);
+#endif
   
 VMM_COW_END:
 	page_unlock(page);
@@ -1082,10 +1408,11 @@ static inline error_t vmm_do_mapped(struct vm_region_s *region, uint_t vaddr, ui
 
 	index = ((vaddr - region->vm_start) + region->vm_offset) >> PMM_PAGE_SHIFT;
 
-	page = mapper_get_page(region->vm_mapper, 
-			       index, 
-			       MAPPER_SYNC_OP,
-			       region->vm_file);
+	page = mapper_get_page_on(region->vm_mapper, 
+				  index, 
+				  MAPPER_SYNC_OP,
+				  region->vm_file,
+				  vm_region_mpol_cluster(region, vaddr));
 
 	if(page == NULL)
 		return (region->vm_file == NULL) ? EIO : ENOMEM;
@@ -1100,6 +1427,19 @@ static inline error_t vmm_do_mapped(struct vm_region_s *region, uint_t vaddr, ui
 
 	page_lock(page);
 
+#if CONFIG_PPM_RECLAIM
+	/* Evicted by the page reclaim since we got it, the access will fault again */
+	if((page->mapper != region->vm_mapper) || (page->index != index))
+	{
+		page_unlock(page);
+		mapper_put_page(page);
+		return 0;
+	}
+
+	/* Mapped pagecache pages have no reverse map, they are never evicted */
+	PAGE_SET(page, PG_MAPPED);
+#endif
+
 	err = pmm_get_page(&region->vmm->pmm, vaddr, &current);
 
 	if(err == 0)
@@ -1145,6 +1485,7 @@ static inline error_t vmm_do_mapped(struct vm_region_s *region, uint_t vaddr, ui
 	}
 
 	page_unlock(page);
+	mapper_put_page(page);
 
 	return err;
 }
@@ -1178,13 +1519,14 @@ static inline error_t vmm_do_aod(struct vm_region_s *region, uint_t vaddr)
 	req.size  = 0;
 	req.flags = AF_PGFAULT | AF_ZERO;
 
-	if((page = kmem_alloc(&req)) == NULL)
+	if((page = vmm_mpol_alloc(region, vaddr, &req)) == NULL)
 	{
 		(void)pmm_unlock_page(&region->vmm->pmm, vaddr, &old);
 		return ENOMEM;
 	}
 
 	page->mapper = NULL;
+	swap_rmap_set(page, region->vmm, vaddr);
 
 	new.attr    = region->vm_pgprot;
 	new.ppn     = ppm_page2ppn(page);
@@ -1199,6 +1541,10 @@ static inline error_t vmm_do_aod(struct vm_region_s *region, uint_t vaddr)
 	if(page->cid != cluster->id)
 		this->info.remote_pages_cntr ++;
 
+#if CONFIG_PPM_RECLAIM
+	ppm_lru_add(page, true);
+#endif
+
 	return 0;
 
 fail_set_pg:
@@ -1210,6 +1556,125 @@ fail_set_pg:
 	return err;
 }
 
+#if CONFIG_SWAP
+static inline bool_t vmm_pte_isSwapEntry(struct vmm_s *vmm, uint_t vaddr, uint_t slot)
+{
+	pmm_page_info_t info;
+
+	if(pmm_get_page(&vmm->pmm, vaddr, &info))
+		return false;
+
+	return ((info.attr & PMM_SWAP) && !(info.attr & PMM_PRESENT) && (info.ppn == slot));
+}
+
+/* Brings back the page of a swap entry, the faulting task gets its own copy if the slot is shared */
+static error_t vmm_do_swapin(struct vm_region_s *region, uint_t vaddr, uint_t slot)
+{
+	register struct thread_s *this;
+	register struct vmm_s *vmm;
+	struct page_s *page;
+	struct page_s *newpage;
+	pmm_page_info_t info;
+	kmem_req_t req;
+	error_t err;
+
+	this     = current_thread;
+	vmm      = region->vmm;
+	page     = NULL;
+	err      = 0;
+	req.type = KMEM_PAGE;
+	req.size = 0;
+
+	/* Keeps fork from sharing the slot meanwhile */
+	rwlock_rdlock(&vmm->rwlock);
+
+	if(vmm_pte_isSwapEntry(vmm, vaddr, slot) == false)
+		goto VMM_SWAPIN_SPURIOUS;
+
+	swap_readahead(slot);
+
+	while(1)
+	{
+		/* As for a mapper without a file, the slot could not be read back */
+		if((page = swap_cache_get(slot)) == NULL)
+		{
+			err = EIO;
+			goto VMM_SWAPIN_END;
+		}
+
+		page_lock(page);
+
+		if(vmm_pte_isSwapEntry(vmm, vaddr, slot) == false)
+			goto VMM_SWAPIN_SPURIOUS;
+
+		/* Otherwise it has left the swap cache before we locked it */
+		if((page->mapper == swap_area.cache) && (page->index == slot))
+			break;
+
+		page_unlock(page);
+		req.ptr = page;
+		kmem_free(&req);
+	}
+
+	/* The reference it gives goes to the mapping */
+	if(swap_cache_take(slot, page))
+		newpage = page;
+	else
+	{
+		req.flags = AF_PGFAULT;
+
+		if((newpage = vmm_mpol_alloc(region, vaddr, &req)) == NULL)
+		{
+			err = ENOMEM;
+			goto VMM_SWAPIN_UNLOCK;
+		}
+
+		newpage->mapper = NULL;
+		page_copy(newpage, page);
+	}
+
+	info.attr    = region->vm_pgprot;
+	info.ppn     = ppm_page2ppn(newpage);
+	info.cluster = NULL;
+
+	swap_rmap_set(newpage, vmm, vaddr);
+
+	/* The slot is kept on error, so its content is not lost */
+	if((err = pmm_set_page(&vmm->pmm, vaddr, &info)))
+	{
+		req.ptr = newpage;
+		kmem_free(&req);
+		goto VMM_SWAPIN_UNLOCK;
+	}
+
+	swap_free(slot);
+
+#if CONFIG_PPM_RECLAIM
+	ppm_lru_add(newpage, true);
+#endif
+
+	if(newpage->cid != current_cluster->id)
+		this->info.remote_pages_cntr ++;
+
+	goto VMM_SWAPIN_UNLOCK;
+
+VMM_SWAPIN_SPURIOUS:
+	this->info.spurious_pgfault_cntr ++;
+
+	if(page == NULL)
+		goto VMM_SWAPIN_END;
+
+VMM_SWAPIN_UNLOCK:
+	page_unlock(page);
+	req.ptr = page;
+	kmem_free(&req);
+
+VMM_SWAPIN_END:
+	rwlock_unlock(&vmm->rwlock);
+	return err;
+}
+#endif	/* CONFIG_SWAP */
+
 VM_REGION_PAGE_FAULT(vmm_default_pagefault)
 {
 	register struct thread_s *this;
@@ -1220,6 +1685,12 @@ VM_REGION_PAGE_FAULT(vmm_default_pagefault)
 	if((err = pmm_get_page(&region->vmm->pmm, vaddr, &info)))
 		return err;
 
+#if CONFIG_SWAP
+	/* The ppn of a swap entry is its slot, which may be 0 */
+	if((info.attr & PMM_SWAP) && !(info.attr & PMM_PRESENT))
+		return vmm_do_swapin(region, vaddr, info.ppn);
+#endif
+
 	if((info.attr != 0) && (info.ppn != 0))
 	{
 		if((info.attr & PMM_COW) && pmm_except_isWrite(flags))
@@ -1232,6 +1703,11 @@ VM_REGION_PAGE_FAULT(vmm_default_pagefault)
 		if(info.attr & PMM_MIGRATE)
 			return vmm_do_migrate(region, &info, vaddr);
 
+#if CONFIG_NUMA_BALANCING
+		if(info.attr & PMM_HINT)
+			return vmm_do_hint(region, &info, vaddr);
+#endif
+
 		if(info.attr & PMM_PRESENT)
 		{
 			this = current_thread;
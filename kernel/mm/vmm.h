@@ -34,6 +34,7 @@
 
 struct task_s;
 struct vfs_file_s;
+struct cluster_s;
 struct page_s;
 struct vmm_s;
 struct vm_region_s;
@@ -86,6 +87,12 @@ struct vmm_s
 	uint_t heap_current;
 	uint_t entry_point;
 	struct vm_region_s *heap_region;
+
+#if CONFIG_NUMA_BALANCING
+	/* Automatic NUMA balancing */
+	volatile uint_t numa_scan_stamp;	/* next scan, in cpu_time_stamp() cycles */
+	volatile uint_t numa_scan_addr;
+#endif
 };
 
 #define MADV_NORMAL        0x0
@@ -94,6 +101,7 @@ struct vmm_s
 #define MADV_WILLNEED      0x3
 #define MADV_DONTNEED      0x4
 #define MADV_MIGRATE       0x5
+#define MADV_MPOL          0x6	/* sets the memory policy given by mpol_attr_t */
 
 #define MGRT_DEFAULT       0x0
 #define MGRT_STACK         0x1
@@ -108,6 +116,12 @@ typedef struct mmap_attr_s
 	off_t offset;
 }mmap_attr_t;
 
+typedef struct mpol_attr_s
+{
+	uint_t mode;
+	BITMAP_DECLARE(mask, VM_MPOL_MASK_SIZE);
+}mpol_attr_t;
+
 error_t vmm_init(struct vmm_s *vmm);
 
 error_t vmm_dup(struct vmm_s *dst, struct vmm_s *src);
@@ -119,7 +133,7 @@ error_t vmm_destroy(struct vmm_s *vmm);
 inline error_t vmm_check_address(char *objname, struct task_s *task, void *addr, uint_t size);
 
 int sys_mmap(mmap_attr_t *mattr);
-int sys_madvise(void *start, size_t length, uint_t advice);
+int sys_madvise(void *start, size_t length, uint_t advice, mpol_attr_t *mpol);
 int sys_sbrk(uint_t current_heap_ptr, uint_t size);
 
 error_t vmm_sbrk(struct vmm_s *vmm, uint_t current, uint_t size);
@@ -134,12 +148,40 @@ void *vmm_mmap(struct task_s *task,
 
 error_t vmm_munmap(struct vmm_s *vmm, uint_t addr, uint_t length);
 
+/**
+ * Faults in a user page of the current task as a kernel access
+ * would and takes a reference on it, for the kernel paths using
+ * its physical address (DMA, I/O completions). With isWrite, COW
+ * is broken and the write permission is checked first.
+ *
+ * @vmm         current task's vmm
+ * @vaddr       user address in the page
+ * @isWrite     the page is going to be written
+ * @page        referenced page, released by kmem_free
+ * @return      0, or EFAULT if the access is not allowed
+ **/
+error_t vmm_get_user_page(struct vmm_s *vmm, uint_t vaddr, bool_t isWrite, struct page_s **page);
+
 error_t vmm_madvise_migrate(struct vmm_s *vmm, uint_t start, uint_t len);
 
 error_t vmm_madvise_willneed(struct vmm_s *vmm, uint_t start, uint_t len);
 
 error_t vmm_set_auto_migrate(struct vmm_s *vmm, uint_t start, uint_t flags);
 
+/* Hypothesis: vaddr is page aligned, the page is moved to the given cluster */
+error_t vmm_move_page(struct vmm_s *vmm, uint_t vaddr, struct cluster_s *cluster);
+
+#if CONFIG_NUMA_BALANCING
+/* 
+ * Revokes the access to a sample of the private pages, at most once per
+ * CONFIG_NUMA_SCAN_PERIOD ticks: the thread whose CAS moves the deadline
+ * forward scans, the task's others return.
+ */
+void vmm_numa_scan(struct vmm_s *vmm);
+
+#define vmm_numa_scan_isPending(_vmm) ((sint_t)(cpu_time_stamp() - (_vmm)->numa_scan_stamp) >= 0)
+#endif
+
 /* Hypothesis: the region is shared-anon, mapper list is rdlocked, page is locked */
 error_t vmm_broadcast_inval(struct vm_region_s *region, struct page_s *page, struct page_s **new);
 
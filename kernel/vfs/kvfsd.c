@@ -38,6 +38,7 @@
 #include <page.h>
 #include <ext2-private.h>
 #include <event.h>
+#include <swap.h>
 #include <dqdt.h>
 
 #define USR_START (CONFIG_USR_START)
@@ -96,6 +97,10 @@ void* kvfsd(void *arg)
 
 	sysconf_init();
 
+#if CONFIG_SWAP
+	(void)swap_init();
+#endif
+
 	if(err == 0)
 	{
 		if((err = task_load_init(task)))
@@ -30,6 +30,9 @@
 #define VFS_MAX_PATH             VFS_MAX_NAME_LENGTH * VFS_MAX_PATH_DEPTH + 1
 #define VFS_MAX_NODE_NUMBER      40
 #define VFS_MAX_FILE_NUMBER      (CONFIG_TASK_FILE_MAX_NR)
+#define VFS_IOV_MAX              16
+#define VFS_AIO_MAX              16      /* pending async requests per thread */
+#define VFS_AIO_MAX_SIZE         65536   /* larger async requests are run by vfs_aiod */
 
 #define VFS_DEBUG                CONFIG_VFS_DEBUG
 
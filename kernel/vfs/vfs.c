@@ -637,6 +637,39 @@ VFS_READ_ERROR:
 }
 
 
+/* Grow node's size up to end, node's wrlock must be taken */
+static void vfs_node_extend(struct vfs_file_s *file, uint_t end)
+{
+	if(end <= file->f_node->n_size)
+		return;
+
+	file->f_node->n_size = end;
+
+	if(VFS_IS(file->f_flags, VFS_O_SYNC))
+	{
+		vfs_dmsg(1,"%s: node size %d, sync to disk\n", 
+			 __FUNCTION__,
+			 file->f_node->n_size);
+		/* 
+		 * No need to lock node_freelist & change node's state to INLOAD 
+		 * as node count is at least 1 _and_ node wrlock is taken 
+		 */
+		file->f_node->n_op->write(file->f_node);
+	}
+	else
+	{
+		vfs_dmsg(1,"%s: node size %d, set it to DIRTY\n", 
+			 __FUNCTION__,
+			 file->f_node->n_size);
+
+		/*
+		 * No need to lock node_freelist as node count is at least 1 _and_ 
+		 * node wrlock is taken 
+		 */
+		VFS_SET(file->f_node->n_state, VFS_DIRTY);
+	}
+}
+
 ssize_t vfs_write (struct vfs_file_s *file, uint8_t *buffer, size_t count) 
 {
 	ssize_t size;
@@ -673,43 +706,159 @@ ssize_t vfs_write (struct vfs_file_s *file, uint8_t *buffer, size_t count)
 		 hasToLock);
 
 	if(hasToLock) 
+		vfs_node_extend(file, file->f_offset);
+
+VFS_WRITE_ERROR:
+	rwlock_unlock(&file->f_node->n_rwlock);
+	rwlock_unlock(&file->f_rwlock);
+	return size;
+}
+
+
+
+error_t vfs_iovec_copyin(struct vfs_iovec_s *dst, struct vfs_iovec_s *usr_iov, uint_t iovcnt, size_t *count)
+{
+	size_t total;
+	uint_t i;
+	error_t err;
+
+	if((iovcnt == 0) || (iovcnt > VFS_IOV_MAX) || 
+	   ((uint_t)usr_iov >= CONFIG_KERNEL_OFFSET))
+		return EINVAL;
+
+	if((err = cpu_uspace_copy(dst, usr_iov, sizeof(*dst) * iovcnt)))
+		return err;
+
+	for(total = 0, i = 0; i < iovcnt; i++)
 	{
-		if(file->f_offset > file->f_node->n_size)
-		{
-			file->f_node->n_size = file->f_offset;
-
-			if(VFS_IS(file->f_flags, VFS_O_SYNC))
-			{
-				vfs_dmsg(1,"%s: node size %d, sync to disk\n", 
-					 __FUNCTION__,
-					 file->f_node->n_size);
-				/* 
-				 * No need to lock node_freelist & change node's state to INLOAD 
-				 * as node count is at least 1 _and_ node wrlock is taken 
-				 */
-				file->f_node->n_op->write(file->f_node);
-			}
-			else
-			{
-				vfs_dmsg(1,"%s: node size %d, set it to DIRTY\n", 
-					 __FUNCTION__,
-					 file->f_node->n_size);
-
-				/*
-				 * No need to lock node_freelist as node count is at least 1 _and_ 
-				 * node wrlock is taken 
-				 */
-				VFS_SET(file->f_node->n_state, VFS_DIRTY);
-			}
-		}
+		if(((uint_t)dst[i].iov_base >= CONFIG_KERNEL_OFFSET) ||
+		   (dst[i].iov_len > (CONFIG_KERNEL_OFFSET - (uint_t)dst[i].iov_base)) ||
+		   ((total + dst[i].iov_len) < total))
+			return EINVAL;
+
+		total += dst[i].iov_len;
 	}
 
-VFS_WRITE_ERROR:
+	*count = total;
+	return 0;
+}
+
+/* Vector I/O on files without readv/writev methods, one iovec at a time */
+static ssize_t vfs_iov_fallback(struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, bool_t isWrite)
+{
+	ssize_t done;
+	ssize_t size;
+	uint_t i;
+
+	for(done = 0, i = 0; i < iovcnt; i++)
+	{
+		if(iov[i].iov_len == 0)
+			continue;
+
+		if(isWrite)
+			size = vfs_write(file, iov[i].iov_base, iov[i].iov_len);
+		else
+			size = vfs_read(file, iov[i].iov_base, iov[i].iov_len);
+
+		if(size < 0)
+			return (done) ? done : size;
+
+		done += size;
+
+		if((size_t)size != iov[i].iov_len)
+			break;
+	}
+
+	return done;
+}
+
+ssize_t vfs_readv(struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t *offset)
+{
+	ssize_t size;
+
+	if(VFS_IS(file->f_flags,VFS_O_DIRECTORY))
+		return -EISDIR;
+
+	if(!(VFS_IS(file->f_flags,VFS_O_RDONLY)))
+		return -EBADF;
+
+	if(file->f_op->readv == NULL)
+		return (offset == NULL) ? vfs_iov_fallback(file, iov, iovcnt, false) : -ESPIPE;
+
+	/* Positional readers share the file, only the node must be stable */
+	if(offset == NULL)
+		rwlock_wrlock(&file->f_rwlock);
+	else
+		rwlock_rdlock(&file->f_rwlock);
+
+	rwlock_rdlock(&file->f_node->n_rwlock);
+
+	size = file->f_op->readv(file, iov, iovcnt, (offset == NULL) ? file->f_offset : *offset);
+
+	if((size > 0) && (offset == NULL))
+		file->f_offset += size;
+
 	rwlock_unlock(&file->f_node->n_rwlock);
 	rwlock_unlock(&file->f_rwlock);
 	return size;
 }
 
+ssize_t vfs_writev(struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t *offset)
+{
+	ssize_t size;
+	size_t count;
+	uint_t start;
+	uint_t i;
+	bool_t hasToLock;
+
+	if(VFS_IS(file->f_flags,VFS_O_DIRECTORY))
+		return -EINVAL;
+
+	if(!(VFS_IS(file->f_flags,VFS_O_WRONLY)))
+		return -EBADF;
+
+	if(file->f_op->writev == NULL)
+		return (offset == NULL) ? vfs_iov_fallback(file, iov, iovcnt, true) : -ESPIPE;
+
+	for(count = 0, i = 0; i < iovcnt; i++)
+		count += iov[i].iov_len;
+
+	if(offset == NULL)
+		rwlock_wrlock(&file->f_rwlock);
+	else
+		rwlock_rdlock(&file->f_rwlock);
+
+	start     = (offset == NULL) ? file->f_offset : *offset;
+	hasToLock = false;
+	rwlock_rdlock(&file->f_node->n_rwlock);
+
+	if((start + count) > file->f_node->n_size)
+	{
+		hasToLock = true;
+		rwlock_unlock(&file->f_node->n_rwlock);
+		rwlock_wrlock(&file->f_node->n_rwlock);
+	}
+
+	if((size = file->f_op->writev(file, iov, iovcnt, start)) > 0)
+	{
+		if(offset == NULL)
+			file->f_offset += size;
+
+		if(hasToLock)
+			vfs_node_extend(file, start + size);
+	}
+
+	vfs_dmsg(1,"%s: %d has been wrote at %d, n_size %d, hasToLock %d\n",
+		 __FUNCTION__,
+		 size, 
+		 start,
+		 file->f_node->n_size,
+		 hasToLock);
+
+	rwlock_unlock(&file->f_node->n_rwlock);
+	rwlock_unlock(&file->f_rwlock);
+	return size;
+}
 
 error_t vfs_lseek(struct vfs_file_s *file, size_t offset, uint_t whence, size_t *new_offset_ptr) 
 {
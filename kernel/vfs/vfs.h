@@ -39,6 +39,8 @@ struct vfs_node_op_s;
 struct vfs_file_op_s;
 struct vfs_context_op_s;
 struct vm_region_s;
+struct thread_s;
+struct mapper_s;
 
 struct vfs_dirent_s
 {
@@ -64,6 +66,36 @@ struct vfs_stat_s
 	time_t    st_ctime;   /* time of last status change */
 };
 
+/* Asynchronous I/O control block, shared with user-space (dietlibc aio.h) */
+struct vfs_aiocb_s
+{
+	uint_t aio_fildes;
+	uint_t aio_lio_opcode;
+	uint_t aio_reqprio;
+	uint_t aio_offset;
+	void *aio_buf;
+	size_t aio_nbytes;
+	volatile error_t aio_error;	/* EINPROGRESS until completion */
+	ssize_t aio_return;
+};
+
+/* aio_lio_opcode values */
+#define VFS_AIO_READ     0
+#define VFS_AIO_WRITE    1
+
+/* sys_aio operations */
+#define VFS_AIO_SUBMIT   1
+#define VFS_AIO_POLL     2
+#define VFS_AIO_WAIT     3
+#define VFS_AIO_CANCEL   4
+
+/* I/O vector, iov_base is a user-space address */
+struct vfs_iovec_s
+{
+	void *iov_base;
+	size_t iov_len;
+};
+
 struct vfs_context_s
 {
 	uint_t  ctx_type;
@@ -173,6 +205,8 @@ struct vfs_node_op_s
 #define VFS_READ_DIR(n)     error_t (n) (struct vfs_file_s *file, struct vfs_dirent_s *dirent)
 #define VFS_MMAP_FILE(n)    error_t (n) (struct vfs_file_s *file, struct vm_region_s *region)
 #define VFS_MUNMAP_FILE(n)  error_t (n) (struct vfs_file_s *file, struct vm_region_s *region)
+#define VFS_READV_FILE(n)   ssize_t (n) (struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t offset)
+#define VFS_WRITEV_FILE(n)  ssize_t (n) (struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t offset)
 
 typedef VFS_OPEN_FILE(vfs_open_file_t);
 typedef VFS_READ_FILE(vfs_read_file_t);
@@ -183,6 +217,8 @@ typedef VFS_RELEASE_FILE(vfs_release_file_t);
 typedef VFS_READ_DIR(vfs_read_dir_t);
 typedef VFS_MMAP_FILE(vfs_mmap_file_t);
 typedef VFS_MUNMAP_FILE(vfs_munmap_file_t);
+typedef VFS_READV_FILE(vfs_readv_file_t);
+typedef VFS_WRITEV_FILE(vfs_writev_file_t);
 
 struct vfs_file_op_s
 {
@@ -195,6 +231,8 @@ struct vfs_file_op_s
 	vfs_release_file_t *release;
 	vfs_mmap_file_t *mmap;
 	vfs_munmap_file_t *munmap;
+	vfs_readv_file_t *readv;
+	vfs_writev_file_t *writev;
 };
 
 /* Default/generic methods */
@@ -202,6 +240,8 @@ VFS_MMAP_FILE(vfs_default_mmap_file);
 VFS_MMAP_FILE(vfs_default_munmap_file);
 VFS_WRITE_FILE(vfs_default_read);
 VFS_WRITE_FILE(vfs_default_write);
+VFS_READV_FILE(vfs_default_readv);
+VFS_WRITEV_FILE(vfs_default_writev);
 
 /** Kernel VFS Daemon */
 extern void* kvfsd(void*);
@@ -229,6 +269,47 @@ error_t vfs_open(struct vfs_node_s *cwd,
 ssize_t vfs_read(struct vfs_file_s *file, uint8_t *buffer, size_t count);
 ssize_t vfs_write (struct vfs_file_s *file, uint8_t *buffer, size_t count);
 error_t vfs_lseek(struct vfs_file_s *file, size_t offset, uint_t whence, size_t *new_offset_ptr);
+
+/** 
+ * Vectored read/write, iov must be a kernel copy of user's vector.
+ * If offset is NULL the file offset is used and updated, otherwise
+ * the I/O is positional and the file offset is left untouched.
+ */
+ssize_t vfs_readv(struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t *offset);
+ssize_t vfs_writev(struct vfs_file_s *file, struct vfs_iovec_s *iov, uint_t iovcnt, uint_t *offset);
+
+/** Copy & check a user I/O vector, returns total length in count */
+error_t vfs_iovec_copyin(struct vfs_iovec_s *dst, struct vfs_iovec_s *usr_iov, uint_t iovcnt, size_t *count);
+
+/** 
+ * Asynchronous I/O of current thread. Submission starts the page
+ * cache fills and returns, data is transferred by the fill that
+ * loads the last page of the request. Requests which would block are
+ * queued to vfs_aiod. Results are written back to the user control
+ * block which is the request key.
+ */
+error_t vfs_aio_submit(struct vfs_aiocb_s *uaiocb);
+
+/** Returns 0 if the request is completed, EINPROGRESS otherwise */
+error_t vfs_aio_poll(struct vfs_aiocb_s *uaiocb);
+
+/** Wait until at least min requests of ulist are completed, their number is set in done */
+error_t vfs_aio_wait(struct vfs_aiocb_s **ulist, uint_t nr, uint_t min, uint_t *done);
+
+/** Drop a pending request, its result is set to ECANCELED */
+error_t vfs_aio_cancel(struct vfs_aiocb_s *uaiocb);
+
+/** Release asynchronous I/O state of a dying thread */
+void vfs_aio_destroy(struct thread_s *thread);
+
+/** Ends the pending requests waiting for this page, called by mapper_io_end */
+void vfs_aio_page_end(struct mapper_s *mapper, uint_t index);
+
+/** Init the pending requests list */
+void vfs_aio_init(void);
+
+/** Worker thread, runs the asynchronous I/O steps which may sleep */
+void* vfs_aiod(void *arg);
 error_t vfs_close(struct vfs_file_s *file, uint_t *refcount);
 error_t vfs_unlink(struct vfs_node_s *cwd, char *pathname);
 error_t vfs_stat(struct vfs_node_s *cwd, char *pathname, struct vfs_node_s **node);
@@ -0,0 +1,913 @@
+/*
+ * vfs/vfs_aio.c - asynchronous file I/O through the page cache
+ *
+ * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
+ * Copyright (c) 2011,2012 UPMC Sorbonne Universites
+ *
+ * This file is part of ALMOS-kernel.
+ *
+ * ALMOS-kernel is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2.0 of the License.
+ *
+ * ALMOS-kernel is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ALMOS-kernel; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <list.h>
+#include <spinlock.h>
+#include <wait_queue.h>
+#include <scheduler.h>
+#include <thread.h>
+#include <task.h>
+#include <cpu.h>
+#include <cluster.h>
+#include <kmem.h>
+#include <vfs.h>
+#include <mapper.h>
+#include <page.h>
+#include <ppm.h>
+#include <vmm.h>
+
+/*
+ * Requests are private to their submitting thread and keyed by the
+ * user control block address. At submission the file is referenced,
+ * the user buffer and the control block results are pinned through
+ * vmm_get_user_page, and the page cache pages are prefetched and held.
+ * Pending requests are listed in vfs_aio_root: each mapper_io_end,
+ * run by the blkio completions on the per-CPU events managers, ends
+ * the requests whose pages are all loaded. The copy and the results
+ * are done there, through the kernel addresses of the pinned pages,
+ * so requests complete whether or not they are polled. vfs_close may
+ * sleep, so the events managers hand the file reference of the
+ * requests they end to vfs_aiod, the worker thread.
+ *
+ * Submission does not wait: the requests the fills cannot end (large
+ * ones, writes growing the node or to be synced) and the ones finding
+ * a page loaded by another thread are queued to vfs_aiod. It runs the
+ * former through vfs_readv/vfs_writev on the pinned user pages and
+ * starts the latter, waiting for the pages.
+ *
+ * A fork while a read is pending may leave its data in the page then
+ * shared with the child, the page having been pinned before the COW.
+ */
+
+#define VFS_AIO_PAGES     ((VFS_AIO_MAX_SIZE >> PMM_PAGE_SHIFT) + 1)
+
+#define VFS_AIO_PENDING   0	/* in vfs_aio_root */
+#define VFS_AIO_ENDING    1	/* being ended, by an events manager, vfs_aiod or the owner */
+#define VFS_AIO_DONE      2	/* results published, to be reaped by the owner */
+#define VFS_AIO_QUEUED    3	/* in vfs_aio_work, to be started by vfs_aiod */
+
+#define VFS_AIO_IOV       16	/* vfs_aiod I/O vector, in user pages */
+
+struct vfs_aio_req_s
+{
+	struct list_entry list;
+	struct vfs_aio_s *aio;		/* owner */
+	struct vfs_aiocb_s *uaiocb;
+	struct vfs_file_s *file;	/* referenced, NULL once released */
+	struct mapper_s *mapper;
+	volatile uint_t state;
+	bool_t isAsync;			/* ended by the page cache fills */
+	uint_t opcode;
+	uint_t offset;
+	uint_t buf;
+	size_t count;
+	uint_t first;			/* first page cache index */
+	uint_t end;			/* last page cache index + 1 */
+	volatile error_t *kerror;	/* aio_error & aio_return in the pinned pages */
+	ssize_t *kreturn;
+	struct page_s *cb_pages[2];
+	struct page_s *cpages[VFS_AIO_PAGES];
+	uint_t upages_nr;
+	struct page_s *upages[];	/* user buffer */
+};
+
+struct vfs_aio_s
+{
+	uint_t count;
+	volatile uint_t done_nr;	/* requests ended so far, under vfs_aio_lock */
+	struct wait_queue_s wait;
+	struct vfs_aio_req_s *tbl[VFS_AIO_MAX];
+};
+
+static spinlock_t vfs_aio_lock;
+static struct list_entry vfs_aio_root;
+static struct list_entry vfs_aio_work;		/* requests handed to vfs_aiod */
+static struct wait_queue_s vfs_aio_wq;
+
+void vfs_aio_init(void)
+{
+	spinlock_init(&vfs_aio_lock, "VFS AIO");
+	list_root_init(&vfs_aio_root);
+	list_root_init(&vfs_aio_work);
+	wait_queue_init(&vfs_aio_wq, "VFS AIO Worker");
+}
+
+static struct vfs_aio_req_s* vfs_aio_lookup(struct vfs_aio_s *aio, struct vfs_aiocb_s *uaiocb)
+{
+	register uint_t i;
+
+	if((aio == NULL) || (aio->count == 0))
+		return NULL;
+
+	for(i = 0; i < VFS_AIO_MAX; i++)
+	{
+		if((aio->tbl[i] != NULL) && (aio->tbl[i]->uaiocb == uaiocb))
+			return aio->tbl[i];
+	}
+
+	return NULL;
+}
+
+static struct vfs_file_s* vfs_aio_file(uint_t fd)
+{
+	if(fd >= CONFIG_TASK_FILE_MAX_NR)
+		return NULL;
+
+	return task_fd_lookup(current_task, fd);
+}
+
+/* Files served by the page cache */
+static bool_t vfs_aio_isCached(struct vfs_file_s *file)
+{
+	return ((file->f_op->readv != NULL)         && 
+		(file->f_node->n_mapper != NULL)    &&
+		!(file->f_node->n_attr & (VFS_DIR | VFS_FIFO | VFS_DEV)));
+}
+
+/* 
+ * Requests of cached files the fills can end, others are run by
+ * vfs_aiod, as are the writes growing the node or to be synced,
+ * both needing the node's wrlock.
+ */
+static bool_t vfs_aio_isAsync(struct vfs_file_s *file, struct vfs_aiocb_s *aiocb)
+{
+	if(aiocb->aio_nbytes > VFS_AIO_MAX_SIZE)
+		return false;
+
+	if(aiocb->aio_lio_opcode == VFS_AIO_READ)
+		return true;
+
+	return (!(VFS_IS(file->f_flags, VFS_O_SYNC)) && 
+		((aiocb->aio_offset + aiocb->aio_nbytes) <= file->f_node->n_size));
+}
+
+static void vfs_aio_complete_sync(struct vfs_aiocb_s *uaiocb, struct vfs_file_s *file, struct vfs_aiocb_s *aiocb)
+{
+	struct vfs_iovec_s iov;
+	uint_t offset;
+	ssize_t size;
+	error_t err;
+
+	iov.iov_base = aiocb->aio_buf;
+	iov.iov_len  = aiocb->aio_nbytes;
+	offset       = aiocb->aio_offset;
+
+	if(aiocb->aio_nbytes == 0)
+		size = 0;
+	else if(aiocb->aio_lio_opcode == VFS_AIO_READ)
+		size = vfs_readv(file, &iov, 1, (vfs_aio_isCached(file)) ? &offset : NULL);
+	else
+		size = vfs_writev(file, &iov, 1, (vfs_aio_isCached(file)) ? &offset : NULL);
+
+	err  = (size < 0) ? -size : 0;
+	size = (size < 0) ? -1 : size;
+
+	/* aio_error is the completion flag, it must be published last */
+	(void)cpu_uspace_copy(&uaiocb->aio_return, &size, sizeof(size));
+	cpu_wbflush();
+	(void)cpu_uspace_copy((void*)&uaiocb->aio_error, &err, sizeof(err));
+}
+
+static void vfs_aio_publish(struct vfs_aio_req_s *rq, ssize_t size, error_t err)
+{
+	*rq->kreturn = size;
+	cpu_wbflush();
+	*rq->kerror  = err;
+}
+
+static void vfs_aio_put_pages(struct vfs_aio_req_s *rq)
+{
+	kmem_req_t req;
+	uint_t i;
+
+	req.type = KMEM_PAGE;
+
+	for(i = 0; i < VFS_AIO_PAGES; i++)
+	{
+		if((req.ptr = rq->cpages[i]) != NULL)
+			kmem_free(&req);
+
+		rq->cpages[i] = NULL;
+	}
+
+	for(i = 0; i < rq->upages_nr; i++)
+	{
+		if((req.ptr = rq->upages[i]) != NULL)
+			kmem_free(&req);
+
+		rq->upages[i] = NULL;
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		if((req.ptr = rq->cb_pages[i]) != NULL)
+			kmem_free(&req);
+
+		rq->cb_pages[i] = NULL;
+	}
+}
+
+/* Pins the user page of addr, returns its kernel address */
+static void* vfs_aio_pin(struct vmm_s *vmm, uint_t addr, bool_t isWrite, struct page_s **page)
+{
+	if(vmm_get_user_page(vmm, addr, isWrite, page))
+		return NULL;
+
+	return (uint8_t*)ppm_page2addr(*page) + (addr & PMM_PAGE_MASK);
+}
+
+/* Holds the pages of rq, the page cache ones aside */
+static error_t vfs_aio_pin_pages(struct vfs_aio_req_s *rq)
+{
+	struct vmm_s *vmm;
+	uint_t addr;
+	uint_t i;
+
+	vmm = &current_task->vmm;
+
+	rq->kerror = vfs_aio_pin(vmm, (uint_t)&rq->uaiocb->aio_error, true, &rq->cb_pages[0]);
+
+	if(rq->kerror == NULL)
+		return EFAULT;
+
+	rq->kreturn = vfs_aio_pin(vmm, (uint_t)&rq->uaiocb->aio_return, true, &rq->cb_pages[1]);
+
+	if(rq->kreturn == NULL)
+		return EFAULT;
+
+	/* Read data are written to the user buffer */
+	addr = rq->buf & ~PMM_PAGE_MASK;
+
+	for(i = 0; addr < (rq->buf + rq->count); i++, addr += PMM_PAGE_SIZE)
+	{
+		if(vfs_aio_pin(vmm, addr, (rq->opcode == VFS_AIO_READ), &rq->upages[i]) == NULL)
+			return EFAULT;
+	}
+
+	return 0;
+}
+
+/* Returns false while a page cache page of rq is being filled */
+static bool_t vfs_aio_isReady(struct vfs_aio_req_s *rq)
+{
+	struct page_s *page;
+	uint_t i;
+
+	for(i = 0; i < (rq->end - rq->first); i++)
+	{
+		page = rq->cpages[i];
+
+		if((page != NULL) && (PAGE_IS(page, PG_INLOAD)))
+			return false;
+	}
+
+	return true;
+}
+
+/* Copies between the held pages, returns the size done or -error */
+static ssize_t vfs_aio_transfer(struct vfs_aio_req_s *rq)
+{
+	struct page_s *page;
+	uint8_t *pcache;
+	uint8_t *puser;
+	uint_t limit;
+	uint_t foff;
+	uint_t uaddr;
+	size_t count;
+	size_t done;
+	size_t len;
+
+	count = rq->count;
+
+	if(rq->opcode == VFS_AIO_READ)
+	{
+		limit = rq->file->f_node->n_size;
+		limit = (limit > (rq->end << PMM_PAGE_SHIFT)) ? (rq->end << PMM_PAGE_SHIFT) : limit;
+		count = (rq->offset >= limit) ? 0 : MIN(count, limit - rq->offset);
+	}
+
+	for(done = 0; done < count; done += len)
+	{
+		foff  = rq->offset + done;
+		uaddr = rq->buf + done;
+		len   = PMM_PAGE_SIZE - (foff & PMM_PAGE_MASK);
+		len   = MIN(len, PMM_PAGE_SIZE - (uaddr & PMM_PAGE_MASK));
+		len   = MIN(len, count - done);
+		page  = rq->cpages[(foff >> PMM_PAGE_SHIFT) - rq->first];
+
+		/* Its fill has failed, the transfer stops short */
+		if((page == NULL) || (page->mapper != rq->mapper))
+			break;
+
+		pcache  = (uint8_t*) ppm_page2addr(page);
+		pcache += foff & PMM_PAGE_MASK;
+		puser   = (uint8_t*) ppm_page2addr(rq->upages[(uaddr >> PMM_PAGE_SHIFT) - (rq->buf >> PMM_PAGE_SHIFT)]);
+		puser  += uaddr & PMM_PAGE_MASK;
+
+		if(rq->opcode == VFS_AIO_READ)
+			memcpy(puser, pcache, len);
+		else
+		{
+			memcpy(pcache, puser, len);
+			rq->mapper->m_ops->set_page_dirty(page);
+		}
+	}
+
+	return ((done == 0) && (count != 0)) ? -EIO : done;
+}
+
+/* Hypothesis: rq is ENDING, its results are published */
+static void vfs_aio_done(struct vfs_aio_req_s *rq)
+{
+	struct vfs_aio_s *aio;
+	uint_t irq_state;
+
+	(void)vfs_close(rq->file, NULL);
+	rq->file = NULL;
+
+	aio = rq->aio;
+
+	spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+	aio->done_nr ++;
+	wakeup_all(&aio->wait);
+	rq->state = VFS_AIO_DONE;
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+}
+
+/* Hands rq to vfs_aiod, to be started if QUEUED, released if ENDING */
+static void vfs_aio_queue(struct vfs_aio_req_s *rq, uint_t state)
+{
+	uint_t irq_state;
+
+	spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+	rq->state = state;
+	list_add_last(&vfs_aio_work, &rq->list);
+	(void)wakeup_one(&vfs_aio_wq, WAIT_ANY);
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+}
+
+/* 
+ * Hypothesis: rq is ENDING, called by an events manager, the owner
+ * or vfs_aiod. Only the last two may sleep and release the file.
+ */
+static void vfs_aio_end(struct vfs_aio_req_s *rq, bool_t canSleep)
+{
+	ssize_t size;
+
+	size = vfs_aio_transfer(rq);
+
+	vfs_aio_publish(rq, (size < 0) ? -1 : size, (size < 0) ? -size : 0);
+	vfs_aio_put_pages(rq);
+
+	if(canSleep)
+		vfs_aio_done(rq);
+	else
+		vfs_aio_queue(rq, VFS_AIO_ENDING);
+}
+
+/* Runs a request the fills cannot end, in vfs_aiod */
+static void vfs_aio_run(struct vfs_aio_req_s *rq)
+{
+	struct vfs_iovec_s iov[VFS_AIO_IOV];
+	uint_t offset;
+	uint_t uaddr;
+	ssize_t size;
+	size_t done;
+	size_t len;
+	uint_t i;
+
+	offset = rq->offset;
+	size   = 0;
+
+	for(done = 0; done < rq->count; done += size)
+	{
+		/* The pinned pages through their kernel addresses */
+		for(i = 0, len = 0; (i < VFS_AIO_IOV) && ((done + len) < rq->count); i++)
+		{
+			uaddr            = rq->buf + done + len;
+			iov[i].iov_base  = ppm_page2addr(rq->upages[(uaddr >> PMM_PAGE_SHIFT) - (rq->buf >> PMM_PAGE_SHIFT)]);
+			iov[i].iov_base  = (uint8_t*)iov[i].iov_base + (uaddr & PMM_PAGE_MASK);
+			iov[i].iov_len   = MIN(PMM_PAGE_SIZE - (uaddr & PMM_PAGE_MASK), rq->count - done - len);
+			len             += iov[i].iov_len;
+		}
+
+		if(rq->opcode == VFS_AIO_READ)
+			size = vfs_readv(rq->file, &iov[0], i, &offset);
+		else
+			size = vfs_writev(rq->file, &iov[0], i, &offset);
+
+		if(size <= 0)
+			break;
+
+		offset += size;
+
+		if((size_t)size < len)
+		{
+			done += size;
+			break;
+		}
+	}
+
+	if((done == 0) && (size < 0))
+		vfs_aio_publish(rq, -1, -size);
+	else
+		vfs_aio_publish(rq, done, 0);
+
+	vfs_aio_put_pages(rq);
+	vfs_aio_done(rq);
+}
+
+/* 
+ * Prefetches and holds the page cache pages of rq, then lists it if
+ * their fills are still running or ends it. With MAPPER_NOWAIT_OP,
+ * returns EAGAIN on a page loaded by another thread, rq being kept.
+ */
+static error_t vfs_aio_start(struct vfs_aio_req_s *rq, uint_t flags)
+{
+	uint_t irq_state;
+	uint_t index;
+	bool_t isReady;
+	error_t err;
+
+	for(index = rq->first; index < rq->end; index++)
+	{
+		if(rq->cpages[index - rq->first] != NULL)
+			continue;
+
+		err = mapper_prefetch_page(rq->mapper, index, flags, rq->file, &rq->cpages[index - rq->first]);
+
+		if(err == EAGAIN)
+			return EAGAIN;
+
+		if((err != 0) && (err != EINPROGRESS))
+			break;
+	}
+
+	/* Fills ended before this are seen, later ones will find rq listed */
+	spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+	if((isReady = vfs_aio_isReady(rq)) == false)
+	{
+		rq->state = VFS_AIO_PENDING;
+		list_add_last(&vfs_aio_root, &rq->list);
+	}
+
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+
+	if(isReady)
+		vfs_aio_end(rq, true);
+
+	return 0;
+}
+
+void vfs_aio_page_end(struct mapper_s *mapper, uint_t index)
+{
+	struct vfs_aio_req_s *rq;
+	struct list_entry *iter;
+	struct list_entry ended;
+	uint_t irq_state;
+
+	list_root_init(&ended);
+
+	spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+	list_foreach(&vfs_aio_root, iter)
+	{
+		rq = list_element(iter, struct vfs_aio_req_s, list);
+
+		if((rq->mapper != mapper) || (index < rq->first) || (index >= rq->end))
+			continue;
+
+		if(vfs_aio_isReady(rq) == false)
+			continue;
+
+		list_unlink(&rq->list);
+		rq->state = VFS_AIO_ENDING;
+		list_add_last(&ended, &rq->list);
+	}
+
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+
+	while(!(list_empty(&ended)))
+	{
+		rq = list_first(&ended, struct vfs_aio_req_s, list);
+		list_unlink(&rq->list);
+		vfs_aio_end(rq, false);
+	}
+}
+
+/* Waits for an ENDING request to be DONE, vfs_aio_end wakes its owner up */
+static void vfs_aio_sync(struct vfs_aio_req_s *rq)
+{
+	struct thread_s *this;
+	uint_t irq_state;
+
+	this = current_thread;
+
+	while(1)
+	{
+		spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+		if(rq->state != VFS_AIO_ENDING)
+			break;
+
+		wait_on(&rq->aio->wait, WAIT_LAST);
+		spinlock_unlock_nosched(&vfs_aio_lock);
+		sched_sleep(this);
+		cpu_restore_irq(irq_state);
+	}
+
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+}
+
+/* Frees a request which is no more PENDING nor ENDING */
+static void vfs_aio_reap(struct vfs_aio_s *aio, struct vfs_aio_req_s *rq)
+{
+	kmem_req_t req;
+	uint_t i;
+
+	for(i = 0; aio->tbl[i] != rq; i++)
+		;
+
+	aio->tbl[i] = NULL;
+	aio->count --;
+
+	vfs_aio_put_pages(rq);
+
+	if(rq->file != NULL)
+		(void)vfs_close(rq->file, NULL);
+
+	req.type = KMEM_GENERIC;
+	req.ptr  = rq;
+	kmem_free(&req);
+}
+
+error_t vfs_aio_submit(struct vfs_aiocb_s *uaiocb)
+{
+	kmem_req_t req;
+	struct thread_s *this;
+	struct vfs_aio_s *aio;
+	struct vfs_aio_req_s *rq;
+	struct vfs_aiocb_s aiocb;
+	struct vfs_file_s *file;
+	uint_t upages_nr;
+	uint_t end;
+	error_t state;
+	error_t err;
+	uint_t i;
+
+	this = current_thread;
+
+	if(((uint_t)uaiocb >= CONFIG_KERNEL_OFFSET)                    ||
+	   (sizeof(aiocb) > (CONFIG_KERNEL_OFFSET - (uint_t)uaiocb))   ||
+	   ((uint_t)uaiocb & (sizeof(uint_t) - 1)))
+		return EINVAL;
+
+	if((err = cpu_uspace_copy(&aiocb, uaiocb, sizeof(aiocb))))
+		return err;
+
+	if((aiocb.aio_lio_opcode != VFS_AIO_READ) && (aiocb.aio_lio_opcode != VFS_AIO_WRITE))
+		return EINVAL;
+
+	if(((uint_t)aiocb.aio_buf >= CONFIG_KERNEL_OFFSET) || 
+	   (aiocb.aio_nbytes > (CONFIG_KERNEL_OFFSET - (uint_t)aiocb.aio_buf)))
+		return EINVAL;
+
+	if((file = vfs_aio_file(aiocb.aio_fildes)) == NULL)
+		return EBADFD;
+
+	if((aiocb.aio_lio_opcode == VFS_AIO_READ) && !(VFS_IS(file->f_flags, VFS_O_RDONLY)))
+		return EBADF;
+
+	if((aiocb.aio_lio_opcode == VFS_AIO_WRITE) && !(VFS_IS(file->f_flags, VFS_O_WRONLY)))
+		return EBADF;
+
+	if((aio = this->info.aio) == NULL)
+	{
+		req.type  = KMEM_GENERIC;
+		req.size  = sizeof(*aio);
+		req.flags = AF_KERNEL | AF_ZERO;
+
+		if((aio = kmem_alloc(&req)) == NULL)
+			return ENOMEM;
+
+		wait_queue_init(&aio->wait, "VFS AIO");
+		this->info.aio = aio;
+	}
+
+	/* Ended requests are only reaped by their owner */
+	for(i = 0; i < VFS_AIO_MAX; i++)
+	{
+		if((rq = aio->tbl[i]) == NULL)
+			continue;
+
+		if((rq->uaiocb == uaiocb) && 
+		   ((rq->state == VFS_AIO_PENDING) || (rq->state == VFS_AIO_QUEUED)))
+			return EBUSY;
+
+		if(rq->uaiocb == uaiocb)
+			vfs_aio_sync(rq);
+
+		if(rq->state == VFS_AIO_DONE)
+			vfs_aio_reap(aio, rq);
+	}
+
+	if(aio->count == VFS_AIO_MAX)
+		return EAGAIN;
+
+	/* Devices and fifos have no offset nor page cache */
+	if(!(vfs_aio_isCached(file)) || (aiocb.aio_nbytes == 0))
+	{
+		state = EINPROGRESS;
+
+		if((err = cpu_uspace_copy((void*)&uaiocb->aio_error, &state, sizeof(state))))
+			return err;
+
+		vfs_aio_complete_sync(uaiocb, file, &aiocb);
+		return 0;
+	}
+
+	upages_nr = ((((uint_t)aiocb.aio_buf + aiocb.aio_nbytes - 1) >> PMM_PAGE_SHIFT) - 
+		     ((uint_t)aiocb.aio_buf >> PMM_PAGE_SHIFT)) + 1;
+
+	req.type  = KMEM_GENERIC;
+	req.size  = sizeof(*rq) + (upages_nr * sizeof(rq->upages[0]));
+	req.flags = AF_KERNEL | AF_ZERO;
+
+	if((rq = kmem_alloc(&req)) == NULL)
+		return ENOMEM;
+
+	rq->aio       = aio;
+	rq->uaiocb    = uaiocb;
+	rq->mapper    = file->f_node->n_mapper;
+	rq->opcode    = aiocb.aio_lio_opcode;
+	rq->offset    = aiocb.aio_offset;
+	rq->buf       = (uint_t)aiocb.aio_buf;
+	rq->count     = aiocb.aio_nbytes;
+	rq->state     = VFS_AIO_ENDING;
+	rq->isAsync   = vfs_aio_isAsync(file, &aiocb);
+	rq->upages_nr = upages_nr;
+
+	if((err = vfs_aio_pin_pages(rq)))
+	{
+		vfs_aio_put_pages(rq);
+		req.ptr = rq;
+		kmem_free(&req);
+		return err;
+	}
+
+	*rq->kerror = EINPROGRESS;
+
+	atomic_add(&file->f_count, 1);
+	rq->file = file;
+
+	for(i = 0; aio->tbl[i] != NULL; i++)
+		;
+
+	aio->tbl[i] = rq;
+	aio->count ++;
+
+	if(rq->isAsync)
+	{
+		/* Only pages holding file data need to be filled */
+		end = rq->offset + rq->count;
+		end = (end > file->f_node->n_size) ? file->f_node->n_size : end;
+
+		if(end > rq->offset)
+		{
+			rq->first = rq->offset >> PMM_PAGE_SHIFT;
+			rq->end   = ((end - 1) >> PMM_PAGE_SHIFT) + 1;
+		}
+
+		if(vfs_aio_start(rq, MAPPER_NOWAIT_OP) == 0)
+			return 0;
+	}
+
+	vfs_aio_queue(rq, VFS_AIO_QUEUED);
+	return 0;
+}
+
+error_t vfs_aio_poll(struct vfs_aiocb_s *uaiocb)
+{
+	struct vfs_aio_req_s *rq;
+	struct vfs_aio_s *aio;
+
+	aio = current_thread->info.aio;
+
+	if((rq = vfs_aio_lookup(aio, uaiocb)) == NULL)
+		return EINVAL;
+
+	if(rq->state != VFS_AIO_DONE)
+		return EINPROGRESS;
+
+	vfs_aio_reap(aio, rq);
+	return 0;
+}
+
+error_t vfs_aio_wait(struct vfs_aiocb_s **ulist, uint_t nr, uint_t min, uint_t *done)
+{
+	struct vfs_aiocb_s *list[VFS_AIO_MAX];
+	struct vfs_aio_req_s *rq;
+	struct thread_s *this;
+	struct vfs_aio_s *aio;
+	uint_t irq_state;
+	uint_t count;
+	uint_t seen;
+	bool_t isPending;
+	error_t err;
+	uint_t i;
+
+	if((nr == 0) || (nr > VFS_AIO_MAX) || ((uint_t)ulist >= CONFIG_KERNEL_OFFSET))
+		return EINVAL;
+
+	if((err = cpu_uspace_copy(&list[0], ulist, nr * sizeof(list[0]))))
+		return err;
+
+	this = current_thread;
+	aio  = this->info.aio;
+	min  = ((min == 0) || (min > nr)) ? 1 : min;
+
+	while(1)
+	{
+		seen      = (aio != NULL) ? aio->done_nr : 0;
+		count     = 0;
+		isPending = false;
+
+		for(i = 0; i < nr; i++)
+		{
+			if(list[i] == NULL)
+				continue;
+
+			/* Unknown control blocks are already completed */
+			if((rq = vfs_aio_lookup(aio, list[i])) == NULL)
+			{
+				count ++;
+				continue;
+			}
+
+			if(rq->state == VFS_AIO_DONE)
+			{
+				vfs_aio_reap(aio, rq);
+				count ++;
+			}
+			else
+				isPending = true;
+		}
+
+		if((count >= min) || (isPending == false))
+			break;
+
+		/* Sleeps unless a request has ended since the scan */
+		spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+		if(aio->done_nr != seen)
+		{
+			spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+			continue;
+		}
+
+		wait_on(&aio->wait, WAIT_LAST);
+		spinlock_unlock_nosched(&vfs_aio_lock);
+		sched_sleep(this);
+		cpu_restore_irq(irq_state);
+	}
+
+	*done = count;
+	return 0;
+}
+
+error_t vfs_aio_cancel(struct vfs_aiocb_s *uaiocb)
+{
+	struct vfs_aio_req_s *rq;
+	struct vfs_aio_s *aio;
+	uint_t irq_state;
+	bool_t isPending;
+
+	aio = current_thread->info.aio;
+
+	if((rq = vfs_aio_lookup(aio, uaiocb)) == NULL)
+		return ENOENT;
+
+	spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+	if((isPending = ((rq->state == VFS_AIO_PENDING) || (rq->state == VFS_AIO_QUEUED))))
+	{
+		list_unlink(&rq->list);
+		rq->state = VFS_AIO_DONE;
+	}
+
+	spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+
+	if(isPending == false)
+	{
+		if(rq->state == VFS_AIO_DONE)
+			vfs_aio_reap(aio, rq);
+
+		return ENOENT;
+	}
+
+	/* Pages being filled stay in the page cache */
+	vfs_aio_publish(rq, -1, ECANCELED);
+	vfs_aio_reap(aio, rq);
+	return 0;
+}
+
+void vfs_aio_destroy(struct thread_s *thread)
+{
+	struct vfs_aio_req_s *rq;
+	struct vfs_aio_s *aio;
+	kmem_req_t req;
+	uint_t irq_state;
+	uint_t i;
+
+	if((aio = thread->info.aio) == NULL)
+		return;
+
+	for(i = 0; i < VFS_AIO_MAX; i++)
+	{
+		if((rq = aio->tbl[i]) == NULL)
+			continue;
+
+		spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+		if((rq->state == VFS_AIO_PENDING) || (rq->state == VFS_AIO_QUEUED))
+		{
+			list_unlink(&rq->list);
+			rq->state = VFS_AIO_DONE;
+		}
+
+		spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+
+		vfs_aio_sync(rq);
+		vfs_aio_reap(aio, rq);
+	}
+
+	req.type = KMEM_GENERIC;
+	req.ptr  = aio;
+	kmem_free(&req);
+
+	thread->info.aio = NULL;
+}
+
+void* vfs_aiod(void *arg)
+{
+	struct vfs_aio_req_s *rq;
+	struct thread_s *this;
+	uint_t irq_state;
+	uint_t state;
+
+	cpu_enable_all_irq(NULL);
+
+	this = current_thread;
+
+	printk(INFO, "INFO: Starting VFS AIO Worker On Cluster %d\n", current_cluster->id);
+
+	while(1)
+	{
+		spinlock_lock_noirq(&vfs_aio_lock, &irq_state);
+
+		if(list_empty(&vfs_aio_work))
+		{
+			wait_on(&vfs_aio_wq, WAIT_LAST);
+			spinlock_unlock_nosched(&vfs_aio_lock);
+			sched_sleep(this);
+			cpu_restore_irq(irq_state);
+			continue;
+		}
+
+		rq = list_first(&vfs_aio_work, struct vfs_aio_req_s, list);
+		list_unlink(&rq->list);
+		state     = rq->state;
+		rq->state = VFS_AIO_ENDING;
+		spinlock_unlock_noirq(&vfs_aio_lock, irq_state);
+
+		if(state == VFS_AIO_ENDING)
+			vfs_aio_done(rq);
+		else if(rq->isAsync)
+			(void)vfs_aio_start(rq, 0);
+		else
+			vfs_aio_run(rq);
+	}
+
+	return NULL;
+}
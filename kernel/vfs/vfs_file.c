@@ -182,6 +182,8 @@ VFS_READ_FILE(vfs_default_read)
 			current_offset += size;
 		}
 
+		mapper_put_page(page);
+
 		if(thread_sched_isActivated(current_thread))
 			sched_yield(current_thread);
 	}
@@ -250,6 +252,7 @@ VFS_WRITE_FILE(vfs_default_write)
     
 	WRITE_PAGE_LOCK_FAILED:
 		page_unlock(page);
+		mapper_put_page(page);
 	}
 
 	vfs_dmsg(1,"%s Ended: written %d\n", __FUNCTION__, asked_size - size);
@@ -258,5 +261,117 @@ VFS_WRITE_FILE(vfs_default_write)
 WRITE_ERR:
 	mapper_remove_page(page);
 	page_unlock(page);
+	mapper_put_page(page);
 	return -err;
 }
+
+
+/* Copy directly between user's iovec and the mapper pages starting at offset */
+static ssize_t vfs_default_iov_rw(struct vfs_file_s *file, 
+				  struct vfs_iovec_s *iov, 
+				  uint_t iovcnt, 
+				  uint_t offset, 
+				  bool_t isWrite)
+{
+	struct vfs_node_s *node;
+	struct mapper_s *mapper;
+	struct page_s *page;
+	uint8_t *pbuff;
+	uint8_t *ppage;
+	size_t len;
+	size_t ulen;
+	ssize_t done;
+	uint_t index;
+	uint_t i;
+	error_t err;
+
+	node = file->f_node;
+
+	if(node->n_attr & VFS_FIFO)
+		return -EINVAL;
+
+	mapper = node->n_mapper;
+	done   = 0;
+
+	for(i = 0; i < iovcnt; i++)
+	{
+		pbuff = iov[i].iov_base;
+		ulen  = iov[i].iov_len;
+
+		while(ulen > 0)
+		{
+			if((isWrite == false) && (offset >= node->n_size))
+				return done;
+
+			index = offset >> PMM_PAGE_SHIFT;
+			len   = PMM_PAGE_SIZE - (offset % PMM_PAGE_SIZE);
+			len   = (len > ulen) ? ulen : len;
+
+			if((isWrite == false) && (len > (node->n_size - offset)))
+				len = node->n_size - offset;
+
+			if((page = mapper_get_page(mapper, index, MAPPER_SYNC_OP, file)) == NULL)
+				return (done) ? done : -VFS_IO_ERR;
+
+			ppage  = (uint8_t*) ppm_page2addr(page);
+			ppage += offset % PMM_PAGE_SIZE;
+
+			if(isWrite)
+			{
+				page_lock(page);
+
+				/* Page has been evicted meanwhile, look it up again */
+				if((page->mapper != mapper) || (page->index != index))
+				{
+					page_unlock(page);
+					mapper_put_page(page);
+					continue;
+				}
+
+				if((err = cpu_uspace_copy(ppage, pbuff, len)))
+				{
+					mapper_remove_page(page);
+					page_unlock(page);
+					mapper_put_page(page);
+					return (done) ? done : -err;
+				}
+
+				if (VFS_IS(file->f_flags, VFS_O_SYNC))
+					mapper->m_ops->writepage(page, MAPPER_SYNC_OP, NULL);
+				else
+					mapper->m_ops->set_page_dirty(page);
+
+				page_unlock(page);
+				mapper_put_page(page);
+			}
+			else
+			{
+				err = cpu_uspace_copy(pbuff, ppage, len);
+				mapper_put_page(page);
+
+				if(err)
+					return (done) ? done : -err;
+
+				if(thread_sched_isActivated(current_thread))
+					sched_yield(current_thread);
+			}
+
+			pbuff  += len;
+			ulen   -= len;
+			offset += len;
+			done   += len;
+		}
+	}
+
+	return done;
+}
+
+VFS_READV_FILE(vfs_default_readv)
+{
+	return vfs_default_iov_rw(file, iov, iovcnt, offset, false);
+}
+
+VFS_WRITEV_FILE(vfs_default_writev)
+{
+	return vfs_default_iov_rw(file, iov, iovcnt, offset, true);
+}
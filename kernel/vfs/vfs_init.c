@@ -184,6 +184,7 @@ error_t vfs_init(struct device_s *device,
 	vfs_dmsg(1, "%s: Init dirty pages_list\n", __FUNCTION__);
 
 	dirty_pages_init();
+	vfs_aio_init();
 
 	vfs_dmsg(1, "%s: Init nodes freelist\n", __FUNCTION__);
 
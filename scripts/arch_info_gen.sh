@@ -18,13 +18,14 @@
 # - The output of this script is ready to be transformed to BIB 
 #   binary layout with info2bib utility.
 #
-# - 5 arguments can be passed to this script (order is relevant)
+# - 6 arguments can be passed to this script (order is relevant)
 #     MEMSZ: per cluster memory size (given in decimal bytes)
 #     XMAX: number of clusters in a row
 #     YMAX: number of clusters in a column
 #     NPROCS: number of CPUs per Cluster
 #     BSCPU: bootstrap cpu id (global one) declared as operationnal
-#   Default values are (in order) 0xC00000 2 2 4 (io-cid)
+#     SWAP: 1 to declare a second block device, holding the swap area
+#   Default values are (in order) 0xC00000 2 2 4 (io-cid) 0
 #--------------------------------------------------------------------
 
 # XICU Segment Base
@@ -36,6 +37,10 @@ MEMC_BASE=0xF40000
 # FrameBuffer size
 FB_SIZE=0x200000
 
+# Swap BlockDevice Base & IRQ
+SWAP_BASE=0xBFF40000
+SWAP_IRQ=6
+
 # Physical address width
 ADDR_WIDTH=32
 
@@ -44,18 +49,20 @@ DEFAULT_X_MAX=2
 DEFAULT_Y_MAX=2
 DEFAULT_CPU_PER_CLUSTER=4
 DEFAULT_MEMSZ=0xC00000
+DEFAULT_SWAP=0
 #------------------------
 MEMSZ=${1-$DEFAULT_MEMSZ}
 X_MAX=${2-$DEFAULT_X_MAX}
 Y_MAX=${3-$DEFAULT_Y_MAX}
 NPROCS=${4-$DEFAULT_CPU_PER_CLUSTER}
+SWAP=${6-$DEFAULT_SWAP}
 #------------------------
 
 print_comments()
 {
     date=$(date "+%c")
     echo "# TSAR hardware description in BIB (Boot Information Block) format"
-    echo "# This file is autogenerated by the command: $0 $X_MAX $Y_MAX $NPROCS $BSCPU"
+    echo "# This file is autogenerated by the command: $0 $MEMSZ $X_MAX $Y_MAX $NPROCS $BSCPU $SWAP"
     echo "# It is ready to be passed to info2bib utility so the binary format can be generated"
     echo " "
     echo "# $USER on $HOSTNAME $date" 
@@ -107,16 +114,29 @@ print_io_cluster()
     ram_size=$(printf "0x%x" $MEMSZ)
     xicu_base=$(printf "0x%x" $((offset + $XICU_BASE)))
     memc_base=$(printf "0x%x" $((offset + $MEMC_BASE)))
+    dev_nr=10
+
+    if [ "$SWAP" = "1" ]
+    then
+	dev_nr=11
+    fi
 
     echo "[CLUSTER]"
     echo "         CID="$cid
     echo "         CPU_NR="$NPROCS
-    echo "         DEV_NR=10"
+    echo "         DEV_NR="$dev_nr
     echo "         DEVID=RAM      BASE=$ram_base     SIZE=$ram_size  IRQ=-1"
     echo "         DEVID=XICU     BASE=$xicu_base     SIZE=0x1000    IRQ=-1"
     echo "         DEVID=FB       BASE=0xBFD00000     SIZE=$FB_SIZE  IRQ=-1"
     echo "         DEVID=MEMC     BASE=$memc_base     SIZE=0x1000    IRQ=-1"
     echo "         DEVID=BLKDEV   BASE=0xBFF10000     SIZE=0x20      IRQ=0"
+
+    # The kernel takes the second BLKDEV as its swap device
+    if [ "$SWAP" = "1" ]
+    then
+	echo "         DEVID=BLKDEV   BASE=$SWAP_BASE     SIZE=0x20      IRQ=$SWAP_IRQ"
+    fi
+
     echo "         DEVID=TTY      BASE=0xBFF20000     SIZE=0x10      IRQ=2"
     echo "         DEVID=TTY      BASE=0xBFF20010     SIZE=0x10      IRQ=3"
     echo "         DEVID=TTY      BASE=0xBFF20020     SIZE=0x10      IRQ=4"
@@ -158,7 +178,7 @@ esac
 
 x=0; y=0
 io_cid=$((0xbf >> (8 - X_WIDTH - Y_WIDTH)))
-BSCPU=${5-$(($io_cid * $NPROCS))}
+BSCPU=${5:-$(($io_cid * $NPROCS))}
 
 # Generate the description
 print_comments "$0"
@@ -23,6 +23,8 @@
 #     -yfb: frameBuffer's Y-length
 #     -bscpu: BootStrap CPU (0 to xmax*ymax*nproc-1)
 #     -memsz: per cluster memory size in bytes.
+#     -swap: swap disk image, attached as a second block device
+#     -swapsz: size in bytes of the swap disk image, if it is created
 #     -o: output file name
 #     -g: generate TSAR hardware description, dont call the simulator.
 #   Default values are (in order) 2 2 4 XX 0x800000 "arch-info.bin"
@@ -43,6 +45,8 @@ memsz=0xC00000
 bscpu= # let gen-arch-info choose for us #
 output="arch-info.bin"
 noSim="false"
+swap=
+swapsz=0x1000000
 
 usage()
 {
@@ -54,6 +58,8 @@ usage()
     echo "   -yfb: frameBuffer's Y-length"
     echo "   -bscpu: BootStrap CPU (0 to xmax*ymax*nproc-1)"
     echo "   -memsz: per cluster memory size in bytes"
+    echo "   -swap: swap disk image, attached as a second block device"
+    echo "   -swapsz: size in bytes of the swap disk image, if it is created"
     echo "   -o: output file name"
     echo "   -g: generate TSAR hardware description, dont call the simulator"
     echo ""
@@ -71,6 +77,8 @@ do
 	-o)     output="$2";  shift;;
 	-bscpu) bscpu=$2;     shift;;
 	-memsz) memsz=$2;     shift;;
+	-swap)  swap="$2";    shift;;
+	-swapsz) swapsz=$2;   shift;;
 	-g)     noSim="true";;
 	-*) echo "$0: error - unrecognized option $1" 1>&2; usage 1>&2; exit 1;;
 	*) echo "unexpected option/argument $1" 1>&2; usage 1>$2; exit 2;;
@@ -96,17 +104,39 @@ error_info2bib()
     exit 3
 }
 
+error_swap()
+{
+    echo "Cannot create the swap disk image $swap"
+    exit 5
+}
+
+# The first page of the swap area holds its signature (mm/swap.h)
+make_swap()
+{
+    dd if=/dev/zero of="$swap" bs=4096 count=$(($swapsz / 4096)) 2> /dev/null || error_swap
+    printf "ALMOS-SWAP" | dd of="$swap" conv=notrunc 2> /dev/null      || error_swap
+}
+
 error_sim()
 {
     echo "Cannot launch the simulator, command faild or $SIM is not in your PATH"
     exit 4
 }
 
-$GEN_ARCH_INFO $memsz $xmax $ymax $ncpu $bscpu > $INFO_FILE             || error_arch_info
+if [ -n "$swap" ]; then
+    hasSwap=1
+    SIM_SWAP="-SWAP $swap"
+    [ -f "$swap" ] || make_swap
+else
+    hasSwap=0
+    SIM_SWAP=
+fi
+
+$GEN_ARCH_INFO $memsz $xmax $ymax $ncpu "$bscpu" $hasSwap > $INFO_FILE   || error_arch_info
 $INFO2BIB -i $INFO_FILE -o $output                               || error_info2bib
 
 if [ $noSim = "false" ]; then
-    $SIM -XMAX $xmax -YMAX $ymax -NPROCS $ncpu -XFB $xfb -YFB $yfb -MEMSZ $memsz || error_sim
+    $SIM -XMAX $xmax -YMAX $ymax -NPROCS $ncpu -XFB $xfb -YFB $yfb -MEMSZ $memsz $SIM_SWAP || error_sim
 fi
 
 #-------------------------------------------------------------------------------#
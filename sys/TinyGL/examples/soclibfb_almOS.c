@@ -8,13 +8,15 @@
 #include <GL/oscontext.h> 
 #include "ui.h"
 
+static ostgl_context *ctx;
+
+/* the context renders into a back buffer, copied here to the mmap'ed
+   frame buffer which cannot be flipped */
 void tkSwapBuffers(void)
 {
-    nglXSwapBuffers(w1);
+    ostgl_swap_buffers(ctx);
 }
 
-static ostgl_context *ctx;
-
 int ui_loop(int argc, char **argv, const char *name)
 {
   void *dsiplay;
@@ -99,6 +101,10 @@ int ui_loop(int argc, char **argv, const char *name)
     fprintf(stderr, "ERROR: failed to make current ctx\n");
     exit(7);
   }
+
+  /* one band of lines per processor */
+  if(ostgl_set_threads(ctx, sysconf(_SC_NPROCESSORS_ONLN)) != 0)
+    fprintf(stderr, "WARNING: rendering on a single thread\n");
   
   fprintf(stderr, "Initializing scene ..");
   tm_tmp = clock();
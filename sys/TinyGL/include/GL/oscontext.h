@@ -35,6 +35,11 @@ ostgl_resize(ostgl_context * context,
 void
 ostgl_swap_buffers(ostgl_context *context);
 
+/* Renders with numthreads threads, each one owning a band of lines;
+   1 goes back to rendering on the calling thread */
+int
+ostgl_set_threads(ostgl_context *context, const int numthreads);
+
 #ifdef __cplusplus
 }
 #endif
@@ -120,6 +120,7 @@ void nglXSwapBuffers( NGLXDrawable drawable )
     /* retrieve the current NGLXContext */
     gl_context=gl_get_context();
     ctx=(TinyNGLXContext *)gl_context->opaque;
+    ZB_flushTiles(ctx->gl_context->zb);
     
     GrArea(drawable, ctx->gc, 0, 0, ctx->xsize, 
            ctx->ysize, ctx->gl_context->zb->pbuf, ctx->pixtype);
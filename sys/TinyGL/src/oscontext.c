@@ -29,9 +29,12 @@ ostgl_create_context(const int xsize,
   
   assert(context->zbs != NULL && context->framebuffers != NULL);
   
+  /* a single buffer cannot be flipped: render into a back buffer,
+     copied to the screen by ostgl_swap_buffers, so frames do not tear */
   for (i = 0; i < numbuffers; i++) {
     context->framebuffers[i] = framebuffers[i];
-    zb = ZB_open(xsize, ysize, ZB_MODE_5R6G5B, 0, NULL, NULL, framebuffers[i]);
+    zb = ZB_open(xsize, ysize, ZB_MODE_5R6G5B, 0, NULL, NULL,
+                 (numbuffers == 1) ? NULL : framebuffers[i]);
     if (zb == NULL) {
       fprintf(stderr, "Error while initializing Z buffer\n");
       exit(1);
@@ -45,7 +48,7 @@ ostgl_create_context(const int xsize,
   context->ysize = ysize;
   context->numbuffers = numbuffers;
   context->depth = 16;
-  context->bytes_per_line = xsize;
+  context->bytes_per_line = xsize * 2;
   return context;
 }
 
@@ -81,8 +84,14 @@ ostgl_resize(ostgl_context *context,
 {
   int i;
   for (i = 0; i < context->numbuffers; i++) {
-    ZB_resize(context->zbs[i], framebuffers[i], xsize, ysize);
+    context->framebuffers[i] = framebuffers[i];
+    ZB_resize(context->zbs[i],
+              (context->numbuffers == 1) ? NULL : framebuffers[i],
+              xsize, ysize);
   }
+  context->xsize = xsize;
+  context->ysize = ysize;
+  context->bytes_per_line = xsize * 2;
 }
 
 
@@ -91,7 +100,23 @@ ostgl_swap_buffers(ostgl_context *context)
 {
   int i;
   
+  /* the back buffer goes to the screen, flipped buffers are already
+     there once the tiles are flushed */
   for(i = 0; i < context->numbuffers; i++) {
     ZB_copyFrameBuffer(context->zbs[i], context->framebuffers[i], context->bytes_per_line);
   }
 }
+
+int
+ostgl_set_threads(ostgl_context *context, const int numthreads)
+{
+  int i, err = 0;
+
+  for (i = 0; i < context->numbuffers; i++) {
+    if (numthreads > 1)
+      err |= ZB_openTiles(context->zbs[i], numthreads);
+    else
+      ZB_closeTiles(context->zbs[i]);
+  }
+  return err;
+}
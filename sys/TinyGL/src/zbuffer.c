@@ -65,6 +65,9 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
     }
 
     zb->current_texture = NULL;
+    zb->ymin = 0;
+    zb->ymax = ysize;
+    zb->tiles = NULL;
 
     return zb;
   error:
@@ -74,6 +77,9 @@ ZBuffer *ZB_open(int xsize, int ysize, int mode,
 
 void ZB_close(ZBuffer * zb)
 {
+    if (zb->tiles != NULL)
+	ZB_closeTiles(zb);
+
 #ifdef TGL_FEATURE_8_BITS
     if (zb->mode == ZB_MODE_INDEX)
 	ZB_closeDither(zb);
@@ -88,7 +94,10 @@ void ZB_close(ZBuffer * zb)
 
 void ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize)
 {
-    int size;
+    int size, nb_threads;
+
+    /* tiles are cut for the old size */
+    nb_threads = (zb->tiles != NULL) ? ZB_closeTiles(zb) : 0;
 
     /* xsize must be a multiple of 4 */
     xsize = xsize & ~3;
@@ -96,6 +105,8 @@ void ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize)
     zb->xsize = xsize;
     zb->ysize = ysize;
     zb->linesize = (xsize * PSZB + 3) & ~3;
+    zb->ymin = 0;
+    zb->ymax = ysize;
 
     size = zb->xsize * zb->ysize * sizeof(unsigned short);
 
@@ -112,6 +123,9 @@ void ZB_resize(ZBuffer * zb, void *frame_buffer, int xsize, int ysize)
 	zb->pbuf = frame_buffer;
 	zb->frame_buffer_allocated = 0;
     }
+
+    if (nb_threads > 0)
+	ZB_openTiles(zb, nb_threads);
 }
 
 static void ZB_copyBuffer(ZBuffer * zb,
@@ -125,6 +139,21 @@ static void ZB_copyBuffer(ZBuffer * zb,
     q = zb->pbuf;
     p1 = buf;
     n = zb->xsize * PSZB;
+
+    /* the Z buffer renders straight into the frame buffer, which the
+       caller flips */
+    if (buf == zb->pbuf && linesize == zb->linesize)
+	return;
+
+    /* same layout: a single large copy, given to the DMA engine which
+       checks both buffers page by page; the CPU copies if it refuses */
+    if (linesize == zb->linesize) {
+	n += (zb->ysize - 1) * linesize;
+	if (dma_memcpy(q, p1, n) == NULL)
+	    memcpy(p1, q, n);
+	return;
+    }
+
     for (y = 0; y < zb->ysize; y++) {
 	memcpy(p1, q, n);
 	p1 += linesize;
@@ -274,6 +303,9 @@ static void ZB_copyFrameBufferRGB24(ZBuffer * zb,
 void ZB_copyFrameBuffer(ZBuffer * zb, void *buf,
 			int linesize)
 {
+    if (zb->tiles != NULL)
+	ZB_flushTiles(zb);
+
     switch (zb->mode) {
 #ifdef TGL_FEATURE_8_BITS
     case ZB_MODE_INDEX:
@@ -336,6 +368,9 @@ static void ZB_copyFrameBuffer5R6G5B(ZBuffer * zb,
 void ZB_copyFrameBuffer(ZBuffer * zb, void *buf,
 			int linesize)
 {
+    if (zb->tiles != NULL)
+	ZB_flushTiles(zb);
+
     switch (zb->mode) {
 #ifdef TGL_FEATURE_16_BITS
     case ZB_MODE_5R6G5B:
@@ -388,6 +423,9 @@ static void ZB_copyFrameBuffer5R6G5B(ZBuffer * zb,
 void ZB_copyFrameBuffer(ZBuffer * zb, void *buf,
 			int linesize)
 {
+    if (zb->tiles != NULL)
+	ZB_flushTiles(zb);
+
     switch (zb->mode) {
 #ifdef TGL_FEATURE_16_BITS
     case ZB_MODE_5R6G5B:
@@ -495,12 +533,18 @@ void ZB_clear(ZBuffer * zb, int clear_z, int z,
     int y;
     PIXEL *pp;
 
+    if (zb->tiles != NULL) {
+	ZB_tileClear(zb, clear_z, z, clear_color, r, g, b);
+	return;
+    }
+
     if (clear_z) {
-	memset_s(zb->zbuf, z, zb->xsize * zb->ysize);
+	memset_s(zb->zbuf + zb->ymin * zb->xsize, z,
+		 zb->xsize * (zb->ymax - zb->ymin));
     }
     if (clear_color) {
-	pp = zb->pbuf;
-	for (y = 0; y < zb->ysize; y++) {
+	pp = (PIXEL *) ((char *) zb->pbuf + zb->ymin * zb->linesize);
+	for (y = zb->ymin; y < zb->ymax; y++) {
 #if TGL_FEATURE_RENDER_BITS == 15 || TGL_FEATURE_RENDER_BITS == 16
             color = RGB_TO_PIXEL(r, g, b);
 	    memset_s(pp, color, zb->xsize);
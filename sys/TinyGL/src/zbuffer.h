@@ -71,6 +71,8 @@ typedef unsigned int PIXEL;
 
 #endif
 
+struct ZBTiles;
+
 typedef struct {
     int xsize,ysize;
     int linesize; /* line size, in bytes */
@@ -84,6 +86,9 @@ typedef struct {
     unsigned char *dctable;
     int *ctable;
     PIXEL *current_texture;
+
+    int ymin,ymax;          /* only lines ymin..ymax-1 are drawn */
+    struct ZBTiles *tiles;  /* tiled renderer, NULL when drawing directly */
 } ZBuffer;
 
 typedef struct {
@@ -108,7 +113,8 @@ void ZB_close(ZBuffer *zb);
 void ZB_resize(ZBuffer *zb,void *frame_buffer,int xsize,int ysize);
 void ZB_clear(ZBuffer *zb,int clear_z,int z,
 	      int clear_color,int r,int g,int b);
-/* linesize is in BYTES */
+/* linesize is in BYTES; nothing is copied when buf is the frame buffer
+   the Z buffer was opened on, the caller then flips buffers */
 void ZB_copyFrameBuffer(ZBuffer *zb,void *buf,int linesize);
 
 /* zdither.c */
@@ -145,6 +151,22 @@ void ZB_fillTriangleMappingPerspective(ZBuffer *zb,
 typedef void (*ZB_fillTriangleFunc)(ZBuffer  *,
 	    ZBufferPoint *,ZBufferPoint *,ZBufferPoint *);
 
+/* ztile.c */
+
+/* Drawing is binned into horizontal tiles rendered by nb_threads threads */
+int ZB_openTiles(ZBuffer *zb,int nb_threads);
+/* Returns the number of threads the tiles were using */
+int ZB_closeTiles(ZBuffer *zb);
+/* Renders the binned primitives and composites the tiles into pbuf */
+void ZB_flushTiles(ZBuffer *zb);
+
+void ZB_tileTriangle(ZBuffer *zb,ZB_fillTriangleFunc func,
+		     ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_tileLine(ZBuffer *zb,int z_test,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_tilePlot(ZBuffer *zb,ZBufferPoint *p);
+void ZB_tileClear(ZBuffer *zb,int clear_z,int z,
+		  int clear_color,int r,int g,int b);
+
 /* memory.c */
 void gl_free(void *p);
 void *gl_malloc(int size);
@@ -9,6 +9,13 @@ void ZB_plot(ZBuffer * zb, ZBufferPoint * p)
     PIXEL *pp;
     int zz;
 
+    if (zb->tiles != NULL) {
+	ZB_tilePlot(zb, p);
+	return;
+    }
+    if (p->y < zb->ymin || p->y >= zb->ymax)
+	return;
+
     pz = zb->zbuf + (p->y * zb->xsize + p->x);
     pp = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p->y + p->x * PSZB);
     zz = p->z >> ZB_POINT_Z_FRAC_BITS;
@@ -57,6 +64,11 @@ void ZB_line_z(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2)
 {
     int color1, color2;
 
+    if (zb->tiles != NULL) {
+	ZB_tileLine(zb, 1, p1, p2);
+	return;
+    }
+
     color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
     color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
 
@@ -72,6 +84,11 @@ void ZB_line(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2)
 {
     int color1, color2;
 
+    if (zb->tiles != NULL) {
+	ZB_tileLine(zb, 0, p1, p2);
+	return;
+    }
+
     color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
     color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
 
@@ -1,5 +1,5 @@
 {
-    int n, dx, dy, sx, pp_inc_1, pp_inc_2;
+    int n, dx, dy, sx, pp_inc_1, pp_inc_2, y;
     register int a;
     register PIXEL *pp;
 #if defined(INTERP_RGB) || TGL_FEATURE_RENDER_BITS == 24
@@ -21,6 +21,7 @@
 	p2 = tmp;
     }
     sx = zb->xsize;
+    y = p1->y;
     pp = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p1->y + p1->x * PSZB);
 #ifdef INTERP_Z
     pz = zb->zbuf + (p1->y * sx + p1->x);
@@ -56,10 +57,11 @@
 #endif
 #endif /* INTERP_RGB */
 
+/* pixels out of lines ymin..ymax-1 are skipped */
 #ifdef INTERP_Z
 #define ZZ(x) x
 #define PUTPIXEL() 				\
-  {						\
+  if (y >= zb->ymin && y < zb->ymax) {		\
     zz=z >> ZB_POINT_Z_FRAC_BITS;		\
     if (ZCMP(zz,*pz))  { 			\
       RGBPIXEL;	\
@@ -68,7 +70,7 @@
   }
 #else /* INTERP_Z */
 #define ZZ(x)
-#define PUTPIXEL() RGBPIXEL
+#define PUTPIXEL() if (y >= zb->ymin && y < zb->ymax) { RGBPIXEL; }
 #endif /* INTERP_Z */
 
 #define DRAWLINE(dx,dy,inc_1,inc_2) \
@@ -86,8 +88,8 @@
         PUTPIXEL();\
         ZZ(z+=zinc);\
         RGB(r+=rinc;g+=ginc;b+=binc);\
-        if (a>0) { pp=(PIXEL *)((char *)pp + pp_inc_1); ZZ(pz+=(inc_1));  a-=dx; }\
-	else { pp=(PIXEL *)((char *)pp + pp_inc_2); ZZ(pz+=(inc_2)); a+=dy; }\
+        if (a>0) { pp=(PIXEL *)((char *)pp + pp_inc_1); ZZ(pz+=(inc_1));  a-=dx; y++; }\
+	else { pp=(PIXEL *)((char *)pp + pp_inc_2); ZZ(pz+=(inc_2)); a+=dy; y+=((inc_2) == sx); }\
     } while (--n >= 0);
 
 /* fin macro */
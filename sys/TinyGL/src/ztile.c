@@ -0,0 +1,422 @@
+/*
+ * Tiled rendering: the screen is cut into horizontal tiles, each one
+ * owned by a thread which holds its color and depth lines in memory it
+ * allocated itself, thus local to its cluster.
+ *
+ * While tiles are open, the ZB_fill/line/plot/clear entry points only
+ * record the primitive in the command list of every tile it overlaps.
+ * ZB_flushTiles() lets each thread replay its list, in submission order,
+ * on a view of the zbuffer limited to its lines, then copy the tile
+ * lines into pbuf. Each line is drawn by the serial code with the same
+ * edge stepping, so the image is the same as without tiles.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "zbuffer.h"
+
+/* smallest tile height worth a thread */
+#define ZB_TILE_MIN_LINES 8
+/* initial command list size of a tile */
+#define ZB_TILE_MIN_CMDS  64
+
+enum {
+    ZB_CMD_TRIANGLE,
+    ZB_CMD_LINE,
+    ZB_CMD_LINE_Z,
+    ZB_CMD_PLOT,
+    ZB_CMD_CLEAR
+};
+
+typedef struct {
+    int type;
+    ZB_fillTriangleFunc func;
+    PIXEL *texture;
+    union {
+	ZBufferPoint p[3];
+	int clear[6];   /* clear_z, z, clear_color, r, g, b */
+    } u;
+} ZBTileCmd;
+
+typedef struct {
+    struct ZBTiles *tiles;
+    int index;
+    pthread_t thread;
+    ZBuffer view;           /* zbuffer limited to the tile lines */
+    PIXEL *pbuf;
+    unsigned short *zbuf;
+    ZBTileCmd *cmds;
+    int nb_cmds, max_cmds;
+} ZBTile;
+
+struct ZBTiles {
+    ZBuffer *zb;
+    int nb_threads;         /* as asked to ZB_openTiles */
+    int nb_tiles;
+    int tile_lines;
+    int dirty;              /* commands recorded since last flush */
+
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    int generation;
+    int pending;
+    int quit;
+    int error;
+
+    ZBTile *tile;
+};
+
+static void ZB_tileRun(ZBTile *tile)
+{
+    ZBTileCmd *cmd;
+    ZBufferPoint p[3];
+    int i;
+
+    for (i = 0; i < tile->nb_cmds; i++) {
+	cmd = &tile->cmds[i];
+	/* fill functions write in the points, work on a copy */
+	switch (cmd->type) {
+	case ZB_CMD_TRIANGLE:
+	    p[0] = cmd->u.p[0];
+	    p[1] = cmd->u.p[1];
+	    p[2] = cmd->u.p[2];
+	    tile->view.current_texture = cmd->texture;
+	    cmd->func(&tile->view, &p[0], &p[1], &p[2]);
+	    break;
+	case ZB_CMD_LINE:
+	case ZB_CMD_LINE_Z:
+	    p[0] = cmd->u.p[0];
+	    p[1] = cmd->u.p[1];
+	    if (cmd->type == ZB_CMD_LINE_Z)
+		ZB_line_z(&tile->view, &p[0], &p[1]);
+	    else
+		ZB_line(&tile->view, &p[0], &p[1]);
+	    break;
+	case ZB_CMD_PLOT:
+	    p[0] = cmd->u.p[0];
+	    ZB_plot(&tile->view, &p[0]);
+	    break;
+	case ZB_CMD_CLEAR:
+	    ZB_clear(&tile->view, cmd->u.clear[0], cmd->u.clear[1],
+		     cmd->u.clear[2], cmd->u.clear[3], cmd->u.clear[4],
+		     cmd->u.clear[5]);
+	    break;
+	}
+    }
+
+    tile->nb_cmds = 0;
+}
+
+static void *ZB_tileThread(void *arg)
+{
+    ZBTile *tile = arg;
+    struct ZBTiles *tiles = tile->tiles;
+    ZBuffer *zb = tiles->zb;
+    int y0, lines, generation, quit;
+
+    y0 = tile->index * tiles->tile_lines;
+    lines = tiles->tile_lines;
+    if (y0 + lines > zb->ysize)
+	lines = zb->ysize - y0;
+
+    /* first touched here, so backed by our cluster memory */
+    tile->pbuf = gl_malloc(lines * zb->linesize);
+    tile->zbuf = gl_malloc(lines * zb->xsize * sizeof(unsigned short));
+
+    if (tile->pbuf != NULL && tile->zbuf != NULL) {
+	memcpy(tile->pbuf, (char *) zb->pbuf + y0 * zb->linesize,
+	       lines * zb->linesize);
+	memcpy(tile->zbuf, zb->zbuf + y0 * zb->xsize,
+	       lines * zb->xsize * sizeof(unsigned short));
+    }
+
+    /* the view addresses the tile lines with screen coordinates */
+    tile->view = *zb;
+    tile->view.tiles = NULL;
+    tile->view.frame_buffer_allocated = 0;
+    tile->view.ymin = y0;
+    tile->view.ymax = y0 + lines;
+    tile->view.pbuf = (PIXEL *) ((char *) tile->pbuf - y0 * zb->linesize);
+    tile->view.zbuf = tile->zbuf - y0 * zb->xsize;
+
+    pthread_mutex_lock(&tiles->lock);
+    if (tile->pbuf == NULL || tile->zbuf == NULL)
+	tiles->error = 1;
+    generation = tiles->generation;
+    if (--tiles->pending == 0)
+	pthread_cond_signal(&tiles->done);
+
+    for (;;) {
+	while (tiles->generation == generation)
+	    pthread_cond_wait(&tiles->start, &tiles->lock);
+	generation = tiles->generation;
+	quit = tiles->quit;
+	pthread_mutex_unlock(&tiles->lock);
+
+	if (tile->pbuf != NULL && tile->zbuf != NULL) {
+	    ZB_tileRun(tile);
+	    memcpy((char *) zb->pbuf + y0 * zb->linesize, tile->pbuf,
+		   lines * zb->linesize);
+	    /* give the depth back to the serial renderer */
+	    if (quit && !tiles->error)
+		memcpy(zb->zbuf + y0 * zb->xsize, tile->zbuf,
+		       lines * zb->xsize * sizeof(unsigned short));
+	}
+
+	pthread_mutex_lock(&tiles->lock);
+	if (--tiles->pending == 0)
+	    pthread_cond_signal(&tiles->done);
+	if (quit)
+	    break;
+    }
+
+    pthread_mutex_unlock(&tiles->lock);
+
+    gl_free(tile->pbuf);
+    gl_free(tile->zbuf);
+    return NULL;
+}
+
+/* Runs one round of the nb first tile threads and waits for them */
+static void ZB_tileKick(struct ZBTiles *tiles, int nb, int quit)
+{
+    pthread_mutex_lock(&tiles->lock);
+    tiles->pending = nb;
+    tiles->quit = quit;
+    tiles->generation++;
+    pthread_cond_broadcast(&tiles->start);
+    while (tiles->pending != 0)
+	pthread_cond_wait(&tiles->done, &tiles->lock);
+    pthread_mutex_unlock(&tiles->lock);
+}
+
+static void ZB_tileFree(struct ZBTiles *tiles, int nb_started)
+{
+    int i;
+
+    ZB_tileKick(tiles, nb_started, 1);
+
+    for (i = 0; i < nb_started; i++)
+	pthread_join(tiles->tile[i].thread, NULL);
+
+    for (i = 0; i < tiles->nb_tiles; i++)
+	gl_free(tiles->tile[i].cmds);
+
+    pthread_cond_destroy(&tiles->done);
+    pthread_cond_destroy(&tiles->start);
+    pthread_mutex_destroy(&tiles->lock);
+    gl_free(tiles->tile);
+    gl_free(tiles);
+}
+
+int ZB_openTiles(ZBuffer *zb, int nb_threads)
+{
+    struct ZBTiles *tiles;
+    int i, nb_tiles;
+
+    if (zb->tiles != NULL)
+	ZB_closeTiles(zb);
+
+    nb_tiles = zb->ysize / ZB_TILE_MIN_LINES;
+    if (nb_tiles > nb_threads)
+	nb_tiles = nb_threads;
+    if (nb_tiles <= 1)
+	return -1;
+
+    tiles = gl_zalloc(sizeof(struct ZBTiles));
+    if (tiles == NULL)
+	return -1;
+
+    tiles->zb = zb;
+    tiles->nb_threads = nb_threads;
+    tiles->tile_lines = (zb->ysize + nb_tiles - 1) / nb_tiles;
+    tiles->nb_tiles = (zb->ysize + tiles->tile_lines - 1) / tiles->tile_lines;
+    tiles->tile = gl_zalloc(tiles->nb_tiles * sizeof(ZBTile));
+
+    if (tiles->tile == NULL) {
+	gl_free(tiles);
+	return -1;
+    }
+
+    pthread_mutex_init(&tiles->lock, NULL);
+    pthread_cond_init(&tiles->start, NULL);
+    pthread_cond_init(&tiles->done, NULL);
+
+    for (i = 0; i < tiles->nb_tiles; i++) {
+	tiles->tile[i].tiles = tiles;
+	tiles->tile[i].index = i;
+	tiles->tile[i].max_cmds = ZB_TILE_MIN_CMDS;
+	tiles->tile[i].cmds = gl_malloc(ZB_TILE_MIN_CMDS * sizeof(ZBTileCmd));
+	if (tiles->tile[i].cmds == NULL)
+	    tiles->error = 1;
+    }
+
+    pthread_mutex_lock(&tiles->lock);
+    tiles->pending = tiles->nb_tiles;
+
+    for (i = 0; i < tiles->nb_tiles; i++) {
+	if (tiles->error ||
+	    pthread_create(&tiles->tile[i].thread, NULL,
+			   ZB_tileThread, &tiles->tile[i]) != 0) {
+	    tiles->error = 1;
+	    tiles->pending -= tiles->nb_tiles - i;
+	    break;
+	}
+    }
+
+    /* wait for the tiles to get their buffers */
+    while (tiles->pending != 0)
+	pthread_cond_wait(&tiles->done, &tiles->lock);
+    pthread_mutex_unlock(&tiles->lock);
+
+    if (tiles->error) {
+	ZB_tileFree(tiles, i);
+	return -1;
+    }
+
+    zb->tiles = tiles;
+    return 0;
+}
+
+int ZB_closeTiles(ZBuffer *zb)
+{
+    struct ZBTiles *tiles = zb->tiles;
+    int nb_threads;
+
+    if (tiles == NULL)
+	return 0;
+
+    nb_threads = tiles->nb_threads;
+    zb->tiles = NULL;
+    ZB_tileFree(tiles, tiles->nb_tiles);
+    return nb_threads;
+}
+
+void ZB_flushTiles(ZBuffer *zb)
+{
+    struct ZBTiles *tiles = zb->tiles;
+
+    if (tiles == NULL || !tiles->dirty)
+	return;
+
+    ZB_tileKick(tiles, tiles->nb_tiles, 0);
+    tiles->dirty = 0;
+}
+
+/* Returns a new command slot at the end of the list of tile t */
+static ZBTileCmd *ZB_tileAppend(ZBuffer *zb, int t)
+{
+    ZBTile *tile = &zb->tiles->tile[t];
+    ZBTileCmd *cmds;
+
+    if (tile->nb_cmds == tile->max_cmds) {
+	cmds = gl_malloc(2 * tile->max_cmds * sizeof(ZBTileCmd));
+	if (cmds == NULL) {
+	    /* out of memory, render what we have to empty the lists */
+	    ZB_flushTiles(zb);
+	} else {
+	    memcpy(cmds, tile->cmds, tile->nb_cmds * sizeof(ZBTileCmd));
+	    gl_free(tile->cmds);
+	    tile->cmds = cmds;
+	    tile->max_cmds *= 2;
+	}
+    }
+
+    zb->tiles->dirty = 1;
+    return &tile->cmds[tile->nb_cmds++];
+}
+
+/* Gets the first and last tiles holding lines ymin..ymax */
+static int ZB_tileRange(ZBuffer *zb, int ymin, int ymax, int *t0, int *t1)
+{
+    if (ymin < 0)
+	ymin = 0;
+    if (ymax >= zb->ysize)
+	ymax = zb->ysize - 1;
+    if (ymin > ymax)
+	return 0;
+
+    *t0 = ymin / zb->tiles->tile_lines;
+    *t1 = ymax / zb->tiles->tile_lines;
+    return 1;
+}
+
+void ZB_tileTriangle(ZBuffer *zb, ZB_fillTriangleFunc func,
+		     ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2)
+{
+    ZBTileCmd *cmd;
+    int ymin, ymax, t, t0, t1;
+
+    ymin = ymax = p0->y;
+    if (p1->y < ymin) ymin = p1->y;
+    if (p1->y > ymax) ymax = p1->y;
+    if (p2->y < ymin) ymin = p2->y;
+    if (p2->y > ymax) ymax = p2->y;
+
+    if (!ZB_tileRange(zb, ymin, ymax, &t0, &t1))
+	return;
+
+    for (t = t0; t <= t1; t++) {
+	cmd = ZB_tileAppend(zb, t);
+	cmd->type = ZB_CMD_TRIANGLE;
+	cmd->func = func;
+	cmd->texture = zb->current_texture;
+	cmd->u.p[0] = *p0;
+	cmd->u.p[1] = *p1;
+	cmd->u.p[2] = *p2;
+    }
+}
+
+void ZB_tileLine(ZBuffer *zb, int z_test,
+		 ZBufferPoint *p1, ZBufferPoint *p2)
+{
+    ZBTileCmd *cmd;
+    int t, t0, t1;
+
+    if (!ZB_tileRange(zb, (p1->y < p2->y) ? p1->y : p2->y,
+		      (p1->y < p2->y) ? p2->y : p1->y, &t0, &t1))
+	return;
+
+    for (t = t0; t <= t1; t++) {
+	cmd = ZB_tileAppend(zb, t);
+	cmd->type = z_test ? ZB_CMD_LINE_Z : ZB_CMD_LINE;
+	cmd->u.p[0] = *p1;
+	cmd->u.p[1] = *p2;
+    }
+}
+
+void ZB_tilePlot(ZBuffer *zb, ZBufferPoint *p)
+{
+    ZBTileCmd *cmd;
+    int t0, t1;
+
+    if (!ZB_tileRange(zb, p->y, p->y, &t0, &t1))
+	return;
+
+    cmd = ZB_tileAppend(zb, t0);
+    cmd->type = ZB_CMD_PLOT;
+    cmd->u.p[0] = *p;
+}
+
+void ZB_tileClear(ZBuffer *zb, int clear_z, int z,
+		  int clear_color, int r, int g, int b)
+{
+    ZBTileCmd *cmd;
+    int t;
+
+    for (t = 0; t < zb->tiles->nb_tiles; t++) {
+	/* whatever was drawn before is overwritten */
+	if (clear_z && clear_color)
+	    zb->tiles->tile[t].nb_cmds = 0;
+
+	cmd = ZB_tileAppend(zb, t);
+	cmd->type = ZB_CMD_CLEAR;
+	cmd->u.clear[0] = clear_z;
+	cmd->u.clear[1] = z;
+	cmd->u.clear[2] = clear_color;
+	cmd->u.clear[3] = r;
+	cmd->u.clear[4] = g;
+	cmd->u.clear[5] = b;
+    }
+}
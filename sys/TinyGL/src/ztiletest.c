@@ -0,0 +1,293 @@
+/*
+ * Banded rendering must not change a single pixel. Two ostgl contexts
+ * draw the same seeded scenes, one serially and one split in bands
+ * over 2 to 64 threads; their back buffers are then compared with
+ * memcmp, and the Z buffers too once ZB_closeTiles has run. A swap
+ * must copy the back buffer to the screen buffer. Screen
+ * heights are picked so that the last band is shorter than the
+ * others. Build it from sys/TinyGL with the host pthreads, the glx
+ * glue left out:
+ *
+ *   cc -O2 -pthread -Iinclude -o ztiletest $(ls src/[a-z]*.c | grep -v glx) -lm
+ *   ./ztiletest
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GL/gl.h>
+#include <GL/oscontext.h>
+#include "zbuffer.h"
+
+enum {
+    SCENE_FLAT,
+    SCENE_SMOOTH,
+    SCENE_TEXTURE,
+    SCENE_LINES,
+    SCENE_POINTS,
+    SCENE_CLEAR,
+    SCENE_NR
+};
+
+static const char *scene_name[SCENE_NR] = {
+    "flat", "smooth", "texture", "lines", "points", "clear"
+};
+
+static unsigned char texture[2][256 * 256 * 3];
+static int errors;
+
+/* stands for the system call, the CPU always copies */
+void *dma_memcpy(void *src, void *dst, unsigned int size)
+{
+    return NULL;
+}
+
+/* coordinates slightly out of the screen, to go through the clipping */
+static float frand(unsigned int *seed)
+{
+    return (rand_r(seed) % 2400) / 1000.0f - 1.2f;
+}
+
+static void color(unsigned int *seed)
+{
+    glColor3f((rand_r(seed) % 256) / 255.0f, (rand_r(seed) % 256) / 255.0f,
+	      (rand_r(seed) % 256) / 255.0f);
+}
+
+static void vertex(unsigned int *seed)
+{
+    float x = frand(seed), y = frand(seed);
+
+    glVertex3f(x, y, frand(seed) * 0.8f);
+}
+
+static void triangles(unsigned int *seed, int n, int smooth, int textured)
+{
+    int i, j;
+
+    glBegin(GL_TRIANGLES);
+    for (i = 0; i < n; i++) {
+	color(seed);
+	for (j = 0; j < 3; j++) {
+	    if (smooth)
+		color(seed);
+	    if (textured)
+		glTexCoord2f((rand_r(seed) % 400) / 100.0f,
+			     (rand_r(seed) % 400) / 100.0f);
+	    vertex(seed);
+	}
+    }
+    glEnd();
+}
+
+static void draw(int scene, unsigned int seed)
+{
+    unsigned int tex[2];
+    int i;
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glClearColor(0.1f, 0.2f, 0.3f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    switch (scene) {
+    case SCENE_FLAT:
+	glShadeModel(GL_FLAT);
+	triangles(&seed, 200, 0, 0);
+	break;
+    case SCENE_SMOOTH:
+	glShadeModel(GL_SMOOTH);
+	triangles(&seed, 200, 1, 0);
+	/* thin triangles along the band limits */
+	glDisable(GL_DEPTH_TEST);
+	glBegin(GL_TRIANGLES);
+	for (i = 0; i < 40; i++) {
+	    color(&seed);
+	    glVertex3f(-1.0f, frand(&seed), 0.0f);
+	    color(&seed);
+	    glVertex3f(1.0f, frand(&seed), 0.0f);
+	    color(&seed);
+	    glVertex3f(frand(&seed), frand(&seed) * 0.01f, 0.0f);
+	}
+	glEnd();
+	break;
+    case SCENE_TEXTURE:
+	/* the first texture is freed while frames using it are recorded */
+	glGenTextures(2, tex);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, tex[0]);
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 256, 256, 0, GL_RGB,
+		     GL_UNSIGNED_BYTE, texture[0]);
+	glShadeModel(GL_SMOOTH);
+	triangles(&seed, 100, 1, 1);
+	glDeleteTextures(1, &tex[0]);
+	glBindTexture(GL_TEXTURE_2D, tex[1]);
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 256, 256, 0, GL_RGB,
+		     GL_UNSIGNED_BYTE, texture[1]);
+	triangles(&seed, 100, 0, 1);
+	glDeleteTextures(1, &tex[1]);
+	break;
+    case SCENE_LINES:
+	glShadeModel(GL_SMOOTH);
+	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	triangles(&seed, 100, 1, 0);
+	glDisable(GL_DEPTH_TEST);
+	glBegin(GL_LINES);
+	for (i = 0; i < 200; i++) {
+	    color(&seed);
+	    vertex(&seed);
+	    color(&seed);
+	    vertex(&seed);
+	}
+	glEnd();
+	break;
+    case SCENE_POINTS:
+	glBegin(GL_POINTS);
+	for (i = 0; i < 2000; i++) {
+	    if (i == 1000)
+		glDisable(GL_DEPTH_TEST);
+	    color(&seed);
+	    vertex(&seed);
+	}
+	glEnd();
+	break;
+    case SCENE_CLEAR:
+	/* partial clears keep the commands recorded before them */
+	glShadeModel(GL_FLAT);
+	triangles(&seed, 50, 0, 0);
+	glClearColor(0.5f, 0.0f, 0.5f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	triangles(&seed, 50, 0, 0);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	triangles(&seed, 50, 0, 0);
+	break;
+    }
+}
+
+static void compare(ostgl_context *ref, ostgl_context *tiled,
+		    const char *what, int threads, int depth)
+{
+    ZBuffer *zr = ref->zbs[0], *zt = tiled->zbs[0];
+    int n;
+
+    n = ref->ysize * zr->linesize;
+    if (memcmp(zr->pbuf, zt->pbuf, n) != 0) {
+	printf("FAILED: %dx%d, %d threads, %s: color differs\n",
+	       ref->xsize, ref->ysize, threads, what);
+	errors++;
+    }
+
+    n = ref->xsize * ref->ysize * sizeof(unsigned short);
+    if (depth && memcmp(zr->zbuf, zt->zbuf, n) != 0) {
+	printf("FAILED: %dx%d, %d threads, %s: depth differs\n",
+	       ref->xsize, ref->ysize, threads, what);
+	errors++;
+    }
+}
+
+static void frame(ostgl_context *ctx, int scene, unsigned int seed)
+{
+    ZBuffer *zb = ctx->zbs[0];
+
+    ostgl_make_current(ctx, 0);
+    glViewport(0, 0, ctx->xsize, ctx->ysize);
+    draw(scene, seed);
+    ostgl_swap_buffers(ctx);
+
+    /* a single buffer is not flipped, the back buffer is copied */
+    if (zb->pbuf == ctx->framebuffers[0]
+	|| memcmp(zb->pbuf, ctx->framebuffers[0], ctx->ysize * zb->linesize)) {
+	printf("FAILED: %dx%d, %s: not presented\n",
+	       ctx->xsize, ctx->ysize, scene_name[scene]);
+	errors++;
+    }
+}
+
+static void test_size(int xsize, int ysize, int threads)
+{
+    ostgl_context *ref, *tiled;
+    void *fb_ref, *fb_tiled;
+    int scene;
+
+    fb_ref = calloc(ysize, xsize * 2);
+    fb_tiled = calloc(ysize, xsize * 2);
+    ref = ostgl_create_context(xsize, ysize, 16, &fb_ref, 1);
+    tiled = ostgl_create_context(xsize, ysize, 16, &fb_tiled, 1);
+
+    if (ostgl_set_threads(tiled, threads) != 0) {
+	printf("FAILED: %dx%d, %d threads: no tiles\n", xsize, ysize, threads);
+	errors++;
+    }
+
+    for (scene = 0; scene < SCENE_NR; scene++) {
+	frame(ref, scene, scene + 1);
+	frame(tiled, scene, scene + 1);
+	compare(ref, tiled, scene_name[scene], threads, 0);
+    }
+
+    /* a frame recorded but not swapped is rendered when the tiles close */
+    ostgl_make_current(ref, 0);
+    draw(SCENE_SMOOTH, 7);
+    ostgl_make_current(tiled, 0);
+    draw(SCENE_SMOOTH, 7);
+    ostgl_set_threads(tiled, 1);
+    compare(ref, tiled, "close", threads, 1);
+
+    /* the serial renderer goes on with the depth of the tiles */
+    ostgl_make_current(ref, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    triangles(&(unsigned int) { 8 }, 100, 1, 0);
+    ostgl_make_current(tiled, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    triangles(&(unsigned int) { 8 }, 100, 1, 0);
+    compare(ref, tiled, "after close", threads, 1);
+
+    /* reopened tiles start from the serial buffers */
+    ostgl_set_threads(tiled, threads);
+    frame(ref, SCENE_CLEAR, 9);
+    frame(tiled, SCENE_CLEAR, 9);
+    compare(ref, tiled, "reopen", threads, 0);
+
+    ostgl_delete_context(tiled);
+    ostgl_delete_context(ref);
+    free(fb_tiled);
+    free(fb_ref);
+}
+
+int main(int argc, char **argv)
+{
+    static const int sizes[][2] = {
+	{ 320, 240 }, { 156, 103 }, { 64, 17 }, { 500, 8 * 64 + 5 }
+    };
+    unsigned int seed = 1;
+    int i, s, threads;
+
+    for (i = 0; i < (int) sizeof(texture[0]); i++) {
+	texture[0][i] = rand_r(&seed);
+	texture[1][i] = (i / 3 / 16 + i / 3 / 256 / 16) & 1 ? 255 : 0;
+    }
+
+    for (s = 0; s < (int) (sizeof(sizes) / sizeof(sizes[0])); s++) {
+	for (threads = 2; threads <= 64; threads = threads * 3 / 2 + 1) {
+	    /* a single band is not tiled */
+	    if (sizes[s][1] / 8 < 2)
+		break;
+	    test_size(sizes[s][0], sizes[s][1], threads);
+	}
+    }
+
+    if (errors) {
+	printf("%d comparisons failed\n", errors);
+	return 1;
+    }
+
+    printf("tiled frames identical to serial frames\n");
+    return 0;
+}
@@ -12,6 +12,11 @@ void ZB_fillTriangleFlat(ZBuffer *zb,
     int color;
 #endif
 
+    if (zb->tiles != NULL) {
+	ZB_tileTriangle(zb, ZB_fillTriangleFlat, p0, p1, p2);
+	return;
+    }
+
 #define INTERP_Z
 
 #if TGL_FEATURE_RENDER_BITS == 24 
@@ -68,6 +73,11 @@ void ZB_fillTriangleSmooth(ZBuffer *zb,
         int _drgbdx;
 #endif
 
+    if (zb->tiles != NULL) {
+	ZB_tileTriangle(zb, ZB_fillTriangleSmooth, p0, p1, p2);
+	return;
+    }
+
 #define INTERP_Z
 #define INTERP_RGB
 
@@ -181,6 +191,11 @@ void ZB_fillTriangleMapping(ZBuffer *zb,
 {
     PIXEL *texture;
 
+    if (zb->tiles != NULL) {
+	ZB_tileTriangle(zb, ZB_fillTriangleMapping, p0, p1, p2);
+	return;
+    }
+
 #define INTERP_Z
 #define INTERP_ST
 
@@ -239,6 +254,11 @@ void ZB_fillTriangleMappingPerspective(ZBuffer *zb,
     PIXEL *texture;
     float fdzdx,fndzdx,ndszdx,ndtzdx;
 
+    if (zb->tiles != NULL) {
+	ZB_tileTriangle(zb, ZB_fillTriangleMappingPerspective, p0, p1, p2);
+	return;
+    }
+
 #define INTERP_Z
 #define INTERP_STZ
 
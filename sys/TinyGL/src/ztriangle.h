@@ -8,6 +8,7 @@
   unsigned short *pz1;
   PIXEL *pp1;
   int part,update_left,update_right;
+  int y;
 
   int nb_lines,dx1,dy1,tmp,dx2,dy2;
 
@@ -148,8 +149,13 @@
   }
 #endif
 
+  /* nothing to draw in the allowed lines */
+  if (p2->y < zb->ymin || p0->y >= zb->ymax)
+    return;
+
   /* screen coordinates */
 
+  y = p0->y;
   pp1 = (PIXEL *) ((char *) zb->pbuf + zb->linesize * p0->y);
   pz1 = zb->zbuf + p0->y * zb->xsize;
 
@@ -258,6 +264,8 @@
 
     while (nb_lines>0) {
       nb_lines--;
+      /* lines above ymin only step the edges */
+      if (y >= zb->ymin) {
 #ifndef DRAW_LINE
       /* generic draw line */
       {
@@ -319,6 +327,7 @@
 #else
       DRAW_LINE();
 #endif
+      }
       
       /* left edge */
       error+=derror;
@@ -367,6 +376,9 @@
       /* screen coordinates */
       pp1=(PIXEL *)((char *)pp1 + zb->linesize);
       pz1+=zb->xsize;
+
+      if (++y >= zb->ymax)
+        return;
     }
   }
 }
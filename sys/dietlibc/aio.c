@@ -0,0 +1,108 @@
+/*
+   This file is part of MutekP.
+  
+   MutekP is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+  
+   MutekP is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+  
+   You should have received a copy of the GNU General Public License
+   along with MutekP; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+  
+   UPMC / LIP6 / SOC (c) 2008
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <aio.h>
+#include <cpu-syscall.h>
+
+/* sys_aio operations, see kernel VFS_AIO_* */
+#define __AIO_SUBMIT   1
+#define __AIO_POLL     2
+#define __AIO_WAIT     3
+#define __AIO_CANCEL   4
+
+static int __aio_submit(struct aiocb *aiocbp, int opcode)
+{
+  if(aiocbp == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  aiocbp->aio_lio_opcode = opcode;
+  return (int) cpu_syscall((void*)__AIO_SUBMIT, aiocbp, NULL, NULL, SYS_AIO);
+}
+
+int aio_read(struct aiocb *aiocbp)
+{
+  return __aio_submit(aiocbp, LIO_READ);
+}
+
+int aio_write(struct aiocb *aiocbp)
+{
+  return __aio_submit(aiocbp, LIO_WRITE);
+}
+
+int aio_error(const struct aiocb *aiocbp)
+{
+  if(aiocbp->__error == EINPROGRESS)
+    (void) cpu_syscall((void*)__AIO_POLL, (void*)aiocbp, NULL, NULL, SYS_AIO);
+
+  return aiocbp->__error;
+}
+
+ssize_t aio_return(struct aiocb *aiocbp)
+{
+  return aiocbp->__return;
+}
+
+int aio_cancel(int fd, struct aiocb *aiocbp)
+{
+  if((aiocbp == NULL) || (aiocbp->aio_fildes != fd))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if(aiocbp->__error != EINPROGRESS)
+    return AIO_ALLDONE;
+
+  if((int) cpu_syscall((void*)__AIO_CANCEL, aiocbp, NULL, NULL, SYS_AIO))
+    return AIO_ALLDONE;
+
+  return AIO_CANCELED;
+}
+
+int aio_waitn(struct aiocb * const list[], int nent, int min)
+{
+  return (int) cpu_syscall((void*)__AIO_WAIT, (void*)list, (void*)nent, (void*)min, SYS_AIO);
+}
+
+int aio_suspend(const struct aiocb * const list[], int nent, const struct timespec *timeout)
+{
+  int i;
+
+  for(i = 0; i < nent; i++)
+  {
+    if((list[i] != NULL) && (aio_error(list[i]) != EINPROGRESS))
+      return 0;
+  }
+
+  if((timeout != NULL) && (timeout->tv_sec == 0) && (timeout->tv_nsec == 0))
+  {
+    errno = EAGAIN;
+    return -1;
+  }
+
+  return (aio_waitn((struct aiocb * const *)list, nent, 1) < 0) ? -1 : 0;
+}
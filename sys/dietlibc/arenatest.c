@@ -0,0 +1,250 @@
+/*
+   Host test of the small blocks allocator core (malloc_arena.c, built
+   without _ALMOS_, host threads being spread over 4 fake clusters):
+   size classes, block headers, cache flushes, cross-cluster frees,
+   thread exit and the fork child path. Block contents are checked
+   before every free to catch blocks handed out twice.
+
+     cc -O2 -pthread -o arenatest arenatest.c && ./arenatest [rounds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "malloc_arena.c"
+
+#define THREADS  8
+#define SLOTS    4096
+
+static unsigned long rounds;
+static void * volatile slots[SLOTS];	/* blocks left for any thread to free */
+
+static void fail(const char *what)
+{
+  printf("FAILED: %s\n", what);
+  exit(1);
+}
+
+static void fill(void *ptr, size_t size)
+{
+  memset(ptr, (int) ((uintptr_t) ptr >> 4), size);
+}
+
+static void check(void *ptr)
+{
+  unsigned char *p = ptr, c = (unsigned char) ((uintptr_t) ptr >> 4);
+  size_t i, size = __arena_size(ptr);
+
+  for (i = sizeof(void*); i < size; i++)
+    if (p[i] != c)
+      fail("block content overwritten");
+}
+
+/* free blocks of a class in an arena, remote frees included */
+static unsigned long arena_count(struct arena_s *arena, uint_t cls)
+{
+  unsigned long n = arena->bins[cls].count;
+  void *p;
+
+  for (p = arena->remote[cls].head; p != NULL; p = *(void**) p)
+    n++;
+  return n;
+}
+
+static void check_classes(void)
+{
+  size_t size;
+  uint_t cls;
+
+  for (size = 0; size <= ARENA_MAX_SIZE; size++) {
+    cls = arena_size2class(size);
+    if (cls >= ARENA_CLASS_NR || arena_class_size[cls] < size ||
+	(cls > 0 && arena_class_size[cls - 1] >= size && size > 0))
+      fail("size class");
+  }
+}
+
+static void check_blocks(void)
+{
+  struct arena_tcache_s *tcache;
+  void *ptr[ARENA_CACHE_MAX + ARENA_BATCH + 1];
+  size_t size;
+  uint_t i;
+
+  if (__arena_malloc(ARENA_MAX_SIZE + 1) != NULL)
+    fail("large block");
+
+  for (size = 0; size <= ARENA_MAX_SIZE; size += 7) {
+    void *p = __arena_malloc(size);
+
+    if (p == NULL || !__arena_owns(p) || __arena_size(p) < size ||
+	((uintptr_t) p & (sizeof(void*) - 1)))
+      fail("block header");
+    fill(p, __arena_size(p));
+    check(p);
+    __arena_free(p);
+  }
+
+  /* the cache of a class stays bounded */
+  tcache = arena_tls_get();
+  for (i = 0; i < sizeof(ptr) / sizeof(ptr[0]); i++)
+    ptr[i] = __arena_malloc(40);
+  for (i = 0; i < sizeof(ptr) / sizeof(ptr[0]); i++)
+    __arena_free(ptr[i]);
+  if (tcache->bins[arena_size2class(40)].count > ARENA_CACHE_MAX)
+    fail("cache flush");
+}
+
+static void *worker(void *arg)
+{
+  unsigned int seed = (unsigned int) (uintptr_t) arg;
+  unsigned long r;
+  void *p, *old;
+  size_t size;
+  uint_t i;
+
+  for (r = 0; r < rounds; r++) {
+    size = rand_r(&seed) % (ARENA_MAX_SIZE + 1);
+
+    if ((p = __arena_malloc(size)) == NULL)
+      fail("out of memory");
+    if (__arena_size(p) < size)
+      fail("short block");
+    fill(p, __arena_size(p));
+
+    /* swap with a block allocated by any thread, often of another cluster */
+    i = rand_r(&seed) % SLOTS;
+    do {
+      old = slots[i];
+    } while (!__sync_bool_compare_and_swap(&slots[i], old, p));
+
+    if (old != NULL) {
+      check(old);
+      __arena_free(old);
+    }
+  }
+
+  __arena_thread_exit();
+  return NULL;
+}
+
+#define FREE_MAX  (1 << 20)
+
+static void *free_blocks[FREE_MAX];
+
+static int cmp_ptr(const void *a, const void *b)
+{
+  uintptr_t x = (uintptr_t) *(void* const*) a, y = (uintptr_t) *(void* const*) b;
+
+  return (x > y) - (x < y);
+}
+
+static void check_threads(void)
+{
+  pthread_t tid[THREADS];
+  unsigned long n, i;
+  uint_t cls, cid;
+
+  for (i = 0; i < THREADS; i++)
+    if (pthread_create(&tid[i], NULL, worker, (void*) (uintptr_t) (i + 1)))
+      fail("pthread_create");
+
+  for (i = 0; i < THREADS; i++)
+    pthread_join(tid[i], NULL);
+
+  for (i = 0; i < SLOTS; i++) {
+    if (slots[i] != NULL) {
+      check(slots[i]);
+      __arena_free(slots[i]);
+      slots[i] = NULL;
+    }
+  }
+
+  __arena_thread_exit();
+
+  /* free lists hold every block once, in the arena of its chunk */
+  for (cls = 0; cls < ARENA_CLASS_NR; cls++) {
+    for (n = 0, cid = 0; cid < ARENA_NR; cid++) {
+      struct arena_s *arena = arena_tbl[cid];
+      void *p;
+
+      if (arena == NULL)
+	continue;
+
+      for (i = 0; i < 2; i++) {
+	p = (i == 0) ? arena->bins[cls].head : arena->remote[cls].head;
+
+	for (; p != NULL; p = *(void**) p) {
+	  struct arena_chunk_s *chunk;
+
+	  chunk = (struct arena_chunk_s*) (((struct arena_hdr_s*) p - 1)->chunk & ~ARENA_TAG);
+	  if (chunk->arena != arena || chunk->cls != cls)
+	    fail("block in a foreign list");
+	  if (n == FREE_MAX)
+	    fail("free list loops");
+	  free_blocks[n++] = p;
+	}
+      }
+    }
+
+    qsort(free_blocks, n, sizeof(void*), cmp_ptr);
+    for (i = 1; i < n; i++)
+      if (free_blocks[i] == free_blocks[i - 1])
+	fail("block freed twice");
+  }
+}
+
+/* a child keeps the cache of the forking thread and the arenas locks */
+static void check_fork(void)
+{
+  struct arena_tcache_s *tcache;
+  struct arena_s *arena;
+  void *p[ARENA_BATCH];
+  unsigned long before;
+  uint_t cls, i;
+
+  for (i = 0; i < ARENA_BATCH; i++)
+    p[i] = __arena_malloc(100);
+  for (i = 0; i < ARENA_BATCH; i++)
+    __arena_free(p[i]);
+
+  tcache = arena_tls_get();
+  arena  = tcache->arena;
+  cls    = arena_size2class(100);
+  before = arena_count(arena, cls);
+
+  /* held by some other thread of the parent */
+  pthread_spin_lock(&arena->lock);
+
+  /* what fork does in the child: TLS reset, then the cache handed over */
+  arena_tls_set(NULL);
+  __arena_fork_child(tcache);
+
+  if (arena_tls_get() != NULL)
+    fail("fork cache kept");
+  if (arena_count(arena, cls) < before + ARENA_BATCH)
+    fail("fork cache lost");
+  if (pthread_spin_trylock(&arena->lock))
+    fail("fork arena lock");
+  pthread_spin_unlock(&arena->lock);
+
+  if ((p[0] = __arena_malloc(100)) == NULL)
+    fail("malloc after fork");
+  __arena_free(p[0]);
+  __arena_thread_exit();
+}
+
+int main(int argc, char **argv)
+{
+  rounds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 200000;
+
+  check_classes();
+  check_blocks();
+  check_threads();
+  check_fork();
+
+  printf("arena tests passed, %d threads x %lu rounds\n", THREADS, rounds);
+  return 0;
+}
@@ -0,0 +1,174 @@
+/*
+   This file is part of AlmOS.
+
+   AlmOS is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   AlmOS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AlmOS; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+   UPMC / LIP6 / SOC (c) 2008
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/utime.h>
+#include <time.h>
+#include <cpu-syscall.h>
+
+#define NSEC_PER_SEC  1000000000ULL
+
+static uint_t __utime_base;	/* 0: not probed, 1: none, else time pages address */
+
+static struct utime_page_s* __utime_header(void)
+{
+  uint64_t base;
+  struct utime_page_s *hdr;
+
+  if(__utime_base == 0)
+  {
+    base = 0;
+
+    if((int)cpu_syscall(&base, (void*)UTIME_CLOCK_PAGE, NULL, NULL, SYS_CLOCK) || (base == 0))
+      base = 1;
+
+    __utime_base = (uint_t)base;
+  }
+
+  if(__utime_base == 1)
+    return NULL;
+
+  hdr = (struct utime_page_s*)__utime_base;
+  return (hdr->signature == UTIME_SIGNATURE) ? hdr : NULL;
+}
+
+/* Read the running CPU entry without entering the kernel */
+static int __utime_read(struct utime_page_s *hdr, uint64_t *cycles, uint64_t *th_cycles)
+{
+  struct utime_cpu_s *entry;
+  uint_t gid, seq, now;
+  uint_t tls;
+
+  if(!(hdr->flags & UTIME_USR_CYCLES) || (hdr->cpu_nr == 0))
+    return -1;
+
+  tls = (uint_t)cpu_get_tls();
+
+  while(1)
+  {
+    gid   = cpu_get_cpunum();
+    entry = &utime_cluster_page(__utime_base, gid / hdr->cpu_nr)->cpu_tbl[gid % hdr->cpu_nr];
+    seq   = entry->seq;
+
+    /* Owner CPU is updating the entry */
+    if(seq & 1)
+      continue;
+
+    cpu_rdbarrier();
+    now     = cpu_get_count();
+    *cycles = ((((uint64_t)entry->cycles_hi) << 32) | entry->cycles_lo) + (now - entry->tmstmp);
+
+    if(th_cycles != NULL)
+    {
+      if(!(hdr->flags & UTIME_THREAD_TIME) || (entry->th_tls != tls))
+	return -1;
+
+      *th_cycles = entry->th_cputime + (now - entry->th_stamp);
+    }
+
+    cpu_rdbarrier();
+
+    /* Retry if the entry changed or we migrated meanwhile */
+    if((entry->seq == seq) && (cpu_get_cpunum() == gid))
+      break;
+  }
+
+  return 0;
+}
+
+static void __cycles2ts(uint64_t cycles, uint_t cycles_per_sec, struct timespec *tp)
+{
+  tp->tv_sec  = cycles / cycles_per_sec;
+  tp->tv_nsec = ((cycles % cycles_per_sec) * NSEC_PER_SEC) / cycles_per_sec;
+}
+
+int clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+  struct utime_page_s *hdr;
+  uint64_t cycles;
+  uint64_t th_cycles;
+  uint_t id;
+
+  if(tp == NULL)
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  switch(clk_id)
+  {
+  case CLOCK_REALTIME:
+  case CLOCK_MONOTONIC:
+    id = UTIME_CLOCK_CYCLES;
+    break;
+  case CLOCK_THREAD_CPUTIME_ID:
+    id = UTIME_CLOCK_THREAD;
+    break;
+  default:
+    errno = EINVAL;
+    return -1;
+  }
+
+  hdr = __utime_header();
+
+  if((hdr != NULL) &&
+     (__utime_read(hdr, &cycles, (id == UTIME_CLOCK_THREAD) ? &th_cycles : NULL) == 0))
+  {
+    if(id == UTIME_CLOCK_THREAD)
+      cycles = th_cycles;
+  }
+  else
+  {
+    if((int)cpu_syscall(&cycles, (void*)id, NULL, NULL, SYS_CLOCK))
+      return -1;
+  }
+
+  __cycles2ts(cycles, (hdr != NULL) ? hdr->cycles_per_sec : CLOCKS_PER_SEC, tp);
+
+  if((clk_id == CLOCK_REALTIME) && (hdr != NULL))
+    tp->tv_sec += hdr->epoch_sec;
+
+  return 0;
+}
+
+int clock_getres(clockid_t clk_id, struct timespec *res)
+{
+  struct utime_page_s *hdr;
+  uint_t cycles_per_sec;
+
+  if((clk_id != CLOCK_REALTIME) &&
+     (clk_id != CLOCK_MONOTONIC) &&
+     (clk_id != CLOCK_THREAD_CPUTIME_ID))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  if(res == NULL)
+    return 0;
+
+  hdr            = __utime_header();
+  cycles_per_sec = (hdr != NULL) ? hdr->cycles_per_sec : CLOCKS_PER_SEC;
+  res->tv_sec    = 0;
+  res->tv_nsec   = (NSEC_PER_SEC + cycles_per_sec - 1) / cycles_per_sec;
+  return 0;
+}
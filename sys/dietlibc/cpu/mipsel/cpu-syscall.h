@@ -37,6 +37,34 @@ static inline void* cpu_get_tls(void)
   return (void*) ptr;
 }
 
+/* Needs HWREna set by the kernel (UTIME_USR_CYCLES) */
+static inline uint_t cpu_get_cpunum(void)
+{
+  register unsigned long num;
+  asm volatile (".set push          \n"
+		".set mips32r2      \n"
+		"rdhwr   %0,  $0    \n"
+		".set pop           \n"
+		:"=r" (num));
+  return num & 0x1FF;
+}
+
+static inline uint_t cpu_get_count(void)
+{
+  register unsigned long count;
+  asm volatile (".set push          \n"
+		".set mips32r2      \n"
+		"rdhwr   %0,  $2    \n"
+		".set pop           \n"
+		:"=r" (count));
+  return count;
+}
+
+static inline void cpu_rdbarrier(void)
+{
+  asm volatile ("sync" ::: "memory");
+}
+
 static inline void cpu_invalid_dcache_line(void *ptr)
 {
   __asm__ volatile
@@ -77,6 +77,13 @@
 /* do you want support for matherr? */
 //#define WANT_MATHERR
 
+/* do you want memcpy(3) to use the DMA engine for big copies by default?
+ * Copies of at least __memcpy_dma_threshold bytes go to dma_memcpy(), the
+ * threshold is 0 (never) unless this is set, and can be changed at run
+ * time.  The kernel copies page by page, checking both buffers first. */
+//#define WANT_DMA_MEMCPY
+#define DMA_MEMCPY_THRESHOLD 65536
+
 /* do you want crypt(3) to use MD5 if the salt starts with "$1$"? */
 #define WANT_CRYPT_MD5
 
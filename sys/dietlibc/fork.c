@@ -20,14 +20,18 @@
 */
 
 #include <errno.h>
+#include <string.h>
 #include <sys/syscall.h>
 #include <cpu-syscall.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "malloc_arena.h"
 
 pid_t fork(void)
 {
   pid_t pid;
+  void *cache;
+  struct __pthread_rdlock_s rdlocks[__PT_RDLOCKS_MAX];
   struct __pthread_tls_s *tls;
 
   tls = cpu_get_tls();
@@ -37,7 +41,15 @@ pid_t fork(void)
 			    NULL,NULL,SYS_FORK);
 
   if(pid == 0)
+  {
+	  /* Small blocks cache of the parent thread, lost by the TLS reset,
+	   * and its read locks, still held in the copied rwlocks */
+	  cache = (void*)__pthread_tls_get(tls,__PT_TLS_LOCAL_HEAP);
+	  memcpy(rdlocks, tls->rdlocks, sizeof(rdlocks));
 	  __pthread_tls_init(tls);
+	  memcpy(tls->rdlocks, rdlocks, sizeof(rdlocks));
+	  __arena_fork_child(cache);
+  }
  
   return pid;
 }
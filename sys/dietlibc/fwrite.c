@@ -2,6 +2,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/uio.h>
 
 size_t fwrite_unlocked(const void *ptr, size_t size, size_t nmemb, FILE *stream) {
   ssize_t res;
@@ -20,11 +21,31 @@ kaputt:
   if (!nmemb || len/nmemb!=size) return 0; /* check for integer overflow */
   
   if (len>stream->buflen || (stream->flags&NOBUF)) {
-    if (fflush_unlocked(stream)) return 0;
-    i=2;
-    do {
-      res= write(stream->fd,ptr,len);
-    } while ((res==-1) && (i--));// && errno==EINTR);
+    if (stream->bm) {
+      /* flush pending bytes and the new data in a single request */
+      struct iovec iov[2];
+      iov[0].iov_base=stream->buf;
+      iov[0].iov_len=stream->bm;
+      iov[1].iov_base=(void*)ptr;
+      iov[1].iov_len=len;
+      res=writev(stream->fd,iov,2);
+      if (res<(ssize_t)iov[0].iov_len) {
+	/* keep only the pending bytes which were not written */
+	if (res>0) {
+	  memmove(stream->buf,stream->buf+res,stream->bm-res);
+	  stream->bm-=res;
+	}
+	stream->flags|=ERRORINDICATOR;
+	return 0;
+      }
+      stream->bm=0;
+      res-=iov[0].iov_len;
+    } else {
+      i=2;
+      do {
+	res= write(stream->fd,ptr,len);
+      } while ((res==-1) && (i--));// && errno==EINTR);
+    }
   } else {
     /* try to make the common case fast */
     size_t todo=stream->buflen-stream->bm;
@@ -26,8 +26,23 @@
 
 int gettimeofday(struct timeval *tv, struct timezone *tz)
 {
-  tv->tv_sec = clock();
-  tv->tv_usec = 0;
+  struct timespec ts;
+
+  if(clock_gettime(CLOCK_REALTIME, &ts))
+    return -1;
+
+  if(tv != NULL)
+  {
+    tv->tv_sec  = ts.tv_sec;
+    tv->tv_usec = ts.tv_nsec / 1000;
+  }
+
+  if(tz != NULL)
+  {
+    tz->tz_minuteswest = 0;
+    tz->tz_dsttime     = 0;
+  }
+
   return 0;
 }
 
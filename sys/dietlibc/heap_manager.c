@@ -28,6 +28,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
+#include "malloc_arena.h"
 
 #ifndef CONFIG_LIBC_MALLOC_DEBUG
 #define CONFIG_LIBC_MALLOC_DEBUG  0
@@ -106,7 +107,19 @@ void __heap_manager_init(void)
 
 void* do_malloc(size_t, int);
 
+static void* heap_malloc(size_t size);
+
 void* malloc(size_t size)
+{
+	void *ptr;
+
+	if((size <= ARENA_MAX_SIZE) && ((ptr = __arena_malloc(size)) != NULL))
+		return ptr;
+
+	return heap_malloc(size);
+}
+
+static void* heap_malloc(size_t size)
 {
 	block_info_t *info;
 	void *ptr;
@@ -292,6 +305,12 @@ void free(void *ptr)
 
 	if(ptr == NULL)
 		return;
+
+	if(__arena_owns(ptr))
+	{
+		__arena_free(ptr);
+		return;
+	}
 	
 	current = (block_info_t*) ((char*)ptr - sizeof(*current));
 	current = (current->ptr != NULL) ? current->ptr : current;
@@ -333,6 +352,22 @@ void* realloc(void *ptr, size_t size)
 		return NULL;
 	}
 
+	/* Small blocks keep their size class */
+	if(__arena_owns(ptr))
+	{
+		old_size = __arena_size(ptr);
+
+		if(size <= old_size)
+			return ptr;
+
+		if((new_zone = malloc(size)) == NULL)
+			return NULL;
+
+		memcpy(new_zone, ptr, old_size);
+		free(ptr);
+		return new_zone;
+	}
+
 	/* Try to reuse cache lines */
 	info = (block_info_t*)((char*)ptr - sizeof(*info));
 	old_size = info->size; 
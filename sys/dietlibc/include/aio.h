@@ -0,0 +1,63 @@
+/*
+   This file is part of MutekP.
+  
+   MutekP is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+  
+   MutekP is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+  
+   You should have received a copy of the GNU General Public License
+   along with MutekP; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+  
+   UPMC / LIP6 / SOC (c) 2008
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+#ifndef _AIO_H_
+#define _AIO_H_
+
+#include <sys/types.h>
+#include <time.h>
+
+/* Must be kept in sync with the kernel struct vfs_aiocb_s */
+struct aiocb
+{
+  int aio_fildes;
+  int aio_lio_opcode;
+  int aio_reqprio;
+  off_t aio_offset;
+  volatile void *aio_buf;
+  size_t aio_nbytes;
+  volatile int __error;
+  ssize_t __return;
+};
+
+#define LIO_READ          0
+#define LIO_WRITE         1
+
+#define AIO_CANCELED      0
+#define AIO_NOTCANCELED   1
+#define AIO_ALLDONE       2
+
+#define AIO_LISTIO_MAX    16	/* VFS_AIO_MAX, also max pending requests per thread */
+
+/* Requests belong to the submitting thread, which must poll or wait for them */
+int aio_read(struct aiocb *aiocbp);
+int aio_write(struct aiocb *aiocbp);
+int aio_error(const struct aiocb *aiocbp);
+ssize_t aio_return(struct aiocb *aiocbp);
+int aio_cancel(int fd, struct aiocb *aiocbp);
+
+/* A zero timeout only polls, any other timeout waits without limit */
+int aio_suspend(const struct aiocb * const list[], int nent, const struct timespec *timeout);
+
+/* Wait until at least min requests of list are completed, returns their number */
+int aio_waitn(struct aiocb * const list[], int nent, int min);
+
+#endif	/* _AIO_H_ */
@@ -88,4 +88,10 @@ int ffsl(long i);
 int ffsll(long long i);
 #endif
 
+/* ALMOS: copy by the DMA engine, returns dst or NULL on failure */
+void *dma_memcpy(void *src, void *dst, unsigned int size);
+
+/* memcpy() hands copies of at least this many bytes to dma_memcpy(), 0 (default) disables it */
+extern size_t __memcpy_dma_threshold;
+
 #endif
@@ -19,6 +19,8 @@
 #define MAP_LOCKED	0x0010		/* pages are locked */
 #define MAP_HUGETLB     0x0020		/* Allocate the mapping using "huge pages." */
 #define MAP_FIXED	0x0040		/* Interpret addr exactly */
+#define MAP_INTERLEAVE	0x2000		/* interleave the pages over all clusters */
+#define MAP_LOCAL	0x4000		/* place each page on the cluster touching it first */
 #define MAP_DENYWRITE	0x200000	/* ETXTBSY */
 #define MAP_EXECUTABLE	0x400000	/* mark it as an executable */
 #define MAP_32BIT       0x800000	/* Put the mapping into the first 2 Gigabytes of the process address space. */
@@ -38,6 +40,23 @@
 #define MADV_WILLNEED	0x3		/* pre-fault pages */
 #define MADV_DONTNEED	0x4		/* discard these pages */
 #define MADV_MIGRATE    0x5		/* migrate page on next-touch */
+#define MADV_MPOL       0x6		/* set memory policy, used by mbind */
+
+/* Memory policies used by mbind */
+#define MPOL_DEFAULT	0		/* thread placement attributes */
+#define MPOL_LOCAL	1		/* cluster of the faulting thread */
+#define MPOL_PREFERRED	2		/* first cluster of the mask, others when it is full */
+#define MPOL_BIND	3		/* only the clusters of the mask */
+#define MPOL_INTERLEAVE	4		/* clusters of the mask, round-robin on page number */
+
+#define MPOL_CLUSTERS_MAX 256		/* size in bits of the mbind cluster mask */
+
+/* Public structure used by mbind */
+typedef struct
+{
+  uint_t mode;
+  uint_t mask[MPOL_CLUSTERS_MAX / (8 * sizeof(uint_t))];
+} mpol_attr_t;
 
 /* compatibility flags */
 #define MAP_ANON	MAP_ANONYMOUS
@@ -66,7 +85,10 @@ typedef struct
 /* Commands used by mcntl */
 #define MCNTL_READ           0x0
 #define MCNTL_L1_iFLUSH      0x1
-#define MCNTL_MOVE           0x2 /* this operation is not implemented in this version */
+#define MCNTL_MOVE           0x2
+
+/* mi_cid of a page which is not backed by physical memory */
+#define MCNTL_CID_NONE       ((uint_t)-1)
 
 /**
  * Control of process virtual address & core caches
@@ -74,13 +96,16 @@ typedef struct
  * @op       : (in) one of MCNTL_XXX operations
  * @addr     : (in) virtual address (will be arround to page base address)
  * @len      : (in) number of pages 
- * @info     : (in/out) addr related info
+ * @info     : (in/out) array of len entries, info[i] is related to page addr + i * PAGE_SIZE
  * 
  * @return   : 0 if OK
  *
  * Rationale: 
- *   MCNTL_READ    : fills info structre and doesn't need len parameter.
- *   MCNTL_MOVE    : uses info structre as input parameter and must be initialized correctly.
+ *   MCNTL_READ    : fills info[i] with the cluster holding page i, mi_cid is MCNTL_CID_NONE
+ *                   for unbacked pages; a single page query (len 0 or 1) fails on such a page.
+ *   MCNTL_MOVE    : moves page i to cluster info[i].mi_cid then fills info[i] as MCNTL_READ,
+ *                   pages which could not be moved (shared, page-cache, unbacked) are
+ *                   reported where they are.
  **/
 extern int mcntl(int op, void *vaddr, size_t len, minfo_t *info);
 
@@ -91,6 +116,20 @@ int munlockall(void);
 
 int madvise(void *start, size_t length, int advice);
 
+/**
+ * Sets the memory policy of the region holding start, the policy
+ * applies to the whole region and to its pages allocated afterwards
+ *
+ * @start      : (in) page aligned address in the region
+ * @len        : (in) length, the range must lie in the region
+ * @mode       : (in) one of MPOL_XXX policies
+ * @mask       : (in) bitmap of cluster ids, NULL for all clusters
+ * @maxcluster : (in) number of bits in mask
+ *
+ * @return     : 0 if OK
+ **/
+int mbind(void *start, size_t len, int mode, const uint_t *mask, size_t maxcluster);
+
 #define _POSIX_MAPPED_FILES
 
 #endif
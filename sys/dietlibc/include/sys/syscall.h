@@ -69,6 +69,12 @@ enum
    SYS_STAT,
    SYS_MIGRATE,
    SYS_SBRK,
+   SYS_READV,
+   SYS_WRITEV,
+   SYS_PREAD,
+   SYS_PWRITE,
+   SYS_SYSRING,
+   SYS_AIO,
    __SYS_CALL_SERVICES_NUM,
 };
 
@@ -0,0 +1,84 @@
+/*
+   This file is part of AlmOS.
+
+   AlmOS is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   AlmOS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AlmOS; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+   UPMC / LIP6 / SOC (c) 2007
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+
+#ifndef _SYS_SYSRING_H_
+#define _SYS_SYSRING_H_
+
+#include <sys/types.h>
+
+/* User view of the batched system calls ring, must be kept in sync with kern/sysring.h */
+
+#define SYSRING_SIGNATURE    0x474E5253
+#define SYSRING_MAX_ENTRIES  256
+
+#define SYSRING_SETUP        1
+#define SYSRING_ENTER        2
+#define SYSRING_DESTROY      3
+
+struct sysring_sqe_s
+{
+  uint_t service;
+  uint_t args[4];
+  uint_t user_data;
+};
+
+struct sysring_cqe_s
+{
+  sint_t retval;
+  uint_t errno;
+  uint_t user_data;
+  uint_t reserved;
+};
+
+struct sysring_s
+{
+  uint_t signature;
+  uint_t entries_nr;
+  volatile uint_t sq_head;
+  volatile uint_t sq_tail;
+  volatile uint_t cq_head;
+  volatile uint_t cq_tail;
+  uint_t reserved[2];
+};
+
+#define sysring_sq(_ring)      ((struct sysring_sqe_s*)((struct sysring_s*)(_ring) + 1))
+#define sysring_cq(_ring,_nr)  ((struct sysring_cqe_s*)(sysring_sq(_ring) + (_nr)))
+#define sysring_size(_nr)  (sizeof(struct sysring_s) +			\
+			    ((_nr) * (sizeof(struct sysring_sqe_s) + sizeof(struct sysring_cqe_s))))
+
+/* Register ring (of sysring_size(entries_nr) bytes) with calling thread */
+int sysring_setup(struct sysring_s *ring, uint_t entries_nr);
+
+/* Queue a service, returns -1 with errno EAGAIN if the submission queue is full */
+int sysring_submit(struct sysring_s *ring, uint_t service, void *arg0, void *arg1,
+		   void *arg2, void *arg3, uint_t user_data);
+
+/* Run up to to_submit queued services (0: all) in one kernel entry, returns their number */
+int sysring_enter(struct sysring_s *ring, uint_t to_submit);
+
+/* Pop one completion, returns 0 on success and -1 if none is available */
+int sysring_reap(struct sysring_s *ring, struct sysring_cqe_s *cqe);
+
+/* Unregister ring from calling thread */
+int sysring_destroy(struct sysring_s *ring);
+
+#endif	/* _SYS_SYSRING_H_ */
@@ -0,0 +1,69 @@
+/*
+   This file is part of AlmOS.
+
+   AlmOS is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   AlmOS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AlmOS; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+   UPMC / LIP6 / SOC (c) 2007
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+#ifndef _SYS_UTIME_H_
+#define _SYS_UTIME_H_
+
+#include <sys/types.h>
+
+/* User view of the kernel time pages, must be kept in sync with kern/utime.h */
+
+#define UTIME_SIGNATURE      0x454D4954
+#define UTIME_PAGE_SIZE      4096
+#define UTIME_CPU_MAX        4    /* CONFIG_MAX_CPU_PER_CLUSTER_NR */
+#define UTIME_LINE_SIZE      64   /* CONFIG_CACHE_LINE_SIZE */
+
+#define UTIME_USR_CYCLES     0x1
+#define UTIME_THREAD_TIME    0x2
+
+#define UTIME_CLOCK_CYCLES   0
+#define UTIME_CLOCK_THREAD   1
+#define UTIME_CLOCK_PAGE     2
+
+struct utime_cpu_s
+{
+  volatile uint_t seq;
+  uint_t tmstmp;
+  uint_t cycles_lo;
+  uint_t cycles_hi;
+  uint_t ticks_nr;
+  uint_t th_tls;
+  uint_t th_cputime;
+  uint_t th_stamp;
+}__attribute__ ((aligned (UTIME_LINE_SIZE)));
+
+struct utime_page_s
+{
+  uint_t signature;
+  uint_t flags;
+  uint_t cid;
+  uint_t cpu_nr;
+  uint_t cycles_per_sec;
+  uint_t usec_per_tick;
+  uint_t epoch_sec;
+  struct utime_cpu_s cpu_tbl[UTIME_CPU_MAX] __attribute__ ((aligned (UTIME_LINE_SIZE)));
+};
+
+/* Page of given cluster, base is the address given by UTIME_CLOCK_PAGE */
+#define utime_cluster_page(base,cid)					\
+  ((struct utime_page_s*)((uint_t)(base) + (((cid) + 1) * UTIME_PAGE_SIZE)))
+
+#endif	/* _SYS_UTIME_H_ */
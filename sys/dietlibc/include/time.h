@@ -27,6 +27,12 @@
 
 #define CLOCKS_PER_SEC 200000
 
+typedef int clockid_t;
+
+#define CLOCK_REALTIME            0
+#define CLOCK_MONOTONIC           1
+#define CLOCK_THREAD_CPUTIME_ID   3
+
 struct timespec {
   time_t tv_sec;    /* secondes */
   long   tv_nsec;   /* nanosecondes */
@@ -44,5 +50,7 @@ struct timezone {
 
 clock_t clock(void);
 int gettimeofday(struct timeval *tv, struct timezone *tz);
+int clock_gettime(clockid_t clk_id, struct timespec *tp);
+int clock_getres(clockid_t clk_id, struct timespec *res);
 
 #endif	/* _TIME_H_ */
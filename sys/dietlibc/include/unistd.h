@@ -55,12 +55,15 @@
 #define _SC_CACHE_LINE_SIZE  7
 #define _SC_HEAP_MAX_SIZE    8
 #define _SC_NCLUSTERS_ONLN   9
+#define _SC_CLUSTER_YMAX     10
 
 //#define LIBC_DEBUG
 long sysconf(int name);
 ssize_t read(int fd, void *buf, size_t count);
 ssize_t write(int fd, const void *buf, size_t count);
 off_t lseek(int fd, off_t offset, int whence);
+ssize_t pread(int fd, void *buf, size_t count, off_t offset);
+ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset);
 int unlink(const char *pathname);
 int close(int fd);
 int chdir(const char *path);
@@ -32,3 +32,27 @@ int madvise(void *start, size_t length, int advice)
 
   return (int) cpu_syscall(start, (void*)length, (void*)advice, NULL, SYS_MADVISE);
 }
+
+int mbind(void *start, size_t len, int mode, const uint_t *mask, size_t maxcluster)
+{
+  mpol_attr_t attr;
+  size_t i;
+
+  if((start == NULL) || (mode < MPOL_DEFAULT) || (mode > MPOL_INTERLEAVE))
+    return EINVAL;
+
+  attr.mode = mode;
+  maxcluster = (maxcluster > MPOL_CLUSTERS_MAX) ? MPOL_CLUSTERS_MAX : maxcluster;
+
+  for(i = 0; i < MPOL_CLUSTERS_MAX / (8 * sizeof(uint_t)); i++)
+    attr.mask[i] = (mask == NULL) ? (uint_t)-1 : 0;
+
+  if(mask != NULL)
+  {
+    for(i = 0; i < maxcluster; i++)
+      if(mask[i / (8 * sizeof(uint_t))] & (1UL << (i % (8 * sizeof(uint_t)))))
+	attr.mask[i / (8 * sizeof(uint_t))] |= (1UL << (i % (8 * sizeof(uint_t))));
+  }
+
+  return (int) cpu_syscall(start, (void*)len, (void*)MADV_MPOL, &attr, SYS_MADVISE);
+}
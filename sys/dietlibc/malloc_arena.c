@@ -0,0 +1,393 @@
+/*
+   This file is part of AlmOS.
+
+   AlmOS is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   AlmOS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AlmOS; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+   UPMC / LIP6 / SOC (c) 2009
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "malloc_arena.h"
+
+#define ARENA_NR          64        /* arenas, indexed by cluster id */
+#define ARENA_CHUNK_SIZE  0x10000   /* bytes carved by an arena at once */
+#define ARENA_BATCH       16        /* blocks moved between cache and arena */
+#define ARENA_CACHE_MAX   64        /* blocks kept by a thread cache per bin */
+#define ARENA_LINE_SIZE   64
+
+/* Platform hooks: TLS slot, cluster id and CAS */
+#ifdef _ALMOS_
+#include <cpu-syscall.h>
+
+static inline void* arena_tls_get(void)
+{
+	__pthread_tls_t *tls = cpu_get_tls();
+	return (void*)__pthread_tls_get(tls, __PT_TLS_LOCAL_HEAP);
+}
+
+static inline void arena_tls_set(void *val)
+{
+	__pthread_tls_t *tls = cpu_get_tls();
+	__pthread_tls_set(tls, __PT_TLS_LOCAL_HEAP, val);
+}
+
+static inline uint_t arena_cluster_id(void)
+{
+	__pthread_tls_t *tls = cpu_get_tls();
+	return (uint_t)tls->attr.cid;
+}
+
+#define arena_cas(ptr,old,new)  cpu_atomic_cas((void*)(ptr), (sint_t)(old), (sint_t)(new))
+#define arena_wbflush()         cpu_wbflush()
+
+#else  /* Host build of the allocator core, for testing */
+typedef unsigned int uint_t;
+
+static __thread void *arena_tls;
+static unsigned int arena_host_threads;
+
+static inline void* arena_tls_get(void)     { return arena_tls; }
+static inline void arena_tls_set(void *val) { arena_tls = val; }
+
+/* Spread host threads over 4 fake clusters to exercise remote frees */
+static inline uint_t arena_cluster_id(void)
+{
+	return __sync_fetch_and_add(&arena_host_threads, 1) % 4;
+}
+
+#define arena_cas(ptr,old,new)  __sync_bool_compare_and_swap((ptr), (old), (new))
+#define arena_wbflush()         __sync_synchronize()
+#endif
+
+/* Usable sizes, blocks add a two words header */
+static const unsigned short arena_class_size[] =
+{
+	16, 32, 48, 64, 80, 96, 112, 128,
+	192, 256, 384, 512, 768, 1024, 1536, ARENA_MAX_SIZE
+};
+
+#define ARENA_CLASS_NR  (sizeof(arena_class_size) / sizeof(arena_class_size[0]))
+
+struct arena_hdr_s
+{
+	size_t size;
+	uintptr_t chunk;		/* chunk address | ARENA_TAG */
+};
+
+struct arena_chunk_s
+{
+	struct arena_s *arena;
+	uint_t cls;
+};
+
+struct arena_remote_s
+{
+	void * volatile head;
+} __attribute__ ((aligned (ARENA_LINE_SIZE)));
+
+struct arena_bin_s
+{
+	void *head;
+	uint_t count;
+	char *bump;			/* carving position in current chunk */
+	char *bump_end;
+};
+
+struct arena_s
+{
+	pthread_spinlock_t lock;
+	struct arena_bin_s bins[ARENA_CLASS_NR];
+	struct arena_remote_s remote[ARENA_CLASS_NR];
+};
+
+struct arena_tcache_s
+{
+	struct arena_s *arena;
+	struct arena_bin_s bins[ARENA_CLASS_NR];
+};
+
+static struct arena_s * volatile arena_tbl[ARENA_NR];
+
+static inline uint_t arena_size2class(size_t size)
+{
+	uint_t cls;
+
+	if(size <= 128)
+		return (size == 0) ? 0 : (size - 1) >> 4;
+
+	for(cls = 8; arena_class_size[cls] < size; cls++);
+
+	return cls;
+}
+
+static inline size_t arena_block_size(uint_t cls)
+{
+	return arena_class_size[cls] + sizeof(struct arena_hdr_s);
+}
+
+static void* arena_mmap(size_t size)
+{
+	void *ptr;
+
+	ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return ((ptr == MAP_FAILED) || (ptr == NULL)) ? NULL : ptr;
+}
+
+static struct arena_s* arena_get(uint_t cid)
+{
+	struct arena_s *arena;
+	uint_t cls;
+
+	cid  %= ARENA_NR;
+	arena = arena_tbl[cid];
+
+	if(arena != NULL)
+		return arena;
+
+	if((arena = arena_mmap(sizeof(*arena))) == NULL)
+		return NULL;
+
+	pthread_spin_init(&arena->lock, 0);
+
+	for(cls = 0; cls < ARENA_CLASS_NR; cls++)
+	{
+		arena->bins[cls].head     = NULL;
+		arena->bins[cls].count    = 0;
+		arena->bins[cls].bump     = NULL;
+		arena->bins[cls].bump_end = NULL;
+		arena->remote[cls].head   = NULL;
+	}
+
+	arena_wbflush();
+
+	/* Lost the race, the arena memory is kept unused */
+	if(!arena_cas(&arena_tbl[cid], NULL, arena))
+		return arena_tbl[cid];
+
+	return arena;
+}
+
+static struct arena_tcache_s* arena_tcache(void)
+{
+	struct arena_tcache_s *tcache;
+	struct arena_s *arena;
+
+	tcache = arena_tls_get();
+
+	if(tcache != NULL)
+		return tcache;
+
+	if((arena = arena_get(arena_cluster_id())) == NULL)
+		return NULL;
+
+	/* mmap'ed memory is zeroed */
+	if((tcache = arena_mmap(sizeof(*tcache))) == NULL)
+		return NULL;
+
+	tcache->arena = arena;
+	arena_tls_set(tcache);
+	return tcache;
+}
+
+/* Moves up to ARENA_BATCH blocks of class cls into bin, arena locked */
+static void arena_refill(struct arena_s *arena, uint_t cls, struct arena_bin_s *bin)
+{
+	struct arena_bin_s *abin;
+	struct arena_chunk_s *chunk;
+	struct arena_hdr_s *hdr;
+	void *list;
+	void *last;
+	size_t blksz;
+
+	abin = &arena->bins[cls];
+
+	/* Take back remote frees at once */
+	if(arena->remote[cls].head != NULL)
+	{
+		do
+		{
+			list = arena->remote[cls].head;
+		}while(!arena_cas(&arena->remote[cls].head, list, NULL));
+
+		for(last = list; *(void**)last != NULL; last = *(void**)last)
+			abin->count ++;
+
+		abin->count ++;
+		*(void**)last = abin->head;
+		abin->head    = list;
+	}
+
+	while((bin->count < ARENA_BATCH) && (abin->head != NULL))
+	{
+		list          = abin->head;
+		abin->head    = *(void**)list;
+		abin->count --;
+		*(void**)list = bin->head;
+		bin->head     = list;
+		bin->count ++;
+	}
+
+	blksz = arena_block_size(cls);
+
+	while(bin->count < ARENA_BATCH)
+	{
+		if((size_t)(abin->bump_end - abin->bump) < blksz)
+		{
+			if((chunk = arena_mmap(ARENA_CHUNK_SIZE)) == NULL)
+				return;
+
+			chunk->arena   = arena;
+			chunk->cls     = cls;
+			abin->bump     = (char*)(chunk + 1);
+			abin->bump_end = (char*)chunk + ARENA_CHUNK_SIZE;
+		}
+
+		chunk      = (struct arena_chunk_s*)((uintptr_t)abin->bump_end - ARENA_CHUNK_SIZE);
+		hdr        = (struct arena_hdr_s*)abin->bump;
+		hdr->size  = arena_class_size[cls];
+		hdr->chunk = (uintptr_t)chunk | ARENA_TAG;
+		abin->bump += blksz;
+
+		*(void**)(hdr + 1) = bin->head;
+		bin->head = hdr + 1;
+		bin->count ++;
+	}
+}
+
+/* Gives count blocks of bin back to the arena */
+static void arena_flush(struct arena_s *arena, uint_t cls, struct arena_bin_s *bin, uint_t count)
+{
+	struct arena_bin_s *abin;
+	void *ptr;
+
+	abin = &arena->bins[cls];
+
+	pthread_spin_lock(&arena->lock);
+
+	while(count-- && (bin->head != NULL))
+	{
+		ptr          = bin->head;
+		bin->head    = *(void**)ptr;
+		bin->count --;
+		*(void**)ptr = abin->head;
+		abin->head   = ptr;
+		abin->count ++;
+	}
+
+	pthread_spin_unlock(&arena->lock);
+}
+
+void* __arena_malloc(size_t size)
+{
+	struct arena_tcache_s *tcache;
+	struct arena_bin_s *bin;
+	void *ptr;
+	uint_t cls;
+
+	if(size > ARENA_MAX_SIZE)
+		return NULL;
+
+	if((tcache = arena_tcache()) == NULL)
+		return NULL;
+
+	cls = arena_size2class(size);
+	bin = &tcache->bins[cls];
+
+	if(bin->head == NULL)
+	{
+		pthread_spin_lock(&tcache->arena->lock);
+		arena_refill(tcache->arena, cls, bin);
+		pthread_spin_unlock(&tcache->arena->lock);
+
+		if(bin->head == NULL)
+			return NULL;
+	}
+
+	ptr       = bin->head;
+	bin->head = *(void**)ptr;
+	bin->count --;
+	return ptr;
+}
+
+void __arena_free(void *ptr)
+{
+	struct arena_tcache_s *tcache;
+	struct arena_chunk_s *chunk;
+	struct arena_remote_s *remote;
+	struct arena_bin_s *bin;
+	void *head;
+
+	chunk  = (struct arena_chunk_s*)(((struct arena_hdr_s*)ptr - 1)->chunk & ~ARENA_TAG);
+	tcache = arena_tcache();
+
+	if((tcache == NULL) || (tcache->arena != chunk->arena))
+	{
+		remote = &chunk->arena->remote[chunk->cls];
+
+		do
+		{
+			head         = remote->head;
+			*(void**)ptr = head;
+		}while(!arena_cas(&remote->head, head, ptr));
+
+		return;
+	}
+
+	bin          = &tcache->bins[chunk->cls];
+	*(void**)ptr = bin->head;
+	bin->head    = ptr;
+	bin->count ++;
+
+	if(bin->count > ARENA_CACHE_MAX)
+		arena_flush(tcache->arena, chunk->cls, bin, ARENA_BATCH);
+}
+
+void __arena_thread_exit(void)
+{
+	struct arena_tcache_s *tcache;
+	uint_t cls;
+
+	if((tcache = arena_tls_get()) == NULL)
+		return;
+
+	for(cls = 0; cls < ARENA_CLASS_NR; cls++)
+		arena_flush(tcache->arena, cls, &tcache->bins[cls], tcache->bins[cls].count);
+
+	arena_tls_set(NULL);
+	munmap(tcache, sizeof(*tcache));
+}
+
+void __arena_fork_child(void *cache)
+{
+	uint_t cid;
+
+	/* Other threads of the parent may have held them at fork time */
+	for(cid = 0; cid < ARENA_NR; cid++)
+	{
+		if(arena_tbl[cid] != NULL)
+			pthread_spin_init(&arena_tbl[cid]->lock, 0);
+	}
+
+	if(cache == NULL)
+		return;
+
+	arena_tls_set(cache);
+	__arena_thread_exit();
+}
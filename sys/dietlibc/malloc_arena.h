@@ -0,0 +1,64 @@
+/*
+   This file is part of AlmOS.
+
+   AlmOS is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   AlmOS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AlmOS; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+   UPMC / LIP6 / SOC (c) 2009
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+#ifndef _MALLOC_ARENA_H_
+#define _MALLOC_ARENA_H_
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/*
+ * Small blocks allocator sitting in front of the heap manager.
+ *
+ * Blocks up to ARENA_MAX_SIZE bytes are served from per-thread caches
+ * of size-class bins, refilled from the arena of the thread's cluster.
+ * Arenas carve mmap'ed chunks, which are first touched, and thus backed,
+ * in their cluster. A block freed by a thread of another cluster goes
+ * back to its arena through a lock-free remote list.
+ *
+ * Like heap blocks, a small block is preceded by two words: its usable
+ * size, then its chunk address tagged with ARENA_TAG. Heap headers
+ * hold an aligned pointer or NULL there, which tells both apart.
+ */
+
+#define ARENA_MAX_SIZE    2048
+#define ARENA_TAG         0x1
+
+#define __arena_owns(ptr)      (((uintptr_t*)(ptr))[-1] & ARENA_TAG)
+#define __arena_size(ptr)      (((size_t*)(ptr))[-2])
+
+/** Returns NULL if size is too big or no arena can be used */
+void* __arena_malloc(size_t size);
+
+/** Frees a block for which __arena_owns() is true */
+void __arena_free(void *ptr);
+
+/** Gives the calling thread's cached blocks back to its arena */
+void __arena_thread_exit(void);
+
+/**
+ * Called in a forked child, the calling thread being the only one
+ * left, with the cache it had in the parent (its TLS has been reset).
+ * The arenas locks are reset and the cached blocks given back.
+ */
+void __arena_fork_child(void *cache);
+
+#endif	/* _MALLOC_ARENA_H_ */
@@ -2,10 +2,32 @@
 #include "dietfeatures.h"
 #include "dietstring.h"
 
+/* non-zero if one byte of x is zero */
+#define HASZERO(x) (((x) - MKW(0x1ul)) & ~(x) & MKW(0x80ul))
+
 void* memchr(const void *s, int c, size_t n) {
   const unsigned char *pc = (unsigned char *) s;
+#ifndef WANT_SMALL_STRING_ROUTINES
+  const unsigned long *lx;
+  unsigned long mask, l;
+
+  for (; n && ((unsigned long) pc & (sizeof(l)-1)); n--, pc++)
+    if (*pc == (unsigned char) c)
+      return ((void *) pc);
+
+  mask = MKW(0x1ul) * (unsigned char) c;
+
+  /* aligned word loads never cross the end page of the buffer */
+  for (lx = (const unsigned long *) pc; n >= sizeof(l); n -= sizeof(l), lx++) {
+    l = *lx ^ mask;
+    if (HASZERO(l))
+      break;
+  }
+
+  pc = (const unsigned char *) lx;
+#endif
   for (;n--;pc++)
-    if (*pc == c)
+    if (*pc == (unsigned char) c)
       return ((void *) pc);
   return 0;
 }
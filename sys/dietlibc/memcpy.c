@@ -4,6 +4,21 @@
 #include "dietfeatures.h"
 #include "dietstring.h"
 
+#ifdef WANT_DMA_MEMCPY
+size_t __memcpy_dma_threshold = DMA_MEMCPY_THRESHOLD;
+#else
+size_t __memcpy_dma_threshold = 0;
+#endif
+
+#define WSIZE  sizeof(unsigned long)
+
+/* Builds a destination word from two aligned source words, off in bits */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+# define MERGEW(w0,w1,off) (((w0) >> (off)) | ((w1) << (WSIZE * 8 - (off))))
+#else
+# define MERGEW(w0,w1,off) (((w0) << (off)) | ((w1) >> (WSIZE * 8 - (off))))
+#endif
+
 void *
 memcpy (void *dst, const void *src, size_t n)
 {
@@ -15,37 +30,74 @@ memcpy (void *dst, const void *src, size_t n)
     while (n--) *c1++ = *c2++;
     return (res);
 #else
-    int             tmp;
-    unsigned long  *lx1 = NULL;
-    const unsigned long *lx2 = NULL;
-
-    if (!UNALIGNED(dst, src) && n > sizeof(unsigned long)) {
-
-	if ((tmp = STRALIGN(dst))) {
-	    c1 = (unsigned char *) dst;
-	    c2 = (unsigned char *) src;
-	    while (tmp-- && n--)
-		*c1++ = *c2++;
-	    if (n == (size_t) - 1)
-		return (res);
-	    dst = c1;
-	    src = c2;
-	}
+    unsigned long  *lx1;
+    const unsigned long *lx2;
+    unsigned long   w0, w1;
+    unsigned int    off;
+    size_t          words;
 
-	lx1 = (unsigned long *) dst;
-	lx2 = (unsigned long *) src;
+    /* falls back to the CPU if the DMA engine refuses the request */
+    if (__memcpy_dma_threshold && n >= __memcpy_dma_threshold &&
+	dma_memcpy((void *) src, dst, n) != NULL)
+	return (res);
 
-	for (; n >= sizeof(unsigned long); n -= sizeof(unsigned long))
-	    *lx1++ = *lx2++;
-    }
+    c1 = (unsigned char *) dst;
+    c2 = (unsigned char *) src;
 
-    if (n) {
-	c1 = (unsigned char *) (lx1?lx1:dst);
-	c2 = (unsigned char *) (lx1?lx2:src);
-	while (n--)
+    if (n >= 2 * WSIZE) {
+	/* align the destination, stores are the costly side */
+	while ((unsigned long) c1 & (WSIZE - 1)) {
 	    *c1++ = *c2++;
+	    n--;
+	}
+
+	lx1 = (unsigned long *) c1;
+	off = (unsigned long) c2 & (WSIZE - 1);
+	words = n / WSIZE;
+
+	if (!off) {
+	    lx2 = (const unsigned long *) c2;
+
+	    for (; words >= 4; words -= 4) {
+		lx1[0] = lx2[0];
+		lx1[1] = lx2[1];
+		lx1[2] = lx2[2];
+		lx1[3] = lx2[3];
+		lx1 += 4;
+		lx2 += 4;
+	    }
+
+	    while (words--)
+		*lx1++ = *lx2++;
+	} else {
+	    /* only aligned words are read, none crosses the source end page */
+	    lx2 = (const unsigned long *) (c2 - off);
+	    off *= 8;
+	    w0 = *lx2++;
+
+	    for (; words >= 2; words -= 2) {
+		w1 = lx2[0];
+		lx1[0] = MERGEW(w0, w1, off);
+		w0 = lx2[1];
+		lx1[1] = MERGEW(w1, w0, off);
+		lx1 += 2;
+		lx2 += 2;
+	    }
+
+	    if (words) {
+		w1 = *lx2;
+		*lx1++ = MERGEW(w0, w1, off);
+	    }
+	}
+
+	n &= WSIZE - 1;
+	c2 += (unsigned char *) lx1 - c1;
+	c1 = (unsigned char *) lx1;
     }
 
+    while (n--)
+	*c1++ = *c2++;
+
     return (res);
 #endif
 }
@@ -21,32 +21,43 @@
 
 #include <string.h>
 
-void *memset (void *s, int c, unsigned int size)
+void *memset (void *s, int c, size_t size)
 {
-  register char *ptr = s;
-  register unsigned int *iptr;
-  register unsigned int val;
-  register unsigned int isize;
-  register unsigned int iamount;
+  register unsigned char *ptr = s;
+  register unsigned long *iptr;
+  register unsigned long val;
+  register size_t isize;
 
-  while(((uint32_t) ptr & 0x3) && size && size--)
-    *(ptr++) = (char) c;
+  while(((unsigned long) ptr & (sizeof(val) - 1)) && size)
+  {
+    *(ptr++) = (unsigned char) c;
+    size--;
+  }
 
   if(!size) return s;
 
-  val = c << 24 | c << 16 | c << 8 | (c & 0xFF); 
-  isize = size >> 2;
-  iamount = isize << 2;
-  iptr = (unsigned int*) ptr;
-  
+  val   = (unsigned char) c;
+  val  |= val << 8;
+  val  |= val << 16;
+  if(sizeof(val) > 4) val |= (val << 16) << 16;
+
+  isize = size / sizeof(val);
+  size -= isize * sizeof(val);
+  iptr  = (unsigned long*) ptr;
+
+  for(; isize >= 8; isize -= 8, iptr += 8)
+  {
+    iptr[0] = val; iptr[1] = val; iptr[2] = val; iptr[3] = val;
+    iptr[4] = val; iptr[5] = val; iptr[6] = val; iptr[7] = val;
+  }
+
   while(isize--)
     *(iptr++) = val;
- 
-  size = size - iamount;
-  ptr = (char*) iptr;
-  
+
+  ptr = (unsigned char*) iptr;
+
   while(size--)
-    *(ptr++) = (char) c;
+    *(ptr++) = (unsigned char) c;
 
   return s;
 }
@@ -0,0 +1,321 @@
+/*
+   Host test of the word-at-a-time string primitives: random offsets and
+   lengths are checked against byte loops, buffers end on a PROT_NONE
+   page to catch reads past the end, then each routine is timed against
+   its byte loop.  The dietlibc sources are built under other names:
+
+     cc -O2 -o memtest memtest.c && ./memtest [rounds]
+
+   Add -m32 to check the 32 bits word code of the target.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+void *dma_memcpy(void *src, void *dst, unsigned int size);
+
+#define memcpy  diet_memcpy
+#define memset  diet_memset
+#define strlen  diet_strlen
+#define memchr  diet_memchr
+#define strcmp  diet_strcmp
+#define strcoll diet_strcoll
+#define alias(sym) deprecated	/* strcoll stays a plain declaration */
+#include "memcpy.c"
+#include "memset.c"
+#include "strlen.c"
+#include "memchr.c"
+#include "strcmp.c"
+#undef memcpy
+#undef memset
+#undef strlen
+#undef memchr
+#undef strcmp
+#undef strcoll
+#undef alias
+
+#define AREA   (64 * 1024)
+
+static unsigned char *src_area;
+static unsigned char *dst_area;
+static size_t page_size;
+static unsigned long dma_calls;
+static int dma_accept;
+
+/* Stands for the system call: counts the requests, refuses them unless told */
+void *dma_memcpy(void *src, void *dst, unsigned int size)
+{
+  unsigned char *d = dst, *s = src;
+
+  dma_calls++;
+
+  if (!dma_accept)
+    return NULL;
+
+  while (size--) *d++ = *s++;
+  return dst;
+}
+
+/* AREA bytes followed by an inaccessible page */
+static unsigned char *guarded_area(void)
+{
+  unsigned char *p;
+
+  p = mmap(NULL, AREA + page_size, PROT_READ | PROT_WRITE,
+	   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (p == MAP_FAILED) {
+    perror("mmap");
+    exit(1);
+  }
+
+  if (mprotect(p + AREA, page_size, PROT_NONE)) {
+    perror("mprotect");
+    exit(1);
+  }
+
+  return p;
+}
+
+static void fill(unsigned char *p, size_t n)
+{
+  while (n--) *p++ = (unsigned char) (rand() % 255 + 1);
+}
+
+static void fail(const char *what, size_t soff, size_t doff, size_t n)
+{
+  printf("FAILED: %s, src offset %zu, dst offset %zu, len %zu\n", what, soff, doff, n);
+  exit(1);
+}
+
+static size_t rand_len(void)
+{
+  /* mostly short lengths, where the alignment code matters */
+  switch (rand() % 4) {
+  case 0:  return rand() % 16;
+  case 1:  return rand() % 256;
+  case 2:  return rand() % 4096;
+  default: return rand() % (AREA / 2);
+  }
+}
+
+static void check_memcpy(size_t n)
+{
+  size_t soff, doff, i;
+
+  /* source ends on the guard page one time out of two */
+  soff = (rand() & 1) ? AREA - n : rand() % (AREA - n + 1);
+  doff = rand() % (AREA - n + 1);
+
+  fill(src_area + soff, n);
+  memset(dst_area, 0, AREA);
+
+  if (diet_memcpy(dst_area + doff, src_area + soff, n) != dst_area + doff)
+    fail("memcpy return", soff, doff, n);
+
+  for (i = 0; i < AREA; i++) {
+    unsigned char want = (i >= doff && i < doff + n) ? src_area[soff + i - doff] : 0;
+    if (dst_area[i] != want)
+      fail("memcpy", soff, doff, n);
+  }
+}
+
+static void check_memset(size_t n)
+{
+  size_t doff, i;
+  int c;
+
+  doff = rand() % (AREA - n + 1);
+  c = rand() & 0xff;
+  memset(dst_area, c ^ 0x5a, AREA);
+
+  if (diet_memset(dst_area + doff, c, n) != dst_area + doff)
+    fail("memset return", 0, doff, n);
+
+  for (i = 0; i < AREA; i++) {
+    unsigned char want = (i >= doff && i < doff + n) ? c : c ^ 0x5a;
+    if (dst_area[i] != want)
+      fail("memset", 0, doff, n);
+  }
+}
+
+static void check_strlen(size_t n)
+{
+  size_t soff;
+
+  /* the terminating zero is the last byte before the guard page */
+  n = (n == 0) ? 1 : n;
+  soff = AREA - n;
+  fill(src_area + soff, n);
+  src_area[AREA - 1] = 0;
+
+  if (diet_strlen((char *) src_area + soff) != n - 1)
+    fail("strlen", soff, 0, n);
+}
+
+static void check_memchr(size_t n)
+{
+  size_t soff, pos;
+  unsigned char c;
+  void *want;
+
+  soff = AREA - n;
+  fill(src_area + soff, n);
+  c = (unsigned char) (rand() | 0x80);
+
+  /* a character above 0x7f exercises the unsigned char compare */
+  pos = (n && (rand() & 1)) ? rand() % n : n;
+  if (pos < n)
+    src_area[soff + pos] = c;
+
+  want = memchr(src_area + soff, c, n);
+
+  if (diet_memchr(src_area + soff, (signed char) c, n) != want)
+    fail("memchr", soff, 0, n);
+}
+
+static int sign(int x)
+{
+  return (x > 0) - (x < 0);
+}
+
+static void check_strcmp(size_t n)
+{
+  size_t soff, doff, pos;
+
+  n = (n == 0) ? 1 : n;
+  soff = AREA - n;
+  doff = rand() % (AREA - n + 1);
+
+  fill(src_area + soff, n);
+  src_area[AREA - 1] = 0;
+  memcpy(dst_area + doff, src_area + soff, n);
+
+  /* differ at some point, possibly by a character above 0x7f */
+  if (rand() & 1) {
+    pos = rand() % n;
+    dst_area[doff + pos] = (unsigned char) (rand() & 0xff);
+  }
+
+  if (sign(diet_strcmp((char *) src_area + soff, (char *) dst_area + doff)) !=
+      sign(strcmp((char *) src_area + soff, (char *) dst_area + doff)))
+    fail("strcmp", soff, doff, n);
+}
+
+static void check_dma(void)
+{
+  size_t n = 2 * page_size + 3;
+
+  fill(src_area, AREA);
+
+  /* off by default */
+  dma_calls = 0;
+  diet_memcpy(dst_area + 1, src_area, n);
+  if (dma_calls != 0 || memcmp(dst_area + 1, src_area, n))
+    fail("dma disabled", 0, 1, n);
+
+  /* refused requests fall back to the CPU */
+  __memcpy_dma_threshold = page_size;
+  dma_accept = 0;
+  memset(dst_area, 0, AREA);
+  diet_memcpy(dst_area + 1, src_area, n);
+  if (dma_calls != 1 || memcmp(dst_area + 1, src_area, n))
+    fail("dma fallback", 0, 1, n);
+
+  /* accepted requests are not copied twice, small ones stay on the CPU */
+  dma_accept = 1;
+  diet_memcpy(dst_area, src_area, n);
+  diet_memcpy(dst_area, src_area, page_size - 1);
+  if (dma_calls != 2 || memcmp(dst_area, src_area, n))
+    fail("dma dispatch", 0, 0, n);
+
+  __memcpy_dma_threshold = 0;
+  dma_accept = 0;
+}
+
+/* byte loops the routines replace, kept out of line */
+static void *__attribute__((noinline)) byte_memcpy(void *dst, const void *src, size_t n)
+{
+  volatile unsigned char *d = dst;
+  const unsigned char *s = src;
+  while (n--) *d++ = *s++;
+  return dst;
+}
+
+static size_t __attribute__((noinline)) byte_strlen(const char *s)
+{
+  volatile const char *t = s;
+  while (*t) t++;
+  return t - s;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define BENCH(name, expr)						\
+  do {									\
+    double t0 = now();							\
+    for (i = 0; i < loops; i++) { expr; }				\
+    printf("  %-34s %8.1f MB/s\n", name,				\
+	   (double) len * loops / (now() - t0) / 1e6);			\
+  } while (0)
+
+static void bench(size_t len, size_t off)
+{
+  volatile size_t sink = 0;
+  unsigned long i, loops;
+
+  loops = (256ul << 20) / (len + 64);
+  fill(src_area, AREA);
+  src_area[off + len] = 0;
+
+  printf("len %zu, src offset %zu:\n", len, off);
+  BENCH("byte memcpy", byte_memcpy(dst_area, src_area + off, len));
+  BENCH("memcpy", diet_memcpy(dst_area, src_area + off, len));
+  BENCH("memset", diet_memset(dst_area + off, (int) i, len));
+  BENCH("byte strlen", sink += byte_strlen((char *) src_area + off));
+  BENCH("strlen", sink += diet_strlen((char *) src_area + off));
+  BENCH("memchr", sink += (size_t) diet_memchr(src_area + off, 0, len));
+  memcpy(dst_area, src_area + off, len + 1);
+  BENCH("strcmp", sink += diet_strcmp((char *) src_area + off, (char *) dst_area));
+}
+
+int main(int argc, char **argv)
+{
+  unsigned long rounds, r;
+  size_t n;
+
+  rounds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+  page_size = sysconf(_SC_PAGESIZE);
+  src_area = guarded_area();
+  dst_area = guarded_area();
+  srand(1);
+
+  check_dma();
+
+  for (r = 0; r < rounds; r++) {
+    n = rand_len();
+    check_memcpy(n);
+    check_memset(n);
+    check_strlen(n);
+    check_memchr(n);
+    check_strcmp(n);
+  }
+
+  printf("%lu rounds passed\n", rounds);
+
+  bench(64, 0);
+  bench(64, 3);
+  bench(4096, 0);
+  bench(4096, 1);
+  bench(AREA / 2, 2);
+  return 0;
+}
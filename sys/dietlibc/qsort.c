@@ -1,40 +1,117 @@
 #include <stdlib.h>
 
-static void exch(char* base,size_t size,size_t a,size_t b) {
+/* swap strategies, picked once from size and base alignment */
+#define SWAP_BYTES 0
+#define SWAP_WORDS 1
+#define SWAP_WORD  2
+
+/* below this many elements, insertion sort beats partitioning */
+#define QSORT_CUTOFF 12
+
+static inline void exch(char* base,size_t size,size_t a,size_t b,int swaptype) {
   char* x=base+a*size;
   char* y=base+b*size;
-  while (size) {
-    char z=*x;
-    *x=*y;
-    *y=z;
-    --size; ++x; ++y;
+  if (swaptype==SWAP_WORD) {
+    long z=*(long*)x;
+    *(long*)x=*(long*)y;
+    *(long*)y=z;
+  } else if (swaptype==SWAP_WORDS) {
+    long* lx=(long*)x;
+    long* ly=(long*)y;
+    for (size/=sizeof(long); size; --size, ++lx, ++ly) {
+      long z=*lx;
+      *lx=*ly;
+      *ly=z;
+    }
+  } else {
+    while (size) {
+      char z=*x;
+      *x=*y;
+      *y=z;
+      --size; ++x; ++y;
+    }
+  }
+}
+
+static void insertionsort(char* base,size_t size,ssize_t l,ssize_t r,int swaptype,
+			  int (*compar)(const void*,const void*)) {
+  ssize_t i,j;
+  for (i=l+1; i<=r; i++)
+    for (j=i; j>l && compar(base+(j-1)*size,base+j*size)>0; j--)
+      exch(base,size,j-1,j,swaptype);
+}
+
+static void siftdown(char* base,size_t size,ssize_t l,ssize_t root,ssize_t n,int swaptype,
+		     int (*compar)(const void*,const void*)) {
+  ssize_t child;
+  while ((child=2*root+1) < n) {
+    if (child+1<n && compar(base+(l+child)*size,base+(l+child+1)*size)<0) ++child;
+    if (compar(base+(l+root)*size,base+(l+child)*size)>=0) return;
+    exch(base,size,l+root,l+child,swaptype);
+    root=child;
   }
 }
 
-/* Quicksort with 3-way partitioning, ala Sedgewick */
+/* worst case guard, O(n log n) whatever the input */
+static void heap_sort(char* base,size_t size,ssize_t l,ssize_t r,int swaptype,
+		      int (*compar)(const void*,const void*)) {
+  ssize_t n=r-l+1, i;
+  for (i=n/2-1; i>=0; i--) siftdown(base,size,l,i,n,swaptype,compar);
+  for (i=n-1; i>0; i--) {
+    exch(base,size,l,l+i,swaptype);
+    siftdown(base,size,l,0,i,swaptype,compar);
+  }
+}
+
+/* Introsort: quicksort with 3-way partitioning, ala Sedgewick, on a
+ * median-of-three pivot; small ranges are left to insertion sort and
+ * ranges recursing deeper than 2*log2(n) to heapsort */
 /* Blame him for the scary variable names */
 /* http://www.cs.princeton.edu/~rs/talks/QuicksortIsOptimal.pdf */
-static void quicksort(char* base,size_t size,ssize_t l,ssize_t r,
+static void quicksort(char* base,size_t size,ssize_t l,ssize_t r,int depth,int swaptype,
 		      int (*compar)(const void*,const void*)) {
-  ssize_t i=l-1, j=r, p=l-1, q=r, k;
-  char* v=base+r*size;
-  if (r<=l) return;
-  for (;;) {
-    while (++i != r && compar(base+i*size,v)<0) ;
-    while (compar(v,base+(--j)*size)<0) if (j == l) break;
-    if (i >= j) break;
-    exch(base,size,i,j);
-    if (compar(base+i*size,v)==0) exch(base,size,++p,i);
-    if (compar(v,base+j*size)==0) exch(base,size,j,--q);
+  while (r-l+1 > QSORT_CUTOFF) {
+    ssize_t i=l-1, j=r, p=l-1, q=r, k, m=l+(r-l)/2;
+    char* v=base+r*size;
+
+    if (depth-- == 0) {
+      heap_sort(base,size,l,r,swaptype,compar);
+      return;
+    }
+
+    /* move the median of l, m, r to r, where the pivot is taken */
+    if (compar(base+l*size,base+m*size)>0) exch(base,size,l,m,swaptype);
+    if (compar(base+m*size,v)>0) exch(base,size,m,r,swaptype);
+    if (compar(base+l*size,base+m*size)>0) exch(base,size,l,m,swaptype);
+    exch(base,size,m,r,swaptype);
+
+    for (;;) {
+      while (++i != r && compar(base+i*size,v)<0) ;
+      while (compar(v,base+(--j)*size)<0) if (j == l) break;
+      if (i >= j) break;
+      exch(base,size,i,j,swaptype);
+      if (compar(base+i*size,v)==0) exch(base,size,++p,i,swaptype);
+      if (compar(v,base+j*size)==0) exch(base,size,j,--q,swaptype);
+    }
+    exch(base,size,i,r,swaptype); j = i-1; ++i;
+    for (k=l; k<p; k++, j--) exch(base,size,k,j,swaptype);
+    for (k=r-1; k>q; k--, i++) exch(base,size,i,k,swaptype);
+
+    /* recurse on the smaller side to bound the stack to log n frames */
+    if (j-l < r-i) {
+      quicksort(base,size,l,j,depth,swaptype,compar);
+      l=i;
+    } else {
+      quicksort(base,size,i,r,depth,swaptype,compar);
+      r=j;
+    }
   }
-  exch(base,size,i,r); j = i-1; ++i;
-  for (k=l; k<p; k++, j--) exch(base,size,k,j);
-  for (k=r-1; k>q; k--, i++) exch(base,size,i,k);
-  quicksort(base,size,l,j,compar);
-  quicksort(base,size,i,r,compar);
+  insertionsort(base,size,l,r,swaptype,compar);
 }
 
 void qsort(void* base,size_t nmemb,size_t size,int (*compar)(const void*,const void*)) {
+  int depth, swaptype;
+  size_t n;
   /* check for integer overflows */
   if (nmemb >= (((size_t)-1)>>1) ||
       size >= (((size_t)-1)>>1)) return;
@@ -45,6 +122,11 @@ void qsort(void* base,size_t nmemb,size_t size,int (*compar)(const void*,const v
     if (size*nmemb/nmemb != size) return;
   }
 #endif
-  if (nmemb>1)
-    quicksort(base,size,0,nmemb-1,compar);
+  if (nmemb<=1) return;
+  if (((unsigned long)base | size) & (sizeof(long)-1))
+    swaptype=SWAP_BYTES;
+  else
+    swaptype=(size==sizeof(long))?SWAP_WORD:SWAP_WORDS;
+  for (depth=0, n=nmemb; n>1; n>>=1) depth+=2;
+  quicksort(base,size,0,nmemb-1,depth,swaptype,compar);
 }
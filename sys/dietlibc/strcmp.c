@@ -17,13 +17,13 @@ strcmp (const char *s1, const char *s2)
 
     if (UNALIGNED(s1, s2)) {
         while (*s1 && *s1 == *s2) s1++, s2++;
-        return (*s1 - *s2);
+        return ((unsigned char) *s1 - (unsigned char) *s2);
     }
 
     if ((tmp = STRALIGN(s1)))
         for (; tmp--; s1++, s2++)
             if (!*s1 || *s1 != *s2)
-                return (*s1 - *s2);
+                return ((unsigned char) *s1 - (unsigned char) *s2);
 
     lx1 = (unsigned long *) s1;
     lx2 = (unsigned long *) s2;
@@ -31,8 +31,8 @@ strcmp (const char *s1, const char *s2)
     while (1) {
         l1 = *lx1++;
         l2 = *lx2++;
-        if ((((l1 - MKW(0x1ul)) & ~l1) & MKW(0x80ul)) ||
-            ((((l2 - MKW(0x1ul)) & ~l2) & MKW(0x80ul))) || l1 != l2) {
+        /* equal words hold a zero in both or in none */
+        if (l1 != l2 || (((l1 - MKW(0x1ul)) & ~l1) & MKW(0x80ul))) {
             unsigned char c1, c2;
             while (1) {
 		c1 = GFC(l1);
@@ -1,9 +1,10 @@
 #include <endian.h>
 #include "dietfeatures.h"
+#include "dietstring.h"
 #include <string.h>
 #include <stdint.h>
 
-#if 1 // WANT_SMALL_STRING_ROUTINES
+#ifdef WANT_SMALL_STRING_ROUTINES
 size_t strlen(const char *s) {
   register size_t i;
   if (!s) return 0;
@@ -13,87 +14,28 @@ size_t strlen(const char *s) {
 
 #else
 
-#if __WORDSIZE == 64
-typedef uint64_t	word_t;
-#elif __WORDSIZE == 32
-typedef uint32_t	word_t;
-#else
-#error unsupported __WORDSIZE
-#endif
-
-static word_t const	magic = (word_t)(0x0101010101010101ull);
+/* non-zero if one byte of x is zero */
+#define HASZERO(x) (((x) - MKW(0x1ul)) & ~(x) & MKW(0x80ul))
 
 size_t strlen(const char *s)
 {
   const char *t = s;
-  word_t	word;
-  word_t	mask;
+  const unsigned long *lx;
 
   if (!s) return 0;
 
   /* Byte compare up until word boundary */
-  for (; ((unsigned long) t & (sizeof(magic)-1)); t++)
+  for (; ((unsigned long) t & (sizeof(*lx)-1)); t++)
     if (!*t) return t - s;
 
-  /* Word compare */
-  do {
-    word = *((word_t const *) t); t += sizeof word;
-    word = (word - magic) &~ word;
-    word &= (magic << 7);
-  } while (word == 0);
-
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-  (void)mask;
-  switch (sizeof(word)) {
-  case 8:
-    /* word & 0x8080808080808080 == word */
-    word = (word - 1) & (magic << 8);
-    word += //(word << 32);
-    word += (word << 16);
-    word += (word << 8);
-    t += word >> 56;
-    break;
-
-  case 4:
-    /* word & 0x80808080 == word */
-    word = (word - 1) & (magic << 10);
-    word += (word << 8) + (word << 16);
-    t += word >> 26;
-    break;
-
-  default: { char exc[sizeof(word)==8]; (void)exc; }
+  /* Word compare, two words per round; an aligned word never crosses
+   * the page holding the terminating zero */
+  for (lx = (const unsigned long *) t; ; lx += 2) {
+    if (HASZERO(lx[0])) break;
+    if (HASZERO(lx[1])) { lx++; break; }
   }
-#else
-  mask = (magic << 7);
-
-  switch (sizeof(word)) {
-  case 8:
-    mask <<= 4*8;
-    if ((word & mask) == 0) {
-      t     += 4;
-      word <<= 4*8;
-    }
-    /* fallthrough */
-
-  case 4:
-    mask <<= 2*8;
-    if ((word & mask) == 0) {
-      t     += 2;
-      word <<= 2*8;
-    }
-    /* fallthrough */
 
-  case 2:
-    mask <<= 1*8;
-    if ((word & mask) == 0) {
-      t     += 1;
-      word <<= 1*8;
-    }
-    break;
-
-  default: { char exc[sizeof(word)==8]; (void)exc; }
-  }
-#endif
-  return t - sizeof(word) - s;
+  for (t = (const char *) lx; *t; t++);
+  return t - s;
 }
 #endif
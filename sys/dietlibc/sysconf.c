@@ -78,6 +78,9 @@ long sysconf(int name)
 
   case _SC_NCLUSTERS_ONLN:
     return sysconf_get("CLUSTER_ONLN_NR");
+
+  case _SC_CLUSTER_YMAX:
+    return sysconf_get("CLUSTER_YMAX");
   }
   errno=ENOSYS;
   return -1;
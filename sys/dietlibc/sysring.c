@@ -0,0 +1,82 @@
+/*
+   This file is part of MutekP.
+  
+   MutekP is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+  
+   MutekP is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+  
+   You should have received a copy of the GNU General Public License
+   along with MutekP; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+  
+   UPMC / LIP6 / SOC (c) 2008
+   Copyright Ghassan Almaless <ghassan.almaless@gmail.com>
+*/
+
+
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/sysring.h>
+#include <cpu-syscall.h>
+
+int sysring_setup(struct sysring_s *ring, uint_t entries_nr)
+{
+  return (int) cpu_syscall((void*)SYSRING_SETUP, ring, (void*)entries_nr, NULL, SYS_SYSRING);
+}
+
+int sysring_submit(struct sysring_s *ring, uint_t service, void *arg0, void *arg1,
+		   void *arg2, void *arg3, uint_t user_data)
+{
+  struct sysring_sqe_s *sqe;
+  uint_t tail;
+
+  tail = ring->sq_tail;
+
+  if((tail - ring->sq_head) >= ring->entries_nr)
+  {
+    errno = EAGAIN;
+    return -1;
+  }
+
+  sqe            = &sysring_sq(ring)[tail & (ring->entries_nr - 1)];
+  sqe->service   = service;
+  sqe->args[0]   = (uint_t)arg0;
+  sqe->args[1]   = (uint_t)arg1;
+  sqe->args[2]   = (uint_t)arg2;
+  sqe->args[3]   = (uint_t)arg3;
+  sqe->user_data = user_data;
+
+  cpu_wbflush();
+  ring->sq_tail = tail + 1;
+  return 0;
+}
+
+int sysring_enter(struct sysring_s *ring, uint_t to_submit)
+{
+  return (int) cpu_syscall((void*)SYSRING_ENTER, ring, (void*)to_submit, NULL, SYS_SYSRING);
+}
+
+int sysring_reap(struct sysring_s *ring, struct sysring_cqe_s *cqe)
+{
+  uint_t head;
+
+  head = ring->cq_head;
+
+  if(head == ring->cq_tail)
+    return -1;
+
+  *cqe = sysring_cq(ring, ring->entries_nr)[head & (ring->entries_nr - 1)];
+  ring->cq_head = head + 1;
+  return 0;
+}
+
+int sysring_destroy(struct sysring_s *ring)
+{
+  return (int) cpu_syscall((void*)SYSRING_DESTROY, ring, NULL, NULL, SYS_SYSRING);
+}
@@ -123,6 +123,20 @@ unsigned char *SHA1(const unsigned char *d, size_t n, unsigned char *md);
 void SHA1_Transform(SHA_CTX *c, const unsigned char *data);
 #endif
 
+/*
+ * Multi-buffer hashing: SHA_MB_LANES independent messages of a batch are
+ * hashed together, their rounds interleaved in a single loop so that the
+ * dependency chain of one message does not stall the pipeline.
+ */
+#define SHA_MB_LANES	4
+
+typedef struct SHA_MB_JOB_st
+	{
+	const void *data;
+	size_t len;
+	unsigned char *md;	/* receives the digest */
+	} SHA_MB_JOB;
+
 #define SHA256_CBLOCK	(SHA_LBLOCK*4)	/* SHA-256 treats input data as a
 					 * contiguous array of 32 bit
 					 * wide big-endian values. */
@@ -147,6 +161,8 @@ int SHA256_Update(SHA256_CTX *c, const void *data, size_t len);
 int SHA256_Final(unsigned char *md, SHA256_CTX *c);
 unsigned char *SHA256(const unsigned char *d, size_t n,unsigned char *md);
 void SHA256_Transform(SHA256_CTX *c, const unsigned char *data);
+void SHA256_MB(SHA_MB_JOB *job, size_t n);
+void SHA256_MB_threads(SHA_MB_JOB *job, size_t n, int nthreads);
 #endif
 
 #define SHA384_DIGEST_LENGTH	48
@@ -194,6 +210,8 @@ int SHA512_Update(SHA512_CTX *c, const void *data, size_t len);
 int SHA512_Final(unsigned char *md, SHA512_CTX *c);
 unsigned char *SHA512(const unsigned char *d, size_t n,unsigned char *md);
 void SHA512_Transform(SHA512_CTX *c, const unsigned char *data);
+void SHA512_MB(SHA_MB_JOB *job, size_t n);
+void SHA512_MB_threads(SHA_MB_JOB *job, size_t n, int nthreads);
 #endif
 
 #ifdef  __cplusplus
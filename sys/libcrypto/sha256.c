@@ -287,6 +287,151 @@ static void sha256_block_data_order (SHA256_CTX *ctx, const void *in, size_t num
 	}
 
 #endif
+
+/*
+ * Multi-buffer transform: one block of each of the SHA_MB_LANES contexts
+ * per iteration. Every round is done for all lanes before the next one,
+ * which gives the compiler independent instructions to schedule in place
+ * of the serial chain of a single message.
+ */
+#define	MB_ROUND_00_15(i,a,b,c,d,e,f,g,h)	do {		\
+	for (j=0;j<SHA_MB_LANES;j++) {				\
+		T1 = X[(i)&0x0f][j] + h[j] + Sigma1(e[j]) +	\
+		     Ch(e[j],f[j],g[j]) + K256[i];		\
+		h[j] = Sigma0(a[j]) + Maj(a[j],b[j],c[j]);	\
+		d[j] += T1;	h[j] += T1;	}		} while (0)
+
+#define	MB_ROUND_16_63(i,a,b,c,d,e,f,g,h)	do {		\
+	for (j=0;j<SHA_MB_LANES;j++) {				\
+		s0 = X[((i)+1)&0x0f][j];	s0 = sigma0(s0);	\
+		s1 = X[((i)+14)&0x0f][j];	s1 = sigma1(s1);	\
+		X[(i)&0x0f][j] += s0 + s1 + X[((i)+9)&0x0f][j];	}	\
+	MB_ROUND_00_15(i,a,b,c,d,e,f,g,h);		} while (0)
+
+static void sha256_mb_block_data_order (SHA256_CTX *ctx, const unsigned char **in, size_t num)
+	{
+	SHA_LONG	a[SHA_MB_LANES],b[SHA_MB_LANES],c[SHA_MB_LANES],d[SHA_MB_LANES];
+	SHA_LONG	e[SHA_MB_LANES],f[SHA_MB_LANES],g[SHA_MB_LANES],h[SHA_MB_LANES];
+	SHA_LONG	X[16][SHA_MB_LANES],l,s0,s1,T1;
+	int i,j;
+
+			while (num--) {
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		{
+		a[j] = ctx[j].h[0];	b[j] = ctx[j].h[1];
+		c[j] = ctx[j].h[2];	d[j] = ctx[j].h[3];
+		e[j] = ctx[j].h[4];	f[j] = ctx[j].h[5];
+		g[j] = ctx[j].h[6];	h[j] = ctx[j].h[7];
+		for (i=0;i<16;i++)
+			{ HOST_c2l(in[j],l); X[i][j] = l; }
+		}
+
+	for (i=0;i<64;i+=8)
+		{
+		if (i<16)
+			{
+			MB_ROUND_00_15(i+0,a,b,c,d,e,f,g,h);
+			MB_ROUND_00_15(i+1,h,a,b,c,d,e,f,g);
+			MB_ROUND_00_15(i+2,g,h,a,b,c,d,e,f);
+			MB_ROUND_00_15(i+3,f,g,h,a,b,c,d,e);
+			MB_ROUND_00_15(i+4,e,f,g,h,a,b,c,d);
+			MB_ROUND_00_15(i+5,d,e,f,g,h,a,b,c);
+			MB_ROUND_00_15(i+6,c,d,e,f,g,h,a,b);
+			MB_ROUND_00_15(i+7,b,c,d,e,f,g,h,a);
+			}
+		else
+			{
+			MB_ROUND_16_63(i+0,a,b,c,d,e,f,g,h);
+			MB_ROUND_16_63(i+1,h,a,b,c,d,e,f,g);
+			MB_ROUND_16_63(i+2,g,h,a,b,c,d,e,f);
+			MB_ROUND_16_63(i+3,f,g,h,a,b,c,d,e);
+			MB_ROUND_16_63(i+4,e,f,g,h,a,b,c,d);
+			MB_ROUND_16_63(i+5,d,e,f,g,h,a,b,c);
+			MB_ROUND_16_63(i+6,c,d,e,f,g,h,a,b);
+			MB_ROUND_16_63(i+7,b,c,d,e,f,g,h,a);
+			}
+		}
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		{
+		ctx[j].h[0] += a[j];	ctx[j].h[1] += b[j];
+		ctx[j].h[2] += c[j];	ctx[j].h[3] += d[j];
+		ctx[j].h[4] += e[j];	ctx[j].h[5] += f[j];
+		ctx[j].h[6] += g[j];	ctx[j].h[7] += h[j];
+		}
+
+			}
+	}
+
+/* account for the blocks hashed by the lane, then hash what is left */
+static void sha256_mb_final (SHA256_CTX *ctx, SHA_MB_JOB *job, const unsigned char *in)
+	{
+	size_t done = in - (const unsigned char *)job->data;
+
+	ctx->Nl = (SHA_LONG)(done<<3);
+	ctx->Nh = (SHA_LONG)(done>>29);
+	SHA256_Update(ctx,in,job->len-done);
+	SHA256_Final(job->md,ctx);
+	}
+
+void SHA256_MB (SHA_MB_JOB *job, size_t n)
+	{
+	SHA256_CTX ctx[SHA_MB_LANES];
+	const unsigned char *in[SHA_MB_LANES];
+	SHA_MB_JOB *cur[SHA_MB_LANES];
+	size_t left[SHA_MB_LANES],num,next=0;
+	int j,active;
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		cur[j]=NULL, left[j]=0;
+
+	for (;;)
+		{
+		/* give every lane with no full block left a new message */
+		for (active=0,j=0;j<SHA_MB_LANES;j++)
+			{
+			while (left[j]==0)
+				{
+				if (cur[j]!=NULL)
+					sha256_mb_final(&ctx[j],cur[j],in[j]);
+				cur[j]=NULL;
+				if (next==n) break;
+				cur[j]=&job[next++];
+				SHA256_Init(&ctx[j]);
+				in[j]=cur[j]->data;
+				left[j]=cur[j]->len/SHA256_CBLOCK;
+				}
+			if (cur[j]!=NULL) active++;
+			}
+		if (active<SHA_MB_LANES) break;
+
+		for (num=left[0],j=1;j<SHA_MB_LANES;j++)
+			if (left[j]<num) num=left[j];
+		sha256_mb_block_data_order(ctx,in,num);
+		for (j=0;j<SHA_MB_LANES;j++)
+			left[j]-=num;
+		}
+
+	/* not enough messages to fill the lanes: end them one by one */
+	for (j=0;j<SHA_MB_LANES;j++)
+		if (cur[j]!=NULL)
+			sha256_mb_final(&ctx[j],cur[j],in[j]);
+
+	OPENSSL_cleanse(ctx,sizeof(ctx));
+	}
+
+#else /* SHA256_ASM */
+
+/* the assembler block function hashes a single context at a time */
+void SHA256_MB (SHA_MB_JOB *job, size_t n)
+	{
+	size_t i;
+
+	for (i=0;i<n;i++)
+		SHA256(job[i].data,job[i].len,job[i].md);
+	}
+
 #endif /* SHA256_ASM */
 
 #endif /* OPENSSL_NO_SHA256 */
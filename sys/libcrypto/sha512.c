@@ -542,6 +542,153 @@ static void sha512_block_data_order (SHA512_CTX *ctx, const void *in, size_t num
 
 #endif
 
+/*
+ * Multi-buffer transform, see sha256.c. The lanes read their input a
+ * byte at a time as it may not be aligned.
+ */
+#define	MB_PULL64(p)	(((SHA_LONG64)(p)[0]<<56)|((SHA_LONG64)(p)[1]<<48)|	\
+			 ((SHA_LONG64)(p)[2]<<40)|((SHA_LONG64)(p)[3]<<32)|	\
+			 ((SHA_LONG64)(p)[4]<<24)|((SHA_LONG64)(p)[5]<<16)|	\
+			 ((SHA_LONG64)(p)[6]<<8) |((SHA_LONG64)(p)[7]))
+
+#define	MB_ROUND_00_15(i,a,b,c,d,e,f,g,h)	do {		\
+	for (j=0;j<SHA_MB_LANES;j++) {				\
+		T1 = X[(i)&0x0f][j] + h[j] + Sigma1(e[j]) +	\
+		     Ch(e[j],f[j],g[j]) + K512[i];		\
+		h[j] = Sigma0(a[j]) + Maj(a[j],b[j],c[j]);	\
+		d[j] += T1;	h[j] += T1;	}		} while (0)
+
+#define	MB_ROUND_16_80(i,a,b,c,d,e,f,g,h)	do {		\
+	for (j=0;j<SHA_MB_LANES;j++) {				\
+		s0 = X[((i)+1)&0x0f][j];	s0 = sigma0(s0);	\
+		s1 = X[((i)+14)&0x0f][j];	s1 = sigma1(s1);	\
+		X[(i)&0x0f][j] += s0 + s1 + X[((i)+9)&0x0f][j];	}	\
+	MB_ROUND_00_15(i,a,b,c,d,e,f,g,h);		} while (0)
+
+static void sha512_mb_block_data_order (SHA512_CTX *ctx, const unsigned char **in, size_t num)
+	{
+	SHA_LONG64	a[SHA_MB_LANES],b[SHA_MB_LANES],c[SHA_MB_LANES],d[SHA_MB_LANES];
+	SHA_LONG64	e[SHA_MB_LANES],f[SHA_MB_LANES],g[SHA_MB_LANES],h[SHA_MB_LANES];
+	SHA_LONG64	X[16][SHA_MB_LANES],s0,s1,T1;
+	int i,j;
+
+			while (num--) {
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		{
+		a[j] = ctx[j].h[0];	b[j] = ctx[j].h[1];
+		c[j] = ctx[j].h[2];	d[j] = ctx[j].h[3];
+		e[j] = ctx[j].h[4];	f[j] = ctx[j].h[5];
+		g[j] = ctx[j].h[6];	h[j] = ctx[j].h[7];
+		for (i=0;i<16;i++,in[j]+=8)
+			X[i][j] = MB_PULL64(in[j]);
+		}
+
+	for (i=0;i<80;i+=8)
+		{
+		if (i<16)
+			{
+			MB_ROUND_00_15(i+0,a,b,c,d,e,f,g,h);
+			MB_ROUND_00_15(i+1,h,a,b,c,d,e,f,g);
+			MB_ROUND_00_15(i+2,g,h,a,b,c,d,e,f);
+			MB_ROUND_00_15(i+3,f,g,h,a,b,c,d,e);
+			MB_ROUND_00_15(i+4,e,f,g,h,a,b,c,d);
+			MB_ROUND_00_15(i+5,d,e,f,g,h,a,b,c);
+			MB_ROUND_00_15(i+6,c,d,e,f,g,h,a,b);
+			MB_ROUND_00_15(i+7,b,c,d,e,f,g,h,a);
+			}
+		else
+			{
+			MB_ROUND_16_80(i+0,a,b,c,d,e,f,g,h);
+			MB_ROUND_16_80(i+1,h,a,b,c,d,e,f,g);
+			MB_ROUND_16_80(i+2,g,h,a,b,c,d,e,f);
+			MB_ROUND_16_80(i+3,f,g,h,a,b,c,d,e);
+			MB_ROUND_16_80(i+4,e,f,g,h,a,b,c,d);
+			MB_ROUND_16_80(i+5,d,e,f,g,h,a,b,c);
+			MB_ROUND_16_80(i+6,c,d,e,f,g,h,a,b);
+			MB_ROUND_16_80(i+7,b,c,d,e,f,g,h,a);
+			}
+		}
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		{
+		ctx[j].h[0] += a[j];	ctx[j].h[1] += b[j];
+		ctx[j].h[2] += c[j];	ctx[j].h[3] += d[j];
+		ctx[j].h[4] += e[j];	ctx[j].h[5] += f[j];
+		ctx[j].h[6] += g[j];	ctx[j].h[7] += h[j];
+		}
+
+			}
+	}
+
+/* account for the blocks hashed by the lane, then hash what is left */
+static void sha512_mb_final (SHA512_CTX *ctx, SHA_MB_JOB *job, const unsigned char *in)
+	{
+	size_t done = in - (const unsigned char *)job->data;
+
+	ctx->Nl = ((SHA_LONG64)done)<<3;
+	ctx->Nh = ((SHA_LONG64)done)>>61;
+	SHA512_Update(ctx,in,job->len-done);
+	SHA512_Final(job->md,ctx);
+	}
+
+void SHA512_MB (SHA_MB_JOB *job, size_t n)
+	{
+	SHA512_CTX ctx[SHA_MB_LANES];
+	const unsigned char *in[SHA_MB_LANES];
+	SHA_MB_JOB *cur[SHA_MB_LANES];
+	size_t left[SHA_MB_LANES],num,next=0;
+	int j,active;
+
+	for (j=0;j<SHA_MB_LANES;j++)
+		cur[j]=NULL, left[j]=0;
+
+	for (;;)
+		{
+		/* give every lane with no full block left a new message */
+		for (active=0,j=0;j<SHA_MB_LANES;j++)
+			{
+			while (left[j]==0)
+				{
+				if (cur[j]!=NULL)
+					sha512_mb_final(&ctx[j],cur[j],in[j]);
+				cur[j]=NULL;
+				if (next==n) break;
+				cur[j]=&job[next++];
+				SHA512_Init(&ctx[j]);
+				in[j]=cur[j]->data;
+				left[j]=cur[j]->len/SHA512_CBLOCK;
+				}
+			if (cur[j]!=NULL) active++;
+			}
+		if (active<SHA_MB_LANES) break;
+
+		for (num=left[0],j=1;j<SHA_MB_LANES;j++)
+			if (left[j]<num) num=left[j];
+		sha512_mb_block_data_order(ctx,in,num);
+		for (j=0;j<SHA_MB_LANES;j++)
+			left[j]-=num;
+		}
+
+	/* not enough messages to fill the lanes: end them one by one */
+	for (j=0;j<SHA_MB_LANES;j++)
+		if (cur[j]!=NULL)
+			sha512_mb_final(&ctx[j],cur[j],in[j]);
+
+	OPENSSL_cleanse(ctx,sizeof(ctx));
+	}
+
+#else /* SHA512_ASM */
+
+/* the assembler block function hashes a single context at a time */
+void SHA512_MB (SHA_MB_JOB *job, size_t n)
+	{
+	size_t i;
+
+	for (i=0;i<n;i++)
+		SHA512(job[i].data,job[i].len,job[i].md);
+	}
+
 #endif /* SHA512_ASM */
 
 #endif /* OPENSSL_NO_SHA512 */
@@ -0,0 +1,89 @@
+/* crypto/sha/sha_mb.c */
+/* ====================================================================
+ * Spreads a batch of multi-buffer SHA jobs over several threads.
+ * ====================================================================
+ */
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <openssl/sha.h>
+
+/* jobs taken at once from the queue, enough to keep all lanes busy */
+#define SHA_MB_BATCH	(16*SHA_MB_LANES)
+
+typedef struct SHA_MB_QUEUE_st
+	{
+	pthread_mutex_t lock;
+	void (*hash)(SHA_MB_JOB *job, size_t n);
+	SHA_MB_JOB *job;
+	size_t n,next;
+	} SHA_MB_QUEUE;
+
+static void *sha_mb_worker (void *arg)
+	{
+	SHA_MB_QUEUE *q=arg;
+	size_t i;
+
+	for (;;)
+		{
+		pthread_mutex_lock(&q->lock);
+		i=q->next;
+		if (i<q->n) q->next+=SHA_MB_BATCH;
+		pthread_mutex_unlock(&q->lock);
+
+		if (i>=q->n) break;
+		q->hash(q->job+i,(q->n-i<SHA_MB_BATCH)?q->n-i:SHA_MB_BATCH);
+		}
+	return NULL;
+	}
+
+static void sha_mb_run (void (*hash)(SHA_MB_JOB *, size_t), SHA_MB_JOB *job, size_t n, int nthreads)
+	{
+	SHA_MB_QUEUE q;
+	pthread_t *tid=NULL;
+	int i,created=0;
+
+	/* no point in more threads than batches */
+	if (nthreads<1) nthreads=1;
+	if ((size_t)nthreads>(n+SHA_MB_BATCH-1)/SHA_MB_BATCH)
+		nthreads=(int)((n+SHA_MB_BATCH-1)/SHA_MB_BATCH);
+	if (nthreads<=1)
+		{
+		hash(job,n);
+		return;
+		}
+
+	q.hash=hash;
+	q.job=job;
+	q.n=n;
+	q.next=0;
+	pthread_mutex_init(&q.lock,NULL);
+
+	/* the calling thread works too, and alone if no thread starts */
+	tid=malloc((nthreads-1)*sizeof(pthread_t));
+	if (tid!=NULL)
+		for (;created<nthreads-1;created++)
+			if (pthread_create(&tid[created],NULL,sha_mb_worker,&q))
+				break;
+
+	sha_mb_worker(&q);
+
+	for (i=0;i<created;i++)
+		pthread_join(tid[i],NULL);
+	if (tid!=NULL) free(tid);
+	pthread_mutex_destroy(&q.lock);
+	}
+
+#ifndef OPENSSL_NO_SHA256
+void SHA256_MB_threads (SHA_MB_JOB *job, size_t n, int nthreads)
+	{
+	sha_mb_run(SHA256_MB,job,n,nthreads);
+	}
+#endif
+
+#ifndef OPENSSL_NO_SHA512
+void SHA512_MB_threads (SHA_MB_JOB *job, size_t n, int nthreads)
+	{
+	sha_mb_run(SHA512_MB,job,n,nthreads);
+	}
+#endif
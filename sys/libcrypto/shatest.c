@@ -0,0 +1,179 @@
+/* crypto/sha/shatest.c */
+/* ====================================================================
+ * SHA-2 digests: the FIPS 180-2 vectors of SHA-224, SHA-256, SHA-384
+ * and SHA-512, one million 'a' included. Then every SHA_MB_JOB of a
+ * SHA256_MB or SHA512_MB batch must match the digest SHA256() or
+ * SHA512() gives for the same message, lengths straddling the block
+ * and padding boundaries and batches not filling the lanes. Kept out
+ * of the library's Makefile, like md5test.c:
+ *
+ *   cc -Iinclude -o shatest shatest.c sha256.c sha512.c && ./shatest
+ * ====================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/sha.h>
+
+/* normally provided by mem_clr.c */
+void OPENSSL_cleanse (void *ptr, size_t len)
+	{
+	volatile unsigned char *p=ptr;
+
+	while (len--) *p++=0;
+	}
+
+static const char *msg1="abc";
+static const char *msg2_256="abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+static const char *msg2_512="abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+			    "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu";
+
+static const char *sha224_ret[]={
+	"23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+	"75388b16512776cc5dba5da1fd890150b0c6455cb4f58b1952522525",
+	"20794655980c91d8bbb4c1ea97618a4bf03f42581948b2ee4ee7ad67",
+	};
+
+static const char *sha256_ret[]={
+	"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+	"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+	"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+	};
+
+static const char *sha384_ret[]={
+	"cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed"
+	"8086072ba1e7cc2358baeca134c825a7",
+	"09330c33f71147e83d192fc782cd1b4753111b173b3b05d22fa08086e3b0f712"
+	"fcc7c71a557e2db966c3e9fa91746039",
+	"9d0e1809716474cb086e834e310a4a1ced149e9c00f248527972cec5704c2a5b"
+	"07b8b3dc38ecc4ebae97ddd87f3d8985",
+	};
+
+static const char *sha512_ret[]={
+	"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+	"2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+	"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018"
+	"501d289e4900f7e4331b99dec4b5433ac7d329eeb6dd26545e96e55b874be909",
+	"e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973eb"
+	"de0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b",
+	};
+
+static int err=0;
+
+static char *pt(unsigned char *md, int len)
+	{
+	int i;
+	static char buf[2*SHA512_DIGEST_LENGTH+1];
+
+	for (i=0; i<len; i++)
+		sprintf(&(buf[i*2]),"%02x",md[i]);
+	return(buf);
+	}
+
+static void check(const char *name, int i, unsigned char *md, int len, const char *ret)
+	{
+	char *p=pt(md,len);
+
+	if (strcmp(p,ret) != 0)
+		{
+		printf("error calculating %s test %d\n",name,i);
+		printf("got %s instead of %s\n",p,ret);
+		err++;
+		}
+	else
+		printf("%s test %d ok\n",name,i);
+	}
+
+/* the million 'a' are fed in uneven chunks to go through the partial blocks */
+#define KAT(NAME,CTX,INIT,UPDATE,FINAL,LEN,MSG2,RET)			\
+	{								\
+	CTX c;								\
+	unsigned char md[LEN];						\
+	size_t i,n;							\
+									\
+	INIT(&c); UPDATE(&c,msg1,strlen(msg1)); FINAL(md,&c);		\
+	check(NAME,1,md,LEN,RET[0]);					\
+	INIT(&c); UPDATE(&c,MSG2,strlen(MSG2)); FINAL(md,&c);		\
+	check(NAME,2,md,LEN,RET[1]);					\
+	INIT(&c);							\
+	for (i=0; i<1000000; i+=n)					\
+		{							\
+		n=(1000000-i<288)?1000000-i:288;			\
+		UPDATE(&c,big,n);					\
+		}							\
+	FINAL(md,&c);							\
+	check(NAME,3,md,LEN,RET[2]);					\
+	}
+
+#define MB_JOBS		37	/* not a multiple of the lanes */
+#define MB_MAXLEN	1000
+
+/* a batch of messages around the block boundaries, then longer ones */
+static void mb_test(const char *name, void (*mb)(SHA_MB_JOB *, size_t),
+		    unsigned char *(*one)(const unsigned char *, size_t, unsigned char *),
+		    int len, int round)
+	{
+	static unsigned char data[MB_JOBS][MB_MAXLEN];
+	static unsigned char md[MB_JOBS][SHA512_DIGEST_LENGTH];
+	unsigned char ref[SHA512_DIGEST_LENGTH];
+	SHA_MB_JOB job[MB_JOBS];
+	size_t i,j;
+
+	for (i=0; i<MB_JOBS; i++)
+		{
+		for (j=0; j<MB_MAXLEN; j++)
+			data[i][j]=(unsigned char)rand();
+
+		if (i<16)
+			job[i].len=(i%4==0)?0:round*(i/4+1)+(i%4)-2;
+		else
+			job[i].len=rand()%MB_MAXLEN;
+		job[i].data=data[i];
+		job[i].md=md[i];
+		}
+
+	/* every batch size, so that lanes end at all positions */
+	for (j=1; j<=MB_JOBS; j++)
+		{
+		memset(md,0,sizeof(md));
+		mb(job,j);
+
+		for (i=0; i<j; i++)
+			{
+			one(data[i],job[i].len,ref);
+			if (memcmp(ref,md[i],len) != 0)
+				{
+				printf("error in %s, batch of %d, job %d (len %d)\n",
+				       name,(int)j,(int)i,(int)job[i].len);
+				err++;
+				return;
+				}
+			}
+		}
+
+	printf("%s test ok\n",name);
+	}
+
+int main(int argc, char *argv[])
+	{
+	static unsigned char big[288];
+
+	memset(big,'a',sizeof(big));
+	srand(1);
+
+	KAT("SHA-224",SHA256_CTX,SHA224_Init,SHA224_Update,SHA224_Final,
+	    SHA224_DIGEST_LENGTH,msg2_256,sha224_ret);
+	KAT("SHA-256",SHA256_CTX,SHA256_Init,SHA256_Update,SHA256_Final,
+	    SHA256_DIGEST_LENGTH,msg2_256,sha256_ret);
+	KAT("SHA-384",SHA512_CTX,SHA384_Init,SHA384_Update,SHA384_Final,
+	    SHA384_DIGEST_LENGTH,msg2_512,sha384_ret);
+	KAT("SHA-512",SHA512_CTX,SHA512_Init,SHA512_Update,SHA512_Final,
+	    SHA512_DIGEST_LENGTH,msg2_512,sha512_ret);
+
+	mb_test("SHA256_MB",SHA256_MB,SHA256,SHA256_DIGEST_LENGTH,SHA256_CBLOCK);
+	mb_test("SHA512_MB",SHA512_MB,SHA512,SHA512_DIGEST_LENGTH,SHA512_CBLOCK);
+
+	if (err) printf("ERROR: %d\n", err);
+	return(err);
+	}
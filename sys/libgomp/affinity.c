@@ -22,17 +22,209 @@
    see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
    <http://www.gnu.org/licenses/>.  */
 
-/* This is a generic stub implementation of a CPU affinity setting.  */
+/* Thread affinity for ALMOS: places are sets of CPUs global ids, built
+   from OMP_PLACES or GOMP_CPU_AFFINITY and the clusters layout exported
+   by the kernel (/sys/sysconf).  Team threads are pinned at creation
+   time through pthread_attr_setcpuid_np.  */
 
 #include <gomp/libgomp.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Build one place per CPU, or per cluster of cpus_per_place CPUs.  */
+
+static void
+gomp_affinity_build_places (unsigned long cpus_nr, unsigned long cpus_per_place)
+{
+  unsigned short *cpus;
+  size_t i, nr;
+
+  nr = cpus_nr / cpus_per_place;
+  if (nr > gomp_places_count)
+    nr = gomp_places_count;
+
+  cpus = gomp_malloc (nr * cpus_per_place * sizeof (unsigned short));
+  gomp_places = gomp_malloc (nr * sizeof (struct gomp_place));
+
+  for (i = 0; i < nr * cpus_per_place; i++)
+    cpus[i] = i;
+
+  for (i = 0; i < nr; i++)
+    {
+      gomp_places[i].cpus = &cpus[i * cpus_per_place];
+      gomp_places[i].nr = cpus_per_place;
+    }
+
+  gomp_places_len = nr;
+}
 
 void
 gomp_init_affinity (void)
 {
+  long cpus_nr, clusters_nr;
+  size_t i, len;
+
+  cpus_nr = sysconf (_SC_NPROCESSORS_ONLN);
+  clusters_nr = sysconf (_SC_NCLUSTERS_ONLN);
+
+  if (cpus_nr <= 0)
+    cpus_nr = 1;
+  if (clusters_nr <= 0 || clusters_nr > cpus_nr || cpus_nr % clusters_nr)
+    clusters_nr = 1;
+
+  if (gomp_places_kind == GOMP_PLACES_NONE && gomp_cpu_affinity != NULL)
+    {
+      /* GOMP_CPU_AFFINITY: one place per listed CPU.  */
+      gomp_places = gomp_malloc (gomp_cpu_affinity_len * sizeof (struct gomp_place));
+      for (i = 0; i < gomp_cpu_affinity_len; i++)
+	{
+	  gomp_places[i].cpus = &gomp_cpu_affinity[i];
+	  gomp_places[i].nr = 1;
+	}
+      gomp_places_len = gomp_cpu_affinity_len;
+      gomp_places_kind = GOMP_PLACES_EXPLICIT;
+    }
+
+  switch (gomp_places_kind)
+    {
+    case GOMP_PLACES_NONE:
+    case GOMP_PLACES_THREADS:
+    case GOMP_PLACES_CORES:
+      gomp_affinity_build_places (cpus_nr, 1);
+      break;
+    case GOMP_PLACES_CLUSTERS:
+      gomp_affinity_build_places (cpus_nr, cpus_nr / clusters_nr);
+      break;
+    case GOMP_PLACES_EXPLICIT:
+      break;
+    }
+
+  /* Drop CPUs which are not online, then empty places.  */
+  for (i = 0, len = 0; i < gomp_places_len; i++)
+    {
+      unsigned short j, nr = 0;
+
+      for (j = 0; j < gomp_places[i].nr; j++)
+	if (gomp_places[i].cpus[j] < cpus_nr)
+	  gomp_places[i].cpus[nr++] = gomp_places[i].cpus[j];
+
+      gomp_places[i].nr = nr;
+      if (nr != 0)
+	gomp_places[len++] = gomp_places[i];
+    }
+
+  gomp_places_len = len;
+
+  if (gomp_places_len == 0)
+    {
+      gomp_error ("No valid place, thread affinity disabled");
+      gomp_proc_bind_var = GOMP_PROC_BIND_FALSE;
+    }
+}
+
+/* Assign one of nplaces places to each of the nthreads threads of a
+   team following the OpenMP 4.0 rules, thread 0 being the master
+   which runs on place master_place.  This does not depend on the
+   machine and can be checked on a host build.  */
+
+void
+gomp_affinity_place_threads (enum gomp_proc_bind bind, unsigned master_place,
+			     unsigned nplaces, unsigned nthreads,
+			     unsigned *places)
+{
+  unsigned i, k, n, s, rem, p;
+
+  switch (bind)
+    {
+    case GOMP_PROC_BIND_MASTER:
+      for (i = 0; i < nthreads; i++)
+	places[i] = master_place;
+      return;
+
+    case GOMP_PROC_BIND_SPREAD:
+      if (nthreads <= nplaces)
+	{
+	  /* nthreads sub-partitions of consecutive places, each thread
+	     gets the first place of its own sub-partition.  */
+	  s = nplaces / nthreads;
+	  rem = nplaces % nthreads;
+	  for (i = 0, p = master_place; i < nthreads; i++)
+	    {
+	      places[i] = p % nplaces;
+	      p += s + (i < rem);
+	    }
+	  return;
+	}
+      /* FALLTHRU */
+
+    default:
+      if (nthreads <= nplaces)
+	{
+	  for (i = 0; i < nthreads; i++)
+	    places[i] = (master_place + i) % nplaces;
+	  return;
+	}
+
+      /* Consecutive threads share a place, the first places get
+	 one more thread.  */
+      s = nthreads / nplaces;
+      rem = nthreads % nplaces;
+      for (i = 0, k = 0; k < nplaces; k++)
+	for (n = s + (k < rem); n != 0; n--)
+	  places[i++] = (master_place + k) % nplaces;
+      return;
+    }
+}
+
+/* Compute the CPU of each team member, cpus[0] being the master's
+   own CPU.  Threads sharing a place use its CPUs in turn.  Return
+   0 if the team must not be bound.  */
+
+int
+gomp_affinity_team_cpus (int master_cpu, unsigned nthreads, unsigned *cpus)
+{
+  unsigned *places, *next;
+  unsigned i, master_place;
+  unsigned short j;
+
+  if (gomp_proc_bind_var == GOMP_PROC_BIND_FALSE || gomp_places_len == 0)
+    return 0;
+
+  master_place = 0;
+  next = gomp_alloca (gomp_places_len * sizeof (unsigned));
+  places = gomp_alloca (nthreads * sizeof (unsigned));
+
+  for (i = 0; i < gomp_places_len; i++)
+    next[i] = 0;
+
+  for (i = 0; i < gomp_places_len; i++)
+    for (j = 0; j < gomp_places[i].nr; j++)
+      if (gomp_places[i].cpus[j] == master_cpu)
+	{
+	  master_place = i;
+	  next[i] = j + 1;
+	  goto found;
+	}
+
+ found:
+  gomp_affinity_place_threads (gomp_proc_bind_var, master_place,
+			       gomp_places_len, nthreads, places);
+
+  cpus[0] = (master_cpu < 0) ? gomp_places[master_place].cpus[0] : master_cpu;
+
+  for (i = 1; i < nthreads; i++)
+    {
+      struct gomp_place *place = &gomp_places[places[i]];
+
+      cpus[i] = place->cpus[next[places[i]] % place->nr];
+      next[places[i]]++;
+    }
+
+  return 1;
 }
 
 void
-gomp_init_thread_affinity (pthread_attr_t *attr)
+gomp_init_thread_affinity (pthread_attr_t *attr, unsigned cpu)
 {
-  (void) attr;
+  pthread_attr_setcpuid_np (attr, cpu, NULL);
 }
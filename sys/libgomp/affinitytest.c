@@ -0,0 +1,260 @@
+/* Checks OMP_PLACES, OMP_PROC_BIND and GOMP_CPU_AFFINITY as the
+   runtime reads them, on a fake topology of 8 CPUs in 2 clusters
+   (sysconf is redirected), then the place given to every thread of a
+   team by the close, spread and master policies.  env.c and
+   affinity.c are included as is; only the two cpuid attributes of the
+   ALMOS pthread library are stubbed.
+
+     cc -Iinclude -o affinitytest affinitytest.c && ./affinitytest  */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/* Topology seen by gomp_init_affinity.  */
+static long test_cpus_nr = 8, test_clusters_nr = 2;
+
+#define _SC_NCLUSTERS_ONLN (-1)
+
+static long
+test_sysconf (int name)
+{
+  return (name == _SC_NCLUSTERS_ONLN) ? test_clusters_nr : test_cpus_nr;
+}
+
+static int
+pthread_attr_getcpuid_np (int *cpu)
+{
+  *cpu = 0;
+  return 0;
+}
+
+static int
+pthread_attr_setcpuid_np (pthread_attr_t *attr, int cpu, int *old)
+{
+  return 0;
+}
+
+#define sysconf test_sysconf
+#include "env.c"
+#include "affinity.c"
+#include "alloc.c"
+#include "error.c"
+#undef sysconf
+
+pthread_key_t gomp_tls_key;
+pthread_attr_t gomp_thread_attr;
+
+struct gomp_task_icv *
+gomp_new_icv (void)
+{
+  return &gomp_global_icv;
+}
+
+void
+gomp_init_num_threads (void)
+{
+}
+
+static int errors;
+
+#define CHECK(cond)							\
+  do {									\
+    if (!(cond))							\
+      {									\
+	printf ("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #cond);	\
+	errors++;							\
+      }									\
+  } while (0)
+
+static void
+reset (void)
+{
+  unsetenv ("OMP_PLACES");
+  unsetenv ("OMP_PROC_BIND");
+  unsetenv ("GOMP_CPU_AFFINITY");
+  gomp_places = NULL;
+  gomp_places_len = 0;
+  gomp_places_kind = GOMP_PLACES_NONE;
+  gomp_places_count = ULONG_MAX;
+  gomp_cpu_affinity = NULL;
+  gomp_cpu_affinity_len = 0;
+  gomp_proc_bind_var = GOMP_PROC_BIND_FALSE;
+}
+
+/* Compare place i with the n CPUs that follow.  */
+
+static int
+place_is (size_t i, unsigned n, ...)
+{
+  va_list ap;
+  unsigned j;
+  int ok;
+
+  if (i >= gomp_places_len || gomp_places[i].nr != n)
+    return 0;
+
+  va_start (ap, n);
+  for (ok = 1, j = 0; j < n; j++)
+    if (gomp_places[i].cpus[j] != va_arg (ap, int))
+      ok = 0;
+  va_end (ap);
+  return ok;
+}
+
+static void
+test_parse (void)
+{
+  reset ();
+  setenv ("OMP_PLACES", " {0:4}, {4:4:2},{1, 3,5} ", 1);
+  parse_places ();
+  CHECK (gomp_places_kind == GOMP_PLACES_EXPLICIT);
+  CHECK (gomp_places_len == 3);
+  CHECK (place_is (0, 4, 0, 1, 2, 3));
+  CHECK (place_is (1, 4, 4, 6, 8, 10));
+  CHECK (place_is (2, 3, 1, 3, 5));
+
+  reset ();
+  setenv ("OMP_PLACES", "threads(4)", 1);
+  parse_places ();
+  CHECK (gomp_places_kind == GOMP_PLACES_THREADS);
+  CHECK (gomp_places_count == 4);
+
+  reset ();
+  setenv ("OMP_PLACES", "SOCKETS", 1);
+  parse_places ();
+  CHECK (gomp_places_kind == GOMP_PLACES_CLUSTERS);
+  CHECK (gomp_places_count == ULONG_MAX);
+
+  /* Invalid lists leave the places unset.  */
+  static const char *bad[] = { "{0:0}", "{1", "{1},", "cores(0)", "cores(2", "{1:2:0}", "{70000}" };
+  size_t i;
+
+  for (i = 0; i < sizeof (bad) / sizeof (bad[0]); i++)
+    {
+      reset ();
+      setenv ("OMP_PLACES", bad[i], 1);
+      parse_places ();
+      CHECK (gomp_places_kind == GOMP_PLACES_NONE && gomp_places_len == 0);
+    }
+
+  reset ();
+  setenv ("OMP_PROC_BIND", "spread, close", 1);
+  CHECK (parse_proc_bind () && gomp_proc_bind_var == GOMP_PROC_BIND_SPREAD);
+  setenv ("OMP_PROC_BIND", "sideways", 1);
+  CHECK (!parse_proc_bind ());
+
+  reset ();
+  setenv ("GOMP_CPU_AFFINITY", "0-6:2 9", 1);
+  CHECK (parse_affinity ());
+  CHECK (gomp_cpu_affinity_len == 5);
+  CHECK (gomp_cpu_affinity_len == 5 && gomp_cpu_affinity[3] == 6 && gomp_cpu_affinity[4] == 9);
+}
+
+static void
+test_init (void)
+{
+  unsigned cpus[8];
+
+  /* 8 CPUs in 2 clusters.  */
+  reset ();
+  gomp_places_kind = GOMP_PLACES_CLUSTERS;
+  gomp_init_affinity ();
+  CHECK (gomp_places_len == 2);
+  CHECK (place_is (0, 4, 0, 1, 2, 3));
+  CHECK (place_is (1, 4, 4, 5, 6, 7));
+
+  reset ();
+  gomp_places_kind = GOMP_PLACES_CORES;
+  gomp_places_count = 3;
+  gomp_init_affinity ();
+  CHECK (gomp_places_len == 3 && place_is (2, 1, 2));
+
+  /* Offline CPUs are dropped, then empty places.  */
+  reset ();
+  setenv ("OMP_PLACES", "{6:4},{9},{2}", 1);
+  parse_places ();
+  gomp_init_affinity ();
+  CHECK (gomp_places_len == 2);
+  CHECK (place_is (0, 2, 6, 7));
+  CHECK (place_is (1, 1, 2));
+
+  /* No place left disables binding.  */
+  reset ();
+  setenv ("OMP_PLACES", "{12}", 1);
+  parse_places ();
+  gomp_proc_bind_var = GOMP_PROC_BIND_TRUE;
+  gomp_init_affinity ();
+  CHECK (gomp_places_len == 0 && gomp_proc_bind_var == GOMP_PROC_BIND_FALSE);
+
+  /* Threads sharing a cluster place use its CPUs in turn, from the
+     master's.  */
+  reset ();
+  gomp_places_kind = GOMP_PLACES_CLUSTERS;
+  gomp_proc_bind_var = GOMP_PROC_BIND_CLOSE;
+  gomp_init_affinity ();
+  CHECK (gomp_affinity_team_cpus (5, 4, cpus) == 1);
+  CHECK (cpus[0] == 5 && cpus[1] == 6 && cpus[2] == 0 && cpus[3] == 1);
+
+  gomp_proc_bind_var = GOMP_PROC_BIND_FALSE;
+  CHECK (gomp_affinity_team_cpus (5, 4, cpus) == 0);
+}
+
+static int
+places_are (const unsigned *places, unsigned n, const unsigned *want)
+{
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+    if (places[i] != want[i])
+      return 0;
+  return 1;
+}
+
+static void
+test_place_threads (void)
+{
+  unsigned p[16];
+
+  gomp_affinity_place_threads (GOMP_PROC_BIND_MASTER, 3, 8, 4, p);
+  CHECK (places_are (p, 4, (unsigned []) { 3, 3, 3, 3 }));
+
+  gomp_affinity_place_threads (GOMP_PROC_BIND_CLOSE, 6, 8, 4, p);
+  CHECK (places_are (p, 4, (unsigned []) { 6, 7, 0, 1 }));
+
+  gomp_affinity_place_threads (GOMP_PROC_BIND_TRUE, 0, 4, 4, p);
+  CHECK (places_are (p, 4, (unsigned []) { 0, 1, 2, 3 }));
+
+  /* More threads than places: the first places get one more.  */
+  gomp_affinity_place_threads (GOMP_PROC_BIND_CLOSE, 1, 4, 10, p);
+  CHECK (places_are (p, 10, (unsigned []) { 1, 1, 1, 2, 2, 2, 3, 3, 0, 0 }));
+
+  /* Spread: the first place of each of 3 sub-partitions of 3, 3 and 2
+     places.  */
+  gomp_affinity_place_threads (GOMP_PROC_BIND_SPREAD, 0, 8, 3, p);
+  CHECK (places_are (p, 3, (unsigned []) { 0, 3, 6 }));
+
+  gomp_affinity_place_threads (GOMP_PROC_BIND_SPREAD, 5, 8, 4, p);
+  CHECK (places_are (p, 4, (unsigned []) { 5, 7, 1, 3 }));
+
+  /* Spread with more threads than places is close.  */
+  gomp_affinity_place_threads (GOMP_PROC_BIND_SPREAD, 2, 3, 5, p);
+  CHECK (places_are (p, 5, (unsigned []) { 2, 2, 0, 0, 1 }));
+}
+
+int
+main (void)
+{
+  test_parse ();
+  test_init ();
+  test_place_threads ();
+
+  if (errors)
+    {
+      printf ("%d checks failed\n", errors);
+      return 1;
+    }
+
+  printf ("affinity tests passed\n");
+  return 0;
+}
@@ -22,144 +22,98 @@
    see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
    <http://www.gnu.org/licenses/>.  */
 
-/* This is the default implementation of a barrier synchronization mechanism
-   for libgomp.  This type is private to the library.  Note that we rely on
-   being able to adjust the barrier count while threads are blocked, so the
-   POSIX pthread_barrier_t won't work.  */
+/* This is a generation counter implementation of a barrier
+   synchronization mechanism for libgomp, see bar.h.  */
 
+#include <limits.h>
 #include <gomp/libgomp.h>
+#include <gomp/wait.h>
 
 
 void
-gomp_barrier_init (gomp_barrier_t *bar, unsigned count)
+gomp_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 {
-  gomp_mutex_init (&bar->mutex1);
-#ifndef HAVE_SYNC_BUILTINS
-  gomp_mutex_init (&bar->mutex2);
-#endif
-  gomp_sem_init (&bar->sem1, 0);
-  gomp_sem_init (&bar->sem2, 0);
-  bar->total = count;
-  bar->arrived = 0;
-  bar->generation = 0;
-}
+  if (__builtin_expect ((state & 1) != 0, 0))
+    {
+      /* Next time we'll be awaiting TOTAL threads again.  */
+      bar->awaited = bar->total;
+      __sync_synchronize ();
+      bar->generation += 4;
+      gomp_futex_wake ((int *) &bar->generation, INT_MAX);
+    }
+  else
+    {
+      unsigned int generation = state;
 
-void
-gomp_barrier_destroy (gomp_barrier_t *bar)
-{
-  /* Before destroying, make sure all threads have left the barrier.  */
-  gomp_mutex_lock (&bar->mutex1);
-  gomp_mutex_unlock (&bar->mutex1);
-
-  gomp_mutex_destroy (&bar->mutex1);
-#ifndef HAVE_SYNC_BUILTINS
-  gomp_mutex_destroy (&bar->mutex2);
-#endif
-  gomp_sem_destroy (&bar->sem1);
-  gomp_sem_destroy (&bar->sem2);
+      do
+	do_wait ((int *) &bar->generation, generation);
+      while (*(volatile unsigned *) &bar->generation == generation);
+    }
 }
 
 void
-gomp_barrier_reinit (gomp_barrier_t *bar, unsigned count)
+gomp_barrier_wait (gomp_barrier_t *bar)
 {
-  gomp_mutex_lock (&bar->mutex1);
-  bar->total = count;
-  gomp_mutex_unlock (&bar->mutex1);
+  gomp_barrier_wait_end (bar, gomp_barrier_wait_start (bar));
 }
 
+/* Like gomp_barrier_wait, except that if the encountering thread
+   is not the last one to hit the barrier, it returns immediately.
+   The intended usage is that a thread which intends to gomp_barrier_destroy
+   this barrier calls gomp_barrier_wait, while all other threads
+   call gomp_barrier_wait_last.  When gomp_barrier_wait returns,
+   the barrier can be safely destroyed.  */
+
 void
-gomp_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
+gomp_barrier_wait_last (gomp_barrier_t *bar)
 {
-  unsigned int n;
-
+  gomp_barrier_state_t state = gomp_barrier_wait_start (bar);
   if (state & 1)
-    {
-      n = --bar->arrived;
-      if (n > 0)
-	{
-	  do
-	    gomp_sem_post (&bar->sem1);
-	  while (--n != 0);
-	  gomp_sem_wait (&bar->sem2);
-	}
-      gomp_mutex_unlock (&bar->mutex1);
-    }
-  else
-    {
-      gomp_mutex_unlock (&bar->mutex1);
-      gomp_sem_wait (&bar->sem1);
-
-#ifdef HAVE_SYNC_BUILTINS
-      n = __sync_add_and_fetch (&bar->arrived, -1);
-#else
-      gomp_mutex_lock (&bar->mutex2);
-      n = --bar->arrived;
-      gomp_mutex_unlock (&bar->mutex2);
-#endif
-
-      if (n == 0)
-	gomp_sem_post (&bar->sem2);
-    }
+    gomp_barrier_wait_end (bar, state);
 }
 
 void
-gomp_barrier_wait (gomp_barrier_t *barrier)
+gomp_team_barrier_wake (gomp_barrier_t *bar, int count)
 {
-  gomp_barrier_wait_end (barrier, gomp_barrier_wait_start (barrier));
+  gomp_futex_wake ((int *) &bar->generation, count == 0 ? INT_MAX : count);
 }
 
 void
 gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 {
-  unsigned int n;
+  unsigned int generation;
 
-  if (state & 1)
+  if (__builtin_expect ((state & 1) != 0, 0))
     {
-      n = --bar->arrived;
+      /* Next time we'll be awaiting TOTAL threads again.  */
       struct gomp_thread *thr = gomp_thread ();
       struct gomp_team *team = thr->ts.team;
 
-      if (team->task_count)
+      bar->awaited = bar->total;
+      __sync_synchronize ();
+      if (__builtin_expect (team->task_count, 0))
 	{
 	  gomp_barrier_handle_tasks (state);
-	  if (n > 0)
-	    gomp_sem_wait (&bar->sem2);
-	  gomp_mutex_unlock (&bar->mutex1);
-	  return;
+	  state &= ~1;
 	}
-
-      bar->generation = state + 3;
-      if (n > 0)
+      else
 	{
-	  do
-	    gomp_sem_post (&bar->sem1);
-	  while (--n != 0);
-	  gomp_sem_wait (&bar->sem2);
+	  bar->generation = state + 3;
+	  gomp_futex_wake ((int *) &bar->generation, INT_MAX);
+	  return;
 	}
-      gomp_mutex_unlock (&bar->mutex1);
     }
-  else
+
+  generation = state;
+  do
     {
-      gomp_mutex_unlock (&bar->mutex1);
-      do
-	{
-	  gomp_sem_wait (&bar->sem1);
-	  if (bar->generation & 1)
-	    gomp_barrier_handle_tasks (state);
-	}
-      while (bar->generation != state + 4);
-
-#ifdef HAVE_SYNC_BUILTINS
-      n = __sync_add_and_fetch (&bar->arrived, -1);
-#else
-      gomp_mutex_lock (&bar->mutex2);
-      n = --bar->arrived;
-      gomp_mutex_unlock (&bar->mutex2);
-#endif
-
-      if (n == 0)
-	gomp_sem_post (&bar->sem2);
+      do_wait ((int *) &bar->generation, generation);
+      if (__builtin_expect (*(volatile unsigned *) &bar->generation & 1, 0))
+	gomp_barrier_handle_tasks (state);
+      if ((*(volatile unsigned *) &bar->generation & 2))
+	generation |= 2;
     }
+  while (*(volatile unsigned *) &bar->generation != state + 4);
 }
 
 void
@@ -167,12 +121,3 @@ gomp_team_barrier_wait (gomp_barrier_t *barrier)
 {
   gomp_team_barrier_wait_end (barrier, gomp_barrier_wait_start (barrier));
 }
-
-void
-gomp_team_barrier_wake (gomp_barrier_t *bar, int count)
-{
-  if (count == 0)
-    count = bar->total - 1;
-  while (count-- > 0)
-    gomp_sem_post (&bar->sem1);
-}
@@ -133,13 +133,15 @@ GOMP_atomic_end (void)
   gomp_mutex_unlock (&atomic_lock);
 }
 
-#if !GOMP_MUTEX_INIT_0
+/* Called by crt0, static locks need no initialization when zero is
+   a valid unlocked mutex.  */
 void initialize_critical (void)
 {
+#if !GOMP_MUTEX_INIT_0
   gomp_mutex_init (&default_lock);
   gomp_mutex_init (&atomic_lock);
 #ifndef HAVE_SYNC_BUILTINS
   gomp_mutex_init (&create_lock_lock);
 #endif
-}
 #endif
+}
@@ -43,6 +43,7 @@
 #endif
 #include <limits.h>
 #include <errno.h>
+#include <unistd.h>
 
 #ifndef HAVE_STRTOULL
 # define strtoull(ptr, eptr, base) strtoul (ptr, eptr, base)
@@ -58,6 +59,11 @@ struct gomp_task_icv gomp_global_icv = {
 
 unsigned short *gomp_cpu_affinity;
 size_t gomp_cpu_affinity_len;
+enum gomp_proc_bind gomp_proc_bind_var = GOMP_PROC_BIND_FALSE;
+enum gomp_places_kind gomp_places_kind = GOMP_PLACES_NONE;
+unsigned long gomp_places_count = ULONG_MAX;
+struct gomp_place *gomp_places;
+size_t gomp_places_len;
 unsigned long gomp_max_active_levels_var = INT_MAX;
 unsigned long gomp_thread_limit_var = ULONG_MAX;
 unsigned long gomp_remaining_threads_count;
@@ -65,6 +71,7 @@ unsigned long gomp_remaining_threads_count;
 gomp_mutex_t gomp_remaining_threads_lock;
 #endif
 unsigned long gomp_available_cpus = 1, gomp_managed_threads = 1;
+unsigned long gomp_cpus_per_cluster = 1;
 unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
 
 /* Parse the OMP_SCHEDULE environment variable.  */
@@ -469,10 +476,228 @@ parse_affinity (void)
   return false;
 }
 
+/* Parse the OMP_PROC_BIND environment variable.  Only the first item
+   of a list is used, nested teams are not bound.  Return true if one
+   was present and it was successfully parsed.  */
+
+static bool
+parse_proc_bind (void)
+{
+  static const struct
+  {
+    const char *name;
+    size_t len;
+    enum gomp_proc_bind kind;
+  } kinds[] =
+  {
+    { "false", 5, GOMP_PROC_BIND_FALSE },
+    { "true", 4, GOMP_PROC_BIND_TRUE },
+    { "master", 6, GOMP_PROC_BIND_MASTER },
+    { "close", 5, GOMP_PROC_BIND_CLOSE },
+    { "spread", 6, GOMP_PROC_BIND_SPREAD }
+  };
+  char *env;
+  size_t i;
+
+  env = getenv ("OMP_PROC_BIND");
+  if (env == NULL)
+    return false;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+
+  for (i = 0; i < sizeof (kinds) / sizeof (kinds[0]); i++)
+    if (strncasecmp (env, kinds[i].name, kinds[i].len) == 0)
+      {
+	env += kinds[i].len;
+	while (isspace ((unsigned char) *env))
+	  ++env;
+	if (*env == '\0' || *env == ',')
+	  {
+	    gomp_proc_bind_var = kinds[i].kind;
+	    return true;
+	  }
+	break;
+      }
+
+  gomp_error ("Invalid value for environment variable OMP_PROC_BIND");
+  return false;
+}
+
+/* Parse one "{res,res,...}" place of OMP_PLACES, where res is
+   "cpu[:len[:stride]]".  Return the position after the closing
+   brace, NULL if invalid.  */
+
+static char *
+parse_one_place (char *env, struct gomp_place *place)
+{
+  unsigned long cpu, len, stride;
+  unsigned short *cpus = NULL;
+  size_t used = 0;
+  char *end;
+
+  if (*env != '{')
+    return NULL;
+
+  do
+    {
+      ++env;
+      while (isspace ((unsigned char) *env))
+	++env;
+
+      cpu = strtoul (env, &end, 10);
+      if (env == end || cpu >= 65536)
+	goto invalid;
+
+      len = 1;
+      stride = 1;
+      env = end;
+      if (*env == ':')
+	{
+	  len = strtoul (++env, &end, 10);
+	  if (env == end || len == 0 || len >= 65536)
+	    goto invalid;
+	  env = end;
+	  if (*env == ':')
+	    {
+	      stride = strtoul (++env, &end, 10);
+	      if (env == end || stride == 0 || stride >= 65536)
+		goto invalid;
+	      env = end;
+	    }
+	}
+
+      if (cpu + (len - 1) * stride >= 65536 || used + len >= 65536)
+	goto invalid;
+
+      cpus = gomp_realloc (cpus, (used + len) * sizeof (unsigned short));
+      while (len--)
+	{
+	  cpus[used++] = cpu;
+	  cpu += stride;
+	}
+
+      while (isspace ((unsigned char) *env))
+	++env;
+    }
+  while (*env == ',');
+
+  if (*env != '}')
+    goto invalid;
+
+  place->cpus = cpus;
+  place->nr = used;
+  return env + 1;
+
+ invalid:
+  free (cpus);
+  return NULL;
+}
+
+/* Parse the OMP_PLACES environment variable: either an abstract name
+   (threads, cores, clusters or sockets, optionally followed by a
+   count in parentheses) resolved by gomp_init_affinity against the
+   machine topology, or an explicit list of places.  */
+
+static void
+parse_places (void)
+{
+  static const struct
+  {
+    const char *name;
+    size_t len;
+    enum gomp_places_kind kind;
+  } kinds[] =
+  {
+    { "threads", 7, GOMP_PLACES_THREADS },
+    { "cores", 5, GOMP_PLACES_CORES },
+    { "clusters", 8, GOMP_PLACES_CLUSTERS },
+    { "sockets", 7, GOMP_PLACES_CLUSTERS }
+  };
+  struct gomp_place *places = NULL;
+  size_t used = 0, i;
+  unsigned long count;
+  char *env, *end;
+
+  env = getenv ("OMP_PLACES");
+  if (env == NULL)
+    return;
+
+  while (isspace ((unsigned char) *env))
+    ++env;
+
+  for (i = 0; i < sizeof (kinds) / sizeof (kinds[0]); i++)
+    if (strncasecmp (env, kinds[i].name, kinds[i].len) == 0)
+      {
+	env += kinds[i].len;
+	count = ULONG_MAX;
+	while (isspace ((unsigned char) *env))
+	  ++env;
+	if (*env == '(')
+	  {
+	    count = strtoul (++env, &end, 10);
+	    if (env == end || count == 0 || *end != ')')
+	      goto invalid;
+	    env = end + 1;
+	    while (isspace ((unsigned char) *env))
+	      ++env;
+	  }
+	if (*env != '\0')
+	  goto invalid;
+	gomp_places_kind = kinds[i].kind;
+	gomp_places_count = count;
+	return;
+      }
+
+  do
+    {
+      while (isspace ((unsigned char) *env))
+	++env;
+      places = gomp_realloc (places, (used + 1) * sizeof (struct gomp_place));
+      env = parse_one_place (env, &places[used]);
+      if (env == NULL)
+	goto invalid;
+      ++used;
+      while (isspace ((unsigned char) *env))
+	++env;
+    }
+  while (*env++ == ',');
+
+  if (env[-1] != '\0')
+    goto invalid;
+
+  gomp_places = places;
+  gomp_places_len = used;
+  gomp_places_kind = GOMP_PLACES_EXPLICIT;
+  return;
+
+ invalid:
+  for (i = 0; i < used; i++)
+    free (places[i].cpus);
+  free (places);
+  gomp_error ("Invalid value for environment variable OMP_PLACES");
+}
+
+/* Used to steal tasks from threads of the same cluster first.  */
+
+static void
+gomp_init_cpus_per_cluster (void)
+{
+  long cpus_nr, clusters_nr;
+
+  cpus_nr = sysconf (_SC_NPROCESSORS_ONLN);
+  clusters_nr = sysconf (_SC_NCLUSTERS_ONLN);
+
+  if (cpus_nr > 0 && clusters_nr > 0 && clusters_nr <= cpus_nr
+      && cpus_nr % clusters_nr == 0)
+    gomp_cpus_per_cluster = cpus_nr / clusters_nr;
+}
+
 void initialize_env (void)
 {
   unsigned long stacksize;
   int wait_policy;
+  bool proc_bind, cpu_affinity;
 
   /* Do a compile time check that mkomp_h.pl did good job.  */
   //omp_check_defines();
@@ -489,9 +714,16 @@ void initialize_env (void)
 #endif
   gomp_init_num_threads ();
   gomp_available_cpus = gomp_global_icv.nthreads_var;
+  gomp_init_cpus_per_cluster ();
   if (!parse_unsigned_long ("OMP_NUM_THREADS", &gomp_global_icv.nthreads_var))
     gomp_global_icv.nthreads_var = gomp_available_cpus;
-  if (parse_affinity ())
+  proc_bind = parse_proc_bind ();
+  parse_places ();
+  cpu_affinity = parse_affinity ();
+  /* Giving places, or a CPU list, implies binding.  */
+  if (!proc_bind && (cpu_affinity || gomp_places_kind != GOMP_PLACES_NONE))
+    gomp_proc_bind_var = GOMP_PROC_BIND_TRUE;
+  if (gomp_proc_bind_var != GOMP_PROC_BIND_FALSE)
     gomp_init_affinity ();
   wait_policy = parse_wait_policy ();
   if (!parse_spincount ("GOMP_SPINCOUNT", &gomp_spin_count_var))
@@ -641,6 +873,12 @@ omp_get_max_active_levels (void)
   return gomp_max_active_levels_var;
 }
 
+omp_proc_bind_t
+omp_get_proc_bind (void)
+{
+  return (omp_proc_bind_t) gomp_proc_bind_var;
+}
+
 ialias (omp_set_dynamic)
 ialias (omp_set_nested)
 ialias (omp_set_num_threads)
@@ -652,3 +890,4 @@ ialias (omp_get_max_threads)
 ialias (omp_get_thread_limit)
 ialias (omp_set_max_active_levels)
 ialias (omp_get_max_active_levels)
+ialias (omp_get_proc_bind)
@@ -22,35 +22,43 @@
    see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
    <http://www.gnu.org/licenses/>.  */
 
-/* This is the default implementation of a barrier synchronization mechanism
-   for libgomp.  This type is private to the library.  Note that we rely on
-   being able to adjust the barrier count while threads are blocked, so the
-   POSIX pthread_barrier_t won't work.  */
+/* This is a generation counter barrier synchronization mechanism for
+   libgomp, modeled on the Linux futex implementation.  Threads spin on
+   the generation for GOMP_SPINCOUNT iterations before blocking in
+   gomp_futex_wait.  This type is private to the library.  */
 
 #ifndef GOMP_BARRIER_H
 #define GOMP_BARRIER_H 1
 
-#include <pthread.h>
-
 typedef struct
 {
-  gomp_mutex_t mutex1;
-#ifndef HAVE_SYNC_BUILTINS
-  gomp_mutex_t mutex2;
-#endif
-  gomp_sem_t sem1;
-  gomp_sem_t sem2;
-  unsigned total;
-  unsigned arrived;
+  /* Make sure total/generation is in a mostly read cacheline, while
+     awaited in a separate cacheline.  */
+  unsigned total __attribute__((aligned (64)));
   unsigned generation;
+  unsigned awaited __attribute__((aligned (64)));
 } gomp_barrier_t;
 typedef unsigned int gomp_barrier_state_t;
 
-extern void gomp_barrier_init (gomp_barrier_t *, unsigned);
-extern void gomp_barrier_reinit (gomp_barrier_t *, unsigned);
-extern void gomp_barrier_destroy (gomp_barrier_t *);
+static inline void gomp_barrier_init (gomp_barrier_t *bar, unsigned count)
+{
+  bar->total = count;
+  bar->awaited = count;
+  bar->generation = 0;
+}
+
+static inline void gomp_barrier_reinit (gomp_barrier_t *bar, unsigned count)
+{
+  __sync_fetch_and_add (&bar->awaited, count - bar->total);
+  bar->total = count;
+}
+
+static inline void gomp_barrier_destroy (gomp_barrier_t *bar)
+{
+}
 
 extern void gomp_barrier_wait (gomp_barrier_t *);
+extern void gomp_barrier_wait_last (gomp_barrier_t *);
 extern void gomp_barrier_wait_end (gomp_barrier_t *, gomp_barrier_state_t);
 extern void gomp_team_barrier_wait (gomp_barrier_t *);
 extern void gomp_team_barrier_wait_end (gomp_barrier_t *,
@@ -60,10 +68,8 @@ extern void gomp_team_barrier_wake (gomp_barrier_t *, int);
 static inline gomp_barrier_state_t
 gomp_barrier_wait_start (gomp_barrier_t *bar)
 {
-  unsigned int ret;
-  gomp_mutex_lock (&bar->mutex1);
-  ret = bar->generation & ~3;
-  ret += ++bar->arrived == bar->total;
+  unsigned int ret = bar->generation & ~3;
+  ret += __sync_add_and_fetch (&bar->awaited, -1) == 0;
   return ret;
 }
 
@@ -73,31 +79,27 @@ gomp_barrier_last_thread (gomp_barrier_state_t state)
   return state & 1;
 }
 
-static inline void
-gomp_barrier_wait_last (gomp_barrier_t *bar)
-{
-  gomp_barrier_wait (bar);
-}
-
-/* All the inlines below must be called with team->task_lock
-   held.  */
+/* Task queues are lock-free, so the pending and waiting bits may be
+   changed concurrently and are updated atomically.  gomp_team_barrier_done
+   must be called with team->task_lock held.  */
 
 static inline void
 gomp_team_barrier_set_task_pending (gomp_barrier_t *bar)
 {
-  bar->generation |= 1;
+  if ((bar->generation & 1) == 0)
+    __sync_fetch_and_or (&bar->generation, 1);
 }
 
 static inline void
 gomp_team_barrier_clear_task_pending (gomp_barrier_t *bar)
 {
-  bar->generation &= ~1;
+  __sync_fetch_and_and (&bar->generation, ~1U);
 }
 
 static inline void
 gomp_team_barrier_set_waiting_for_tasks (gomp_barrier_t *bar)
 {
-  bar->generation |= 2;
+  __sync_fetch_and_or (&bar->generation, 2);
 }
 
 static inline bool
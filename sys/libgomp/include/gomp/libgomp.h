@@ -121,6 +121,13 @@ struct gomp_work_share
      in the first gomp_work_share struct in the block.  */
   struct gomp_work_share *next_alloc;
 
+  /* Per-cluster dispensers of non-ordered DYNAMIC and GUIDED loops run
+     by threads of several clusters, NULL otherwise.  */
+  struct gomp_iter_cluster *clusters;
+  unsigned nclusters;
+  /* Block clusters was carved from, rounded up to a cache line.  */
+  void *clusters_alloc;
+
   /* The above fields are written once during workshare initialization,
      or related to ordered worksharing.  Make sure the following fields
      are in a different cache line.  */
@@ -161,6 +168,17 @@ struct gomp_work_share
   unsigned inline_ordered_team_ids[0];
 };
 
+/* A cluster's share of the iterations of a loop, refilled from the work
+   share's next by super-chunks and handed out chunk by chunk to the
+   threads of the cluster.  */
+
+struct gomp_iter_cluster
+{
+  gomp_mutex_t lock;
+  long next;
+  long end;
+} __attribute__((aligned (64)));
+
 /* This structure contains all of the thread-local data associated with 
    a thread team.  This is the data that must be saved when a thread
    encounters a nested PARALLEL construct.  */
@@ -228,6 +246,7 @@ extern gomp_mutex_t gomp_remaining_threads_lock;
 extern unsigned long gomp_max_active_levels_var;
 extern unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
 extern unsigned long gomp_available_cpus, gomp_managed_threads;
+extern unsigned long gomp_cpus_per_cluster;
 
 enum gomp_task_kind
 {
@@ -242,20 +261,43 @@ enum gomp_task_kind
 struct gomp_task
 {
   struct gomp_task *parent;
-  struct gomp_task *children;
-  struct gomp_task *next_child;
-  struct gomp_task *prev_child;
-  struct gomp_task *next_queue;
-  struct gomp_task *prev_queue;
   struct gomp_task_icv icv;
   void (*fn) (void *);
   void *fn_data;
   enum gomp_task_kind kind;
-  bool in_taskwait;
+  /* Number of children not yet completed, GOMP_taskwait waits for 0.  */
+  int num_children;
+  /* One reference held by the task itself until it completes, plus one
+     per child until the child is released.  Heap allocated tasks are
+     freed when it drops to 0, undeferred ones live on the stack and wait
+     for it to drop to 1 before returning, which keeps the parent chain
+     of any pending task valid.  */
+  int refs;
+  /* GOMP_TASK_WAIT_CHILDREN or GOMP_TASK_WAIT_REFS while the task sleeps
+     on taskwait_sem, 0 otherwise.  */
+  int in_taskwait;
   bool in_tied_task;
   gomp_sem_t taskwait_sem;
 };
 
+#define GOMP_TASK_WAIT_CHILDREN 1
+#define GOMP_TASK_WAIT_REFS 2
+
+/* Chase-Lev work-stealing deque of deferred tasks.  The owner thread
+   pushes and pops at BOTTOM, other threads of the team steal at TOP.  */
+
+#define GOMP_TASK_DEQUE_SIZE 128
+
+struct gomp_task_deque
+{
+  volatile long top __attribute__((aligned (64)));
+  /* Keep thieves' and owner's indexes on different cache lines.  */
+  volatile long bottom __attribute__((aligned (64)));
+  /* Cluster of the owner, set on its first push.  */
+  int cluster;
+  struct gomp_task *tasks[GOMP_TASK_DEQUE_SIZE];
+};
+
 /* This structure describes a "team" of threads.  These are the threads
    that are spawned by a PARALLEL constructs, as well as the work sharing
    constructs that the team encounters.  */
@@ -311,8 +353,12 @@ struct gomp_team
      structs in the common case.  */
   struct gomp_work_share work_shares[8];
 
+  /* Only serializes the end of a team barrier against the completion
+     of the last task, queues are the lock-free deques below.  */
   gomp_mutex_t task_lock;
-  struct gomp_task *task_queue;
+  /* One deque per thread, indexed by team_id, carved from the end of
+     the team block on a cache line boundary.  */
+  struct gomp_task_deque *task_deques;
   int task_count;
   int task_running_count;
 
@@ -374,6 +420,17 @@ static inline struct gomp_thread *gomp_thread (void)
 }
 #endif
 
+/* Cluster of the CPU the calling thread is bound to.  */
+
+static inline int gomp_cpu_cluster (void)
+{
+  int cpu;
+
+  if (pthread_attr_getcpuid_np (&cpu) != 0 || cpu < 0)
+    return 0;
+  return cpu / gomp_cpus_per_cluster;
+}
+
 extern struct gomp_task_icv *gomp_new_icv (void);
 
 /* Here's how to access the current copy of the ICVs.  */
@@ -397,12 +454,51 @@ extern pthread_attr_t gomp_thread_attr;
 extern unsigned short *gomp_cpu_affinity;
 extern size_t gomp_cpu_affinity_len;
 
+/* OMP_PROC_BIND policy, only the outermost level is honoured.  */
+
+enum gomp_proc_bind
+{
+  GOMP_PROC_BIND_FALSE = 0,
+  GOMP_PROC_BIND_TRUE,
+  GOMP_PROC_BIND_MASTER,
+  GOMP_PROC_BIND_CLOSE,
+  GOMP_PROC_BIND_SPREAD
+};
+
+/* OMP_PLACES abstract names, explicit lists are built by env.c.  */
+
+enum gomp_places_kind
+{
+  GOMP_PLACES_NONE = 0,
+  GOMP_PLACES_THREADS,
+  GOMP_PLACES_CORES,
+  GOMP_PLACES_CLUSTERS,
+  GOMP_PLACES_EXPLICIT
+};
+
+/* A place is a set of CPUs, given by their global ids.  */
+
+struct gomp_place
+{
+  unsigned short *cpus;
+  unsigned short nr;
+};
+
+extern enum gomp_proc_bind gomp_proc_bind_var;
+extern enum gomp_places_kind gomp_places_kind;
+extern unsigned long gomp_places_count;
+extern struct gomp_place *gomp_places;
+extern size_t gomp_places_len;
+
 /* Function prototypes.  */
 
 /* affinity.c */
 
 extern void gomp_init_affinity (void);
-extern void gomp_init_thread_affinity (pthread_attr_t *);
+extern void gomp_affinity_place_threads (enum gomp_proc_bind, unsigned,
+					 unsigned, unsigned, unsigned *);
+extern int gomp_affinity_team_cpus (int, unsigned, unsigned *);
+extern void gomp_init_thread_affinity (pthread_attr_t *, unsigned);
 
 /* alloc.c */
 
@@ -431,6 +527,8 @@ extern int gomp_iter_guided_next_locked (long *, long *);
 extern bool gomp_iter_dynamic_next (long *, long *);
 extern bool gomp_iter_guided_next (long *, long *);
 #endif
+extern void gomp_iter_cluster_init (struct gomp_work_share *, unsigned);
+extern int gomp_iter_cluster_next (long *, long *);
 
 /* iter_ull.c */
 
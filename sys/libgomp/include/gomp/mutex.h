@@ -22,36 +22,47 @@
    see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
    <http://www.gnu.org/licenses/>.  */
 
-/* This is the default PTHREADS implementation of a mutex synchronization
-   mechanism for libgomp.  This type is private to the library.  */
+/* This is a word sized mutex synchronization mechanism for libgomp,
+   modeled on the Linux futex implementation.  The uncontended paths
+   are a single atomic operation, contended threads spin for a while
+   then block in the kernel through gomp_futex_wait.  This type is
+   private to the library.  */
 
 #ifndef GOMP_MUTEX_H
 #define GOMP_MUTEX_H 1
 
-#include <pthread.h>
+/* 0: unlocked, 1: locked, 2: locked with possible waiters.  */
+typedef int gomp_mutex_t;
 
-typedef pthread_mutex_t gomp_mutex_t;
-
-#define GOMP_MUTEX_INIT_0 0
+#define GOMP_MUTEX_INIT_0 1
 
 static inline void gomp_mutex_init (gomp_mutex_t *mutex)
 {
-  pthread_mutex_init (mutex, NULL);
+  *mutex = 0;
 }
 
+extern void gomp_mutex_lock_slow (gomp_mutex_t *mutex, int);
 static inline void gomp_mutex_lock (gomp_mutex_t *mutex)
 {
-  pthread_mutex_lock (mutex);
+  int oldval = __sync_val_compare_and_swap (mutex, 0, 1);
+  if (__builtin_expect (oldval, 0))
+    gomp_mutex_lock_slow (mutex, oldval);
 }
 
+extern void gomp_mutex_unlock_slow (gomp_mutex_t *mutex);
 static inline void gomp_mutex_unlock (gomp_mutex_t *mutex)
 {
-   pthread_mutex_unlock (mutex);
+  int val;
+
+  /* __sync_lock_test_and_set is only an acquire barrier.  */
+  __sync_synchronize ();
+  val = __sync_lock_test_and_set (mutex, 0);
+  if (__builtin_expect (val > 1, 0))
+    gomp_mutex_unlock_slow (mutex);
 }
 
 static inline void gomp_mutex_destroy (gomp_mutex_t *mutex)
 {
-  pthread_mutex_destroy (mutex);
 }
 
 #endif /* GOMP_MUTEX_H */
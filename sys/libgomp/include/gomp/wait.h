@@ -0,0 +1,69 @@
+/* Copyright (C) 2005, 2008, 2009 Free Software Foundation, Inc.
+   Contributed by Richard Henderson <rth@redhat.com>.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is a user-space emulation of the Linux futex wait/wake
+   operations used by the mutex and the barrier of libgomp: threads
+   block with SYS_SLEEP in a wait queue hashed on the address, after
+   spinning up to GOMP_SPINCOUNT iterations.  This file is private to
+   the library.  */
+
+#ifndef GOMP_WAIT_H
+#define GOMP_WAIT_H 1
+
+/* Block while *ADDR == VAL, until woken up by gomp_futex_wake.
+   Spurious returns are possible, callers must recheck *ADDR.  */
+extern void gomp_futex_wait (int *addr, int val);
+
+/* Wake up at most COUNT threads blocked on ADDR.  */
+extern void gomp_futex_wake (int *addr, int count);
+
+static inline void cpu_relax (void)
+{
+  __asm__ volatile ("" : : : "memory");
+}
+
+/* Spin until *ADDR != VAL, return nonzero if it has not changed
+   after the spin count.  */
+
+static inline int do_spin (int *addr, int val)
+{
+  unsigned long long i, count = gomp_spin_count_var;
+
+  if (__builtin_expect (gomp_managed_threads > gomp_available_cpus, 0))
+    count = gomp_throttled_spin_count_var;
+  for (i = 0; i < count; i++)
+    if (__builtin_expect (*(volatile int *) addr != val, 0))
+      return 0;
+    else
+      cpu_relax ();
+  return 1;
+}
+
+static inline void do_wait (int *addr, int val)
+{
+  if (do_spin (addr, val))
+    gomp_futex_wait (addr, val);
+}
+
+#endif /* GOMP_WAIT_H */
@@ -43,6 +43,15 @@ typedef enum omp_sched_t
   omp_sched_auto = 4
 } omp_sched_t;
 
+typedef enum omp_proc_bind_t
+{
+  omp_proc_bind_false = 0,
+  omp_proc_bind_true = 1,
+  omp_proc_bind_master = 2,
+  omp_proc_bind_close = 3,
+  omp_proc_bind_spread = 4
+} omp_proc_bind_t;
+
 #ifdef __cplusplus
 extern "C" {
 # define __GOMP_NOTHROW throw ()
@@ -55,6 +64,7 @@ extern int omp_get_num_threads (void) __GOMP_NOTHROW;
 extern int omp_get_max_threads (void) __GOMP_NOTHROW;
 extern int omp_get_thread_num (void) __GOMP_NOTHROW;
 extern int omp_get_num_procs (void) __GOMP_NOTHROW;
+extern omp_proc_bind_t omp_get_proc_bind (void) __GOMP_NOTHROW;
 
 extern int omp_in_parallel (void) __GOMP_NOTHROW;
 
@@ -26,6 +26,7 @@
    for loops and sections.  */
 
 #include <gomp/libgomp.h>
+#include <limits.h>
 #include <stdlib.h>
 
 /* This function implements the STATIC scheduling method.  The caller should
@@ -331,3 +332,171 @@ gomp_iter_guided_next (long *pstart, long *pend)
   return true;
 }
 #endif /* HAVE_SYNC_BUILTINS */
+
+
+/* Hierarchical dispensing of DYNAMIC and GUIDED loops.  Each cluster
+   grabs a super-chunk of up to GOMP_ITER_CLUSTER_CHUNKS chunks per CPU
+   under ws->lock and hands it out under its own lock, so the work share
+   is only touched once per super-chunk.  A thread whose cluster and the
+   work share are both exhausted takes its chunk from another cluster's
+   remainder.  */
+
+#define GOMP_ITER_CLUSTER_CHUNKS 4
+
+void
+gomp_iter_cluster_init (struct gomp_work_share *ws, unsigned nthreads)
+{
+  unsigned i, n;
+
+  n = (nthreads + gomp_cpus_per_cluster - 1) / gomp_cpus_per_cluster;
+  if (n <= 1)
+    return;
+
+  /* malloc only guarantees word alignment, round up to the 64 bytes
+     struct gomp_iter_cluster is aligned on.  */
+  ws->clusters_alloc
+    = gomp_malloc (n * sizeof (struct gomp_iter_cluster)
+		   + __alignof__ (struct gomp_iter_cluster) - 1);
+  ws->clusters = (struct gomp_iter_cluster *)
+    (((uintptr_t) ws->clusters_alloc
+      + __alignof__ (struct gomp_iter_cluster) - 1)
+     & ~(uintptr_t) (__alignof__ (struct gomp_iter_cluster) - 1));
+  ws->nclusters = n;
+  for (i = 0; i < n; i++)
+    {
+      gomp_mutex_init (&ws->clusters[i].lock);
+      ws->clusters[i].next = ws->next;
+      ws->clusters[i].end = ws->next;
+    }
+}
+
+/* Take the next block out of [*PNEXT, END) for one of NTHREADS threads,
+   following ws->sched.  */
+
+static int
+gomp_iter_cluster_take (struct gomp_work_share *ws, long *pnext, long end,
+			unsigned long nthreads, long *pstart, long *pend)
+{
+  long start = *pnext;
+  long nend;
+
+  if (start == end)
+    return false;
+
+  if (ws->sched == GFS_DYNAMIC)
+    {
+      long chunk = ws->chunk_size;
+      long left = end - start;
+
+      if (ws->incr < 0)
+	{
+	  if (chunk < left)
+	    chunk = left;
+	}
+      else
+	{
+	  if (chunk > left)
+	    chunk = left;
+	}
+      nend = start + chunk;
+    }
+  else
+    {
+      unsigned long n, q;
+
+      n = (end - start) / ws->incr;
+      q = (n + nthreads - 1) / nthreads;
+      if (q < (unsigned long)ws->chunk_size)
+	q = ws->chunk_size;
+      if (q <= n)
+	nend = start + q * ws->incr;
+      else
+	nend = end;
+    }
+
+  *pnext = nend;
+  *pstart = start;
+  *pend = nend;
+  return true;
+}
+
+/* Refill cluster C from the work share.  Must be called with C's lock
+   held.  */
+
+static void
+gomp_iter_cluster_refill (struct gomp_work_share *ws,
+			  struct gomp_iter_cluster *c)
+{
+  long start, end;
+  int ret;
+
+  gomp_mutex_lock (&ws->lock);
+  if (ws->sched == GFS_DYNAMIC)
+    {
+      long chunk = ws->chunk_size;
+      long left = ws->end - ws->next;
+      unsigned long nchunks, k;
+
+      nchunks = (left + chunk - (ws->incr > 0 ? 1 : -1)) / chunk;
+      k = nchunks / (2 * ws->nclusters);
+      if (k > GOMP_ITER_CLUSTER_CHUNKS * gomp_cpus_per_cluster)
+	k = GOMP_ITER_CLUSTER_CHUNKS * gomp_cpus_per_cluster;
+      if (k == 0 || (unsigned long)(chunk > 0 ? chunk : -chunk) > LONG_MAX / k)
+	k = 1;
+
+      ws->chunk_size = chunk * (long)k;
+      ret = gomp_iter_cluster_take (ws, &ws->next, ws->end, 1, &start, &end);
+      ws->chunk_size = chunk;
+    }
+  else
+    ret = gomp_iter_cluster_take (ws, &ws->next, ws->end, 2 * ws->nclusters,
+				  &start, &end);
+  gomp_mutex_unlock (&ws->lock);
+
+  if (ret)
+    {
+      c->next = start;
+      c->end = end;
+    }
+}
+
+/* Like gomp_iter_dynamic_next_locked or gomp_iter_guided_next_locked,
+   for work shares having per-cluster dispensers, without ws->lock held.  */
+
+int
+gomp_iter_cluster_next (long *pstart, long *pend)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  struct gomp_work_share *ws = thr->ts.work_share;
+  unsigned long nthreads = thr->ts.team->nthreads;
+  unsigned long per_cluster;
+  unsigned i, id;
+  int ret;
+
+  per_cluster = (nthreads + ws->nclusters - 1) / ws->nclusters;
+  id = gomp_cpu_cluster () % ws->nclusters;
+
+  gomp_mutex_lock (&ws->clusters[id].lock);
+  if (ws->clusters[id].next == ws->clusters[id].end
+      && ws->next != ws->end)
+    gomp_iter_cluster_refill (ws, &ws->clusters[id]);
+  ret = gomp_iter_cluster_take (ws, &ws->clusters[id].next,
+				ws->clusters[id].end, per_cluster,
+				pstart, pend);
+  gomp_mutex_unlock (&ws->clusters[id].lock);
+
+  /* End of the loop, help the other clusters.  */
+  for (i = 1; !ret && i < ws->nclusters; i++)
+    {
+      struct gomp_iter_cluster *c = &ws->clusters[(id + i) % ws->nclusters];
+
+      if (c->next == c->end)
+	continue;
+      gomp_mutex_lock (&c->lock);
+      ret = gomp_iter_cluster_take (ws, &c->next, c->end, per_cluster,
+				    pstart, pend);
+      gomp_mutex_unlock (&c->lock);
+    }
+
+  return ret;
+}
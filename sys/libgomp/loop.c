@@ -121,9 +121,14 @@ gomp_loop_dynamic_start (long start, long end, long incr, long chunk_size,
     {
       gomp_loop_init (thr->ts.work_share, start, end, incr,
 		      GFS_DYNAMIC, chunk_size);
+      if (thr->ts.team != NULL)
+	gomp_iter_cluster_init (thr->ts.work_share, thr->ts.team->nthreads);
       gomp_work_share_init_done ();
     }
 
+  if (thr->ts.work_share->clusters != NULL)
+    return gomp_iter_cluster_next (istart, iend);
+
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_dynamic_next (istart, iend);
 #else
@@ -146,9 +151,14 @@ gomp_loop_guided_start (long start, long end, long incr, long chunk_size,
     {
       gomp_loop_init (thr->ts.work_share, start, end, incr,
 		      GFS_GUIDED, chunk_size);
+      if (thr->ts.team != NULL)
+	gomp_iter_cluster_init (thr->ts.work_share, thr->ts.team->nthreads);
       gomp_work_share_init_done ();
     }
 
+  if (thr->ts.work_share->clusters != NULL)
+    return gomp_iter_cluster_next (istart, iend);
+
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_guided_next (istart, iend);
 #else
@@ -304,12 +314,15 @@ gomp_loop_static_next (long *istart, long *iend)
 static bool
 gomp_loop_dynamic_next (long *istart, long *iend)
 {
+  struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
+  if (thr->ts.work_share->clusters != NULL)
+    return gomp_iter_cluster_next (istart, iend);
+
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_dynamic_next (istart, iend);
 #else
-  struct gomp_thread *thr = gomp_thread ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
   ret = gomp_iter_dynamic_next_locked (istart, iend);
   gomp_mutex_unlock (&thr->ts.work_share->lock);
@@ -321,12 +334,15 @@ gomp_loop_dynamic_next (long *istart, long *iend)
 static bool
 gomp_loop_guided_next (long *istart, long *iend)
 {
+  struct gomp_thread *thr = gomp_thread ();
   bool ret;
 
+  if (thr->ts.work_share->clusters != NULL)
+    return gomp_iter_cluster_next (istart, iend);
+
 #ifdef HAVE_SYNC_BUILTINS
   ret = gomp_iter_guided_next (istart, iend);
 #else
-  struct gomp_thread *thr = gomp_thread ();
   gomp_mutex_lock (&thr->ts.work_share->lock);
   ret = gomp_iter_guided_next_locked (istart, iend);
   gomp_mutex_unlock (&thr->ts.work_share->lock);
@@ -446,6 +462,8 @@ gomp_parallel_loop_start (void (*fn) (void *), void *data,
   num_threads = gomp_resolve_num_threads (num_threads, 0);
   team = gomp_new_team (num_threads);
   gomp_loop_init (&team->work_shares[0], start, end, incr, sched, chunk_size);
+  if (sched == GFS_DYNAMIC || sched == GFS_GUIDED)
+    gomp_iter_cluster_init (&team->work_shares[0], num_threads);
   gomp_team_start (fn, data, num_threads, team);
 }
 
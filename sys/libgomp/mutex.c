@@ -1 +1,62 @@
-/* Everything is in the header.  */
+/* Copyright (C) 2005, 2008, 2009 Free Software Foundation, Inc.
+   Contributed by Richard Henderson <rth@redhat.com>.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This is the slow path of the word sized mutex, see mutex.h.  */
+
+#include <gomp/libgomp.h>
+#include <gomp/wait.h>
+
+/* A mutex is held for short periods, so do not spin as long as
+   barriers do before blocking.  */
+#define GOMP_MUTEX_SPIN_COUNT 1000
+
+void
+gomp_mutex_lock_slow (gomp_mutex_t *mutex, int oldval)
+{
+  unsigned long i, count = GOMP_MUTEX_SPIN_COUNT;
+
+  if (gomp_managed_threads > gomp_available_cpus
+      && gomp_throttled_spin_count_var < count)
+    count = gomp_throttled_spin_count_var;
+
+  for (i = 0; oldval == 1 && i < count; i++)
+    {
+      cpu_relax ();
+      if (*(volatile int *) mutex == 0)
+	{
+	  oldval = __sync_val_compare_and_swap (mutex, 0, 1);
+	  if (oldval == 0)
+	    return;
+	}
+    }
+
+  while (__sync_lock_test_and_set (mutex, 2) != 0)
+    gomp_futex_wait (mutex, 2);
+}
+
+void
+gomp_mutex_unlock_slow (gomp_mutex_t *mutex)
+{
+  gomp_futex_wake (mutex, 1);
+}
@@ -30,6 +30,172 @@
 #include <string.h>
 
 
+/* Deferred tasks live in per-thread Chase-Lev deques (see struct
+   gomp_task_deque).  The owner pushes and pops at the bottom without
+   any atomic operation in the common case, idle threads steal the
+   oldest task at the top with a compare and swap, first from threads
+   of their own cluster, then from remote ones.  */
+
+static inline bool
+gomp_task_deque_full (struct gomp_task_deque *dq)
+{
+  return dq->bottom - dq->top >= GOMP_TASK_DEQUE_SIZE;
+}
+
+/* Called by the owner only, the caller has checked the deque is not
+   full.  */
+
+static inline void
+gomp_task_deque_push (struct gomp_task_deque *dq, struct gomp_task *task)
+{
+  long b = dq->bottom;
+
+  if (__builtin_expect (dq->cluster < 0, 0))
+    dq->cluster = gomp_cpu_cluster ();
+  dq->tasks[b & (GOMP_TASK_DEQUE_SIZE - 1)] = task;
+  __sync_synchronize ();
+  dq->bottom = b + 1;
+}
+
+/* Called by the owner only.  Return the newest task, NULL if the deque
+   is empty or its last task has just been stolen.  */
+
+static inline struct gomp_task *
+gomp_task_deque_pop (struct gomp_task_deque *dq)
+{
+  struct gomp_task *task;
+  long b = dq->bottom - 1;
+  long t;
+
+  dq->bottom = b;
+  __sync_synchronize ();
+  t = dq->top;
+  if (t > b)
+    {
+      dq->bottom = b + 1;
+      return NULL;
+    }
+  task = dq->tasks[b & (GOMP_TASK_DEQUE_SIZE - 1)];
+  if (t == b)
+    {
+      /* Last task, race with thieves.  */
+      if (!__sync_bool_compare_and_swap (&dq->top, t, t + 1))
+	task = NULL;
+      dq->bottom = b + 1;
+    }
+  return task;
+}
+
+static inline struct gomp_task *
+gomp_task_deque_steal (struct gomp_task_deque *dq)
+{
+  struct gomp_task *task;
+  long t = dq->top;
+
+  __sync_synchronize ();
+  if (t >= dq->bottom)
+    return NULL;
+  task = dq->tasks[t & (GOMP_TASK_DEQUE_SIZE - 1)];
+  if (!__sync_bool_compare_and_swap (&dq->top, t, t + 1))
+    return NULL;
+  return task;
+}
+
+/* Take a task for the calling thread: its own newest task, else the
+   oldest one of another thread, same cluster first.  */
+
+static struct gomp_task *
+gomp_task_take (struct gomp_team *team, unsigned id)
+{
+  struct gomp_task_deque *dq = &team->task_deques[0];
+  struct gomp_task *task;
+  unsigned n = team->nthreads;
+  unsigned i, victim;
+  int cluster, pass;
+
+  if ((task = gomp_task_deque_pop (&dq[id])) != NULL)
+    return task;
+
+  cluster = gomp_cpu_cluster ();
+  for (pass = 0; pass < 2; pass++)
+    for (i = 1; i < n; i++)
+      {
+	victim = (id + i) % n;
+	if (dq[victim].bottom - dq[victim].top <= 0
+	    || (dq[victim].cluster == cluster) != (pass == 0))
+	  continue;
+	if ((task = gomp_task_deque_steal (&dq[victim])) != NULL)
+	  return task;
+      }
+  return NULL;
+}
+
+static inline bool
+gomp_task_is_descendant (struct gomp_task *task, struct gomp_task *ancestor)
+{
+  while ((task = task->parent) != NULL)
+    if (task == ancestor)
+      return true;
+  return false;
+}
+
+/* Drop a reference on TASK, freeing it and releasing its parent when it
+   was the last one.  Only heap allocated tasks ever drop their own
+   reference.  */
+
+static void
+gomp_task_release (struct gomp_task *task)
+{
+  struct gomp_task *parent;
+  int refs;
+
+  while (task != NULL)
+    {
+      refs = __sync_sub_and_fetch (&task->refs, 1);
+      /* Last descendant of an undeferred task waiting to return.  */
+      if (refs == 1
+	  && __sync_bool_compare_and_swap (&task->in_taskwait,
+					   GOMP_TASK_WAIT_REFS, 0))
+	gomp_sem_post (&task->taskwait_sem);
+      if (refs != 0)
+	break;
+      parent = task->parent;
+      gomp_finish_task (task);
+      free (task);
+      task = parent;
+    }
+}
+
+/* Account for the end of TASK, return the number of tasks of the team
+   still queued or running.  */
+
+static int
+gomp_task_complete (struct gomp_team *team, struct gomp_task *task)
+{
+  struct gomp_task *parent = task->parent;
+
+  if (parent != NULL
+      && __sync_sub_and_fetch (&parent->num_children, 1) == 0
+      && __sync_bool_compare_and_swap (&parent->in_taskwait,
+				       GOMP_TASK_WAIT_CHILDREN, 0))
+    gomp_sem_post (&parent->taskwait_sem);
+  gomp_task_release (task);
+  __sync_fetch_and_add (&team->task_running_count, -1);
+  return __sync_add_and_fetch (&team->task_count, -1);
+}
+
+static inline void
+gomp_task_run (struct gomp_thread *thr, struct gomp_task *task)
+{
+  struct gomp_task *prev = thr->task;
+
+  task->kind = GOMP_TASK_TIED;
+  __sync_fetch_and_add (&thr->ts.team->task_running_count, 1);
+  thr->task = task;
+  task->fn (task->fn_data);
+  thr->task = prev;
+}
+
 /* Create a new task data structure.  */
 
 void
@@ -39,9 +205,10 @@ gomp_init_task (struct gomp_task *task, struct gomp_task *parent_task,
   task->parent = parent_task;
   task->icv = *prev_icv;
   task->kind = GOMP_TASK_IMPLICIT;
-  task->in_taskwait = false;
+  task->num_children = 0;
+  task->refs = 1;
+  task->in_taskwait = 0;
   task->in_tied_task = false;
-  task->children = NULL;
   gomp_sem_init (&task->taskwait_sem, 0);
 }
 
@@ -57,18 +224,42 @@ gomp_end_task (void)
   thr->task = task->parent;
 }
 
-static inline void
-gomp_clear_parent (struct gomp_task *children)
+/* Wait for *COUNT, the children or the references of TASK, to drop to
+   UNTIL.  Descendants of TASK were all pushed on our deque after the
+   tasks already queued there, run those still at its bottom.  A task is
+   only looked at once popped, as a thief may run and free it until
+   then; the first one which is not a descendant goes back where it was,
+   the deque having room for it.  Then sleep until the ones run by other
+   threads are done, WAIT telling the end of which to post.  */
+
+static void
+gomp_task_wait (struct gomp_thread *thr, struct gomp_task *task,
+		volatile int *count, int until, int wait)
 {
-  struct gomp_task *task = children;
+  struct gomp_team *team = thr->ts.team;
+  struct gomp_task_deque *dq = &team->task_deques[thr->ts.team_id];
+  struct gomp_task *child_task;
 
-  if (task)
-    do
-      {
-	task->parent = NULL;
-	task = task->next_child;
-      }
-    while (task != children);
+  while (*count != until)
+    {
+      child_task = gomp_task_deque_pop (dq);
+      if (child_task == NULL)
+	break;
+      if (!gomp_task_is_descendant (child_task, task))
+	{
+	  gomp_task_deque_push (dq, child_task);
+	  break;
+	}
+      gomp_task_run (thr, child_task);
+      gomp_task_complete (team, child_task);
+    }
+
+  task->in_taskwait = wait;
+  __sync_synchronize ();
+  if (*count == until
+      && __sync_bool_compare_and_swap (&task->in_taskwait, wait, 0))
+    return;
+  gomp_sem_wait (&task->taskwait_sem);
 }
 
 /* Called when encountering an explicit task directive.  If IF_CLAUSE is
@@ -82,6 +273,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
+  struct gomp_task_deque *dq = NULL;
 
 #ifdef HAVE_BROKEN_POSIX_SEMAPHORES
   /* If pthread_mutex_* is used for omp_*lock*, then each task must be
@@ -94,8 +286,12 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
     flags &= ~1;
 #endif
 
+  if (team != NULL)
+    dq = &team->task_deques[thr->ts.team_id];
+
   if (!if_clause || team == NULL
-      || (unsigned int)team->task_count > 64 * (unsigned int)team->nthreads)
+      || (unsigned int)team->task_count > 64 * (unsigned int)team->nthreads
+      || gomp_task_deque_full (dq))
     {
       struct gomp_task task;
 
@@ -114,13 +310,12 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	}
       else
 	fn (data);
-      if (task.children)
-	{
-	  gomp_mutex_lock (&team->task_lock);
-	  gomp_clear_parent (task.children);
-	  gomp_mutex_unlock (&team->task_lock);
-	}
-      gomp_end_task ();
+      /* Deferred descendants reach TASK through their parent chain, it
+	 must outlive them.  */
+      if (task.refs != 1)
+	gomp_task_wait (thr, &task, &task.refs, 1, GOMP_TASK_WAIT_REFS);
+      thr->task = task.parent;
+      gomp_finish_task (&task);
     }
   else
     {
@@ -145,38 +340,13 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task->fn = fn;
       task->fn_data = arg;
       task->in_tied_task = true;
-      gomp_mutex_lock (&team->task_lock);
-      if (parent->children)
-	{
-	  task->next_child = parent->children;
-	  task->prev_child = parent->children->prev_child;
-	  task->next_child->prev_child = task;
-	  task->prev_child->next_child = task;
-	}
-      else
-	{
-	  task->next_child = task;
-	  task->prev_child = task;
-	}
-      parent->children = task;
-      if (team->task_queue)
-	{
-	  task->next_queue = team->task_queue;
-	  task->prev_queue = team->task_queue->prev_queue;
-	  task->next_queue->prev_queue = task;
-	  task->prev_queue->next_queue = task;
-	}
-      else
-	{
-	  task->next_queue = task;
-	  task->prev_queue = task;
-	  team->task_queue = task;
-	}
-      ++team->task_count;
+      __sync_fetch_and_add (&parent->num_children, 1);
+      __sync_fetch_and_add (&parent->refs, 1);
+      __sync_fetch_and_add (&team->task_count, 1);
+      gomp_task_deque_push (dq, task);
       gomp_team_barrier_set_task_pending (&team->barrier);
       do_wake = team->task_running_count + !parent->in_tied_task
 	< (int)team->nthreads;
-      gomp_mutex_unlock (&team->task_lock);
       if (do_wake)
 	gomp_team_barrier_wake (&team->barrier, 1);
     }
@@ -187,13 +357,11 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 {
   struct gomp_thread *thr = gomp_thread ();
   struct gomp_team *team = thr->ts.team;
-  struct gomp_task *task = thr->task;
-  struct gomp_task *child_task = NULL;
-  struct gomp_task *to_free = NULL;
+  struct gomp_task *child_task;
 
-  gomp_mutex_lock (&team->task_lock);
   if (gomp_barrier_last_thread (state))
     {
+      gomp_mutex_lock (&team->task_lock);
       if (team->task_count == 0)
 	{
 	  gomp_team_barrier_done (&team->barrier, state);
@@ -202,77 +370,37 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	  return;
 	}
       gomp_team_barrier_set_waiting_for_tasks (&team->barrier);
+      gomp_mutex_unlock (&team->task_lock);
     }
 
-  while (1)
+  while ((child_task = gomp_task_take (team, thr->ts.team_id)) != NULL)
     {
-      if (team->task_queue != NULL)
-	{
-	  struct gomp_task *parent;
-
-	  child_task = team->task_queue;
-	  parent = child_task->parent;
-	  if (parent && parent->children == child_task)
-	    parent->children = child_task->next_child;
-	  child_task->prev_queue->next_queue = child_task->next_queue;
-	  child_task->next_queue->prev_queue = child_task->prev_queue;
-	  if (child_task->next_queue != child_task)
-	    team->task_queue = child_task->next_queue;
-	  else
-	    team->task_queue = NULL;
-	  child_task->kind = GOMP_TASK_TIED;
-	  team->task_running_count++;
-	  if (team->task_count == team->task_running_count)
-	    gomp_team_barrier_clear_task_pending (&team->barrier);
-	}
-      gomp_mutex_unlock (&team->task_lock);
-      if (to_free)
-	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
-	  to_free = NULL;
-	}
-      if (child_task)
-	{
-	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
-	  thr->task = task;
-	}
-      else
-	return;
-      gomp_mutex_lock (&team->task_lock);
-      if (child_task)
+      gomp_task_run (thr, child_task);
+      if (gomp_task_complete (team, child_task) == 0)
 	{
-	  struct gomp_task *parent = child_task->parent;
-	  if (parent)
-	    {
-	      child_task->prev_child->next_child = child_task->next_child;
-	      child_task->next_child->prev_child = child_task->prev_child;
-	      if (parent->children == child_task)
-		{
-		  if (child_task->next_child != child_task)
-		    parent->children = child_task->next_child;
-		  else
-		    {
-		      parent->children = NULL;
-		      if (parent->in_taskwait)
-			gomp_sem_post (&parent->taskwait_sem);
-		    }
-		}
-	    }
-	  gomp_clear_parent (child_task->children);
-	  to_free = child_task;
-	  child_task = NULL;
-	  team->task_running_count--;
-	  if (--team->task_count == 0
-	      && gomp_team_barrier_waiting_for_tasks (&team->barrier))
+	  /* Last task of the team, finish the barrier if every thread
+	     has reached it.  */
+	  gomp_mutex_lock (&team->task_lock);
+	  if (gomp_team_barrier_waiting_for_tasks (&team->barrier))
 	    {
 	      gomp_team_barrier_done (&team->barrier, state);
 	      gomp_mutex_unlock (&team->task_lock);
 	      gomp_team_barrier_wake (&team->barrier, 0);
+	      return;
 	    }
+	  gomp_mutex_unlock (&team->task_lock);
 	}
     }
+
+  /* Nothing left to run, let sleeping threads stay asleep unless a task
+     has been queued meanwhile.  */
+  if (team->task_count == team->task_running_count)
+    {
+      gomp_team_barrier_clear_task_pending (&team->barrier);
+      __sync_synchronize ();
+      if (team->task_count != team->task_running_count)
+	gomp_team_barrier_set_task_pending (&team->barrier);
+    }
 }
 
 /* Called when encountering a taskwait directive.  */
@@ -281,84 +409,11 @@ void
 GOMP_taskwait (void)
 {
   struct gomp_thread *thr = gomp_thread ();
-  struct gomp_team *team = thr->ts.team;
   struct gomp_task *task = thr->task;
-  struct gomp_task *child_task = NULL;
-  struct gomp_task *to_free = NULL;
 
-  if (task == NULL || task->children == NULL)
+  if (task == NULL || task->num_children == 0)
     return;
-  gomp_mutex_lock (&team->task_lock);
-  while (1)
-    {
-      if (task->children == NULL)
-	{
-	  gomp_mutex_unlock (&team->task_lock);
-	  if (to_free)
-	    {
-	      gomp_finish_task (to_free);
-	      free (to_free);
-	    }
-	  return;
-	}
-      if (task->children->kind == GOMP_TASK_WAITING)
-	{
-	  child_task = task->children;
-	  task->children = child_task->next_child;
-	  child_task->prev_queue->next_queue = child_task->next_queue;
-	  child_task->next_queue->prev_queue = child_task->prev_queue;
-	  if (team->task_queue == child_task)
-	    {
-	      if (child_task->next_queue != child_task)
-		team->task_queue = child_task->next_queue;
-	      else
-		team->task_queue = NULL;
-	    }
-	  child_task->kind = GOMP_TASK_TIED;
-	  team->task_running_count++;
-	  if (team->task_count == team->task_running_count)
-	    gomp_team_barrier_clear_task_pending (&team->barrier);
-	}
-      else
-	/* All tasks we are waiting for are already running
-	   in other threads.  Wait for them.  */
-	task->in_taskwait = true;
-      gomp_mutex_unlock (&team->task_lock);
-      if (to_free)
-	{
-	  gomp_finish_task (to_free);
-	  free (to_free);
-	  to_free = NULL;
-	}
-      if (child_task)
-	{
-	  thr->task = child_task;
-	  child_task->fn (child_task->fn_data);
-	  thr->task = task;
-	}
-      else
-	{
-	  gomp_sem_wait (&task->taskwait_sem);
-	  task->in_taskwait = false;
-	  return;
-	}
-      gomp_mutex_lock (&team->task_lock);
-      if (child_task)
-	{
-	  child_task->prev_child->next_child = child_task->next_child;
-	  child_task->next_child->prev_child = child_task->prev_child;
-	  if (task->children == child_task)
-	    {
-	      if (child_task->next_child != child_task)
-		task->children = child_task->next_child;
-	      else
-		task->children = NULL;
-	    }
-	  gomp_clear_parent (child_task->children);
-	  to_free = child_task;
-	  child_task = NULL;
-	  team->task_count--;
-	  team->task_running_count--;
-	}
-    }
+
+  gomp_task_wait (thr, task, &task->num_children, 0,
+		  GOMP_TASK_WAIT_CHILDREN);
 }
@@ -140,8 +140,12 @@ gomp_new_team (unsigned nthreads)
   size_t size;
   int i;
 
+  /* malloc only guarantees word alignment, leave room to round the
+     deques up to the 64 bytes struct gomp_task_deque is aligned on.  */
   size = sizeof (*team) + nthreads * (sizeof (team->ordered_release[0])
-				      + sizeof (team->implicit_task[0]));
+				      + sizeof (team->implicit_task[0])
+				      + sizeof (team->task_deques[0]))
+	 + __alignof__ (struct gomp_task_deque) - 1;
   team = gomp_malloc (size);
 
   team->work_share_chunk = 8;
@@ -166,7 +170,16 @@ gomp_new_team (unsigned nthreads)
   team->ordered_release[0] = &team->master_release;
 
   gomp_mutex_init (&team->task_lock);
-  team->task_queue = NULL;
+  team->task_deques = (struct gomp_task_deque *)
+    (((uintptr_t) &team->ordered_release[nthreads]
+      + __alignof__ (struct gomp_task_deque) - 1)
+     & ~(uintptr_t) (__alignof__ (struct gomp_task_deque) - 1));
+  for (i = 0; i < (int) nthreads; i++)
+    {
+      team->task_deques[i].top = 0;
+      team->task_deques[i].bottom = 0;
+      team->task_deques[i].cluster = -1;
+    }
   team->task_count = 0;
   team->task_running_count = 0;
 
@@ -416,6 +429,11 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
     n_master = -1;
   }
 
+  /* OMP_PROC_BIND/OMP_PLACES placement, relative to the master's CPU.  */
+  unsigned *team_cpus = gomp_alloca (nthreads * sizeof (unsigned));
+  if (!gomp_affinity_team_cpus (n_master, nthreads, team_cpus))
+    team_cpus = NULL;
+
   for (; i < nthreads; ++i, ++start_data )
     {
       pthread_t pt;
@@ -438,10 +456,9 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       start_data->thread_pool = pool;
       start_data->nested = nested;
 
-      if (gomp_cpu_affinity != NULL)
-	gomp_init_thread_affinity (attr);
-
-      if (i==(unsigned)n_master) 
+      if (team_cpus != NULL)
+	gomp_init_thread_affinity (attr, team_cpus[i]);
+      else if (i==(unsigned)n_master) 
         pthread_attr_setcpuid_np(attr, 0, NULL);
       else 
         pthread_attr_setcpuid_np(attr, i, NULL);
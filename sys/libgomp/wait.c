@@ -0,0 +1,140 @@
+/* Copyright (C) 2005, 2008, 2009 Free Software Foundation, Inc.
+   Contributed by Richard Henderson <rth@redhat.com>.
+
+   This file is part of the GNU OpenMP Library (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file emulates the futex wait/wake operations in user-space, see
+   wait.h.  Blocked threads are queued in a table of wait queues hashed
+   on the address they wait on and are woken up with SYS_WAKEUP.  The
+   kernel keeps a wakeup sent before the target thread sleeps, so every
+   dequeued waiter is sent exactly one wakeup and sleeps at least once.  */
+
+#include <gomp/libgomp.h>
+#include <gomp/wait.h>
+#include <sys/syscall.h>
+#include <cpu-syscall.h>
+
+#define GOMP_WAIT_BUCKETS 64
+
+/* Maximum number of threads woken up by a single SYS_WAKEUP.  */
+#define GOMP_WAKE_BATCH 100
+
+struct gomp_waiter
+{
+  struct gomp_waiter *next;
+  int *addr;
+  pthread_t tid;
+  volatile int woken;
+};
+
+struct gomp_wait_bucket
+{
+  int lock;
+  struct gomp_waiter *head;
+} __attribute__((aligned (64)));
+
+static struct gomp_wait_bucket gomp_wait_tbl[GOMP_WAIT_BUCKETS];
+
+static inline struct gomp_wait_bucket *
+gomp_wait_bucket (int *addr)
+{
+  uintptr_t key = (uintptr_t) addr >> 2;
+
+  return &gomp_wait_tbl[(key ^ (key >> 6)) % GOMP_WAIT_BUCKETS];
+}
+
+static inline void
+gomp_wait_bucket_lock (struct gomp_wait_bucket *b)
+{
+  while (__sync_lock_test_and_set (&b->lock, 1) != 0)
+    while (*(volatile int *) &b->lock != 0)
+      cpu_relax ();
+}
+
+static inline void
+gomp_wait_bucket_unlock (struct gomp_wait_bucket *b)
+{
+  __sync_synchronize ();
+  __sync_lock_release (&b->lock);
+}
+
+void
+gomp_futex_wait (int *addr, int val)
+{
+  struct gomp_wait_bucket *b = gomp_wait_bucket (addr);
+  struct gomp_waiter self, **pprev;
+
+  gomp_wait_bucket_lock (b);
+  if (*(volatile int *) addr != val)
+    {
+      gomp_wait_bucket_unlock (b);
+      return;
+    }
+
+  self.next = NULL;
+  self.addr = addr;
+  self.tid = pthread_self ();
+  self.woken = 0;
+  for (pprev = &b->head; *pprev != NULL; pprev = &(*pprev)->next)
+    ;
+  *pprev = &self;
+  gomp_wait_bucket_unlock (b);
+
+  do
+    (void) cpu_syscall (NULL, NULL, NULL, NULL, SYS_SLEEP);
+  while (!self.woken);
+}
+
+void
+gomp_futex_wake (int *addr, int count)
+{
+  struct gomp_wait_bucket *b = gomp_wait_bucket (addr);
+  struct gomp_waiter *w, **pprev;
+  pthread_t tbl[GOMP_WAKE_BATCH];
+  int nr;
+
+  do
+    {
+      nr = 0;
+      gomp_wait_bucket_lock (b);
+      pprev = &b->head;
+      while ((w = *pprev) != NULL && nr < count && nr < GOMP_WAKE_BATCH)
+	{
+	  if (w->addr != addr)
+	    {
+	      pprev = &w->next;
+	      continue;
+	    }
+	  *pprev = w->next;
+	  tbl[nr++] = w->tid;
+	  /* W may be gone as soon as woken is set.  */
+	  w->woken = 1;
+	}
+      gomp_wait_bucket_unlock (b);
+
+      if (nr != 0)
+	(void) cpu_syscall ((void *) tbl[0], tbl, (void *) nr, NULL,
+			    SYS_WAKEUP);
+      count -= nr;
+    }
+  while (nr == GOMP_WAKE_BATCH && count > 0);
+}
@@ -115,6 +115,8 @@ gomp_init_work_share (struct gomp_work_share *ws, int ordered,
     ws->ordered_team_ids = NULL;
   gomp_ptrlock_init (&ws->next_ws, NULL);
   ws->threads_completed = 0;
+  ws->clusters = NULL;
+  ws->nclusters = 0;
 }
 
 /* Do any needed destruction of gomp_work_share fields before it
@@ -126,6 +128,14 @@ gomp_fini_work_share (struct gomp_work_share *ws)
   gomp_mutex_destroy (&ws->lock);
   if (ws->ordered_team_ids != ws->inline_ordered_team_ids)
     free (ws->ordered_team_ids);
+  if (ws->clusters != NULL)
+    {
+      unsigned i;
+
+      for (i = 0; i < ws->nclusters; i++)
+	gomp_mutex_destroy (&ws->clusters[i].lock);
+      free (ws->clusters_alloc);
+    }
   gomp_ptrlock_destroy (&ws->next_ws);
 }
 
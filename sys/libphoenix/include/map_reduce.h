@@ -146,6 +146,13 @@ typedef struct
     * but can increase merge time. */
     bool use_one_queue_per_task;    
 
+    /* Keeps map output in a hash table per map thread and
+    * reduce task, sorted only when the reduce task starts,
+    * instead of a sorted array. Faster for jobs emitting many
+    * distinct keys (word count, histograms). Keys that compare
+    * equal must have the same key_size bytes. */
+    bool use_hash_store;
+
     int L1_cache_size;     /* Size of L1 cache in bytes */
     int num_map_threads;   /* # of threads to run map tasks on.
                                  * Default is one per processor */
@@ -32,6 +32,7 @@
 #include "processor.h"
 
 static int num_cluster = 0;
+static int cluster_ymax = 0;
 
 /* Retrieve the number of processors that belong to the locality
    group of the calling LWP. */
@@ -83,3 +84,23 @@ int loc_mem_to_lgrp (void *addr)
 
   return info.mi_cid;
 }
+
+/* Retrieve the mesh distance between locality groups LGRP1 and LGRP2,
+   as the kernel's DQDT does: cluster ids are laid out as x * ymax + y. */
+int loc_get_distance (int lgrp1, int lgrp2)
+{
+  int dx, dy;
+
+  if(cluster_ymax == 0)
+  {
+    cluster_ymax = sysconf(_SC_CLUSTER_YMAX);
+
+    if(cluster_ymax < 1)
+      cluster_ymax = 1;
+  }
+
+  dx = lgrp1 / cluster_ymax - lgrp2 / cluster_ymax;
+  dy = lgrp1 % cluster_ymax - lgrp2 % cluster_ymax;
+
+  return ((dx < 0) ? -dx : dx) + ((dy < 0) ? -dy : dy);
+}
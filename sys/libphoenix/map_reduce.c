@@ -66,7 +66,10 @@
 //#define DEFAULT_CACHE_SIZE        (8 * 1024)
 #define DEFAULT_KEYVAL_ARR_LEN      10
 #define DEFAULT_VALS_ARR_LEN        10
+#define DEFAULT_HASH_STORE_LEN      16      /* Must be a power of 2. */
 #define L2_CACHE_LINE_SIZE          64
+#define MERGE_OVERSAMPLING          16      /* Samples per merge thread. */
+#define MERGE_MIN_KEYS_PER_THREAD   1024
 /* End tunables. */
 
 /* Debug printf */
@@ -94,13 +97,16 @@ typedef struct
     };
 } keyval_arr_t;
 
-/* Array of keyvals_t. */
+/* Array of keyvals_t.
+   With the hash store, arr is an open addressing table of alloc_len
+   slots (free slots have vals == NULL) until it is sorted for reduce. */
 typedef struct 
 {
     int len;
     int alloc_len;
     int pos;
     keyvals_t *arr;
+    unsigned int *hashes;           /* Slot key hashes, hash store only. */
 } keyvals_arr_t;
 
 /* Thread information.
@@ -144,6 +150,7 @@ typedef struct
 
     bool oneOutputQueuePerMapTask;      /* One output queue per map task? */
     bool oneOutputQueuePerReduceTask;   /* One output queue per reduce task? */
+    bool useHashStore;                  /* Hash map output, sort at reduce? */
 
     int intermediate_task_alloc_len;
 
@@ -164,7 +171,9 @@ typedef struct
                                     /* Array to send to reduce task. */
 
     keyval_arr_t *final_vals;       /* Array to send to merge task. */
-    keyval_arr_t *merge_vals;       /* Array to send to user. */
+    keyval_t *merge_output;         /* Array to send to user. */
+    void **merge_splitters;         /* Lower key bound of each merge thread
+                                       but the first. */
 
     int splitter_pos;         /* Tracks position in array_splitter(). */
 
@@ -182,6 +191,7 @@ static pthread_key_t emit_time_key;
 static pthread_key_t env_key;       /* Environment for current thread. */
 static pthread_key_t tpool_key;
 static pthread_key_t thread_index_key;
+static key_cmp_t sort_key_cmp;      /* Used by qsort() comparators. */
 
 /* Data passed on to each worker thread. */
 typedef struct
@@ -191,7 +201,6 @@ typedef struct
     TASK_TYPE_T     task_type;          /* Assigned task type. */
     int             merge_len;
     keyval_arr_t    *merge_input;
-    int             merge_round;
     mr_env_t        *env;
 } thread_arg_t;
 
@@ -208,10 +217,14 @@ static inline void insert_keyval (
     mr_env_t* env, keyval_arr_t *, void *, void *);
 static inline void insert_keyval_merged (
     mr_env_t* env, keyvals_arr_t *, void *, void *);
+static inline void insert_keyval_hashed (
+    mr_env_t* env, keyvals_arr_t *, void *, void *, int);
+static inline void insert_val (mr_env_t* env, keyvals_t *, void *);
+static void hash_store_sort (keyvals_arr_t *);
 
 static int array_splitter (void *, int, map_args_t *);
 static void identity_reduce (void *, iterator_t *itr);
-static inline void merge_results (mr_env_t* env, keyval_arr_t*, int);
+static inline void merge_results (mr_env_t* env, keyval_arr_t*, int, int);
 
 static void *map_worker (void *);
 static void *reduce_worker (void *);
@@ -389,6 +402,7 @@ env_init (map_reduce_args_t *args)
 
     env->oneOutputQueuePerMapTask = false;
     env->oneOutputQueuePerReduceTask = args->use_one_queue_per_task;
+    env->useHashStore = args->use_hash_store;
 
     /* Determine the number of threads to schedule for each type of task. */
     env->num_map_threads = (args->num_map_threads > 0) ? 
@@ -400,10 +414,6 @@ env_init (map_reduce_args_t *args)
     env->num_merge_threads = (args->num_merge_threads > 0) ? 
         args->num_merge_threads : env->num_reduce_threads;
 
-    if (env->oneOutputQueuePerReduceTask == false) {
-        env->num_merge_threads = env->num_reduce_threads / 2;
-    }
-
     /* Assign at least one merge thread. */
     env->num_merge_threads = MAX(env->num_merge_threads, 1);
 
@@ -441,9 +451,6 @@ env_init (map_reduce_args_t *args)
     {
         env->num_reduce_tasks = DEFAULT_NUM_REDUCE_TASKS;
     }
-    env->num_merge_threads = MIN (
-        env->num_merge_threads, env->num_reduce_tasks / 2);
-
     if (env->oneOutputQueuePerMapTask) 
         env->intermediate_task_alloc_len = 
             args->data_size / env->chunk_size + 1;
@@ -459,6 +466,9 @@ env_init (map_reduce_args_t *args)
     env->locator = args->locator;
     env->key_cmp = args->key_cmp;
 
+    /* map_reduce() is not reentrant, a single comparator is enough. */
+    sort_key_cmp = env->key_cmp;
+
     /* 2. Initialize structures. */
 
     env->intermediate_vals = (keyvals_arr_t **)mem_malloc (
@@ -835,6 +845,14 @@ static bool reduce_worker_do_next_task (
 
     num_map_threads =  args->num_map_threads;
 
+    /* Hashed map outputs are sorted here, each partition
+       being owned by its reduce task. */
+    if (env->useHashStore) {
+        for (curr_thread = 0; curr_thread < num_map_threads; curr_thread++)
+            hash_store_sort (
+                &env->intermediate_vals[curr_thread][curr_reduce_task]);
+    }
+
     args->run_time = 0;
     min_key_val = NULL;
     next_min = NULL;
@@ -994,6 +1012,8 @@ reduce_worker (void *args)
 /** merge_worker()
 * args - pointer to thread_arg_t
 * returns 0 on success
+* Merges the keys between this thread's splitters, taken from every
+* reduce output, straight into its slice of the final array.
 */
 static void *
 merge_worker (void *args) 
@@ -1004,56 +1024,25 @@ merge_worker (void *args)
     thread_arg_t    *th_arg = (thread_arg_t *)args;
     int             thread_index = th_arg->thread_id;
     mr_env_t        *env = th_arg->env;
-    int             cpu;
 #ifdef TIMING
     uintptr_t       work_time = 0;
 #endif
 
     env->tinfo[thread_index].tid = pthread_self();
 
-    /* Bind thread.
-       Spread out the merge workers as much as possible. */
-    if (env->oneOutputQueuePerReduceTask)
-        cpu = th_arg->cpu_id * (1 << (th_arg->merge_round - 1));
-    else
-        cpu = th_arg->cpu_id * (1 << th_arg->merge_round);
-
-    CHECK_ERROR (proc_bind_thread (cpu) != 0);
+    /* Bind thread. */
+    CHECK_ERROR (proc_bind_thread (th_arg->cpu_id) != 0);
 
     CHECK_ERROR (pthread_setspecific (env_key, env));
 
-    /* Assumes num_merge_threads is modified before each call. */
-    int length = th_arg->merge_len / env->num_merge_threads;
-    int modlen = th_arg->merge_len % env->num_merge_threads;
-
-    /* Let's make some progress here. */
-    if (length <= 1) {
-        length = 2;
-        modlen = th_arg->merge_len % 2;
-    }
-
-    int pos = thread_index * length + 
-                ((thread_index < modlen) ? thread_index : modlen);
-
-    if (pos < th_arg->merge_len) {
-
-        keyval_arr_t *vals = &th_arg->merge_input[pos];
-
-//        dprintf("Thread %d: cpu_id -> %d - Started\n", 
-  //                  thread_index, th_arg->cpu_id);
-
-        get_time (&work_begin);
-        merge_results (th_arg->env, vals, length + (thread_index < modlen));
-        get_time (&work_end);
+    get_time (&work_begin);
+    merge_results (env, th_arg->merge_input, th_arg->merge_len, thread_index);
+    get_time (&work_end);
 
 #ifdef TIMING
-        work_time = time_diff (&work_end, &work_begin);
+    work_time = time_diff (&work_end, &work_begin);
 #endif
 
-//        dprintf("Thread %d: cpu_id -> %d - Done\n", 
-//                    thread_index, th_arg->cpu_id);
-    }
-
     /* Unbind thread. */
     CHECK_ERROR (proc_unbind_thread () != 0);
 
@@ -1307,7 +1296,7 @@ static void run_combiner (mr_env_t* env, int thread_index)
 {
     assert (! env->oneOutputQueuePerMapTask);
 
-    int i, j;
+    int i, j, len;
     keyvals_arr_t *my_output;
     keyvals_t *reduce_pos;
     void *reduced_val;
@@ -1319,7 +1308,11 @@ static void run_combiner (mr_env_t* env, int thread_index)
     for (i = 0; i < env->num_reduce_tasks; ++i)
     {
         my_output = &env->intermediate_vals[thread_index][i];
-        for (j = 0; j < my_output->len; ++j)
+
+        /* Free hash store slots are zeroed and skipped below. */
+        len = (env->useHashStore) ? my_output->alloc_len : my_output->len;
+
+        for (j = 0; j < len; ++j)
         {
             reduce_pos = &(my_output->arr[j]);
             if (reduce_pos->len == 0) continue;
@@ -1386,7 +1379,10 @@ emit_intermediate (void *key, void *val, int key_size)
     /* Insert sorted in global queue at pos curr_proc */
     arr = &env->intermediate_vals[curr_task][reduce_pos];
 
-    insert_keyval_merged (env, arr, key, val);
+    if (env->useHashStore)
+        insert_keyval_hashed (env, arr, key, val, key_size);
+    else
+        insert_keyval_merged (env, arr, key, val);
 
     get_time (&end);
 
@@ -1450,7 +1446,6 @@ insert_keyval_merged (mr_env_t* env, keyvals_arr_t *arr, void *key, void *val)
     int high = arr->len, low = -1, next;
     int cmp = 1;
     keyvals_t *insert_pos;
-    val_t *new_vals;
 
     assert(arr->len <= arr->alloc_len);
     if (arr->len > 0)
@@ -1509,6 +1504,136 @@ insert_keyval_merged (mr_env_t* env, keyvals_arr_t *arr, void *key, void *val)
 
     insert_pos = &(arr->arr[low]);
 
+    insert_val (env, insert_pos, val);
+}
+
+/* Hash of the key_size bytes of key, mixed so that slots
+   are independent of default_partition(). */
+static inline unsigned int
+hash_key (void *key, int key_size)
+{
+    unsigned int hash = 5381;
+    unsigned char *str = (unsigned char *)key;
+    int i;
+
+    for (i = 0; i < key_size; i++)
+        hash = ((hash << 5) + hash) + str[i];
+
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+/* Double the slots of a hash store and rehash its entries. */
+static void
+hash_store_grow (keyvals_arr_t *arr)
+{
+    keyvals_t *old_arr = arr->arr;
+    unsigned int *old_hashes = arr->hashes;
+    int old_len = arr->alloc_len;
+    unsigned int mask, pos;
+    int i;
+
+    arr->alloc_len = (old_len) ? old_len * 2 : DEFAULT_HASH_STORE_LEN;
+    arr->arr = (keyvals_t *)mem_calloc (arr->alloc_len, sizeof (keyvals_t));
+    arr->hashes = (unsigned int *)mem_malloc (
+        arr->alloc_len * sizeof (unsigned int));
+    assert (arr->arr && arr->hashes);
+
+    mask = arr->alloc_len - 1;
+
+    for (i = 0; i < old_len; i++)
+    {
+        if (old_arr[i].vals == NULL) continue;
+
+        pos = old_hashes[i] & mask;
+        while (arr->arr[pos].vals != NULL)
+            pos = (pos + 1) & mask;
+
+        arr->arr[pos] = old_arr[i];
+        arr->hashes[pos] = old_hashes[i];
+    }
+
+    if (old_len)
+    {
+        mem_free (old_arr);
+        mem_free (old_hashes);
+    }
+}
+
+static int
+keyvals_cmp (const void *v1, const void *v2)
+{
+    return sort_key_cmp (((keyvals_t *)v1)->key, ((keyvals_t *)v2)->key);
+}
+
+/* Turn a hash store into the sorted array expected by reduce. */
+static void
+hash_store_sort (keyvals_arr_t *arr)
+{
+    int i, len = 0;
+
+    if (arr->hashes == NULL)
+        return;
+
+    for (i = 0; i < arr->alloc_len; i++)
+    {
+        if (arr->arr[i].vals != NULL)
+            arr->arr[len++] = arr->arr[i];
+    }
+
+    assert (len == arr->len);
+
+    mem_free (arr->hashes);
+    arr->hashes = NULL;
+
+    qsort (arr->arr, len, sizeof (keyvals_t), keyvals_cmp);
+}
+
+static inline void 
+insert_keyval_hashed (mr_env_t* env, keyvals_arr_t *arr, void *key, void *val,
+    int key_size)
+{
+    unsigned int hash, mask, pos;
+    keyvals_t *insert_pos;
+
+    /* Keep the load factor under 3/4. */
+    if (4 * (arr->len + 1) > 3 * arr->alloc_len)
+        hash_store_grow (arr);
+
+    hash = hash_key (key, key_size);
+    mask = arr->alloc_len - 1;
+    pos = hash & mask;
+
+    /* Linear probing, free slots have no values. */
+    while (arr->arr[pos].vals != NULL)
+    {
+        if (arr->hashes[pos] == hash && !env->key_cmp(arr->arr[pos].key, key))
+            break;
+        pos = (pos + 1) & mask;
+    }
+
+    insert_pos = &(arr->arr[pos]);
+
+    if (insert_pos->vals == NULL)
+    {
+        insert_pos->key = key;
+        insert_pos->len = 0;
+        arr->hashes[pos] = hash;
+        arr->len++;
+    }
+
+    insert_val (env, insert_pos, val);
+}
+
+/* Append val to the values of insert_pos. */
+static inline void
+insert_val (mr_env_t* env, keyvals_t *insert_pos, void *val)
+{
+    val_t *new_vals;
+
     if (insert_pos->vals == NULL)
     {
         /* Allocate a chunk for the first time. */
@@ -1629,63 +1754,108 @@ insert_keyval (mr_env_t* env, keyval_arr_t *arr, void *key, void *val)
     arr->len++;
 }
 
-static inline void 
-merge_results (mr_env_t* env, keyval_arr_t *vals, int length) 
+/* Cursor on the part of a reduce output that a merge thread owns. */
+typedef struct
 {
-    int data_idx;
-    int total_num_keys = 0;
-    int i;
-    //static __thread int curr_thread = -1;
-    int curr_thread;
-
-    curr_thread = getCurrThreadIndex (TASK_TYPE_MERGE);
+    keyval_t    *arr;
+    int         pos;
+    int         end;
+} merge_cursor_t;
+
+/* Index of the first key of vals that is not lower than key. */
+static inline int
+merge_lower_bound (mr_env_t* env, keyval_arr_t *vals, void *key)
+{
+    int low = 0, high = vals->len, next;
 
-    for (i = 0; i < length; i++) {
-        total_num_keys += vals[i].len;
+    while (low < high)
+    {
+        next = (low + high) / 2;
+        if (env->key_cmp (vals->arr[next].key, key) < 0)
+            low = next + 1;
+        else
+            high = next;
     }
 
-    env->merge_vals[curr_thread].len = total_num_keys;
-    env->merge_vals[curr_thread].alloc_len = total_num_keys;
-    env->merge_vals[curr_thread].pos = 0;
-    env->merge_vals[curr_thread].arr = (keyval_t *)
-      mem_malloc(sizeof(keyval_t) * total_num_keys);
+    return low;
+}
 
-    for (data_idx = 0; data_idx < total_num_keys; data_idx++) {
-        /* For each keyval_t. */
-        int         min_idx;
-        keyval_t    *min_keyval;
+static inline void
+merge_heap_down (mr_env_t* env, merge_cursor_t *heap, int len, int i)
+{
+    merge_cursor_t tmp;
+    int child;
+
+    while ((child = 2 * i + 1) < len)
+    {
+        if (child + 1 < len &&
+            env->key_cmp (heap[child + 1].arr[heap[child + 1].pos].key,
+                          heap[child].arr[heap[child].pos].key) < 0)
+            child++;
+
+        if (env->key_cmp (heap[child].arr[heap[child].pos].key,
+                          heap[i].arr[heap[i].pos].key) >= 0)
+            break;
 
-        for (i = 0; i < length && vals[i].pos >= vals[i].len; i++);
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
 
-        if (i == length) break;
+/* K-way merge of the keys in [splitter[thread_index - 1],
+   splitter[thread_index]) of the length sorted arrays. The output
+   offset is the number of keys lower than the first splitter. */
+static inline void 
+merge_results (mr_env_t* env, keyval_arr_t *vals, int length, 
+    int thread_index) 
+{
+    merge_cursor_t  *heap;
+    keyval_t        *out;
+    int             num_cursors = 0;
+    int             out_pos = 0;
+    int             i, low, high;
 
-        /* Determine the minimum key. */
-        min_idx = i;
-        min_keyval = &vals[i].arr[vals[i].pos];
+    heap = (merge_cursor_t *)mem_malloc (length * sizeof (merge_cursor_t));
+    CHECK_ERROR (heap == NULL);
 
-        for (i++; i < length; i++) {
-            if (vals[i].pos < vals[i].len)
-            {
-                int cmp_ret;
-                cmp_ret = env->key_cmp(
-                    min_keyval->key, 
-                    vals[i].arr[vals[i].pos].key);
-
-                if (cmp_ret > 0) {
-                    min_idx = i;
-                    min_keyval = &vals[i].arr[vals[i].pos];
-                }
-            }
-        }
+    for (i = 0; i < length; i++)
+    {
+        low = (thread_index > 0) ? merge_lower_bound (
+            env, &vals[i], env->merge_splitters[thread_index - 1]) : 0;
+        high = (thread_index < env->num_merge_threads - 1) ? 
+            merge_lower_bound (
+                env, &vals[i], env->merge_splitters[thread_index]) : 
+            vals[i].len;
 
-        mem_memcpy (&env->merge_vals[curr_thread].arr[data_idx], 
-                        min_keyval, sizeof(keyval_t));
-        vals[min_idx].pos += 1;
+        out_pos += low;
+
+        if (low < high)
+        {
+            heap[num_cursors].arr = vals[i].arr;
+            heap[num_cursors].pos = low;
+            heap[num_cursors].end = high;
+            num_cursors++;
+        }
     }
 
-    for (i = 0; i < length; i++) {
-        mem_free(vals[i].arr);
+    for (i = num_cursors / 2 - 1; i >= 0; i--)
+        merge_heap_down (env, heap, num_cursors, i);
+
+    out = &env->merge_output[out_pos];
+
+    while (num_cursors > 0)
+    {
+        *out++ = heap[0].arr[heap[0].pos++];
+
+        if (heap[0].pos == heap[0].end)
+            heap[0] = heap[--num_cursors];
+
+        merge_heap_down (env, heap, num_cursors, 0);
     }
+
+    mem_free (heap);
 }
 
 static inline int 
@@ -1863,12 +2033,67 @@ static void reduce (mr_env_t* env)
     mem_free (env->intermediate_vals);
 }
 
+static int
+keyval_cmp (const void *v1, const void *v2)
+{
+    return sort_key_cmp (((keyval_t *)v1)->key, ((keyval_t *)v2)->key);
+}
+
 /**
- * Merge all reduced data 
+ * Pick num_merge_threads - 1 splitters out of a regular sample
+ * of the sorted reduce outputs, so that every merge thread gets
+ * about the same number of keys.
+ */
+static void merge_select_splitters (
+    mr_env_t* env, keyval_arr_t *vals, int length, int total)
+{
+    keyval_t    *samples;
+    int         num_samples = 0;
+    int         stride;
+    int         i, j;
+
+    env->merge_splitters = NULL;
+
+    if (env->num_merge_threads <= 1)
+        return;
+
+    stride = total / (env->num_merge_threads * MERGE_OVERSAMPLING);
+    stride = MAX (stride, 1);
+
+    samples = (keyval_t *)mem_malloc (
+        (total / stride + length) * sizeof (keyval_t));
+    CHECK_ERROR (samples == NULL);
+
+    for (i = 0; i < length; i++)
+    {
+        for (j = 0; j < vals[i].len; j += stride)
+            samples[num_samples++] = vals[i].arr[j];
+    }
+
+    qsort (samples, num_samples, sizeof (keyval_t), keyval_cmp);
+
+    env->merge_splitters = (void **)mem_malloc (
+        (env->num_merge_threads - 1) * sizeof (void *));
+    CHECK_ERROR (env->merge_splitters == NULL);
+
+    for (i = 1; i < env->num_merge_threads; i++)
+    {
+        env->merge_splitters[i - 1] = 
+            samples[(i * num_samples) / env->num_merge_threads].key;
+    }
+
+    mem_free (samples);
+}
+
+/**
+ * Merge all reduced data in a single pass: each merge thread
+ * k-way merges one splitter range into the final array.
  */
 static void merge (mr_env_t* env)
 {
     thread_arg_t   th_arg;
+    int            total = 0;
+    int            i;
 
     mem_memset (&th_arg, 0, sizeof (thread_arg_t));
     th_arg.task_type = TASK_TYPE_MERGE;
@@ -1890,32 +2115,31 @@ static void merge (mr_env_t* env)
         return;
     }
 
-    /* have work to merge! */
-    while (th_arg.merge_len > 1) {
-        th_arg.merge_round += 1;
+    for (i = 0; i < th_arg.merge_len; i++)
+        total += env->final_vals[i].len;
 
-        /* This is the worst case length, 
-           depending on the value of num_merge_threads. */
-        env->merge_vals = (keyval_arr_t*) 
-            mem_malloc (env->num_merge_threads * sizeof(keyval_arr_t));
+    /* Do not wake up threads for a handful of keys. */
+    env->num_merge_threads = MIN (
+        env->num_merge_threads, total / MERGE_MIN_KEYS_PER_THREAD);
+    env->num_merge_threads = MAX (env->num_merge_threads, 1);
 
-        /* Run merge tasks and get merge values. */
-        start_workers (env, &th_arg);
+    env->merge_output = (keyval_t *)mem_malloc (
+        MAX (total, 1) * sizeof (keyval_t));
+    CHECK_ERROR (env->merge_output == NULL);
 
-        mem_free (th_arg.merge_input);
-        th_arg.merge_len = env->num_merge_threads;
+    merge_select_splitters (env, th_arg.merge_input, th_arg.merge_len, total);
 
-        env->num_merge_threads /= 2;
-        if (env->num_merge_threads == 0)
-            env->num_merge_threads = 1;
+    /* have work to merge! */
+    start_workers (env, &th_arg);
 
-        th_arg.merge_input = env->merge_vals;
-    }
+    for (i = 0; i < th_arg.merge_len; i++)
+        mem_free (env->final_vals[i].arr);
 
-    env->args->result->data = env->merge_vals[0].arr;
-    env->args->result->length = env->merge_vals[0].len;
+    mem_free (env->final_vals);
+    mem_free (env->merge_splitters);
 
-    mem_free(env->merge_vals);
+    env->args->result->data = env->merge_output;
+    env->args->result->length = total;
 }
 
 static inline mr_env_t* get_env (void)
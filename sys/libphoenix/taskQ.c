@@ -32,65 +32,55 @@
 
 #include "memory.h"
 #include "taskQ.h"
-#include "queue.h"
 #include "synch.h"
 #include "locality.h"
+#include "atomic.h"
+
+#define TQ_DEFAULT_LEN          64      /* Must be a power of 2. */
+#define TQ_CACHE_LINE_SIZE      64
 
 static int num_strands_per_chip = 0;
 
-typedef struct {
-    task_t              task; 
-    queue_elem_t        queue_elem;
-} tq_entry_t;
+/* Ring of task entries. Arenas are only replaced by bigger ones,
+   retired arenas stay valid for late readers until tq_reset(). */
+typedef struct tq_arena_t {
+    struct tq_arena_t   *next;
+    unsigned int        size;
+    task_t              tasks[];
+} tq_arena_t;
 
+/* Producers append at bottom (serialized by lock unless sequential),
+   consumers of any locality group take from top with a CAS. */
 typedef struct {
-    mr_lock_t  parent;
-    uintptr_t  chksum;
-    mr_lock_t  *per_thread;
-} tq_lock_t;
+    union {
+        volatile uintptr_t  top;
+        char                pad[TQ_CACHE_LINE_SIZE];
+    };
+    volatile uintptr_t      bottom;
+    tq_arena_t * volatile   arena;
+    tq_arena_t              *retired;
+    mr_lock_t               parent;
+    mr_lock_t               *per_thread;
+} __attribute__ ((aligned (TQ_CACHE_LINE_SIZE))) tq_deque_t;
 
 struct taskQ_t {
     int             num_queues;
     int             num_threads;
-    queue_t         **queues;
-    queue_t         **free_queues;
-    tq_lock_t       *locks;
+    tq_deque_t      *deques;
+    /* per-queue victims, nearest locality groups first */
+    unsigned short  *steal_order;
     /* putting all seeds together may lead to extra coherence traffic among cpus
      * if it's a problem we can pad it by l1 line size */
     /* per-thread random seed */
     unsigned int    *seeds;
  };
 
-typedef int (*dequeue_fn)(taskQ_t *, int, int, queue_elem_t**);
-
-static inline taskQ_t* tq_init_normal(int numThreads);
-static inline void tq_finalize_normal(taskQ_t* tq);
-static inline int tq_dequeue_normal(
-    taskQ_t* tq, task_t* task, int lgrp, int tid);
-static inline int tq_dequeue_normal_seq (
-    taskQ_t* tq, task_t* task, int lgrp, int tid);
-static inline int tq_dequeue_normal_internal (
-    taskQ_t* tq, task_t* task, int lgrp, int tid, dequeue_fn dequeue_fn);
-
-static queue_t* tq_alloc_queue(void);
-static void tq_free_queue(queue_t* q);
-static int tq_queue_init(taskQ_t* tq, unsigned int idx);
-static void tq_queue_destroy(taskQ_t* tq, unsigned int idx);
-static void tq_empty_queue(queue_t* q);
+static int tq_deque_init (taskQ_t* tq, tq_deque_t *dq);
+static void tq_deque_destroy (taskQ_t* tq, tq_deque_t *dq);
+static void tq_free_retired (tq_deque_t *dq);
+static void tq_init_steal_order (taskQ_t* tq);
 
 taskQ_t* tq_init (int num_threads)
-{
-    return tq_init_normal(num_threads);
-}
-
-void tq_reset (taskQ_t* tq, int num_threads)
-{
-}
-
-/**
- * Initialize task queue for a normal machine
- */
-static inline taskQ_t* tq_init_normal(int numThreads)
 {
     int             i;
     taskQ_t         *tq = NULL;
@@ -102,315 +92,327 @@ static inline taskQ_t* tq_init_normal(int numThreads)
 
     /* XXX should this be local? */
     num_strands_per_chip = loc_get_lgrp_size ();
-    tq->num_threads = numThreads;
+    tq->num_threads = num_threads;
     tq->num_queues = tq->num_threads / num_strands_per_chip;
 
     if (tq->num_queues == 0)
         tq->num_queues = 1;
 
-    tq->queues = (queue_t **)mem_calloc (tq->num_queues, sizeof (queue_t *));
-    if (tq->queues == NULL) goto fail_queues;
-
-    tq->free_queues = (queue_t **)mem_calloc (
-        tq->num_queues, sizeof (queue_t *));
-    if (tq->free_queues == NULL) goto fail_free_queues;
+    tq->deques = (tq_deque_t *)mem_malloc (
+        tq->num_queues * sizeof (tq_deque_t));
+    if (tq->deques == NULL) goto fail_deques;
 
-    tq->locks = (tq_lock_t *)mem_calloc (tq->num_queues, sizeof (tq_lock_t));
-    if (tq->locks == NULL) goto fail_locks;
+    tq->steal_order = (unsigned short *)mem_malloc (
+        tq->num_queues * tq->num_queues * sizeof (unsigned short));
+    if (tq->steal_order == NULL) goto fail_steal_order;
 
     tq->seeds = (unsigned int*)mem_calloc(
         tq->num_threads, sizeof(unsigned int));
     if (tq->seeds == NULL) goto fail_seeds;
-    mem_memset(tq->seeds, 0, sizeof(unsigned int) * tq->num_threads);
 
     for (i = 0; i < tq->num_queues; ++i)
-        if (!tq_queue_init(tq, i))
+        if (!tq_deque_init(tq, &tq->deques[i]))
             goto fail_tq_init;
 
+    tq_init_steal_order (tq);
+
     return tq;
 
 fail_tq_init:
     /* destroy all queues that have been allocated */
     i--;
     while (i >= 0) {
-        tq_queue_destroy(tq, i);
+        tq_deque_destroy(tq, &tq->deques[i]);
         --i;
     }
     mem_free(tq->seeds);
 fail_seeds:
-    mem_free(tq->locks);
-fail_locks:
-    mem_free(tq->free_queues);
-fail_free_queues:
-    mem_free(tq->queues);
-fail_queues:
+    mem_free(tq->steal_order);
+fail_steal_order:
+    mem_free(tq->deques);
+fail_deques:
     mem_free(tq);
     return NULL;
 }
 
 /**
- * Destroys an initialized queue (i.e. free queue and alloc queue) in task queue
- * @param tq    tq to index
- * @param idx   index of queue to destroy in tq
+ * Empties all queues for a new phase and frees retired arenas, keeping
+ * the current ones as the entry pool. No dequeue may be in progress.
  */
-static void tq_queue_destroy(taskQ_t* tq, unsigned int idx)
+void tq_reset (taskQ_t* tq, int num_threads)
 {
-    int             j;
-    uintptr_t       chksum;
+    int i;
 
-//    assert (idx < tq->num_queues);
+    assert (num_threads <= tq->num_threads);
 
-    tq_empty_queue(tq->queues[idx]);
-    tq_free_queue(tq->queues[idx]);
+    for (i = 0; i < tq->num_queues; ++i) {
+        tq_free_retired (&tq->deques[i]);
+        tq->deques[i].top = 0;
+        tq->deques[i].bottom = 0;
+    }
+}
 
-    tq_empty_queue(tq->free_queues[idx]);
-    tq_free_queue(tq->free_queues[idx]);
+/**
+ * Locality group served by a queue: tq_enqueue and tq_dequeue use queue
+ * lgrp % num_queues, so queue index holds the tasks of lgrp index first.
+ * Queues beyond the last lgrp only get tasks of no particular lgrp and
+ * are spread over the lgrps again.
+ */
+static inline int tq_queue_lgrp (int index)
+{
+    return index % loc_get_num_lgrps ();
+}
 
-    /* free all lock data associated with queue */
-    chksum = 0;
-    for (j = 0; j < tq->num_threads; j++) {
-        chksum += (uintptr_t)tq->locks[idx].per_thread[j];
-        lock_free_per_thread(tq->locks[idx].per_thread[j]);
-    }
+/**
+ * Orders, for each queue, the other queues by the distance of their
+ * locality groups; ties are broken by index to spread the thieves.
+ */
+static void tq_init_steal_order (taskQ_t* tq)
+{
+    int             i, j, k, n, lgrp, dist;
+    unsigned short  *order, victim;
 
-    lock_free (tq->locks[idx].parent);
+    n = tq->num_queues;
 
-    mem_free (tq->locks[idx].per_thread);
-    tq->locks[idx].per_thread = NULL;
+    for (i = 0; i < n; ++i) {
+        order = &tq->steal_order[i * n];
+        lgrp = tq_queue_lgrp (i);
+
+        for (j = 1; j < n; ++j) {
+            victim = (i + j) % n;
+            dist = loc_get_distance (lgrp, tq_queue_lgrp (victim));
+
+            /* Insertion sort, stable on the rotated index. */
+            for (k = j - 1; k > 0 && loc_get_distance (
+                     lgrp, tq_queue_lgrp (order[k - 1])) > dist; --k)
+                order[k] = order[k - 1];
+
+            order[k] = victim;
+        }
+    }
 }
 
 /**
- * Initialize a queue for a given index in the task queue
+ * Initialize a queue with an empty arena of TQ_DEFAULT_LEN entries
  * @return zero on failure, nonzero on success
  */
-static int tq_queue_init(taskQ_t* tq, unsigned int idx)
+static int tq_deque_init (taskQ_t* tq, tq_deque_t *dq)
 {
     int     j;
 
-    assert (idx < (unsigned)tq->num_queues);
+    mem_memset (dq, 0, sizeof (tq_deque_t));
 
-    tq->queues[idx] = tq_alloc_queue();
-    if (tq->queues[idx] == NULL) return 0;
+    dq->arena = (tq_arena_t *)mem_malloc (
+        sizeof (tq_arena_t) + TQ_DEFAULT_LEN * sizeof (task_t));
+    if (dq->arena == NULL) return 0;
 
-    tq->free_queues[idx] = tq_alloc_queue();
-    if (tq->free_queues[idx] == NULL) goto fail_free_queue;
+    dq->arena->next = NULL;
+    dq->arena->size = TQ_DEFAULT_LEN;
 
-    tq->locks[idx].parent = lock_alloc();
+    dq->parent = lock_alloc();
 
-    tq->locks[idx].per_thread = (mr_lock_t *)mem_calloc(
+    dq->per_thread = (mr_lock_t *)mem_calloc(
         tq->num_threads, sizeof(mr_lock_t));
-    if (tq->locks[idx].per_thread == NULL) goto fail_priv_alloc;
-
-    tq->locks[idx].chksum = 0;
-    for (j = 0; j < tq->num_threads; ++j) {
-        mr_lock_t   per_thread;
-        per_thread = lock_alloc_per_thread(tq->locks[idx].parent);
-        tq->locks[idx].per_thread[j] = per_thread;
-        tq->locks[idx].chksum += (uintptr_t)per_thread;
-    }
+    if (dq->per_thread == NULL) goto fail_priv_alloc;
+
+    for (j = 0; j < tq->num_threads; ++j)
+        dq->per_thread[j] = lock_alloc_per_thread(dq->parent);
 
     return 1;
 
 fail_priv_alloc:
-    lock_free(&tq->locks[idx].parent);
-    tq_free_queue(tq->free_queues[idx]);
-    tq->free_queues[idx] = NULL;
-fail_free_queue:
-    tq_free_queue(tq->queues[idx]);
-    tq->queues[idx] = NULL;
+    lock_free(dq->parent);
+    mem_free(dq->arena);
+    dq->arena = NULL;
 
     return 0;
 }
 
 /**
- * Allocates an initialized queue
- * @return NULL on failure, initialized queue pointer on success
+ * Destroys an initialized queue and all its arenas
  */
-static queue_t* tq_alloc_queue(void)
+static void tq_deque_destroy (taskQ_t* tq, tq_deque_t *dq)
 {
-    queue_t *q;
+    int             j;
 
-    q = (queue_t*) mem_malloc (sizeof(queue_t));
-    if (q == NULL) {
-        return NULL;
-    }
+    tq_free_retired (dq);
+    mem_free (dq->arena);
+    dq->arena = NULL;
 
-    queue_init(q);
+    /* free all lock data associated with queue */
+    for (j = 0; j < tq->num_threads; j++)
+        lock_free_per_thread(dq->per_thread[j]);
 
-    return q;
-}
+    lock_free (dq->parent);
 
-/**
- * Frees an initialized queue that was allocated on the heap.
- */
-static void tq_free_queue(queue_t* q)
-{
-    mem_free(q);
+    mem_free (dq->per_thread);
+    dq->per_thread = NULL;
 }
 
-/**
- * Empties out a queue in the task queue by dequeuing and freeing
- * every task.
- */
-static void tq_empty_queue(queue_t* q)
+static void tq_free_retired (tq_deque_t *dq)
 {
-    do {
-        tq_entry_t      *entry;
-        queue_elem_t    *queue_elem;
+    tq_arena_t  *arena, *next;
 
-        if (queue_pop_front (q, &queue_elem) == 0)
-            break;
+    for (arena = dq->retired; arena != NULL; arena = next) {
+        next = arena->next;
+        mem_free (arena);
+    }
 
-        entry = queue_entry (queue_elem, tq_entry_t, queue_elem);
-        assert (entry != NULL);
-        mem_free (entry);
-    } while (1);
+    dq->retired = NULL;
 }
 
-static inline void tq_finalize_normal(taskQ_t* tq)
+void tq_finalize (taskQ_t* tq)
 {
     int i;
 
-    assert (tq->queues != NULL);
-    assert (tq->free_queues != NULL);
-    assert (tq->locks != NULL);
+    assert (tq->deques != NULL);
 
     /* destroy all queues */
     for (i = 0; i < tq->num_queues; ++i) {
-        tq_queue_destroy(tq, i);
+        tq_deque_destroy(tq, &tq->deques[i]);
     }
 
     /* destroy all first level pointers in tq */
-    mem_free (tq->queues);
-    mem_free (tq->free_queues);
-    mem_free (tq->locks);
+    mem_free (tq->deques);
+    mem_free (tq->steal_order);
     mem_free (tq->seeds);
 
     /* finally kill tq */
     mem_free (tq);
 }
 
-void tq_finalize (taskQ_t* tq)
-{
-    tq_finalize_normal(tq);
-}
-
-/* Queue TASK at LGRP task queue with locking.
-   LGRP is a locality hint denoting to which locality group this task 
-   should be queued at. If LGRP is less than 0, the locality group is 
-   randomly selected. TID is required for MCS locking. */
-int tq_enqueue (taskQ_t* tq, task_t *task, int lgrp, int tid)
+/**
+ * Replaces a full arena by one twice as big. Entries still to be taken
+ * are copied, the old arena is retired since consumers may be reading it.
+ * @return the new arena, NULL on failure
+ */
+static tq_arena_t* tq_deque_grow (tq_deque_t *dq, uintptr_t bottom)
 {
-    tq_entry_t      *entry;
-    int             index;
+    tq_arena_t      *old, *arena;
+    uintptr_t       i;
 
-    assert (tq != NULL);
-    assert (task != NULL);
+    old = dq->arena;
 
-    entry = (tq_entry_t *)mem_malloc (sizeof (tq_entry_t));
-    if (entry == NULL) {
-        return -1;
+    arena = (tq_arena_t *)mem_malloc (
+        sizeof (tq_arena_t) + old->size * 2 * sizeof (task_t));
+    if (arena == NULL) {
+        return NULL;
     }
 
-    mem_memcpy (&entry->task, task, sizeof (task_t));
+    arena->size = old->size * 2;
 
-    index = (lgrp < 0) ? rand_r(&tq->seeds[tid]) : lgrp;
-    index %= tq->num_queues;
+    for (i = dq->top; i != bottom; i++)
+        arena->tasks[i & (arena->size - 1)] = old->tasks[i & (old->size - 1)];
 
-    lock_acquire (tq->locks[index].per_thread[tid]);
-    queue_push_back (tq->queues[index], &entry->queue_elem);
-    lock_release (tq->locks[index].per_thread[tid]);
+    old->next = dq->retired;
+    dq->retired = old;
 
-    return 0;
+    cpu_wbflush ();
+    dq->arena = arena;
+
+    return arena;
 }
 
-/* Queue TASK at LGRP task queue without locking.
-   LGRP is a locality hint denoting to which locality group this task
-   should be queued at. If LGRP is less than 0, the locality group is
-   randomly selected. */
-int tq_enqueue_seq (taskQ_t* tq, task_t *task, int lgrp)
+/* Appends TASK at the bottom of DQ. Caller is the only producer. */
+static inline int tq_deque_push (tq_deque_t *dq, task_t *task)
 {
-    tq_entry_t      *entry;
-    int             index;
+    tq_arena_t      *arena;
+    uintptr_t       bottom;
 
-    assert (task != NULL);
+    arena = dq->arena;
+    bottom = dq->bottom;
 
-    entry = (tq_entry_t *)mem_malloc (sizeof (tq_entry_t));
-    if (entry == NULL) {
-        return -1;
+    if (bottom - dq->top >= arena->size) {
+        arena = tq_deque_grow (dq, bottom);
+        if (arena == NULL) {
+            return -1;
+        }
     }
 
-    mem_memcpy (&entry->task, task, sizeof (task_t));
+    mem_memcpy (&arena->tasks[bottom & (arena->size - 1)], task, 
+        sizeof (task_t));
 
-    index = (lgrp < 0) ? rand() % tq->num_queues : lgrp % tq->num_queues;
-    queue_push_back (tq->queues[index], &entry->queue_elem);
+    /* Entry must be visible before it can be taken. */
+    cpu_wbflush ();
+    dq->bottom = bottom + 1;
 
     return 0;
 }
 
-/**
- * Safely dequeues an element from the normal queue and queues onto free queue
- * @param tq        taskQ to operate on
- * @param idx       index of queue to use
- * @param tid       task id
- * @param qe        queue element of element we operated on
- * @return nonzero if normal queue was empty
- */
-static inline int tq_elem_into_free_seq (
-    taskQ_t* tq, int idx, int tid, queue_elem_t** qe)
+/* Takes the oldest task of DQ.
+   @return nonzero on success, zero if DQ is empty */
+static inline int tq_deque_take (tq_deque_t *dq, task_t *task)
 {
-    queue_elem_t    *queue_elem = NULL;
-    int             ret;
+    tq_arena_t      *arena;
+    uintptr_t       top, bottom;
 
-    ret = queue_pop_front (tq->queues[idx], &queue_elem);
-    if (ret != 0)
-        queue_push_back (tq->free_queues[idx], queue_elem);
+    do {
+        top = dq->top;
+        cpu_rdbarrier ();
+        bottom = dq->bottom;
 
-    *qe = queue_elem;
+        if ((intptr_t)(bottom - top) <= 0) {
+            return 0;
+        }
 
-    return ret;
+        /* Read after bottom: the arena holds at least [top, bottom). */
+        cpu_rdbarrier ();
+        arena = dq->arena;
+        mem_memcpy (task, &arena->tasks[top & (arena->size - 1)], 
+            sizeof (task_t));
+
+    } while (!cmp_and_swp (top + 1, (uintptr_t *)&dq->top, top));
+
+    return 1;
 }
 
-/**
- * Safely dequeues an element from the normal queue and queues onto free queue
- * @param tq        taskQ to operate on
- * @param idx       index of queue to use
- * @param tid       task id
- * @param qe        queue element of element we operated on
- * @return nonzero if normal queue was empty
- */
-static inline int tq_elem_into_free (
-    taskQ_t* tq, int idx, int tid, queue_elem_t** qe)
+/* Queue TASK at LGRP task queue with locking.
+   LGRP is a locality hint denoting to which locality group this task 
+   should be queued at. If LGRP is less than 0, the locality group is 
+   randomly selected. TID is required for MCS locking. */
+int tq_enqueue (taskQ_t* tq, task_t *task, int lgrp, int tid)
 {
+    tq_deque_t      *dq;
+    int             index;
     int             ret;
 
-    lock_acquire (tq->locks[idx].per_thread[tid]);
-    ret = tq_elem_into_free_seq (tq, idx, tid, qe);
-    lock_release (tq->locks[idx].per_thread[tid]);
+    assert (tq != NULL);
+    assert (task != NULL);
+
+    index = (lgrp < 0) ? rand_r(&tq->seeds[tid]) : lgrp;
+    index %= tq->num_queues;
+    dq = &tq->deques[index];
+
+    lock_acquire (dq->per_thread[tid]);
+    ret = tq_deque_push (dq, task);
+    lock_release (dq->per_thread[tid]);
 
     return ret;
 }
 
-static inline int tq_dequeue_normal_seq (
-    taskQ_t* tq, task_t* task, int lgrp, int tid)
+/* Queue TASK at LGRP task queue without locking.
+   LGRP is a locality hint denoting to which locality group this task
+   should be queued at. If LGRP is less than 0, the locality group is
+   randomly selected. */
+int tq_enqueue_seq (taskQ_t* tq, task_t *task, int lgrp)
 {
-    return tq_dequeue_normal_internal (
-        tq, task, lgrp, tid, tq_elem_into_free_seq);
-}
+    int             index;
 
-static inline int tq_dequeue_normal(
-    taskQ_t* tq, task_t* task, int lgrp, int tid)
-{
-    return tq_dequeue_normal_internal (
-        tq, task, lgrp, tid, tq_elem_into_free);
+    assert (task != NULL);
+
+    index = (lgrp < 0) ? rand() % tq->num_queues : lgrp % tq->num_queues;
+
+    return tq_deque_push (&tq->deques[index], task);
 }
 
-static inline int tq_dequeue_normal_internal (
-    taskQ_t* tq, task_t* task, int lgrp, int tid, dequeue_fn dequeue_fn)
+/* Dequeue a task from LGRP task queue, then steal from the other
+   queues, nearest locality groups first. If LGRP is less than 0, the
+   starting queue is randomly selected.
+   @return nonzero on success, zero if there is no more work */
+int tq_dequeue (taskQ_t* tq, task_t *task, int lgrp, int tid)
 {
-    int             i, ret, index;
-    queue_elem_t    *queue_elem;
-    tq_entry_t      *entry;
+    unsigned short  *order;
+    int             i, index;
 
     assert (task != NULL);
 
@@ -418,31 +420,18 @@ static inline int tq_dequeue_normal_internal (
 
     index = (lgrp < 0) ? rand_r(&tq->seeds[tid]) : lgrp;
     index %= tq->num_queues;
-    ret = (*dequeue_fn)(tq, index, tid, &queue_elem);
-
-   /* Do task stealing if nothing on our queue.
-      Cycle through all indexes until success or exhaustion */
-    for (i = (index + 1) % tq->num_queues;
-        (ret == 0) && (i != index);
-        i = (i + 1) % tq->num_queues)
-    {
-        ret = (*dequeue_fn)(tq, i, tid, &queue_elem);
-    }
 
-    if (ret == 0) {
-        /* There really is no more work. */
-        return 0;
-    }
+    if (tq_deque_take (&tq->deques[index], task))
+        return 1;
 
-    entry = queue_entry (queue_elem, tq_entry_t, queue_elem);
-    assert (entry != NULL);
+    /* Do task stealing if nothing on our queue. */
+    order = &tq->steal_order[index * tq->num_queues];
 
-    mem_memcpy (task, &entry->task, sizeof (task_t));
-
-    return 1;
-}
+    for (i = 0; i < tq->num_queues - 1; i++) {
+        if (tq_deque_take (&tq->deques[order[i]], task))
+            return 1;
+    }
 
-int tq_dequeue (taskQ_t* tq, task_t *task, int lgrp, int tid)
-{
-    return tq_dequeue_normal(tq, task, lgrp, tid);
+    /* There really is no more work. */
+    return 0;
 }
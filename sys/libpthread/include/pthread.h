@@ -101,6 +101,16 @@ enum{
 	__PT_TLS_VALUES_NR
 };
 
+/* Read locks held by a thread on one process-private rwlock,
+ * entries with a null count are free */
+#define __PT_RDLOCKS_MAX              4
+
+struct __pthread_rdlock_s
+{
+	void *rwlock;
+	uint_t count;
+};
+
 #define __pthread_tls_set(tls,index,val)
 #define __pthread_tls_get(tls,index)
 #define __pthread_tls_getlocation(tls,index)
@@ -111,6 +121,7 @@ typedef struct __pthread_tls_s
 	pthread_attr_t attr;
 	void *values_tbl[PTHREAD_KEYS_MAX];
 	uint_t tls_tbl[__PT_TLS_VALUES_NR];
+	struct __pthread_rdlock_s rdlocks[__PT_RDLOCKS_MAX];
 }__pthread_tls_t;
 
 void __pthread_init(void);
@@ -128,7 +139,6 @@ void __pthread_barrier_init(void);
 #define __PTHREAD_OBJECT_FREE      0xC0A5C0A5
 
 typedef unsigned long pthread_t;
-typedef unsigned long pthread_rwlock_t;
 typedef unsigned long pthread_rwlockattr_t;
 typedef unsigned long pthread_key_t;
 
@@ -161,7 +171,7 @@ typedef struct
 
 #define __MUTEX_INITIALIZER(_t)						\
 	{							        \
-		.sem     = 0,						\
+		.sem     = {.sysid = 0},				\
 		.lock    = {.val = __PTHREAD_OBJECT_FREE},		\
 		.value   = __PTHREAD_OBJECT_FREE,		        \
 		.waiting = 0,				                \
@@ -190,6 +200,38 @@ typedef struct
 		.queue = {.next = 0, .pred = 0}         		\
 	}
 
+/* value holds the readers count, the writer bit and the waiters bit,
+ * sysid is only used by process-shared rwlocks which are kernel objects.
+ * Readers queue up behind waiting writers, except a thread which already
+ * holds a read lock on this rwlock: it gets the lock while other readers
+ * hold it, so that a recursive rdlock does not wait for a writer waiting
+ * for it. Threads track up to __PT_RDLOCKS_MAX rwlocks at once */
+typedef struct
+{
+	unsigned long sysid;
+	int scope;
+	pthread_spinlock_t lock;
+	volatile uint_t value    __CACHELINE;
+	uint_t owner;
+	uint_t rwaiting          __CACHELINE;
+	uint_t wwaiting;
+	struct list_entry rqueue __CACHELINE;
+	struct list_entry wqueue;
+}pthread_rwlock_t;
+
+#define PTHREAD_RWLOCK_INITIALIZER				\
+	{							\
+		.sysid    = 0,					\
+		.scope    = PTHREAD_PROCESS_PRIVATE,		\
+		.lock     = {.val = __PTHREAD_OBJECT_FREE},	\
+		.value    = 0,					\
+		.owner    = 0,					\
+		.rwaiting = 0,					\
+		.wwaiting = 0,					\
+		.rqueue   = {.next = 0, .pred = 0},		\
+		.wqueue   = {.next = 0, .pred = 0}		\
+	}
+
 typedef struct
 {
 	int lock;
@@ -23,7 +23,28 @@
 #ifndef _SEMAPHORE_H_
 #define _SEMAPHORE_H_
 
-typedef unsigned long sem_t;
+#include <sys/types.h>
+#include <sys/list.h>
+
+/*
+ * A process-private semaphore lives in user space: value holds the
+ * tokens and is taken or given back by atomic operations, the kernel
+ * being entered only to block or wake a waiter.  A value of -1 means
+ * no token with some waiters queued.  Process-shared semaphores are
+ * kernel objects referenced by sysid, which must stay first as the
+ * kernel reads it from the sem_t address.  Only value, hit by every
+ * operation, gets a line of its own; the waiters side is used under
+ * lock on the slow path.
+ */
+typedef struct
+{
+	unsigned long sysid;
+	int scope;
+	uint_t lock;
+	uint_t waiting;
+	struct list_entry queue;
+	volatile sint_t value    __CACHELINE;
+}sem_t;
 
 int sem_init(sem_t *sem, int pshared, unsigned int value);
 int sem_getvalue(sem_t *sem, int *value);
@@ -37,6 +37,8 @@ pthread_mutex_t __printf_lock = PTHREAD_MUTEX_INITIALIZER;
 uint_t ___dmsg_lock = 0;
 uint_t ___dmsg_ok = 0;
 
+extern void __arena_thread_exit(void);
+
 void __pthread_init(void)
 {
 	__pthread_keys_init();
@@ -53,6 +55,9 @@ void __pthread_tls_init(struct __pthread_tls_s *tls)
 
 void pthread_exit (void *retval)
 {
+	/* Give cached small blocks back to the cluster arena */
+	__arena_thread_exit();
+
 	cpu_syscall(retval,NULL,NULL,NULL,SYS_EXIT);
 }
 
@@ -1,5 +1,5 @@
 /*
- * pthread_mutex.c - pthread rwlock related functions
+ * pthread_rwlock.c - pthread rwlock related functions
  * 
  * Copyright (c) 2008,2009,2010,2011,2012 Ghassan Almaless
  * Copyright (c) 2011,2012 UPMC Sorbonne Universites
@@ -45,37 +45,340 @@ static int __sys_rwlock(pthread_rwlock_t *rwlock, uint_t operation)
 	return retval;
 }
 
+/*
+ * Process-private rwlocks are handled in user space: readers and writers
+ * get the lock by an atomic update of value while nobody is queued, the
+ * spinlock and the kernel are only used once a thread has to wait.  The
+ * waiters bit is set and cleared under the spinlock only, and while it is
+ * set every change of value is made under the spinlock too.  The releaser
+ * hands the lock over to the waiters before waking them up.  Each thread
+ * counts the read locks it holds per rwlock, so that it can still get a
+ * read lock while writers are queued behind the readers it belongs to.
+ */
+#define RWLOCK_WRITER       0x80000000
+#define RWLOCK_WAITERS      0x40000000
+#define RWLOCK_READERS_MASK 0x3FFFFFFF
+#define RWLOCK_WAKEUP_MAX   100
+
+/* Grants the lock to every queued reader, called with the spinlock held */
+static void __rwlock_wakeup_readers(pthread_rwlock_t *rwlock)
+{
+	struct __shared_s *next;
+	pthread_t tbl[RWLOCK_WAKEUP_MAX];
+	uint_t count;
+
+	rwlock->value = rwlock->rwaiting | ((rwlock->wwaiting) ? RWLOCK_WAITERS : 0);
+	rwlock->owner = 0;
+	cpu_wbflush();
+
+	while(rwlock->rwaiting != 0)
+	{
+		for(count = 0; (count < RWLOCK_WAKEUP_MAX) && (rwlock->rwaiting != 0); count++)
+		{
+			next = list_first(&rwlock->rqueue, struct __shared_s, list);
+			list_unlink(&next->list);
+			rwlock->rwaiting --;
+			tbl[count] = next->tid;
+		}
+
+		(void)cpu_syscall((void*)tbl[0], &tbl[0], (void*)count, NULL, SYS_WAKEUP);
+	}
+}
+
+/* Grants the lock to the first queued writer, called with the spinlock held */
+static void __rwlock_wakeup_writer(pthread_rwlock_t *rwlock)
+{
+	struct __shared_s *next;
+
+	next = list_first(&rwlock->wqueue, struct __shared_s, list);
+	list_unlink(&next->list);
+	rwlock->wwaiting --;
+
+	rwlock->owner = next->tid;
+	rwlock->value = RWLOCK_WRITER | ((rwlock->wwaiting || rwlock->rwaiting) ? RWLOCK_WAITERS : 0);
+	cpu_wbflush();
+
+	(void)cpu_syscall((void*)next->tid, NULL, NULL, NULL, SYS_WAKEUP);
+}
+
+/* Queues the current thread and sleeps until the lock is handed over to it,
+ * called with the spinlock held */
+static int __rwlock_sleep(pthread_rwlock_t *rwlock, struct list_entry *queue, uint_t *waiting)
+{
+	struct __shared_s *shared;
+
+	if(*waiting == 0)
+		list_root_init(queue);
+
+	*waiting += 1;
+	shared = (struct __shared_s*)__pthread_tls_get((__pthread_tls_t*)cpu_get_tls(),__PT_TLS_SHARED);
+	list_add_last(queue, &shared->list);
+
+	(void)pthread_spin_unlock(&rwlock->lock);
+
+	(void)cpu_syscall(NULL, NULL, NULL, NULL, SYS_SLEEP);
+
+	cpu_wbflush();
+	return 0;
+}
+
+/* Read locks held by the current thread on rwlock: its entry, else a
+ * free one, NULL if the table is full */
+static struct __pthread_rdlock_s* __rwlock_rdlocks(pthread_rwlock_t *rwlock)
+{
+	struct __pthread_rdlock_s *tbl;
+	struct __pthread_rdlock_s *free;
+	uint_t i;
+
+	tbl  = ((__pthread_tls_t*)cpu_get_tls())->rdlocks;
+	free = NULL;
+
+	for(i = 0; i < __PT_RDLOCKS_MAX; i++)
+	{
+		if(tbl[i].count == 0)
+			free = (free == NULL) ? &tbl[i] : free;
+		else if(tbl[i].rwlock == rwlock)
+			return &tbl[i];
+	}
+
+	return free;
+}
+
+/* Untracked read locks, the table being full, never bypass writers */
+static inline void __rwlock_rdlocks_up(pthread_rwlock_t *rwlock, struct __pthread_rdlock_s *rdlocks)
+{
+	if(rdlocks == NULL)
+		return;
+
+	rdlocks->rwlock  = rwlock;
+	rdlocks->count  += 1;
+}
+
+static inline int __rwlock_fast_rdlock(pthread_rwlock_t *rwlock)
+{
+	register uint_t v;
+
+	while(((v = rwlock->value) & (RWLOCK_WRITER | RWLOCK_WAITERS)) == 0)
+	{
+		if(cpu_atomic_cas((void*)&rwlock->value, v, v + 1))
+		{
+			__rwlock_rdlocks_up(rwlock, __rwlock_rdlocks(rwlock));
+			return 0;
+		}
+	}
+
+	return EBUSY;
+}
+
 int pthread_rwlock_init(pthread_rwlock_t *rwlock, const pthread_rwlockattr_t *attr)
 {
-	return __sys_rwlock(rwlock, RWLOCK_INIT);
+	int err;
+
+	if(rwlock == NULL)
+		return EINVAL;
+
+	rwlock->scope = ((attr != NULL) && (*attr == PTHREAD_PROCESS_SHARED)) ? 
+		PTHREAD_PROCESS_SHARED : PTHREAD_PROCESS_PRIVATE;
+
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_INIT);
+
+	err = pthread_spin_init(&rwlock->lock, 0);
+
+	if(err) return err;
+
+	rwlock->value    = 0;
+	rwlock->owner    = 0;
+	rwlock->rwaiting = 0;
+	rwlock->wwaiting = 0;
+	return 0;
 }
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_TRYWRLOCK);
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_TRYWRLOCK);
+
+	if(cpu_atomic_cas((void*)&rwlock->value, 0, RWLOCK_WRITER) == false)
+		return EBUSY;
+
+	rwlock->owner = (uint_t)pthread_self();
+	return 0;
 }
 
 int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_WRLOCK);
+	register uint_t v;
+	uint_t this;
+	int err;
+
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_WRLOCK);
+
+	this = (uint_t)pthread_self();
+
+	if(cpu_atomic_cas((void*)&rwlock->value, 0, RWLOCK_WRITER))
+	{
+		rwlock->owner = this;
+		return 0;
+	}
+
+	if((rwlock->value & RWLOCK_WRITER) && (rwlock->owner == this))
+		return EDEADLK;
+
+	err = pthread_spin_lock(&rwlock->lock);
+	if(err) return err;
+
+	while(1)
+	{
+		v = rwlock->value;
+
+		if(v == 0)
+		{
+			if(cpu_atomic_cas((void*)&rwlock->value, 0, RWLOCK_WRITER))
+			{
+				rwlock->owner = this;
+				(void)pthread_spin_unlock(&rwlock->lock);
+				return 0;
+			}
+			continue;
+		}
+
+		if((v & RWLOCK_WAITERS) || cpu_atomic_cas((void*)&rwlock->value, v, v | RWLOCK_WAITERS))
+			break;
+	}
+
+	return __rwlock_sleep(rwlock, &rwlock->wqueue, &rwlock->wwaiting);
 }
 
 int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_RDLOCK);
+	register uint_t v;
+	struct __pthread_rdlock_s *rdlocks;
+	int err;
+
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_RDLOCK);
+
+	if(__rwlock_fast_rdlock(rwlock) == 0)
+		return 0;
+
+	if((rwlock->value & RWLOCK_WRITER) && (rwlock->owner == (uint_t)pthread_self()))
+		return EDEADLK;
+
+	rdlocks = __rwlock_rdlocks(rwlock);
+
+	err = pthread_spin_lock(&rwlock->lock);
+	if(err) return err;
+
+	/* Readers queue up behind any waiting writer, unless they already
+	 * hold a read lock on this rwlock which the writer may be waiting for */
+	while(1)
+	{
+		v = rwlock->value;
+
+		if(((v & (RWLOCK_WRITER | RWLOCK_WAITERS)) == 0) ||
+		   (!(v & RWLOCK_WRITER) && (v & RWLOCK_READERS_MASK) && 
+		    (rdlocks != NULL) && (rdlocks->count != 0)))
+		{
+			if(cpu_atomic_cas((void*)&rwlock->value, v, v + 1))
+			{
+				(void)pthread_spin_unlock(&rwlock->lock);
+				__rwlock_rdlocks_up(rwlock, rdlocks);
+				return 0;
+			}
+			continue;
+		}
+
+		if((v & RWLOCK_WAITERS) || cpu_atomic_cas((void*)&rwlock->value, v, v | RWLOCK_WAITERS))
+			break;
+	}
+
+	err = __rwlock_sleep(rwlock, &rwlock->rqueue, &rwlock->rwaiting);
+
+	if(err == 0)
+		__rwlock_rdlocks_up(rwlock, rdlocks);
+
+	return err;
 }
 
 int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_TRYRDLOCK);
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_TRYRDLOCK);
+
+	return __rwlock_fast_rdlock(rwlock);
 }
 
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_UNLOCK);
+	register uint_t v;
+	uint_t isWriter;
+	struct __pthread_rdlock_s *rdlocks;
+	int err;
+
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_UNLOCK);
+
+	v        = rwlock->value;
+	isWriter = v & RWLOCK_WRITER;
+
+	if(isWriter)
+	{
+		if(rwlock->owner != (uint_t)pthread_self())
+			return EPERM;
+
+		rwlock->owner = 0;
+	}
+	else
+	{
+		if((v & RWLOCK_READERS_MASK) == 0)
+			return EPERM;
+
+		rdlocks = __rwlock_rdlocks(rwlock);
+
+		if((rdlocks != NULL) && (rdlocks->count != 0))
+			rdlocks->count -= 1;
+	}
+
+	while((v & RWLOCK_WAITERS) == 0)
+	{
+		if(cpu_atomic_cas((void*)&rwlock->value, v, (isWriter) ? 0 : v - 1))
+			return 0;
+
+		v = rwlock->value;
+	}
+
+	err = pthread_spin_lock(&rwlock->lock);
+	if(err) return err;
+
+	v = rwlock->value;
+
+	if((isWriter == 0) && ((v & RWLOCK_READERS_MASK) > 1))
+	{
+		rwlock->value = v - 1;
+		(void)pthread_spin_unlock(&rwlock->lock);
+		return 0;
+	}
+
+	/* Last owner out: a writer passes the lock to the readers, if any,
+	 * the readers to a writer, so that neither side can starve */
+	if((rwlock->wwaiting != 0) && (isWriter == 0 || rwlock->rwaiting == 0))
+		__rwlock_wakeup_writer(rwlock);
+	else
+		__rwlock_wakeup_readers(rwlock);
+
+	(void)pthread_spin_unlock(&rwlock->lock);
+	return 0;
 }
 
 int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
 {
-	return __sys_rwlock(rwlock, RWLOCK_DESTROY);
+	if(rwlock->scope == PTHREAD_PROCESS_SHARED)
+		return __sys_rwlock(rwlock, RWLOCK_DESTROY);
+
+	if((rwlock->value != 0) || (rwlock->rwaiting != 0) || (rwlock->wwaiting != 0))
+		return EBUSY;
+
+	return pthread_spin_destroy(&rwlock->lock);
 }
@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include <sys/syscall.h>
 #include <cpu-syscall.h>
 
@@ -44,35 +45,183 @@ static int __sys_sem(sem_t *sem, int operation, int pshared, int *value)
 	return retval;
 }
 
+#define sem_lock(_sem)   cpu_spinlock_lock(&(_sem)->lock)
+#define sem_unlock(_sem) cpu_spinlock_unlock(&(_sem)->lock)
+
+/* Takes a token if there is one, without entering the kernel */
+static inline int sem_fast_wait(sem_t *sem)
+{
+	register sint_t v;
+
+	while((v = sem->value) > 0)
+	{
+		if(cpu_atomic_cas((void*)&sem->value, v, v - 1))
+			return 0;
+	}
+
+	return -1;
+}
+
 int sem_init(sem_t *sem, int pshared, unsigned int value)
 {
 	int v          = (int)value;
 	int *value_ptr = &v;
 
-	return __sys_sem(sem, SEM_INIT, pshared, value_ptr);
+	if(sem == NULL)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	sem->scope = pshared;
+
+	if(pshared != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_INIT, pshared, value_ptr);
+
+	if(value > SEM_VALUE_MAX)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	sem->lock    = 0;
+	sem->value   = v;
+	sem->waiting = 0;
+	list_root_init(&sem->queue);
+	cpu_wbflush();
+	return 0;
 }
 
 int sem_getvalue(sem_t *sem, int *value)
 {
-	return __sys_sem(sem, SEM_GETVALUE, 0, value);
+	sint_t v;
+
+	if(sem->scope != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_GETVALUE, 0, value);
+
+	v      = sem->value;
+	*value = (v > 0) ? (int)v : 0;
+	return 0;
 }
 
 int sem_wait(sem_t *sem)
 {
-	return __sys_sem(sem, SEM_WAIT, 0, NULL);
+	struct __shared_s *shared;
+	register sint_t v;
+
+	if(sem->scope != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_WAIT, 0, NULL);
+
+	if(sem_fast_wait(sem) == 0)
+		return 0;
+
+	sem_lock(sem);
+
+	/* Either take a token posted meanwhile or mark the semaphore as
+	 * contended, so the next sem_post goes through the waiters queue */
+	while(1)
+	{
+		v = sem->value;
+
+		if(v > 0)
+		{
+			if(cpu_atomic_cas((void*)&sem->value, v, v - 1))
+			{
+				sem_unlock(sem);
+				return 0;
+			}
+			continue;
+		}
+
+		if((v < 0) || cpu_atomic_cas((void*)&sem->value, 0, -1))
+			break;
+	}
+
+	shared = (struct __shared_s*)__pthread_tls_get((__pthread_tls_t*)cpu_get_tls(),__PT_TLS_SHARED);
+	list_add_last(&sem->queue, &shared->list);
+	sem->waiting += 1;
+
+	sem_unlock(sem);
+
+	/* The poster hands its token over directly before waking us up */
+	(void)cpu_syscall(NULL, NULL, NULL, NULL, SYS_SLEEP);
+
+	cpu_wbflush();
+	return 0;
 }
 
 int sem_trywait(sem_t *sem)
 {
-	return __sys_sem(sem, SEM_TRYWAIT, 0, NULL);
+	if(sem->scope != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_TRYWAIT, 0, NULL);
+
+	if(sem_fast_wait(sem) == 0)
+		return 0;
+
+	errno = EAGAIN;
+	return -1;
 }
 
 int sem_post(sem_t *sem)
 {
-	return __sys_sem(sem, SEM_POST, 0, NULL);
+	struct __shared_s *next;
+	register sint_t v;
+
+	if(sem->scope != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_POST, 0, NULL);
+
+	while(1)
+	{
+		v = sem->value;
+
+		if(v >= 0)
+		{
+			if(v >= SEM_VALUE_MAX)
+			{
+				errno = EOVERFLOW;
+				return -1;
+			}
+
+			if(cpu_atomic_cas((void*)&sem->value, v, v + 1))
+				return 0;
+
+			continue;
+		}
+
+		/* Only sem_post leaves the contended state, under the lock, so
+		 * another poster may have woken the last waiter meanwhile */
+		sem_lock(sem);
+
+		if(sem->value < 0)
+			break;
+
+		sem_unlock(sem);
+	}
+
+	next = list_first(&sem->queue, struct __shared_s, list);
+	list_unlink(&next->list);
+	sem->waiting -= 1;
+
+	if(sem->waiting == 0)
+		sem->value = 0;
+
+	cpu_wbflush();
+	(void)cpu_syscall((void*)next->tid, NULL, NULL, NULL, SYS_WAKEUP);
+
+	sem_unlock(sem);
+	return 0;
 }
 
 int sem_destroy(sem_t *sem)
 {
-	return __sys_sem(sem, SEM_DESTROY, 0, NULL);
+	if(sem->scope != PTHREAD_PROCESS_PRIVATE)
+		return __sys_sem(sem, SEM_DESTROY, 0, NULL);
+
+	if(sem->waiting != 0)
+	{
+		errno = EBUSY;
+		return -1;
+	}
+
+	return 0;
 }
@@ -1044,6 +1044,32 @@ ZEXTERN uLong ZEXPORT compressBound OF((uLong sourceLen));
    a compress() or compress2() call to allocate the destination buffer.
 */
 
+ZEXTERN int ZEXPORT compressParallel OF((Bytef *dest,   uLongf *destLen,
+                                         const Bytef *source, uLong sourceLen,
+                                         int level, int windowBits,
+                                         int nthreads));
+/*
+     Compresses the source buffer into the destination buffer like
+   compress2(), deflating 128K blocks on up to nthreads threads. Each
+   block is primed with the 32K of data preceding it, so the ratio stays
+   close to the one of compress2(). windowBits selects the wrapper as in
+   deflateInit2(): 8..15 for a zlib stream, 16 more for a gzip one and
+   negative for raw deflate data. Upon entry, destLen is the total size
+   of the destination buffer, which should be at least the value returned
+   by compressParallelBound(sourceLen). Upon exit, destLen is the actual
+   size of the compressed data, a single stream any inflate can read.
+
+     compressParallel returns Z_OK if success, Z_MEM_ERROR if there was not
+   enough memory, Z_BUF_ERROR if there was not enough room in the output
+   buffer, Z_STREAM_ERROR if the level or windowBits parameter is invalid.
+*/
+
+ZEXTERN uLong ZEXPORT compressParallelBound OF((uLong sourceLen));
+/*
+     compressParallelBound() returns an upper bound on the compressed size
+   after compressParallel() on sourceLen bytes, whatever the wrapper.
+*/
+
 ZEXTERN int ZEXPORT uncompress OF((Bytef *dest,   uLongf *destLen,
                                    const Bytef *source, uLong sourceLen));
 /*
@@ -0,0 +1,330 @@
+/* pcompress.c -- compress a memory buffer on several threads
+ * For conditions of distribution and use, see copyright notice in zlib.h
+ */
+
+/* @(#) $Id$ */
+
+/*
+ *  The input is cut in PCOMPRESS_BLOCK bytes blocks, each one deflated as a
+ *  raw stream by its own z_stream, as done by pigz. A block is primed with
+ *  the PCOMPRESS_DICT bytes preceding it, so matches may still reach back
+ *  into the previous block, and ends with a sync flush so it is byte
+ *  aligned and has no last-block bit. The last block is finished normally.
+ *  Concatenated behind the wrapper header, the blocks then form a single
+ *  deflate stream, and the check value is rebuilt from the per block ones
+ *  with adler32_combine() or crc32_combine().
+ */
+
+#include <pthread.h>
+#include "zutil.h"
+
+#define PCOMPRESS_BLOCK (128 * 1024L)
+#define PCOMPRESS_DICT  (32 * 1024)
+
+typedef struct pblock_s {
+    const Bytef *in;    /* start of the block in the source */
+    uLong len;          /* number of source bytes in the block */
+    Bytef *out;         /* raw deflate data, malloc'ed */
+    uLong out_len;      /* number of bytes in out */
+    uLong check;        /* adler32 or crc32 of the block */
+} pblock;
+
+typedef struct pjob_s {
+    pthread_mutex_t lock;
+    const Bytef *source;
+    pblock *blocks;
+    uLong nb_blocks;
+    uLong next;         /* next block to compress */
+    int level;
+    int wrap;           /* 0: raw, 1: zlib, 2: gzip */
+    int err;            /* first error met by a worker */
+} pjob;
+
+/* ===========================================================================
+     Deflates one block into a buffer of its own, which is grown when the
+   compressed data turns out larger than the source.
+*/
+local int pcompress_block(job, blk, last)
+    pjob *job;
+    pblock *blk;
+    int last;
+{
+    z_stream strm;
+    uLong size, dict;
+    Bytef *out;
+    int err, flush;
+
+    strm.zalloc = (alloc_func)0;
+    strm.zfree = (free_func)0;
+    strm.opaque = (voidpf)0;
+
+    err = deflateInit2(&strm, job->level, Z_DEFLATED, -MAX_WBITS,
+                       DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (err != Z_OK) return err;
+
+    dict = (uLong)(blk->in - job->source);
+    if (dict > PCOMPRESS_DICT) dict = PCOMPRESS_DICT;
+    if (dict != 0) {
+        err = deflateSetDictionary(&strm, blk->in - dict, (uInt)dict);
+        if (err != Z_OK) goto end;
+    }
+
+    size = blk->len + (blk->len >> 12) + (blk->len >> 14) + 16;
+    blk->out = (Bytef *)malloc(size);
+    if (blk->out == Z_NULL) {
+        err = Z_MEM_ERROR;
+        goto end;
+    }
+
+    strm.next_in = (Bytef *)blk->in;
+    strm.avail_in = (uInt)blk->len;
+    strm.next_out = blk->out;
+    strm.avail_out = (uInt)size;
+    flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+    for (;;) {
+        err = deflate(&strm, flush);
+        if (err == Z_STREAM_END) break;
+        if (err != Z_OK && err != Z_BUF_ERROR) goto end;
+        /* a sync flush is over once deflate leaves room in the output */
+        if (flush == Z_SYNC_FLUSH && strm.avail_out != 0) break;
+
+        out = (Bytef *)realloc(blk->out, size << 1);
+        if (out == Z_NULL) {
+            err = Z_MEM_ERROR;
+            goto end;
+        }
+        blk->out = out;
+        strm.next_out = out + size;
+        strm.avail_out = (uInt)size;
+        size <<= 1;
+    }
+    blk->out_len = strm.total_out;
+
+    if (job->wrap == 1)
+        blk->check = adler32(adler32(0L, Z_NULL, 0), blk->in, (uInt)blk->len);
+    else if (job->wrap == 2)
+        blk->check = crc32(crc32(0L, Z_NULL, 0), blk->in, (uInt)blk->len);
+    err = Z_OK;
+
+end:
+    deflateEnd(&strm);
+    return err;
+}
+
+/* ===========================================================================
+     Worker loop, shared by the pool threads and the calling thread: takes
+   the next block until all of them are done or one of them failed.
+*/
+local void *pcompress_worker(arg)
+    void *arg;
+{
+    pjob *job = (pjob *)arg;
+    uLong i;
+    int err;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        i = job->next++;
+        if (job->err != Z_OK) i = job->nb_blocks;
+        pthread_mutex_unlock(&job->lock);
+
+        if (i >= job->nb_blocks) break;
+
+        err = pcompress_block(job, &job->blocks[i], i == job->nb_blocks - 1);
+        if (err != Z_OK) {
+            pthread_mutex_lock(&job->lock);
+            if (job->err == Z_OK) job->err = err;
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+    return NULL;
+}
+
+/* ===========================================================================
+     Writes the zlib or gzip header, at most 10 bytes, and returns its length.
+*/
+local uInt pcompress_header(dest, level, wrap)
+    Bytef *dest;
+    int level;
+    int wrap;
+{
+    uInt header, level_flags;
+
+    if (wrap == 1) {
+        header = (Z_DEFLATED + ((MAX_WBITS-8)<<4)) << 8;
+        if (level < 2)
+            level_flags = 0;
+        else if (level < 6)
+            level_flags = 1;
+        else if (level == 6)
+            level_flags = 2;
+        else
+            level_flags = 3;
+        header |= (level_flags << 6);
+        header += 31 - (header % 31);
+        dest[0] = (Byte)(header >> 8);
+        dest[1] = (Byte)(header & 0xff);
+        return 2;
+    }
+    if (wrap == 2) {
+        dest[0] = 31;
+        dest[1] = 139;
+        dest[2] = 8;
+        dest[3] = dest[4] = dest[5] = dest[6] = dest[7] = 0;
+        dest[8] = (Byte)(level == 9 ? 2 : (level < 2 ? 4 : 0));
+        dest[9] = OS_CODE;
+        return 10;
+    }
+    return 0;
+}
+
+/* ===========================================================================
+     Compresses the source buffer into the destination buffer with up to
+   nthreads threads. level has the same meaning as in deflateInit and
+   windowBits selects the wrapper as in deflateInit2: 8..15 gives a zlib
+   stream, 8+16..15+16 a gzip one and -8..-15 raw deflate data; the
+   window is always 32K. Upon entry, destLen is the total size of the
+   destination buffer, which should be compressParallelBound(sourceLen).
+   Upon exit, destLen is the actual size of the compressed data.
+
+     compressParallel returns Z_OK if success, Z_MEM_ERROR if there was
+   not enough memory, Z_BUF_ERROR if there was not enough room in the
+   output buffer, Z_STREAM_ERROR if a parameter is invalid.
+*/
+int ZEXPORT compressParallel (dest, destLen, source, sourceLen, level,
+                              windowBits, nthreads)
+    Bytef *dest;
+    uLongf *destLen;
+    const Bytef *source;
+    uLong sourceLen;
+    int level;
+    int windowBits;
+    int nthreads;
+{
+    pjob job;
+    pthread_t *threads;
+    uLong i, len, check, total;
+    int n, created, wrap;
+    Byte head[10];
+    Bytef *out;
+
+    if (level == Z_DEFAULT_COMPRESSION) level = 6;
+    if (level < 0 || level > 9) return Z_STREAM_ERROR;
+
+    wrap = 1;
+    if (windowBits < 0) {
+        wrap = 0;
+        windowBits = -windowBits;
+    } else if (windowBits > 15) {
+        wrap = 2;
+        windowBits -= 16;
+    }
+    if (windowBits < 8 || windowBits > 15) return Z_STREAM_ERROR;
+
+    job.nb_blocks = (sourceLen + PCOMPRESS_BLOCK - 1) / PCOMPRESS_BLOCK;
+    if (job.nb_blocks == 0) job.nb_blocks = 1;
+    job.blocks = (pblock *)calloc(job.nb_blocks, sizeof(pblock));
+    if (job.blocks == Z_NULL) return Z_MEM_ERROR;
+
+    for (i = 0; i < job.nb_blocks; i++) {
+        job.blocks[i].in = source + i * PCOMPRESS_BLOCK;
+        len = sourceLen - i * PCOMPRESS_BLOCK;
+        job.blocks[i].len = len > PCOMPRESS_BLOCK ? PCOMPRESS_BLOCK : len;
+    }
+
+    job.source = source;
+    job.next = 0;
+    job.level = level;
+    job.wrap = wrap;
+    job.err = Z_OK;
+    pthread_mutex_init(&job.lock, NULL);
+
+    /* the calling thread is one of the workers */
+    if (nthreads < 1) nthreads = 1;
+    if ((uLong)nthreads > job.nb_blocks) nthreads = (int)job.nb_blocks;
+    threads = Z_NULL;
+    created = 0;
+    if (nthreads > 1)
+        threads = (pthread_t *)malloc((nthreads - 1) * sizeof(pthread_t));
+    if (threads != Z_NULL) {
+        for (n = 0; n < nthreads - 1; n++) {
+            if (pthread_create(&threads[n], NULL, pcompress_worker, &job))
+                break;
+            created++;
+        }
+    }
+
+    pcompress_worker(&job);
+
+    for (n = 0; n < created; n++)
+        pthread_join(threads[n], NULL);
+    if (threads != Z_NULL) free(threads);
+    pthread_mutex_destroy(&job.lock);
+
+    if (job.err != Z_OK) goto end;
+
+    /* stitch the blocks behind the header and rebuild the check value */
+    job.err = Z_BUF_ERROR;
+    total = pcompress_header(head, level, wrap);
+    if (*destLen < total) goto end;
+    zmemcpy(dest, head, (uInt)total);
+    out = dest + total;
+    check = wrap == 2 ? crc32(0L, Z_NULL, 0) : adler32(0L, Z_NULL, 0);
+
+    for (i = 0; i < job.nb_blocks; i++) {
+        pblock *blk = &job.blocks[i];
+
+        if (*destLen - total < blk->out_len) goto end;
+        zmemcpy(out, blk->out, (uInt)blk->out_len);
+        out += blk->out_len;
+        total += blk->out_len;
+
+        if (wrap == 1)
+            check = adler32_combine(check, blk->check, (z_off_t)blk->len);
+        else if (wrap == 2)
+            check = crc32_combine(check, blk->check, (z_off_t)blk->len);
+    }
+
+    if (wrap == 1) {
+        if (*destLen - total < 4) goto end;
+        out[0] = (Byte)(check >> 24);
+        out[1] = (Byte)(check >> 16);
+        out[2] = (Byte)(check >> 8);
+        out[3] = (Byte)check;
+        total += 4;
+    } else if (wrap == 2) {
+        if (*destLen - total < 8) goto end;
+        out[0] = (Byte)check;
+        out[1] = (Byte)(check >> 8);
+        out[2] = (Byte)(check >> 16);
+        out[3] = (Byte)(check >> 24);
+        out[4] = (Byte)sourceLen;
+        out[5] = (Byte)(sourceLen >> 8);
+        out[6] = (Byte)(sourceLen >> 16);
+        out[7] = (Byte)(sourceLen >> 24);
+        total += 8;
+    }
+    *destLen = total;
+    job.err = Z_OK;
+
+end:
+    for (i = 0; i < job.nb_blocks; i++)
+        if (job.blocks[i].out != Z_NULL) free(job.blocks[i].out);
+    free(job.blocks);
+    return job.err;
+}
+
+/* ===========================================================================
+     Each block costs the bound of compress() plus the 5 bytes of its sync
+   flush, and the whole stream a gzip header and trailer at most.
+ */
+uLong ZEXPORT compressParallelBound (sourceLen)
+    uLong sourceLen;
+{
+    uLong nb_blocks = (sourceLen + PCOMPRESS_BLOCK - 1) / PCOMPRESS_BLOCK;
+
+    if (nb_blocks == 0) nb_blocks = 1;
+    return sourceLen + (sourceLen >> 12) + (sourceLen >> 14) +
+           16 * nb_blocks + 18;
+}